@@ -0,0 +1,279 @@
+// Drive archive: compression ratio, codec speed and query selectivity.
+//
+// Inputs: hours of driving sampled the way the dashboard polls (RPM 20 Hz,
+// speed 10 Hz, throttle 10 Hz, coolant 0.5 Hz, a few ms of timing jitter,
+// values quantized by the PID encoding as an ECU would send them), from the
+// emulator's built-in drive cycle and from signals/drive.trace (throttle from
+// the built-in cycle, which the trace doesn't have); plus any
+// recorded log segments given with -f. Each input is archived twice: with
+// raw-integer values where they round-trip (the default) and XOR-only.
+//
+// Reported per input: size against the 16-byte log records, bits per sample,
+// and chunk encode/decode speed in MB/s of log records, in memory. Then two
+// queries on the archive file: RPM above 5000 anywhere, and every channel
+// over the last 10 minutes, with how many chunks each had to read.
+//
+// Build: gcc -O2 bench/drive_archive_bench.c drive_archive.c telemetry_log.c elm327_emu.c obd_pids.c
+//        can_signals.c -o drive_archive_bench -lpthread -lm
+// Usage: ./drive_archive_bench [-H hours] [-f segment.tlog ...]
+
+#include "../drive_archive.h"
+#include "../telemetry_log.h"
+#include "../elm327_emu.h"
+#include "../obd_pids.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+
+#define ARCHIVE_PATH "/tmp/drive_archive_bench.dar"
+
+typedef struct {
+    uint8_t* pid;
+    long long* t;
+    float* v;
+    long count;
+    long capacity;
+} Samples;
+
+static void Push(Samples* s, uint8_t pid, long long t, float v) {
+    if (s->count == s->capacity) {
+        s->capacity = s->capacity ? s->capacity * 2 : 65536;
+        s->pid = realloc(s->pid, s->capacity);
+        s->t = realloc(s->t, s->capacity * sizeof(long long));
+        s->v = realloc(s->v, s->capacity * sizeof(float));
+    }
+    s->pid[s->count] = pid;
+    s->t[s->count] = t;
+    s->v[s->count] = v;
+    s->count++;
+}
+
+static void FreeSamples(Samples* s) {
+    free(s->pid);
+    free(s->t);
+    free(s->v);
+    memset(s, 0, sizeof(*s));
+}
+
+static double NowSeconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// ---- Inputs ----
+
+static const struct { uint8_t pid; float hz; } CHANNELS[] = {
+    { 0x0C, 20.0f }, { 0x0D, 10.0f }, { 0x11, 10.0f }, { 0x05, 0.5f },
+};
+#define NUM_CHANNELS (int)(sizeof(CHANNELS) / sizeof(CHANNELS[0]))
+
+// Polled samples ending now, in time order as the logger would see them
+static void Generate(const ELMEmulator* truth, double hours, Samples* out) {
+    double duration = hours * 3600.0;
+    long long end_us = (long long)time(NULL) * 1000000LL;
+    long long start_us = end_us - (long long)(duration * 1e6);
+    double next[NUM_CHANNELS] = {0};
+    unsigned int rng = 1;
+    for (;;) {
+        int c = 0;
+        for (int i = 1; i < NUM_CHANNELS; i++) if (next[i] < next[c]) c = i;
+        double t = next[c];
+        if (t >= duration) break;
+        next[c] += 1.0 / CHANNELS[c].hz;
+
+        uint8_t data[4];
+        OBD_EncodePID(CHANNELS[c].pid, ELM_Value(truth, CHANNELS[c].pid, t), data);
+        float value = OBD_DecodePID(CHANNELS[c].pid, data);
+
+        rng = rng * 1103515245u + 12345u;
+        long long jitter_us = (rng >> 8) % 8000;   // Reply arrives 0-8 ms late
+        Push(out, CHANNELS[c].pid, start_us + (long long)(t * 1e6) + jitter_us, value);
+    }
+}
+
+static bool LoadSegments(char** paths, int n, Samples* out) {
+    for (int i = 0; i < n; i++) {
+        TLogReader reader;
+        if (!TLog_ReaderOpen(&reader, paths[i])) return false;
+        TLogRecord record;
+        while (TLog_ReaderNext(&reader, &record)) {
+            Push(out, record.pid, record.timestamp_us + reader.header.clock_offset_us, record.value);
+        }
+        TLog_ReaderClose(&reader);
+    }
+    return out->count > 0;
+}
+
+// ---- Measurements ----
+
+// Split into per-channel chunks the way the writer does, encode them all,
+// decode them all; repeated for a stable time
+static void Codec(const Samples* s, bool raw_values, double* encode_mbs, double* decode_mbs, bool* exact) {
+    long long* t = malloc(sizeof(long long) * s->count);
+    float* v = malloc(sizeof(float) * s->count);
+    long* chunk_start = malloc(sizeof(long) * (s->count + 1));
+    int* chunk_len = malloc(sizeof(int) * (s->count + 1));
+    uint8_t* chunk_pid = malloc(s->count + 1);
+    long n = 0, chunks = 0;
+
+    // Group by PID, keeping time order
+    for (int pid = 0; pid < 256; pid++) {
+        long first = n;
+        for (long i = 0; i < s->count; i++) {
+            if (s->pid[i] != pid) continue;
+            t[n] = s->t[i];
+            v[n] = s->v[i];
+            n++;
+        }
+        for (long at = first; at < n; at += ARCHIVE_CHUNK_SAMPLES) {
+            chunk_start[chunks] = at;
+            chunk_len[chunks] = (int)(n - at < ARCHIVE_CHUNK_SAMPLES ? n - at : ARCHIVE_CHUNK_SAMPLES);
+            chunk_pid[chunks] = (uint8_t)pid;
+            chunks++;
+        }
+    }
+
+    ArchiveChunk* index = malloc(sizeof(ArchiveChunk) * chunks);
+    uint8_t* data = malloc(ARCHIVE_CHUNK_MAX_BYTES(ARCHIVE_CHUNK_SAMPLES) * chunks);
+    size_t* offsets = malloc(sizeof(size_t) * chunks);
+    long long dt[ARCHIVE_CHUNK_SAMPLES];
+    float dv[ARCHIVE_CHUNK_SAMPLES];
+    double raw_mb = s->count * sizeof(TLogRecord) / 1e6;
+
+    int rounds = 0;
+    double start = NowSeconds();
+    do {
+        size_t at = 0;
+        for (long c = 0; c < chunks; c++) {
+            offsets[c] = at;
+            at += Archive_EncodeChunk(chunk_pid[c], t + chunk_start[c], v + chunk_start[c], chunk_len[c],
+                                      ARCHIVE_DEFAULT_TIME_UNIT_US, raw_values, data + at, &index[c]);
+        }
+        rounds++;
+    } while (NowSeconds() - start < 0.5);
+    *encode_mbs = raw_mb * rounds / (NowSeconds() - start);
+
+    *exact = true;
+    rounds = 0;
+    start = NowSeconds();
+    do {
+        for (long c = 0; c < chunks; c++) {
+            int got = Archive_DecodeChunk(&index[c], data + offsets[c], ARCHIVE_DEFAULT_TIME_UNIT_US, dt, dv);
+            if (rounds == 0) {
+                // Values bit-exact, times to the millisecond
+                if (got != chunk_len[c]) *exact = false;
+                for (int i = 0; i < got && *exact; i++) {
+                    long long want = t[chunk_start[c] + i] / 1000 * 1000;
+                    if (dt[i] != want || memcmp(&dv[i], &v[chunk_start[c] + i], sizeof(float)) != 0) *exact = false;
+                }
+            }
+        }
+        rounds++;
+    } while (NowSeconds() - start < 0.5);
+    *decode_mbs = raw_mb * rounds / (NowSeconds() - start);
+
+    free(t);
+    free(v);
+    free(chunk_start);
+    free(chunk_len);
+    free(chunk_pid);
+    free(index);
+    free(data);
+    free(offsets);
+}
+
+static long WriteArchive(const Samples* s, bool raw_values) {
+    ArchiveWriter writer;
+    if (!Archive_Create(&writer, ARCHIVE_PATH, ARCHIVE_DEFAULT_TIME_UNIT_US)) exit(1);
+    writer.raw_values = raw_values;
+    for (long i = 0; i < s->count; i++) Archive_Add(&writer, s->pid[i], s->t[i], s->v[i]);
+    if (!Archive_Finish(&writer)) exit(1);
+    FILE* f = fopen(ARCHIVE_PATH, "rb");
+    fseek(f, 0, SEEK_END);
+    long bytes = ftell(f);
+    fclose(f);
+    return bytes;
+}
+
+static void RunQuery(const char* name, const ArchiveQuery* query) {
+    ArchiveReader reader;
+    if (!Archive_Open(&reader, ARCHIVE_PATH)) exit(1);
+    double start = NowSeconds();
+    long matches = Archive_Query(&reader, query, NULL, NULL);
+    double ms = (NowSeconds() - start) * 1000.0;
+    printf("    %-26s %7ld samples   %4lu of %4d chunks read (%6.1f KB)   %6.2f ms\n", name, matches,
+           reader.chunks_read, reader.num_chunks, reader.bytes_read / 1024.0, ms);
+    Archive_Close(&reader);
+}
+
+static void Report(const char* name, const Samples* s) {
+    printf("\n%s: %ld samples, %.1f MB of log records\n", name, s->count, s->count * sizeof(TLogRecord) / 1e6);
+    for (int raw = 1; raw >= 0; raw--) {
+        double encode_mbs, decode_mbs;
+        bool exact;
+        Codec(s, raw, &encode_mbs, &decode_mbs, &exact);
+        long bytes = WriteArchive(s, raw);
+        printf("    %-10s %9ld bytes  %5.1fx  %5.2f bits/sample   encode %6.0f MB/s  decode %6.0f MB/s%s\n",
+               raw ? "raw+xor" : "xor only", bytes, (double)s->count * sizeof(TLogRecord) / bytes,
+               bytes * 8.0 / s->count, encode_mbs, decode_mbs, exact ? "" : "  MISMATCH");
+    }
+
+    // Queries on the default archive
+    WriteArchive(s, true);
+    ArchiveQuery fast = Archive_QueryAll();
+    fast.pid = 0x0C;
+    fast.min_value = 5000.0f;
+    RunQuery("RPM > 5000", &fast);
+    ArchiveQuery recent = Archive_QueryAll();
+    long long last = 0;
+    for (long i = 0; i < s->count; i++) if (s->t[i] > last) last = s->t[i];
+    recent.from_us = last - 600 * 1000000LL;
+    RunQuery("all channels, last 10 min", &recent);
+    unlink(ARCHIVE_PATH);
+}
+
+int main(int argc, char** argv) {
+    double hours = 8.0;
+    int opt;
+    bool segments = false;
+    while ((opt = getopt(argc, argv, "H:f")) != -1) {
+        switch (opt) {
+            case 'H': hours = atof(optarg); break;
+            case 'f': segments = true; break;
+            default:
+                fprintf(stderr, "usage: %s [-H hours] [-f segment.tlog ...]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    printf("%d-sample chunks, 1 ms timestamps; MB/s are of 16-byte log records\n", ARCHIVE_CHUNK_SAMPLES);
+    static ELMEmulator truth;
+    truth.config.trace_loop = true;
+    Samples s = {0};
+
+    if (segments) {
+        if (!LoadSegments(argv + optind, argc - optind, &s)) return 1;
+        Report("recorded segments", &s);
+        FreeSamples(&s);
+        return 0;
+    }
+
+    char name[64];
+    Generate(&truth, hours, &s);
+    snprintf(name, sizeof(name), "built-in drive cycle, %.0f h", hours);
+    Report(name, &s);
+    FreeSamples(&s);
+
+    if (ELM_LoadTrace(&truth.trace, "signals/drive.trace")) {
+        Generate(&truth, hours, &s);
+        snprintf(name, sizeof(name), "signals/drive.trace looped, %.0f h", hours);
+        Report(name, &s);
+        FreeSamples(&s);
+        ELM_FreeTrace(&truth.trace);
+    }
+    return 0;
+}
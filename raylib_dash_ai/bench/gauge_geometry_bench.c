@@ -0,0 +1,216 @@
+// Gauge geometry: table trigonometry against libm, and a face built every
+// frame against one built once.
+//
+//   accuracy   worst error of Geo_SinCos against double precision sin/cos
+//              over every angle a needle can take, in 1/64 degree steps
+//   needle     a needle's tip and base from its angle: six sinf/cosf calls
+//              (the old OnCircle three times) against one table lookup
+//   face       the tachometer face's triangles (bezel, 44 ticks, 270 zone
+//              lines) written to a vertex buffer the way the render batch
+//              gets them: computed with sinf/cosf each frame, as the gauges
+//              did, against copying the prebuilt mesh at an offset
+//
+// Needs raylib's header for the vector types only; it runs where the
+// dashboard can't, e.g. cross-compiled for a Pi without its GL stack.
+//
+// Build: gcc -O2 bench/gauge_geometry_bench.c gauge_geometry.c -o gauge_geometry_bench -lm
+//   Pi Zero (ARMv6):      add -mcpu=arm1176jzf-s -mfpu=vfp -mfloat-abi=hard
+//   Pi 3 (ARMv7, 32 bit): add -mcpu=cortex-a53 -mfpu=neon-fp-armv8 -mfloat-abi=hard
+// Usage: ./gauge_geometry_bench [-n iterations]
+
+#include "../gauge_geometry.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+
+#define START_ANGLE 135.0f
+#define END_ANGLE 405.0f
+#define RADIUS 150.0f
+
+// Vertices the batch would receive
+static Vector2 batch[16384];
+static int batchCount;
+static volatile float sink;
+
+static long long NowNanos(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// ---- libm every frame ----
+
+static Vector2 OnCircleLibm(Vector2 center, float angleRad, float radius) {
+    return (Vector2){ center.x + cosf(angleRad) * radius, center.y + sinf(angleRad) * radius };
+}
+
+static void Emit(Vector2 v) {
+    batch[batchCount++] = v;
+}
+
+static void LineLibm(Vector2 a, Vector2 b, float thick) {
+    float dx = b.x - a.x, dy = b.y - a.y;
+    float scale = thick / (2.0f * sqrtf(dx * dx + dy * dy));
+    Vector2 side = { -scale * dy, scale * dx };
+    Vector2 p1 = { a.x + side.x, a.y + side.y }, p2 = { a.x - side.x, a.y - side.y };
+    Vector2 p3 = { b.x + side.x, b.y + side.y }, p4 = { b.x - side.x, b.y - side.y };
+    Emit(p1); Emit(p2); Emit(p3);
+    Emit(p2); Emit(p4); Emit(p3);
+}
+
+// As raylib's DrawCircleSector: sinf/cosf at every segment edge
+static void CircleLibm(Vector2 center, float radius, int segments) {
+    float step = 2.0f * PI / segments;
+    for (int i = 0; i < segments; i++) {
+        float angle = i * step;
+        Emit(center);
+        Emit((Vector2){ center.x + cosf(angle + step) * radius, center.y + sinf(angle + step) * radius });
+        Emit((Vector2){ center.x + cosf(angle) * radius, center.y + sinf(angle) * radius });
+    }
+}
+
+static void FaceLibm(Vector2 center) {
+    CircleLibm(center, RADIUS + 10, GEO_CIRCLE_SEGMENTS);
+    CircleLibm(center, RADIUS + 5, GEO_CIRCLE_SEGMENTS);
+    CircleLibm(center, RADIUS, GEO_CIRCLE_SEGMENTS);
+    for (int i = 0; i < 9; i++) {
+        float angleRad = (START_ANGLE + (END_ANGLE - START_ANGLE) * i / 8) * DEG2RAD;
+        LineLibm(OnCircleLibm(center, angleRad, RADIUS - 10), OnCircleLibm(center, angleRad, RADIUS - 30), 3.0f);
+    }
+    for (int i = 0; i < 40; i++) {
+        if (i % 5 == 0) continue;
+        float angleRad = (START_ANGLE + (END_ANGLE - START_ANGLE) * i / 40.0f) * DEG2RAD;
+        LineLibm(OnCircleLibm(center, angleRad, RADIUS - 10), OnCircleLibm(center, angleRad, RADIUS - 20), 1.5f);
+    }
+    for (int angle = START_ANGLE; angle < END_ANGLE; angle++) {
+        float angleRad = angle * DEG2RAD;
+        LineLibm(OnCircleLibm(center, angleRad, RADIUS - 35), OnCircleLibm(center, angleRad, RADIUS - 5), 2.0f);
+    }
+}
+
+// ---- Built once ----
+
+static GeoMesh BuildFace(void) {
+    GeoMesh mesh = {0};
+    Vector2 origin = { 0.0f, 0.0f };
+    Geo_AddCircle(&mesh, origin, RADIUS + 10, BLACK);
+    Geo_AddCircle(&mesh, origin, RADIUS + 5, DARKGRAY);
+    Geo_AddCircle(&mesh, origin, RADIUS, BLACK);
+    for (int i = 0; i < 9; i++) {
+        float angle = START_ANGLE + (END_ANGLE - START_ANGLE) * i / 8;
+        Geo_AddLine(&mesh, Geo_OnCircle(origin, angle, RADIUS - 10), Geo_OnCircle(origin, angle, RADIUS - 30), 3.0f,
+                    WHITE);
+    }
+    for (int i = 0; i < 40; i++) {
+        if (i % 5 == 0) continue;
+        float angle = START_ANGLE + (END_ANGLE - START_ANGLE) * i / 40.0f;
+        Geo_AddLine(&mesh, Geo_OnCircle(origin, angle, RADIUS - 10), Geo_OnCircle(origin, angle, RADIUS - 20), 1.5f,
+                    GRAY);
+    }
+    for (int angle = START_ANGLE; angle < END_ANGLE; angle++) {
+        Geo_AddLine(&mesh, Geo_OnCircle(origin, angle, RADIUS - 35), Geo_OnCircle(origin, angle, RADIUS - 5), 2.0f,
+                    GREEN);
+    }
+    return mesh;
+}
+
+static void FaceMesh(const GeoMesh* mesh, Vector2 center) {
+    for (int i = 0; i < mesh->count; i++) {
+        Emit((Vector2){ center.x + mesh->vertices[i].x, center.y + mesh->vertices[i].y });
+    }
+}
+
+// ---- Runs ----
+
+static void Accuracy(void) {
+    double worst = 0.0, worstAt = 0.0;
+    for (int i = 0; i <= (int)(END_ANGLE - START_ANGLE) * 64; i++) {
+        float degrees = START_ANGLE + i / 64.0f;
+        float s, c;
+        Geo_SinCos(degrees, &s, &c);
+        double rad = degrees * M_PI / 180.0;
+        double err = fmax(fabs(s - sin(rad)), fabs(c - cos(rad)));
+        if (err > worst) {
+            worst = err;
+            worstAt = degrees;
+        }
+    }
+    // A needle 110 px long is off by this much at its tip
+    printf("accuracy  worst error %.2e at %.3f deg (%.5f px at a 110 px tip)\n", worst, worstAt, worst * 110.0);
+}
+
+static void Needles(int iterations) {
+    Vector2 center = { 280.0f, 280.0f };
+    long long t0 = NowNanos();
+    for (int i = 0; i < iterations; i++) {
+        float angle = START_ANGLE + (END_ANGLE - START_ANGLE) * (i % 4096) / 4096.0f;
+        Vector2 tip = OnCircleLibm(center, angle * DEG2RAD, 110.0f);
+        Vector2 base1 = OnCircleLibm(center, (angle - 90) * DEG2RAD, 8.0f);
+        Vector2 base2 = OnCircleLibm(center, (angle + 90) * DEG2RAD, 8.0f);
+        sink = tip.x + tip.y + base1.x + base1.y + base2.x + base2.y;
+    }
+    long long libm = NowNanos() - t0;
+
+    t0 = NowNanos();
+    for (int i = 0; i < iterations; i++) {
+        float angle = START_ANGLE + (END_ANGLE - START_ANGLE) * (i % 4096) / 4096.0f;
+        float s, c;
+        Geo_SinCos(angle, &s, &c);
+        Vector2 tip = { center.x + c * 110.0f, center.y + s * 110.0f };
+        Vector2 base1 = { center.x + s * 8.0f, center.y - c * 8.0f };
+        Vector2 base2 = { center.x - s * 8.0f, center.y + c * 8.0f };
+        sink = tip.x + tip.y + base1.x + base1.y + base2.x + base2.y;
+    }
+    long long table = NowNanos() - t0;
+    printf("needle    libm %7.1f ns   table %7.1f ns   %.1fx\n", (double)libm / iterations,
+           (double)table / iterations, (double)libm / table);
+}
+
+static void Faces(int iterations) {
+    int frames = iterations / 1000 > 0 ? iterations / 1000 : 1;
+    Vector2 center = { 280.0f, 280.0f };
+
+    long long t0 = NowNanos();
+    for (int f = 0; f < frames; f++) {
+        batchCount = 0;
+        FaceLibm(center);
+    }
+    long long libm = NowNanos() - t0;
+    int libmVertices = batchCount;
+
+    t0 = NowNanos();
+    GeoMesh mesh = BuildFace();
+    long long build = NowNanos() - t0;
+
+    t0 = NowNanos();
+    for (int f = 0; f < frames; f++) {
+        batchCount = 0;
+        FaceMesh(&mesh, center);
+    }
+    long long table = NowNanos() - t0;
+    printf("face      libm %7.1f us   mesh %7.1f us   %.1fx   (%d / %d vertices, mesh built once in %.1f us)\n",
+           libm / 1e3 / frames, table / 1e3 / frames, (double)libm / table, libmVertices, mesh.count, build / 1e3);
+    Geo_FreeMesh(&mesh);
+}
+
+int main(int argc, char** argv) {
+    int iterations = 2000000;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:")) != -1) {
+        switch (opt) {
+            case 'n': iterations = atoi(optarg); break;
+            default:
+                fprintf(stderr, "usage: %s [-n iterations]\n", argv[0]);
+                return 1;
+        }
+    }
+    if (iterations < 1) iterations = 1;
+
+    Geo_Init();
+    Accuracy();
+    Needles(iterations);
+    Faces(iterations);
+    return 0;
+}
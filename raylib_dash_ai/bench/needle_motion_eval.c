@@ -0,0 +1,195 @@
+// Needle motion against ground truth: replays a trace as the dashboard would
+// see it (samples at the poll rate, each arriving with latency and jitter),
+// draws frames at several frame rates with jittered frame times, and measures
+// how far each motion model's needle is from the true value at every frame.
+//
+// Models: the old per-frame smoothing (x += (target - x) * 0.1, blind to dt),
+// the spring and the one-euro filter from needle_motion.c, each with and
+// without extrapolation. Reported per PID and frame rate: RMS error and 95th
+// percentile of the absolute error, in the PID's unit, after a 2 s warm-up.
+// A model that is frame-rate independent shows the same numbers in every
+// column.
+//
+// Build: gcc -O2 bench/needle_motion_eval.c needle_motion.c elm327_emu.c obd_pids.c can_signals.c
+//        -o needle_motion_eval -lpthread -lm
+// Usage: ./needle_motion_eval [-t trace] [-d seconds] [-l latency_ms] [-j jitter_ms] [-p pid]
+//   -t    trace in the emulator's format (default: signals/drive.trace;
+//         "-t synthetic" for the emulator's built-in drive cycle)
+
+#include "../needle_motion.h"
+#include "../elm327_emu.h"
+#include "../obd_pids.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+
+#define WARMUP_S 2.0
+
+static const struct { uint8_t pid; float hz; float legacy_gain; } CHANNELS[] = {
+    { 0x0C, 20.0f, 0.1f },   // The dashboard's poll rates and old smoothing factors
+    { 0x0D, 10.0f, 0.1f },
+    { 0x05, 0.5f, 0.05f },
+};
+#define NUM_CHANNELS (int)(sizeof(CHANNELS) / sizeof(CHANNELS[0]))
+
+static const int FRAME_RATES[] = { 20, 30, 60, 144 };
+#define NUM_FRAME_RATES (int)(sizeof(FRAME_RATES) / sizeof(FRAME_RATES[0]))
+
+enum { MODEL_LEGACY, MODEL_SPRING, MODEL_SPRING_LEAD, MODEL_EURO, MODEL_EURO_LEAD, NUM_MODELS };
+static const char* MODEL_NAMES[NUM_MODELS] = {
+    "per-frame 0.1", "spring", "spring + lead", "one-euro", "one-euro + lead",
+};
+
+static unsigned int rng = 12345;
+
+static float Random01(void) {
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return (rng & 0xFFFFFF) / (float)0x1000000;
+}
+
+static int CompareFloat(const void* a, const void* b) {
+    float x = *(const float*)a, y = *(const float*)b;
+    return (x > y) - (x < y);
+}
+
+static NeedleTuning ModelTuning(int model, uint8_t pid) {
+    NeedleTuning tuning = Needle_DefaultTuning(pid);
+    bool lead = model == MODEL_SPRING_LEAD || model == MODEL_EURO_LEAD;
+    if (!lead) tuning.max_lead_s = 0.0f;
+    if (model == MODEL_EURO || model == MODEL_EURO_LEAD) {
+        // Same time constant at rest as the spring's response, opening up with speed
+        tuning.filter = NEEDLE_ONE_EURO;
+        tuning.min_cutoff_hz = 1.0f / (2.0f * (float)M_PI * tuning.response_s / 2.3f);
+        tuning.beta = pid == 0x0C ? 0.002f : 0.05f;
+    }
+    return tuning;
+}
+
+typedef struct {
+    double rms;
+    double p95;
+} ErrorStats;
+
+// One channel, one model, one frame rate
+static ErrorStats Evaluate(const ELMEmulator* truth, int channel, int model, int fps, double duration,
+                           double latency_s, double jitter_s) {
+    uint8_t pid = CHANNELS[channel].pid;
+    double period = 1.0 / CHANNELS[channel].hz;
+    NeedleTuning tuning = ModelTuning(model, pid);
+    NeedleMotion needle;
+    float start = ELM_Value(truth, pid, 0.0);
+    Needle_Init(&needle, &tuning, start);
+    float legacy = start;
+    float target = start;
+
+    int max_frames = (int)(duration * fps) + 1;
+    float* errors = malloc(sizeof(float) * max_frames);
+    int count = 0;
+    double sum_sq = 0.0;
+
+    // Next sample: polled at the channel's rate, arriving latency + jitter later
+    double next_poll = 0.0;
+    double next_arrival = latency_s + Random01() * jitter_s;
+
+    for (double t = 0.0; t < duration;) {
+        while (next_arrival <= t) {
+            float value = ELM_Value(truth, pid, next_arrival - latency_s);
+            Needle_AddSample(&needle, (long long)(next_arrival * 1e6), value);
+            target = value;
+            next_poll += period;
+            double arrival = next_poll + latency_s + Random01() * jitter_s;
+            next_arrival = arrival > next_arrival ? arrival : next_arrival + 1e-4;
+        }
+
+        long long now_us = (long long)(t * 1e6);
+        float shown;
+        if (model == MODEL_LEGACY) {
+            legacy += (target - legacy) * CHANNELS[channel].legacy_gain;
+            shown = legacy;
+        } else {
+            shown = Needle_Update(&needle, now_us);
+        }
+
+        if (t >= WARMUP_S) {
+            float error = shown - ELM_Value(truth, pid, t);
+            sum_sq += (double)error * error;
+            errors[count++] = fabsf(error);
+        }
+        // Frame times vary by +-25% around 1/fps
+        t += (1.0 / fps) * (0.75 + 0.5 * Random01());
+    }
+
+    ErrorStats stats = { 0.0, 0.0 };
+    if (count > 0) {
+        qsort(errors, count, sizeof(float), CompareFloat);
+        stats.rms = sqrt(sum_sq / count);
+        stats.p95 = errors[(int)(0.95 * (count - 1))];
+    }
+    free(errors);
+    return stats;
+}
+
+int main(int argc, char** argv) {
+    const char* trace_path = "signals/drive.trace";
+    double duration = 0.0;
+    double latency_ms = 50.0;
+    double jitter_ms = 20.0;
+    int only_pid = -1;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "t:d:l:j:p:")) != -1) {
+        switch (opt) {
+            case 't': trace_path = optarg; break;
+            case 'd': duration = atof(optarg); break;
+            case 'l': latency_ms = atof(optarg); break;
+            case 'j': jitter_ms = atof(optarg); break;
+            case 'p': only_pid = (int)strtol(optarg, NULL, 16); break;
+            default:
+                fprintf(stderr, "usage: %s [-t trace|synthetic] [-d seconds] [-l latency_ms] [-j jitter_ms] [-p pid]\n",
+                        argv[0]);
+                return 1;
+        }
+    }
+
+    // The emulator's trace lookup is the ground truth; it is never started
+    static ELMEmulator truth;
+    memset(&truth, 0, sizeof(truth));
+    truth.config.trace_loop = true;
+    if (strcmp(trace_path, "synthetic") != 0) {
+        if (!ELM_LoadTrace(&truth.trace, trace_path)) {
+            fprintf(stderr, "cannot load trace %s\n", trace_path);
+            return 1;
+        }
+        if (duration <= 0.0) duration = truth.trace.duration_s;
+    }
+    if (duration <= 0.0) duration = 60.0;
+
+    printf("%s, %.0f s, latency %.0f ms + 0-%.0f ms jitter, frame times +-25%%\n", trace_path, duration,
+           latency_ms, jitter_ms);
+    for (int c = 0; c < NUM_CHANNELS; c++) {
+        if (only_pid >= 0 && CHANNELS[c].pid != only_pid) continue;
+        const OBDPIDInfo* info = OBD_GetPIDInfo(CHANNELS[c].pid);
+        printf("\nPID %02X %s (%s), %.1f Hz: RMS / p95 error\n", CHANNELS[c].pid, info->name, info->unit,
+               CHANNELS[c].hz);
+        printf("%-16s", "model");
+        for (int f = 0; f < NUM_FRAME_RATES; f++) printf("   %12d FPS", FRAME_RATES[f]);
+        printf("\n");
+        for (int m = 0; m < NUM_MODELS; m++) {
+            printf("%-16s", MODEL_NAMES[m]);
+            for (int f = 0; f < NUM_FRAME_RATES; f++) {
+                rng = 12345;   // Same sample jitter for every model
+                ErrorStats e = Evaluate(&truth, c, m, FRAME_RATES[f], duration, latency_ms / 1000.0,
+                                        jitter_ms / 1000.0);
+                printf("   %7.1f / %6.1f", e.rms, e.p95);
+            }
+            printf("\n");
+        }
+    }
+
+    ELM_FreeTrace(&truth.trace);
+    return 0;
+}
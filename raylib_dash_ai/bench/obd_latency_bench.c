@@ -0,0 +1,192 @@
+// Round-trip latency of OBD_SendCommand and OBD_ReadPIDs against the ELM327
+// emulator (elm327_emu.c) at 38400 baud with a fixed ECU latency. The
+// original sleep-and-poll reader is kept here as LegacySendCommand so old and
+// new paths can be compared.
+//
+// Build: gcc bench/obd_latency_bench.c obd_reader.c obd_can.c obd_parse.c obd_pids.c obd_cache.c elm327_emu.c can_signals.c -o obd_latency_bench -lpthread -lm
+// Usage: ./obd_latency_bench [-n requests] [-l adapter_latency_ms]
+
+#define _GNU_SOURCE
+#include "../obd_reader.h"
+#include "../elm327_emu.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <termios.h>
+#include <time.h>
+
+static double NowMs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+// The reader as it was before the deadline-driven rewrite: flat 100 ms sleep,
+// then 20 ms polls, re-scanning the whole buffer for the prompt each time.
+static bool LegacySendCommand(OBDConnection* conn, const char* cmd, char* response, int response_size) {
+    tcflush(conn->fd, TCIOFLUSH);
+
+    int len = strlen(cmd);
+    if (write(conn->fd, cmd, len) != len) return false;
+
+    usleep(100000);
+
+    int total = 0;
+    int attempts = 0;
+    memset(response, 0, response_size);
+
+    while (total < response_size - 1 && attempts < 50) {
+        int n = read(conn->fd, response + total, response_size - total - 1);
+        if (n > 0) {
+            total += n;
+            if (strchr(response, '>') != NULL) break;
+        }
+        usleep(20000);
+        attempts++;
+    }
+
+    response[total] = '\0';
+    return total > 0;
+}
+
+static int CompareDouble(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static void Report(const char* name, double* samples, int count, int failures, double bytes) {
+    qsort(samples, count, sizeof(double), CompareDouble);
+    double sum = 0.0;
+    for (int i = 0; i < count; i++) sum += samples[i];
+    double mean = count ? sum / count : 0.0;
+    printf("%-12s n=%-5d mean=%8.2f ms  p50=%8.2f  p95=%8.2f  max=%8.2f  (%.1f req/s, %.0f B/reply, %d failed)\n",
+           name, count, mean,
+           count ? samples[count / 2] : 0.0,
+           count ? samples[(count * 95) / 100] : 0.0,
+           count ? samples[count - 1] : 0.0,
+           mean > 0.0 ? 1000.0 / mean : 0.0, bytes, failures);
+}
+
+// Time `requests` dashboard samples (RPM + speed + coolant) on an open connection
+static void TimeDashboardSamples(const char* name, OBDConnection* conn, ELMEmulator* emu,
+                                 double* samples, int requests) {
+    const uint8_t pids[] = { 0x0C, 0x0D, 0x05 };
+    OBDValue values[3];
+
+    int failures = 0;
+    emu->stats.bytes_sent = 0;
+    for (int i = 0; i < requests; i++) {
+        double start = NowMs();
+        if (OBD_ReadPIDs(conn, pids, 3, values) != 3) failures++;
+        samples[i] = NowMs() - start;
+    }
+    Report(name, samples, requests, failures, (double)emu->stats.bytes_sent / requests);
+}
+
+int main(int argc, char** argv) {
+    int requests = 100;
+    int latency_ms = 10;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:l:")) != -1) {
+        if (opt == 'n') requests = atoi(optarg);
+        else if (opt == 'l') latency_ms = atoi(optarg);
+        else {
+            fprintf(stderr, "usage: %s [-n requests] [-l adapter_latency_ms]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (requests < 1) requests = 1;
+
+    ELMConfig config = ELM_DefaultConfig();
+    config.ecu_latency_us = latency_ms * 1000;
+    ELMEmulator emu;
+    if (!ELM_Start(&emu, &config)) return 1;
+    const char* slave_path = emu.slave_path;
+
+    double* samples = malloc(sizeof(double) * requests);
+    char response[256];
+
+    printf("ELM327 emulator on %s, ECU latency %d ms, %d baud, %d requests each\n\n",
+           slave_path, latency_ms, config.baud, requests);
+
+    // Bare profile: only ATZ/ATE0/ATSP0, as OBD_Init used to send
+    OBDInitProfile bare = { .adaptive_timing = -1 };
+    OBDConnection conn = {0};
+    if (!OBD_InitWithProfile(&conn, slave_path, &bare)) {
+        fprintf(stderr, "OBD_Init failed on %s\n", slave_path);
+        return 1;
+    }
+
+    printf("Single PID (010C), bare adapter settings:\n");
+    int failures = 0;
+    emu.stats.bytes_sent = 0;
+    for (int i = 0; i < requests; i++) {
+        double start = NowMs();
+        if (!LegacySendCommand(&conn, "010C\r", response, sizeof(response))) failures++;
+        samples[i] = NowMs() - start;
+    }
+    Report("legacy", samples, requests, failures, (double)emu.stats.bytes_sent / requests);
+
+    failures = 0;
+    emu.stats.bytes_sent = 0;
+    for (int i = 0; i < requests; i++) {
+        double start = NowMs();
+        if (OBD_SendCommand(&conn, "010C\r", response, sizeof(response)) != OBD_OK) failures++;
+        samples[i] = NowMs() - start;
+    }
+    Report("deadline", samples, requests, failures, (double)emu.stats.bytes_sent / requests);
+
+    printf("\nDashboard sample (RPM + speed + coolant):\n");
+    conn.multi_pid = false;
+    TimeDashboardSamples("bare 3x1", &conn, &emu, samples, requests);
+    conn.multi_pid = true;
+    TimeDashboardSamples("bare batched", &conn, &emu, samples, requests);
+    OBD_Close(&conn);
+
+    // Default low-latency profile (without the vehicle cache here)
+    OBDInitProfile tuned = OBD_DefaultProfile();
+    tuned.cache_path = NULL;
+    if (!OBD_InitWithProfile(&conn, slave_path, &tuned)) {
+        fprintf(stderr, "OBD_Init failed on %s\n", slave_path);
+        return 1;
+    }
+    TimeDashboardSamples("tuned", &conn, &emu, samples, requests);
+    OBD_Close(&conn);
+
+    // Headers on, for multi-ECU parsing (no response-count suffix)
+    OBDInitProfile headers = tuned;
+    headers.headers = true;
+    if (!OBD_InitWithProfile(&conn, slave_path, &headers)) {
+        fprintf(stderr, "OBD_Init failed on %s\n", slave_path);
+        return 1;
+    }
+    TimeDashboardSamples("tuned+ATH1", &conn, &emu, samples, requests);
+    OBD_Close(&conn);
+
+    // Connect time: protocol search and PID discovery, then the cached path
+    const char* cache_path = "obd_latency_bench.cache";
+    OBDInitProfile cached = OBD_DefaultProfile();
+    cached.cache_path = cache_path;
+    remove(cache_path);
+
+    printf("\nConnect (ATSP0 search modelled as %d ms):\n", config.search_ms);
+    for (int run = 0; run < 2; run++) {
+        double start = NowMs();
+        bool ok = OBD_InitWithProfile(&conn, slave_path, &cached);
+        double elapsed = NowMs() - start;
+        if (!ok) {
+            fprintf(stderr, "OBD_Init failed on %s\n", slave_path);
+            return 1;
+        }
+        printf("%-12s %8.2f ms  (%s)\n", run == 0 ? "cold" : "cached", elapsed,
+               conn.pids_known ? "PIDs known" : "PIDs unknown");
+        OBD_Close(&conn);
+    }
+    remove(cache_path);
+
+    ELM_Stop(&emu);
+    free(samples);
+    return 0;
+}
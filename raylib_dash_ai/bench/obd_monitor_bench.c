@@ -0,0 +1,250 @@
+// Sustained monitor-mode ingest: obd_monitor.c against the ELM327 emulator
+// replaying a candump log as bus traffic, at several serial rates, with and
+// without the adapter's receive filter.
+//
+// Per run it reports the frame rate on the bus, the rate the adapter printed
+// (what got through its filter and the serial link), the rate ingested and
+// decoded, samples/s, BUFFER FULL overruns, garbled lines and CPU time per
+// ingested frame. Without -f a synthetic log is generated: the signal set's
+// IDs at 50 Hz each plus filler IDs up to -r frames/s.
+//
+// Build: gcc -O2 bench/obd_monitor_bench.c obd_monitor.c obd_reader.c obd_can.c obd_parse.c obd_pids.c
+//        obd_cache.c can_signals.c elm327_emu.c -o obd_monitor_bench -lpthread -lm
+// Usage: ./obd_monitor_bench [-s signal_file] [-f candump_log] [-r frames_per_s] [-t seconds]
+//                            [-b baud] [-M monitor_buffer] [-S]
+//   -b    one serial rate instead of 38400, 115200, 500000 and unpaced
+//   -S    the emulator identifies as an STN11xx (STMA)
+
+#define _GNU_SOURCE
+#include "../obd_monitor.h"
+#include "../elm327_emu.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define FILLER_IDS 48
+
+static double ThreadCPUSeconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void OnSample(void* user, const OBDValue* value, long long timestamp_us) {
+    (void)value;
+    (void)timestamp_us;
+    (*(long*)user)++;
+}
+
+// Two seconds of bus: every signal ID at 50 Hz, filler IDs (0x100 + 7k) for
+// the rest of the frame rate. Returns the frames per second written.
+static double WriteSyntheticLog(const char* path, const CANSignalSet* set, int frames_per_s) {
+    FILE* file = fopen(path, "w");
+    if (!file) return 0.0;
+
+    uint32_t ids[CAN_MAX_SIGNALS + FILLER_IDS];
+    double hz[CAN_MAX_SIGNALS + FILLER_IDS];
+    int num_ids = 0;
+    double signal_hz = 0.0;
+    for (int i = 0; i < set->num_signals; i++) {
+        if (num_ids > 0 && ids[num_ids - 1] == set->signals[i].can_id) continue;
+        ids[num_ids] = set->signals[i].can_id;
+        hz[num_ids++] = 50.0;
+        signal_hz += 50.0;
+    }
+    double filler_hz = frames_per_s > signal_hz ? (frames_per_s - signal_hz) / FILLER_IDS : 0.0;
+    for (int k = 0; k < FILLER_IDS && filler_hz > 0.0; k++) {
+        ids[num_ids] = 0x100 + 7 * k;
+        hz[num_ids++] = filler_hz;
+    }
+
+    // Merge the periodic streams in time order
+    double next[CAN_MAX_SIGNALS + FILLER_IDS];
+    for (int i = 0; i < num_ids; i++) next[i] = i * 1e-5;
+    unsigned int seed = 1;
+    long frames = 0;
+    for (;;) {
+        int first = 0;
+        for (int i = 1; i < num_ids; i++) {
+            if (next[i] < next[first]) first = i;
+        }
+        if (next[first] >= 2.0) break;
+        seed = seed * 1103515245 + 12345;
+        fprintf(file, "(%.6f) vcan0 %03X#%08X%08X\n", 1760000000.0 + next[first], ids[first],
+                seed, seed ^ 0x5A5A5A5A);
+        next[first] += 1.0 / hz[first];
+        frames++;
+    }
+    fclose(file);
+    return frames / 2.0;
+}
+
+// Frames in a log per second of log time
+static double LogRate(const char* path) {
+    FILE* file = fopen(path, "r");
+    if (!file) return 0.0;
+    char line[256];
+    double first = 0.0, last = 0.0;
+    long frames = 0;
+    while (fgets(line, sizeof(line), file)) {
+        double time_s;
+        uint32_t id;
+        bool extended;
+        uint8_t data[8];
+        int len;
+        if (!CAN_ParseCandumpLine(line, &time_s, &id, &extended, data, &len)) continue;
+        if (frames++ == 0) first = time_s;
+        last = time_s;
+    }
+    fclose(file);
+    return last > first ? (frames - 1) / (last - first) : 0.0;
+}
+
+typedef struct {
+    double shown_fps;        // Printed by the adapter
+    double ingested_fps;     // Parsed by obd_monitor.c
+    double samples_per_s;
+    unsigned long overruns;
+    unsigned long bad_lines;
+    double cpu_us_per_frame;
+} Result;
+
+static bool Run(const char* log_path, const CANSignalSet* set, int baud, bool filter,
+                int monitor_buffer, bool stn, double seconds, Result* result) {
+    ELMConfig config = ELM_DefaultConfig();
+    config.baud = baud;
+    config.candump_path = log_path;
+    config.monitor_buffer = monitor_buffer;
+    config.stn = stn;
+    config.search_ms = 0;
+
+    ELMEmulator emu;
+    if (!ELM_Start(&emu, &config)) return false;
+
+    OBDInitProfile profile = OBD_DefaultProfile();
+    profile.cache_path = NULL;
+    OBDConnection conn = {0};
+    if (!OBD_InitWithProfile(&conn, emu.slave_path, &profile)) {
+        fprintf(stderr, "OBD_Init failed on %s\n", emu.slave_path);
+        ELM_Stop(&emu);
+        return false;
+    }
+
+    long samples = 0;
+    OBDMonitor mon;
+    if (!OBD_MonitorStart(&mon, &conn, set, filter, OnSample, &samples)) {
+        OBD_Close(&conn);
+        ELM_Stop(&emu);
+        return false;
+    }
+
+    long shown_start = emu.stats.monitor_frames;
+    double cpu_start = ThreadCPUSeconds();
+    long long start = OBD_NowMicros();
+    long long end = start + (long long)(seconds * 1e6);
+    while (OBD_NowMicros() < end) {
+        if (OBD_MonitorStep(&mon, 50) < 0) break;
+    }
+    double elapsed = (OBD_NowMicros() - start) / 1e6;
+    double cpu = ThreadCPUSeconds() - cpu_start;
+    long shown = emu.stats.monitor_frames - shown_start;
+
+    OBD_MonitorStop(&mon);
+    OBD_Close(&conn);
+    ELM_Stop(&emu);
+
+    result->shown_fps = shown / elapsed;
+    result->ingested_fps = mon.frames / elapsed;
+    result->samples_per_s = samples / elapsed;
+    result->overruns = mon.overruns;
+    result->bad_lines = mon.bad_lines;
+    result->cpu_us_per_frame = mon.frames ? cpu * 1e6 / mon.frames : 0.0;
+    return true;
+}
+
+static void Usage(const char* name) {
+    fprintf(stderr, "usage: %s [-s signal_file] [-f candump_log] [-r frames_per_s] [-t seconds]\n"
+                    "       [-b baud] [-M monitor_buffer] [-S]\n", name);
+}
+
+int main(int argc, char** argv) {
+    const char* signal_path = "signals/example.sig";
+    const char* log_path = NULL;
+    int frames_per_s = 2000;
+    double seconds = 3.0;
+    int only_baud = -1;
+    int monitor_buffer = 512;
+    bool stn = false;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "s:f:r:t:b:M:S")) != -1) {
+        switch (opt) {
+            case 's': signal_path = optarg; break;
+            case 'f': log_path = optarg; break;
+            case 'r': frames_per_s = atoi(optarg); break;
+            case 't': seconds = atof(optarg); break;
+            case 'b': only_baud = atoi(optarg); break;
+            case 'M': monitor_buffer = atoi(optarg); break;
+            case 'S': stn = true; break;
+            default:
+                Usage(argv[0]);
+                return 1;
+        }
+    }
+
+    static CANSignalSet set;
+    if (!CAN_LoadSignals(&set, signal_path)) return 1;
+
+    char generated[64] = "";
+    double bus_fps;
+    if (log_path) {
+        bus_fps = LogRate(log_path);
+    } else {
+        snprintf(generated, sizeof(generated), "/tmp/obd_monitor_bench_%d.log", (int)getpid());
+        bus_fps = WriteSyntheticLog(generated, &set, frames_per_s);
+        if (bus_fps <= 0.0) {
+            perror(generated);
+            return 1;
+        }
+        log_path = generated;
+    }
+
+    static const int BAUDS[] = { 38400, 115200, 500000, 0 };
+    int num_bauds = only_baud >= 0 ? 1 : (int)(sizeof(BAUDS) / sizeof(BAUDS[0]));
+
+    printf("bus %.0f frames/s (%s), %d signals, %s, %d-byte monitor buffer\n", bus_fps, log_path,
+           set.num_signals, stn ? "STMA" : "ATMA", monitor_buffer);
+    printf("%8s %7s %12s %12s %10s %9s %6s %12s\n", "baud", "filter", "shown fr/s", "ingest fr/s",
+           "samples/s", "overruns", "bad", "cpu us/frame");
+    int status = 0;
+    for (int b = 0; b < num_bauds; b++) {
+        int baud = only_baud >= 0 ? only_baud : BAUDS[b];
+        for (int filter = 1; filter >= 0; filter--) {
+            // OBD_Init and OBD_Close report on stdout; keep the table clean
+            fflush(stdout);
+            int saved_stdout = dup(STDOUT_FILENO);
+            dup2(STDERR_FILENO, STDOUT_FILENO);
+            Result r;
+            bool ok = Run(log_path, &set, baud, filter, monitor_buffer, stn, seconds, &r);
+            fflush(stdout);
+            dup2(saved_stdout, STDOUT_FILENO);
+            close(saved_stdout);
+            if (!ok) {
+                status = 1;
+                continue;
+            }
+            char baud_name[16];
+            if (baud > 0) snprintf(baud_name, sizeof(baud_name), "%d", baud);
+            else snprintf(baud_name, sizeof(baud_name), "unpaced");
+            printf("%8s %7s %12.0f %12.0f %10.0f %9lu %6lu %12.2f\n", baud_name, filter ? "adapter" : "host",
+                   r.shown_fps, r.ingested_fps, r.samples_per_s, r.overruns, r.bad_lines,
+                   r.cpu_us_per_frame);
+            fflush(stdout);
+        }
+    }
+
+    if (generated[0]) unlink(generated);
+    return status;
+}
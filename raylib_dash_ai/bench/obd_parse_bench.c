@@ -0,0 +1,320 @@
+// Throughput of the reply parser in obd_parse.c against the strtol-based
+// parser it replaced (kept below as LegacyParseHex and LegacySplit*).
+//
+// Every corpus reply is first checked to decode to the same bytes with both
+// parsers, then each parser is run over the corpus repeatedly and reported in
+// MB/s of reply text.
+//
+// Build: gcc -O2 bench/obd_parse_bench.c obd_parse.c -o obd_parse_bench
+// Usage: ./obd_parse_bench [-s seconds_per_case]
+
+#include "../obd_parse.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+
+// ---- Previous parser (obd_reader.c before the table-based parser) ----
+
+// Parse hex response (e.g., "41 0C 1A F8" -> bytes)
+static bool LegacyParseHex(const char* response, unsigned char* bytes, int* num_bytes) {
+    *num_bytes = 0;
+    char temp[3] = {0};
+    const char* ptr = response;
+
+    while (*ptr) {
+        // Skip non-hex characters
+        while (*ptr && !(((*ptr >= '0') && (*ptr <= '9')) ||
+                        ((*ptr >= 'A') && (*ptr <= 'F')) ||
+                        ((*ptr >= 'a') && (*ptr <= 'f')))) {
+            ptr++;
+        }
+
+        if (!*ptr) break;
+
+        // Read two hex digits
+        temp[0] = *ptr++;
+        if (!*ptr) break;
+        temp[1] = *ptr++;
+        temp[2] = '\0';
+
+        bytes[*num_bytes] = (unsigned char)strtol(temp, NULL, 16);
+        (*num_bytes)++;
+
+        if (*num_bytes >= 64) break;  // Safety limit
+    }
+
+    return *num_bytes > 0;
+}
+
+#define LEGACY_MAX_MESSAGES 8
+
+typedef struct {
+    unsigned char bytes[64];
+    int len;
+    uint32_t ecu;            // Header of the sender (0 when headers are off)
+    int expected;            // ISO-TP total length still being reassembled (0 = complete)
+} LegacyMessage;
+
+// Split a reply into messages, one per ECU answer. Single-frame answers are one
+// line of hex; ISO-TP multi-frame answers (CAN) arrive as a byte-count line
+// such as "00A" followed by "0: ...", "1: ..." continuation lines.
+static int LegacySplitMessages(const char* response, LegacyMessage* msgs, int max_msgs) {
+    int count = 0;
+    int expected_len = 0;
+    LegacyMessage* current = NULL;
+    const char* ptr = response;
+
+    while (*ptr) {
+        // Extract one line
+        char line[128];
+        int line_len = 0;
+        while (*ptr && *ptr != '\r' && *ptr != '\n') {
+            if (line_len < (int)sizeof(line) - 1) line[line_len++] = *ptr;
+            ptr++;
+        }
+        while (*ptr == '\r' || *ptr == '\n') ptr++;
+        line[line_len] = '\0';
+
+        // Only hex, spaces and a frame-index colon are data; skip anything else
+        // ("SEARCHING...", "BUS INIT: ...OK")
+        int digits = 0;
+        bool is_data = line_len > 0;
+        const char* colon = strchr(line, ':');
+        for (int i = 0; i < line_len && is_data; i++) {
+            if (isxdigit((unsigned char)line[i])) digits++;
+            else if (line[i] != ' ' && &line[i] != colon) is_data = false;
+        }
+        if (!is_data || digits == 0) continue;
+
+        if (colon) {
+            int frame = (int)strtol(line, NULL, 16);
+            if (frame == 0) {
+                if (count >= max_msgs) break;
+                current = &msgs[count++];
+                current->len = 0;
+                current->ecu = 0;
+                current->expected = 0;
+            }
+            if (!current) continue;
+
+            unsigned char bytes[64];
+            int num_bytes = 0;
+            if (LegacyParseHex(colon + 1, bytes, &num_bytes)) {
+                for (int i = 0; i < num_bytes && current->len < (int)sizeof(current->bytes); i++) {
+                    current->bytes[current->len++] = bytes[i];
+                }
+            }
+            if (expected_len > 0 && current->len > expected_len) current->len = expected_len;
+        } else if (digits == 3 && line_len == 3) {
+            // Byte count of the multi-frame message that follows
+            expected_len = (int)strtol(line, NULL, 16);
+            current = NULL;
+        } else {
+            if (count >= max_msgs) break;
+            current = &msgs[count++];
+            current->ecu = 0;
+            current->expected = 0;
+            if (!LegacyParseHex(line, current->bytes, &current->len)) count--;
+            current = NULL;
+            expected_len = 0;
+        }
+    }
+
+    return count;
+}
+
+// Split a reply sent with headers on (ATH1). Every line starts with the
+// sender's header: 3 hex digits for 11-bit CAN, 8 for 29-bit CAN, 3 bytes
+// (priority, target, source) for the older protocols, which also end each line
+// with a checksum byte. CAN lines carry the raw ISO-TP PCI byte, so multi-frame
+// answers are reassembled here per ECU.
+static int LegacySplitHeadered(const char* response, LegacyMessage* msgs, int max_msgs,
+                                 int header_chars, bool is_can) {
+    int count = 0;
+    const char* ptr = response;
+
+    while (*ptr) {
+        // Extract one line without spaces
+        char line[128];
+        int line_len = 0;
+        bool is_data = true;
+        while (*ptr && *ptr != '\r' && *ptr != '\n') {
+            if (isxdigit((unsigned char)*ptr)) {
+                if (line_len < (int)sizeof(line) - 1) line[line_len++] = *ptr;
+            } else if (*ptr != ' ') {
+                is_data = false;
+            }
+            ptr++;
+        }
+        while (*ptr == '\r' || *ptr == '\n') ptr++;
+        line[line_len] = '\0';
+        if (!is_data || line_len <= header_chars + 2) continue;
+
+        char header[9];
+        memcpy(header, line, header_chars);
+        header[header_chars] = '\0';
+        uint32_t ecu = (uint32_t)strtoul(header, NULL, 16);
+
+        unsigned char bytes[64];
+        int num_bytes = 0;
+        if (!LegacyParseHex(line + header_chars, bytes, &num_bytes)) continue;
+
+        if (!is_can) {
+            // Drop the trailing checksum
+            if (num_bytes < 2 || count >= max_msgs) continue;
+            LegacyMessage* msg = &msgs[count++];
+            msg->ecu = ecu & 0xFF;
+            msg->expected = 0;
+            msg->len = num_bytes - 1;
+            memcpy(msg->bytes, bytes, msg->len);
+            continue;
+        }
+
+        int type = bytes[0] >> 4;
+        if (type == 0) {
+            // Single frame: PCI low nibble is the length
+            int len = bytes[0] & 0x0F;
+            if (len == 0 || len > num_bytes - 1 || count >= max_msgs) continue;
+            LegacyMessage* msg = &msgs[count++];
+            msg->ecu = ecu;
+            msg->expected = 0;
+            msg->len = len;
+            memcpy(msg->bytes, bytes + 1, len);
+        } else if (type == 1 && num_bytes >= 2) {
+            // First frame: 12-bit total length, then the first data bytes
+            if (count >= max_msgs) continue;
+            LegacyMessage* msg = &msgs[count++];
+            msg->ecu = ecu;
+            msg->expected = ((bytes[0] & 0x0F) << 8) | bytes[1];
+            if (msg->expected > (int)sizeof(msg->bytes)) msg->expected = sizeof(msg->bytes);
+            msg->len = 0;
+            for (int i = 2; i < num_bytes && msg->len < msg->expected; i++) {
+                msg->bytes[msg->len++] = bytes[i];
+            }
+        } else if (type == 2) {
+            // Consecutive frame: append to this ECU's message in progress
+            for (int m = count - 1; m >= 0; m--) {
+                LegacyMessage* msg = &msgs[m];
+                if (msg->ecu != ecu || msg->len >= msg->expected) continue;
+                for (int i = 1; i < num_bytes && msg->len < msg->expected; i++) {
+                    msg->bytes[msg->len++] = bytes[i];
+                }
+                break;
+            }
+        }
+    }
+
+    return count;
+}
+
+// ---- Benchmark ----
+
+typedef struct {
+    const char* name;
+    const char* reply;       // As OBD_SendCommand returns it (prompt stripped)
+    int header_chars;
+    bool is_can;
+} Case;
+
+static const Case CASES[] = {
+    { "single PID",        "41 0C 1A F8",                                        0, true },
+    { "single PID, ATS0",  "410C1AF8",                                           0, true },
+    { "batched 3 PIDs",    "41 0C 1A F8 0D 32 05 5A",                            0, true },
+    { "VIN multi-frame",   "014\r0: 49 02 01 31 46 54\r1: 53 54 41 4E 44 49 4E\r"
+                           "2: 30 30 30 30 30 34 32",                            0, true },
+    { "two ECUs, ATH1",    "7E8 04 41 0C 1A F8\r7E9 04 41 0C 1A F0",             3, true },
+    { "batched, ATH1",     "7E8 10 0A 41 0C 1A F8 0D 32\r7E8 21 05 5A 00 00 00 00 00", 3, true },
+    { "29-bit, ATH1",      "18DAF110 04 41 0C 1A F8",                            8, true },
+    { "ISO 9141, ATH1",    "48 6B 10 41 0C 1A F8 C5",                            6, false },
+};
+#define NUM_CASES (int)(sizeof(CASES) / sizeof(CASES[0]))
+
+static double NowSeconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int LegacySplit(const Case* c, LegacyMessage* msgs) {
+    if (c->header_chars > 0) {
+        return LegacySplitHeadered(c->reply, msgs, LEGACY_MAX_MESSAGES, c->header_chars, c->is_can);
+    }
+    return LegacySplitMessages(c->reply, msgs, LEGACY_MAX_MESSAGES);
+}
+
+static int NewSplit(const Case* c, size_t len, OBDRecord* records) {
+    OBDReplyFormat format = { .header_chars = c->header_chars, .is_can = c->is_can };
+    return OBD_SplitRecords(c->reply, len, &format, records, LEGACY_MAX_MESSAGES).records;
+}
+
+// Both parsers must agree before their speed means anything
+static bool SameResult(const Case* c) {
+    LegacyMessage old_msgs[LEGACY_MAX_MESSAGES];
+    OBDRecord records[LEGACY_MAX_MESSAGES];
+    int old_count = LegacySplit(c, old_msgs);
+    int new_count = NewSplit(c, strlen(c->reply), records);
+    if (old_count != new_count) return false;
+    for (int i = 0; i < old_count; i++) {
+        if (old_msgs[i].len != records[i].len || old_msgs[i].ecu != records[i].ecu) return false;
+        if (memcmp(old_msgs[i].bytes, records[i].bytes, records[i].len) != 0) return false;
+    }
+    return true;
+}
+
+// Run fn over the case until `seconds` pass; returns MB/s of reply text
+#define MEASURE(result, seconds, bytes, body) do {                       \
+        long iterations = 0;                                              \
+        double start = NowSeconds(), elapsed;                             \
+        do {                                                              \
+            for (int rep = 0; rep < 1000; rep++) { body; }                \
+            iterations += 1000;                                           \
+            elapsed = NowSeconds() - start;                               \
+        } while (elapsed < (seconds));                                    \
+        (result) = (double)(bytes) * iterations / elapsed / 1e6;          \
+    } while (0)
+
+int main(int argc, char** argv) {
+    double seconds = 0.5;
+    for (int i = 1; i < argc - 1; i++) {
+        if (strcmp(argv[i], "-s") == 0) seconds = atof(argv[++i]);
+    }
+
+    volatile int sink = 0;
+    bool all_same = true;
+    printf("%-18s %6s %12s %12s %12s %12s\n", "reply", "bytes",
+           "hex old", "hex new", "split old", "split new");
+
+    for (int i = 0; i < NUM_CASES; i++) {
+        const Case* c = &CASES[i];
+        size_t len = strlen(c->reply);
+        bool same = SameResult(c);
+        all_same = all_same && same;
+
+        unsigned char bytes[64];
+        int num_bytes;
+        LegacyMessage old_msgs[LEGACY_MAX_MESSAGES];
+        OBDRecord records[LEGACY_MAX_MESSAGES];
+        double hex_old, hex_new, split_old, split_new;
+
+        // Raw hex decoding of the first line (the old parser needs it copied
+        // out and NUL-terminated, which the split functions do per line)
+        size_t first_line = strcspn(c->reply, "\r");
+        char line[128];
+        memcpy(line, c->reply, first_line);
+        line[first_line] = '\0';
+        MEASURE(hex_old, seconds, first_line,
+                { LegacyParseHex(line, bytes, &num_bytes); sink += num_bytes; });
+        MEASURE(hex_new, seconds, first_line,
+                { OBD_ParseHex(c->reply, first_line, bytes, sizeof(bytes), &num_bytes); sink += num_bytes; });
+        MEASURE(split_old, seconds, len, { sink += LegacySplit(c, old_msgs); });
+        MEASURE(split_new, seconds, len, { sink += NewSplit(c, len, records); });
+
+        printf("%-18s %6zu %9.1f MB/s %7.1f MB/s %7.1f MB/s %7.1f MB/s%s\n", c->name, len,
+               hex_old, hex_new, split_old, split_new, same ? "" : "  MISMATCH");
+    }
+
+    (void)sink;
+    return all_same ? 0 : 1;
+}
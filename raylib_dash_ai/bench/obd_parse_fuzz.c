@@ -0,0 +1,205 @@
+// Fuzz harness for obd_parse.c.
+//
+// Every input is split in all four reply formats (ATH0, 11-bit CAN, 29-bit
+// CAN, older protocols) and run through OBD_ParseHex; the parser must stay
+// inside its output buffers and return consistent counts. The input bytes are
+// also formatted the way the adapter would send them and must parse back
+// unchanged. Any violation aborts, so the fuzzer records it as a crash.
+//
+// SEEDS holds replies as adapters send them and the ways multi-frame ones go
+// wrong, each with the status it must parse to; they are checked on every
+// run, and a plain build writes them out as a starting corpus.
+//
+// libFuzzer:  clang -g -O1 -fsanitize=fuzzer,address bench/obd_parse_fuzz.c obd_parse.c -o obd_parse_fuzz
+//             ./obd_parse_fuzz corpus/
+// AFL++:      afl-clang-fast -DOBD_FUZZ_MAIN -g -O1 bench/obd_parse_fuzz.c obd_parse.c -o obd_parse_fuzz
+//             afl-fuzz -i corpus -o findings -- ./obd_parse_fuzz
+// Plain run:  gcc -DOBD_FUZZ_MAIN -fsanitize=address,undefined bench/obd_parse_fuzz.c obd_parse.c -o obd_parse_fuzz
+//             ./obd_parse_fuzz file...   (or input on stdin)
+//             ./obd_parse_fuzz -w corpus   (write the seeds)
+
+#include "../obd_parse.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_RECORDS 8
+
+static const OBDReplyFormat FORMATS[] = {
+    { .header_chars = 0, .is_can = true },
+    { .header_chars = 3, .is_can = true },
+    { .header_chars = 8, .is_can = true },
+    { .header_chars = 6, .is_can = false },
+};
+
+#define CHECK(cond) do { if (!(cond)) { fprintf(stderr, "check failed: %s\n", #cond); abort(); } } while (0)
+
+typedef struct {
+    const char* name;
+    int format;              // Index into FORMATS
+    const char* reply;
+    OBDParseStatus status;
+} Seed;
+
+// VIN 1FTSTANDIN0000042 (49 02 01 + 17 characters, 20 bytes): a first frame
+// and two consecutive frames
+#define VIN_FF  "7E8 10 14 49 02 01 31 46 54\r"
+#define VIN_CF1 "7E8 21 53 54 41 4E 44 49 4E\r"
+#define VIN_CF2 "7E8 22 30 30 30 30 30 34 32\r"
+
+static const Seed SEEDS[] = {
+    { "batch_two_ecus", 1, "7E8 06 41 0C 1A F8 0D 32\r7E9 04 41 0C 1A F8\r", OBD_PARSE_OK },
+    { "vin_ath0", 0, "014\r0: 49 02 01 31 46 54\r1: 53 54 41 4E 44 49 4E\r2: 30 30 30 30 30 34 32\r",
+      OBD_PARSE_OK },
+    { "vin_ath0_swapped", 0, "014\r0: 49 02 01 31 46 54\r2: 30 30 30 30 30 34 32\r1: 53 54 41 4E 44 49 4E\r",
+      OBD_PARSE_BAD_FRAME },
+    { "vin_ath1", 1, VIN_FF VIN_CF1 VIN_CF2, OBD_PARSE_OK },
+    { "vin_ath1_swapped", 1, VIN_FF VIN_CF2 VIN_CF1, OBD_PARSE_BAD_FRAME },
+    { "vin_ath1_duplicate", 1, VIN_FF VIN_CF1 VIN_CF1 VIN_CF2, OBD_PARSE_BAD_FRAME },
+    { "vin_ath1_truncated", 1, VIN_FF VIN_CF1, OBD_PARSE_TRUNCATED },
+};
+
+#define NUM_SEEDS ((int)(sizeof(SEEDS) / sizeof(SEEDS[0])))
+
+// Good replies come back whole; a broken sequence never yields a complete
+// message with the frames in the wrong place
+static void CheckSeeds(void) {
+    for (int i = 0; i < NUM_SEEDS; i++) {
+        const Seed* seed = &SEEDS[i];
+        OBDRecord records[MAX_RECORDS];
+        OBDParseResult result =
+            OBD_SplitRecords(seed->reply, strlen(seed->reply), &FORMATS[seed->format], records, MAX_RECORDS);
+        if (result.status != seed->status) {
+            fprintf(stderr, "seed %s: %s, expected %s\n", seed->name, OBD_ParseStatusString(result.status),
+                    OBD_ParseStatusString(seed->status));
+            abort();
+        }
+        for (int r = 0; r < result.records; r++) {
+            if (seed->status == OBD_PARSE_OK) CHECK(records[r].len >= records[r].expected);
+            else CHECK(records[r].len < records[r].expected || records[r].expected == 0);
+        }
+    }
+}
+
+static void CheckSplit(const char* buf, size_t len, const OBDReplyFormat* format) {
+    OBDRecord records[MAX_RECORDS + 1];
+    memset(&records[MAX_RECORDS], 0xA5, sizeof(records[MAX_RECORDS]));
+
+    OBDParseResult result = OBD_SplitRecords(buf, len, format, records, MAX_RECORDS);
+    CHECK(result.records >= 0 && result.records <= MAX_RECORDS);
+    CHECK(result.text_lines >= 0 && result.bad_lines >= 0);
+    CHECK(result.status >= OBD_PARSE_OK && result.status <= OBD_PARSE_TRUNCATED);
+    if (result.bad_lines > 0) CHECK(result.status != OBD_PARSE_OK);
+    else CHECK(result.status == OBD_PARSE_OK || result.status == OBD_PARSE_TRUNCATED);
+    for (int i = 0; i < result.records; i++) {
+        CHECK(records[i].len >= 0 && records[i].len <= OBD_RECORD_BYTES);
+        CHECK(records[i].expected >= 0);
+        if (records[i].expected > 0) CHECK(records[i].len <= records[i].expected);
+    }
+
+    // Nothing written past the records it was given
+    OBDRecord guard;
+    memset(&guard, 0xA5, sizeof(guard));
+    CHECK(memcmp(&records[MAX_RECORDS], &guard, sizeof(guard)) == 0);
+}
+
+static void CheckHex(const char* buf, size_t len) {
+    uint8_t out[16];
+    int num_out = -1;
+    OBDParseStatus status = OBD_ParseHex(buf, len, out, sizeof(out), &num_out);
+    CHECK(num_out >= 0 && num_out <= (int)sizeof(out));
+    if (status == OBD_PARSE_OK) CHECK(num_out > 0);
+    if (status == OBD_PARSE_EMPTY) CHECK(num_out == 0);
+}
+
+// Format the input as adapter output and expect the same bytes back
+static void CheckRoundTrip(const uint8_t* data, size_t size) {
+    static const char digits[] = "0123456789ABCDEF";
+    if (size > OBD_RECORD_BYTES) size = OBD_RECORD_BYTES;
+    if (size == 0) return;
+
+    char text[OBD_RECORD_BYTES * 3 + 16];
+    int pos = 0;
+    for (size_t i = 0; i < size; i++) {
+        text[pos++] = digits[data[i] >> 4];
+        text[pos++] = digits[data[i] & 0x0F];
+        if (data[0] & 1) text[pos++] = ' ';  // ATS1 or ATS0
+    }
+
+    uint8_t out[OBD_RECORD_BYTES];
+    int num_out;
+    CHECK(OBD_ParseHex(text, pos, out, sizeof(out), &num_out) == OBD_PARSE_OK);
+    CHECK(num_out == (int)size && memcmp(out, data, size) == 0);
+
+    // As an ATH0 reply line
+    text[pos++] = '\r';
+    OBDRecord records[MAX_RECORDS];
+    OBDParseResult result = OBD_SplitRecords(text, pos, &FORMATS[0], records, MAX_RECORDS);
+    CHECK(result.status == OBD_PARSE_OK && result.records == 1);
+    CHECK(records[0].len == (int)size && memcmp(records[0].bytes, data, size) == 0);
+
+    // As an 11-bit CAN single frame from 7E8
+    int len = size > 7 ? 7 : (int)size;
+    pos = sprintf(text, "7E8 %02X", len);
+    for (int i = 0; i < len; i++) pos += sprintf(text + pos, " %02X", data[i]);
+    result = OBD_SplitRecords(text, pos, &FORMATS[1], records, MAX_RECORDS);
+    CHECK(result.status == OBD_PARSE_OK && result.records == 1);
+    CHECK(records[0].ecu == 0x7E8 && records[0].len == len && memcmp(records[0].bytes, data, len) == 0);
+}
+
+int LLVMFuzzerInitialize(int* argc, char*** argv) {
+    (void)argc;
+    (void)argv;
+    CheckSeeds();
+    return 0;
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    const char* buf = (const char*)data;
+    for (size_t i = 0; i < sizeof(FORMATS) / sizeof(FORMATS[0]); i++) CheckSplit(buf, size, &FORMATS[i]);
+    CheckHex(buf, size);
+    CheckRoundTrip(data, size);
+    return 0;
+}
+
+#ifdef OBD_FUZZ_MAIN
+static void RunFile(FILE* file) {
+    static uint8_t data[1 << 16];
+    size_t size = fread(data, 1, sizeof(data), file);
+    LLVMFuzzerTestOneInput(data, size);
+}
+
+static int WriteSeeds(const char* dir) {
+    for (int i = 0; i < NUM_SEEDS; i++) {
+        char path[512];
+        snprintf(path, sizeof(path), "%s/%s", dir, SEEDS[i].name);
+        FILE* file = fopen(path, "wb");
+        if (!file) {
+            perror(path);
+            return 1;
+        }
+        fputs(SEEDS[i].reply, file);
+        fclose(file);
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    CheckSeeds();
+    if (argc == 3 && strcmp(argv[1], "-w") == 0) return WriteSeeds(argv[2]);
+    if (argc < 2) {
+        RunFile(stdin);
+        return 0;
+    }
+    for (int i = 1; i < argc; i++) {
+        FILE* file = fopen(argv[i], "rb");
+        if (!file) {
+            perror(argv[i]);
+            return 1;
+        }
+        RunFile(file);
+        fclose(file);
+    }
+    return 0;
+}
+#endif
@@ -0,0 +1,338 @@
+// End-to-end OBD throughput and jitter: the poll scheduler (as OBDReadThread
+// runs it) against the ELM327 emulator, for a fixed time.
+//
+// Per PID and overall it reports samples/s, round-trip latency percentiles,
+// inter-sample jitter (standard deviation of the time between samples),
+// timeout rate and CPU time per sample of the polling thread. Presets model a
+// fast USB adapter, a Bluetooth adapter and a lossy Bluetooth link. With -m
+// every channel asks for 1000 Hz, which measures the link's capacity instead
+// of the dashboard's rates.
+//
+// With -c the emulated ECUs answer on a SocketCAN interface and the reader
+// talks to them through obd_can.c instead of the pty (serial rate ignored);
+// -i uses the kernel ISO-TP socket. Needs a vcan interface:
+//   sudo ip link add dev vcan0 type vcan && sudo ip link set up vcan0
+//
+// Build: gcc -O2 bench/obd_throughput_bench.c obd_reader.c obd_can.c obd_parse.c obd_pids.c obd_cache.c
+//        obd_scheduler.c elm327_emu.c can_signals.c -o obd_throughput_bench -lpthread -lm
+// Usage: ./obd_throughput_bench [-p usb|bluetooth|lossy|can] [-t seconds] [-m] [-s seed]
+//                               [-c ifname [-i]] [-f text|json|csv]
+
+#define _GNU_SOURCE
+#include "../obd_reader.h"
+#include "../obd_scheduler.h"
+#include "../elm327_emu.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+
+typedef struct {
+    const char* name;
+    int latency_ms;          // Adapter + ECU response time
+    int jitter_ms;
+    int baud;
+    float drop_rate;
+    float no_data_rate;
+    float garbage_rate;
+    int outage_period_ms;
+    int outage_ms;
+} Preset;
+
+static const Preset PRESETS[] = {
+    { "usb",        4,  1, 115200, 0.0f,  0.0f,  0.0f,  0,     0   },
+    { "bluetooth", 30, 20,  38400, 0.0f,  0.0f,  0.0f,  0,     0   },
+    { "lossy",     30, 20,  38400, 0.02f, 0.02f, 0.01f, 15000, 400 },
+    { "can",        1,  1,      0, 0.0f,  0.0f,  0.0f,  0,     0   },  // ECU timing only
+};
+#define NUM_PRESETS (int)(sizeof(PRESETS) / sizeof(PRESETS[0]))
+
+// The dashboard's channels and rates (tachometer_obd.c)
+static const struct { uint8_t pid; float hz; } CHANNELS[] = {
+    { 0x0C, 20.0f },         // RPM
+    { 0x0D, 10.0f },         // Speed
+    { 0x05, 0.5f },          // Coolant temperature
+};
+#define NUM_CHANNELS (int)(sizeof(CHANNELS) / sizeof(CHANNELS[0]))
+
+typedef struct {
+    double* values;
+    int count;
+    int capacity;
+} Series;
+
+typedef struct {
+    uint8_t pid;
+    Series rtt_ms;
+    Series interval_ms;
+    long long last_us;
+} PIDRecord;
+
+typedef struct {
+    const OBDScheduler* sched;
+    PIDRecord pids[NUM_CHANNELS];
+} Recorder;
+
+// Statistics for one PID (or all of them)
+typedef struct {
+    long samples;
+    long requests;
+    long timeouts;
+    double rate;             // Samples per second
+    double p50, p95, p99;    // Round-trip latency, ms
+    double interval_mean;    // Time between samples, ms
+    double jitter;           // Standard deviation of that time, ms
+    double interval_max;
+} Summary;
+
+static void Push(Series* series, double value) {
+    if (series->count == series->capacity) {
+        series->capacity = series->capacity ? series->capacity * 2 : 1024;
+        series->values = realloc(series->values, sizeof(double) * series->capacity);
+    }
+    series->values[series->count++] = value;
+}
+
+static void OnSample(void* user, const OBDValue* value, long long timestamp_us) {
+    Recorder* rec = (Recorder*)user;
+    for (int i = 0; i < NUM_CHANNELS; i++) {
+        PIDRecord* pid = &rec->pids[i];
+        if (pid->pid != value->pid) continue;
+        Push(&pid->rtt_ms, rec->sched->last_request_us / 1000.0);
+        if (pid->last_us) Push(&pid->interval_ms, (timestamp_us - pid->last_us) / 1000.0);
+        pid->last_us = timestamp_us;
+        return;
+    }
+}
+
+static int CompareDouble(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static double Percentile(const double* sorted, int count, double p) {
+    if (count == 0) return 0.0;
+    int index = (int)(p * (count - 1) + 0.5);
+    return sorted[index];
+}
+
+// Latency percentiles and jitter. Jitter is pooled over the PIDs given, each
+// around its own mean interval.
+static void Summarize(PIDRecord* const* pids, int num_pids, double seconds, Summary* out) {
+    memset(out, 0, sizeof(*out));
+    Series rtt = {0};
+    double sum_sq = 0.0, sum_interval = 0.0;
+    long intervals = 0;
+
+    for (int i = 0; i < num_pids; i++) {
+        const PIDRecord* pid = pids[i];
+        for (int k = 0; k < pid->rtt_ms.count; k++) Push(&rtt, pid->rtt_ms.values[k]);
+
+        double mean = 0.0;
+        for (int k = 0; k < pid->interval_ms.count; k++) mean += pid->interval_ms.values[k];
+        if (pid->interval_ms.count) mean /= pid->interval_ms.count;
+        for (int k = 0; k < pid->interval_ms.count; k++) {
+            double v = pid->interval_ms.values[k];
+            sum_sq += (v - mean) * (v - mean);
+            sum_interval += v;
+            if (v > out->interval_max) out->interval_max = v;
+        }
+        intervals += pid->interval_ms.count;
+    }
+
+    qsort(rtt.values, rtt.count, sizeof(double), CompareDouble);
+    out->samples = rtt.count;
+    out->rate = rtt.count / seconds;
+    out->p50 = Percentile(rtt.values, rtt.count, 0.50);
+    out->p95 = Percentile(rtt.values, rtt.count, 0.95);
+    out->p99 = Percentile(rtt.values, rtt.count, 0.99);
+    out->interval_mean = intervals ? sum_interval / intervals : 0.0;
+    out->jitter = intervals ? sqrt(sum_sq / intervals) : 0.0;
+    free(rtt.values);
+}
+
+static double ThreadCPUSeconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void Usage(const char* name) {
+    fprintf(stderr, "usage: %s [-p usb|bluetooth|lossy|can] [-t seconds] [-m] [-s seed]\n"
+                    "       [-c ifname [-i]] [-f text|json|csv]\n", name);
+}
+
+int main(int argc, char** argv) {
+    const Preset* preset = &PRESETS[0];
+    double seconds = 10.0;
+    bool saturate = false;
+    unsigned int seed = 1;
+    const char* format = "text";
+    const char* can_ifname = NULL;
+    bool isotp = false;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "p:t:ms:c:if:")) != -1) {
+        switch (opt) {
+            case 'p':
+                preset = NULL;
+                for (int i = 0; i < NUM_PRESETS; i++) {
+                    if (strcmp(optarg, PRESETS[i].name) == 0) preset = &PRESETS[i];
+                }
+                if (!preset) {
+                    Usage(argv[0]);
+                    return 1;
+                }
+                break;
+            case 't': seconds = atof(optarg); break;
+            case 'm': saturate = true; break;
+            case 's': seed = (unsigned int)strtoul(optarg, NULL, 10); break;
+            case 'c': can_ifname = optarg; break;
+            case 'i': isotp = true; break;
+            case 'f': format = optarg; break;
+            default:
+                Usage(argv[0]);
+                return 1;
+        }
+    }
+    if (strcmp(format, "text") != 0 && strcmp(format, "json") != 0 && strcmp(format, "csv") != 0) {
+        Usage(argv[0]);
+        return 1;
+    }
+
+    ELMConfig config = ELM_DefaultConfig();
+    config.ecu_latency_us = preset->latency_ms * 1000;
+    config.latency_jitter_us = preset->jitter_ms * 1000;
+    config.baud = preset->baud;
+    config.drop_rate = preset->drop_rate;
+    config.no_data_rate = preset->no_data_rate;
+    config.garbage_rate = preset->garbage_rate;
+    config.outage_period_ms = preset->outage_period_ms;
+    config.outage_ms = preset->outage_ms;
+    config.search_ms = 200;
+    config.seed = seed;
+
+    ELMEmulator emu;
+    if (!(can_ifname ? ELM_StartCAN(&emu, &config, can_ifname) : ELM_Start(&emu, &config))) return 1;
+
+    // OBD_Init reports on stdout; keep that out of machine-readable output
+    fflush(stdout);
+    int saved_stdout = dup(STDOUT_FILENO);
+    dup2(STDERR_FILENO, STDOUT_FILENO);
+    OBDInitProfile profile = OBD_DefaultProfile();
+    profile.cache_path = NULL;
+    profile.can_isotp = isotp;
+    OBDConnection conn = {0};
+    bool connected = OBD_InitWithProfile(&conn, emu.slave_path, &profile);
+    fflush(stdout);
+    dup2(saved_stdout, STDOUT_FILENO);
+    close(saved_stdout);
+    if (!connected) {
+        fprintf(stderr, "OBD_Init failed on %s\n", emu.slave_path);
+        ELM_Stop(&emu);
+        return 1;
+    }
+
+    OBDScheduler sched;
+    Recorder rec = { .sched = &sched };
+    OBD_SchedulerInit(&sched, &conn, OnSample, &rec);
+    for (int i = 0; i < NUM_CHANNELS; i++) {
+        rec.pids[i].pid = CHANNELS[i].pid;
+        OBD_SchedulerAddChannel(&sched, CHANNELS[i].pid, saturate ? 1000.0f : CHANNELS[i].hz);
+    }
+
+    double cpu_start = ThreadCPUSeconds();
+    long long start = OBD_NowMicros();
+    long long end = start + (long long)(seconds * 1e6);
+    while (OBD_NowMicros() < end) OBD_SchedulerStep(&sched, 50);
+    double elapsed = (OBD_NowMicros() - start) / 1e6;
+    double cpu = ThreadCPUSeconds() - cpu_start;
+
+    OBD_Close(&conn);
+    ELM_Stop(&emu);
+
+    // Per PID, then overall
+    Summary summaries[NUM_CHANNELS + 1];
+    PIDRecord* all[NUM_CHANNELS];
+    for (int i = 0; i < NUM_CHANNELS; i++) {
+        all[i] = &rec.pids[i];
+        Summarize(&all[i], 1, elapsed, &summaries[i]);
+    }
+    Summarize(all, NUM_CHANNELS, elapsed, &summaries[NUM_CHANNELS]);
+    for (int i = 0; i < sched.num_channels; i++) {
+        for (int k = 0; k < NUM_CHANNELS; k++) {
+            if (sched.channels[i].pid != CHANNELS[k].pid) continue;
+            summaries[k].requests = sched.channels[i].requests;
+            summaries[k].timeouts = sched.channels[i].timeouts;
+            summaries[NUM_CHANNELS].requests += sched.channels[i].requests;
+            summaries[NUM_CHANNELS].timeouts += sched.channels[i].timeouts;
+        }
+    }
+    const Summary* total = &summaries[NUM_CHANNELS];
+    const char* transport = can_ifname ? (isotp ? "isotp" : "socketcan") : "elm327";
+    double cpu_us = total->samples ? cpu * 1e6 / total->samples : 0.0;
+
+    if (strcmp(format, "json") == 0) {
+        printf("{\"preset\":\"%s\",\"transport\":\"%s\",\"mode\":\"%s\",\"seconds\":%.3f,\"seed\":%u,"
+               "\"cpu_us_per_sample\":%.2f,\"pids\":[",
+               preset->name, transport, saturate ? "max" : "dashboard", elapsed, seed, cpu_us);
+        for (int i = 0; i <= NUM_CHANNELS; i++) {
+            const Summary* s = &summaries[i];
+            char name[8];
+            if (i < NUM_CHANNELS) snprintf(name, sizeof(name), "%02X", CHANNELS[i].pid);
+            else snprintf(name, sizeof(name), "all");
+            printf("%s{\"pid\":\"%s\",\"samples\":%ld,\"requests\":%ld,\"samples_per_s\":%.3f,"
+                   "\"rtt_p50_ms\":%.3f,\"rtt_p95_ms\":%.3f,\"rtt_p99_ms\":%.3f,"
+                   "\"interval_mean_ms\":%.3f,\"jitter_ms\":%.3f,\"interval_max_ms\":%.3f,"
+                   "\"timeout_rate\":%.4f}",
+                   i ? "," : "", name, s->samples, s->requests, s->rate, s->p50, s->p95, s->p99,
+                   s->interval_mean, s->jitter, s->interval_max,
+                   s->requests ? (double)s->timeouts / s->requests : 0.0);
+        }
+        printf("]}\n");
+    } else if (strcmp(format, "csv") == 0) {
+        printf("preset,transport,mode,pid,samples,requests,samples_per_s,rtt_p50_ms,rtt_p95_ms,rtt_p99_ms,"
+               "interval_mean_ms,jitter_ms,interval_max_ms,timeout_rate,cpu_us_per_sample\n");
+        for (int i = 0; i <= NUM_CHANNELS; i++) {
+            const Summary* s = &summaries[i];
+            char name[8];
+            if (i < NUM_CHANNELS) snprintf(name, sizeof(name), "%02X", CHANNELS[i].pid);
+            else snprintf(name, sizeof(name), "all");
+            printf("%s,%s,%s,%s,%ld,%ld,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.4f,%.2f\n",
+                   preset->name, transport, saturate ? "max" : "dashboard", name, s->samples, s->requests,
+                   s->rate, s->p50, s->p95, s->p99, s->interval_mean, s->jitter, s->interval_max,
+                   s->requests ? (double)s->timeouts / s->requests : 0.0, cpu_us);
+        }
+    } else {
+        if (can_ifname) {
+            printf("Preset %s (%d ms latency, %d ms jitter) over %s on %s, %s rates, %.1f s\n\n",
+                   preset->name, preset->latency_ms, preset->jitter_ms, transport, can_ifname,
+                   saturate ? "max" : "dashboard", elapsed);
+        } else {
+            printf("Preset %s (%d ms latency, %d ms jitter, %d baud), %s rates, %.1f s\n\n",
+                   preset->name, preset->latency_ms, preset->jitter_ms, preset->baud,
+                   saturate ? "max" : "dashboard", elapsed);
+        }
+        printf("%-5s %8s %9s %8s %8s %8s %10s %9s %9s %8s\n", "PID", "samples", "samples/s",
+               "p50 ms", "p95 ms", "p99 ms", "interval", "jitter", "max gap", "timeout");
+        for (int i = 0; i <= NUM_CHANNELS; i++) {
+            const Summary* s = &summaries[i];
+            char name[8];
+            if (i < NUM_CHANNELS) snprintf(name, sizeof(name), "%02X", CHANNELS[i].pid);
+            else snprintf(name, sizeof(name), "all");
+            printf("%-5s %8ld %9.2f %8.2f %8.2f %8.2f %7.1f ms %6.2f ms %6.1f ms %7.2f%%\n",
+                   name, s->samples, s->rate, s->p50, s->p95, s->p99, s->interval_mean,
+                   s->jitter, s->interval_max,
+                   s->requests ? 100.0 * s->timeouts / s->requests : 0.0);
+        }
+        printf("\nCPU (polling thread): %.1f us per sample\n", cpu_us);
+    }
+
+    for (int i = 0; i < NUM_CHANNELS; i++) {
+        free(rec.pids[i].rtt_ms.values);
+        free(rec.pids[i].interval_ms.values);
+    }
+    return 0;
+}
@@ -0,0 +1,179 @@
+// Headless gauge rendering benchmark.
+//
+// Renders the dashboard's gauges into an offscreen framebuffer (a
+// render texture the size of each target screen) for a number of frames,
+// the needles sweeping through a scripted drive: with the faces built from
+// shapes every frame, with the faces cached in textures, and with the
+// distance field shader (when it compiles on this GL).
+// Screens are dashboard layouts (dash_layout.h): by default the profiles in
+// layouts/, one per target screen, with the gauges sized for it.
+//
+// Reported per screen and mode:
+//   per gauge   CPU time to build and submit it (including its share of the
+//               batch flush), GL draw calls and vertices
+//   per frame   frames/s, with mean and p99 CPU time of the gauges
+//
+// Draw calls and vertices are read from a private rlgl render batch that
+// is large enough never to flush on its own, so each gauge's batch holds
+// exactly what it drew. The exception is the shader's quad: switching
+// shaders flushes it on the spot, so it is one draw call (6 vertices) more
+// than the shader run reports.
+//
+// No GPU needed: the window is hidden, and Mesa's llvmpipe renders it on the
+// CPU under Xvfb (LIBGL_ALWAYS_SOFTWARE=1 xvfb-run ./render_bench). On a Pi,
+// run it from the console as the dashboard runs.
+//
+// Build: gcc -O2 bench/render_bench.c gauges.c gauge_geometry.c gauge_shader.c readout.c dash_layout.c
+//        -o render_bench -lraylib -lGL -lm -lpthread -ldl -lrt -lX11
+// Usage: ./render_bench [-n frames] [layout...]
+
+#include "../gauges.h"
+#include "../dash_layout.h"
+#include "../raylib/src/rlgl.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+
+// Quads the private batch holds: far more than a frame needs
+#define BATCH_ELEMENTS 65536
+
+typedef struct {
+    long long ns;
+    long draw_calls;
+    long vertices;
+} GaugeCost;
+
+typedef enum { RUN_IMMEDIATE, RUN_CACHED, RUN_SHADER } RunMode;
+
+static const char* DEFAULT_LAYOUTS[] = {
+    "layouts/480x320.layout",
+    "layouts/800x480.layout",
+    "layouts/desktop.layout",
+};
+
+static const char* KIND_NAMES[] = { "tach", "speed", "temp" };
+static const char* RUN_NAMES[] = { "immediate", "cached", "shader" };
+
+static long long NowNanos(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static int CompareLong(const void* a, const void* b) {
+    long long x = *(const long long*)a, y = *(const long long*)b;
+    return (x > y) - (x < y);
+}
+
+// Revving through the gears, speed following, coolant warming up
+static void Script(int frame, Dashboard* dash) {
+    float t = frame / 60.0f;
+    int rpm = Layout_Find(dash, 0x0C), speed = Layout_Find(dash, 0x0D), temp = Layout_Find(dash, 0x05);
+    if (rpm >= 0) dash->values[rpm] = 800.0f + 3200.0f * (1.0f + sinf(t * 1.7f)) + 900.0f * sinf(t * 7.3f);
+    if (speed >= 0) dash->values[speed] = 90.0f + 80.0f * sinf(t * 0.4f);
+    if (temp >= 0) dash->values[temp] = 60.0f + 45.0f * (1.0f - expf(-t / 20.0f));
+}
+
+static void CountBatch(const rlRenderBatch* batch, GaugeCost* cost) {
+    for (int i = 0; i < batch->drawCounter; i++) {
+        if (batch->draws[i].vertexCount == 0) continue;
+        cost->draw_calls++;
+        cost->vertices += batch->draws[i].vertexCount;
+    }
+}
+
+static void Run(const DashLayout* layout, RunMode mode, int frames, rlRenderBatch* batch, long long* frame_ns) {
+    Dashboard dash;
+    Layout_Compile(layout, &dash);
+    Gauge_UseShader(mode == RUN_SHADER);
+    for (int g = 0; g < dash.count && mode != RUN_IMMEDIATE; g++) Gauge_PrepareFace(&dash.gauges[g]);
+    RenderTexture2D target = LoadRenderTexture(layout->width, layout->height);
+
+    GaugeCost cost[LAYOUT_MAX_GAUGES] = {0};
+    long long start = NowNanos();
+    for (int f = 0; f < frames; f++) {
+        Script(f, &dash);
+
+        BeginTextureMode(target);
+        ClearBackground((Color){15, 15, 25, 255});
+        rlSetRenderBatchActive(batch);
+        frame_ns[f] = 0;
+        for (int g = 0; g < dash.count; g++) {
+            long long t0 = NowNanos();
+            Gauge_Draw(&dash.gauges[g], dash.values[g]);
+            if (f == 0) CountBatch(batch, &cost[g]);
+            rlDrawRenderBatch(batch);
+            long long ns = NowNanos() - t0;
+            cost[g].ns += ns;
+            frame_ns[f] += ns;
+        }
+        rlSetRenderBatchActive(NULL);
+        EndTextureMode();
+
+        // Swap so the frame actually gets rendered
+        BeginDrawing();
+        EndDrawing();
+    }
+    double seconds = (NowNanos() - start) / 1e9;
+
+    for (int g = 0; g < dash.count; g++) {
+        printf("  %-10s %-6s %8.1f us  %4ld draw calls  %6ld vertices\n", g == 0 ? RUN_NAMES[mode] : "",
+               KIND_NAMES[dash.gauges[g].kind], cost[g].ns / 1e3 / frames, cost[g].draw_calls, cost[g].vertices);
+    }
+    qsort(frame_ns, frames, sizeof(long long), CompareLong);
+    long long sum = 0;
+    for (int f = 0; f < frames; f++) sum += frame_ns[f];
+    printf("  %-10s %-6s %8.3f ms mean, %.3f ms p99   %7.1f frames/s\n", "", "frame", sum / 1e6 / frames,
+           frame_ns[(int)(frames * 0.99)] / 1e6, frames / seconds);
+
+    UnloadRenderTexture(target);
+    Layout_Unload(&dash);
+}
+
+int main(int argc, char** argv) {
+    int frames = 2000;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:")) != -1) {
+        switch (opt) {
+            case 'n': frames = atoi(optarg); break;
+            default:
+                fprintf(stderr, "usage: %s [-n frames] [layout...]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    const char** paths = (const char**)argv + optind;
+    int numLayouts = argc - optind;
+    if (numLayouts == 0) {
+        paths = DEFAULT_LAYOUTS;
+        numLayouts = (int)(sizeof(DEFAULT_LAYOUTS) / sizeof(DEFAULT_LAYOUTS[0]));
+    }
+    DashLayout* layouts = malloc(sizeof(DashLayout) * numLayouts);
+    for (int s = 0; s < numLayouts; s++) {
+        if (!Layout_Load(&layouts[s], paths[s])) return 1;
+    }
+
+    SetTraceLogLevel(LOG_WARNING);
+    SetConfigFlags(FLAG_WINDOW_HIDDEN);
+    InitWindow(320, 240, "render_bench");
+    rlRenderBatch batch = rlLoadRenderBatch(1, BATCH_ELEMENTS);
+    bool shader = Gauge_UseShader(true);
+
+    long long* frame_ns = malloc(sizeof(long long) * frames);
+    printf("%d frames per run; per gauge: CPU time per frame, GL draw calls and vertices in one frame\n", frames);
+    for (int s = 0; s < numLayouts; s++) {
+        printf("\n%dx%d (%s)\n", layouts[s].width, layouts[s].height, paths[s]);
+        Run(&layouts[s], RUN_IMMEDIATE, frames, &batch, frame_ns);
+        Run(&layouts[s], RUN_CACHED, frames, &batch, frame_ns);
+        if (shader) Run(&layouts[s], RUN_SHADER, frames, &batch, frame_ns);
+    }
+
+    free(frame_ns);
+    free(layouts);
+    rlUnloadRenderBatch(batch);
+    Gauge_UnloadShader();
+    CloseWindow();
+    return 0;
+}
@@ -0,0 +1,216 @@
+// Replay timing: how close to its due time each sample is delivered, at the
+// recorded speed and faster, and how fast a replay goes flat out.
+//
+// The recording is the one given with -f, or else a few minutes of the
+// emulator's drive cycle polled the way the dashboard polls it (RPM 20 Hz,
+// speed 10 Hz, coolant 0.5 Hz), written as log segments first. Each speed
+// plays for -s seconds of wall time; lateness is delivery time minus the
+// sample's timestamp (its due time). Then the same stretch is played twice
+// at 10x and the two deliveries compared: PIDs, values and offsets from the
+// start must match exactly.
+//
+// Build: gcc -O2 bench/replay_bench.c replay.c telemetry_log.c drive_archive.c elm327_emu.c obd_pids.c
+//        can_signals.c -o replay_bench -lpthread -lm
+// Usage: ./replay_bench [-f recording] [-s seconds]
+
+#include "../replay.h"
+#include "../telemetry_log.h"
+#include "../elm327_emu.h"
+#include "../obd_pids.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#define RECORDING_DIR "/tmp/replay_bench"
+#define RECORDING_SECONDS 300.0
+
+static long long NowMicros(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+static int CompareLong(const void* a, const void* b) {
+    long long x = *(const long long*)a, y = *(const long long*)b;
+    return (x > y) - (x < y);
+}
+
+static void RemoveSegments(const char* dir) {
+    DIR* d = opendir(dir);
+    if (!d) return;
+    struct dirent* entry;
+    char path[512];
+    while ((entry = readdir(d))) {
+        size_t len = strlen(entry->d_name);
+        if (len > 5 && strcmp(entry->d_name + len - 5, ".tlog") == 0) {
+            snprintf(path, sizeof(path), "%s/%s", dir, entry->d_name);
+            unlink(path);
+        }
+    }
+    closedir(d);
+}
+
+// ---- Recording ----
+
+static const struct { uint8_t pid; float hz; } CHANNELS[] = {
+    { 0x0C, 20.0f }, { 0x0D, 10.0f }, { 0x05, 0.5f },
+};
+#define NUM_CHANNELS (int)(sizeof(CHANNELS) / sizeof(CHANNELS[0]))
+
+static bool Record(const char* dir) {
+    mkdir(dir, 0755);
+    RemoveSegments(dir);
+    TLogConfig config = TLog_DefaultConfig(dir);
+    TelemetryLog log;
+    if (!TLog_Open(&log, &config)) return false;
+
+    static ELMEmulator truth;
+    long long start_us = NowMicros();
+    double next[NUM_CHANNELS] = {0};
+    unsigned int rng = 1;
+    for (;;) {
+        int c = 0;
+        for (int i = 1; i < NUM_CHANNELS; i++) if (next[i] < next[c]) c = i;
+        double t = next[c];
+        if (t >= RECORDING_SECONDS) break;
+        next[c] += 1.0 / CHANNELS[c].hz;
+
+        uint8_t data[4];
+        OBD_EncodePID(CHANNELS[c].pid, ELM_Value(&truth, CHANNELS[c].pid, t), data);
+        rng = rng * 1103515245u + 12345u;
+        long long jitter_us = (rng >> 8) % 8000;
+        while (!TLog_Write(&log, start_us + (long long)(t * 1e6) + jitter_us, CHANNELS[c].pid,
+                           OBD_DecodePID(CHANNELS[c].pid, data), TLOG_FLAG_POLLED)) {
+            usleep(1000);
+        }
+    }
+    TLog_Close(&log);
+    return true;
+}
+
+// ---- Playback ----
+
+typedef struct {
+    long long* late_us;
+    uint8_t* pid;
+    long long* offset_us;
+    float* value;
+    long count;
+    long capacity;
+    long long first_us;
+} Delivery;
+
+static void OnSample(void* user, const OBDValue* value, long long timestamp_us) {
+    long long now = NowMicros();
+    Delivery* d = (Delivery*)user;
+    if (d->count == d->capacity) return;
+    if (d->count == 0) d->first_us = timestamp_us;
+    d->late_us[d->count] = now - timestamp_us;
+    d->pid[d->count] = value->pid;
+    d->offset_us[d->count] = timestamp_us - d->first_us;
+    d->value[d->count] = value->value;
+    d->count++;
+}
+
+static void Play(Replay* replay, float speed, double seconds, Delivery* d) {
+    d->count = 0;
+    Replay_Start(replay, speed, true, OnSample, d);
+    long long end = NowMicros() + (long long)(seconds * 1e6);
+    while (NowMicros() < end && d->count < d->capacity) Replay_Step(replay, 50);
+}
+
+static void Report(const char* name, Replay* replay, float speed, double seconds, Delivery* d) {
+    long long start = NowMicros();
+    Play(replay, speed, seconds, d);
+    double elapsed = (NowMicros() - start) / 1e6;
+    if (d->count == 0) {
+        printf("%-12s nothing delivered\n", name);
+        return;
+    }
+    if (speed <= 0.0f) {
+        double recorded_rate = replay->count / (replay->duration_us / 1e6);
+        printf("%-12s %9ld samples  %10.0f /s   %.0fx the recorded rate (%lu loops)\n", name, d->count,
+               d->count / elapsed, d->count / elapsed / recorded_rate, replay->loops);
+        return;
+    }
+    qsort(d->late_us, d->count, sizeof(long long), CompareLong);
+    printf("%-12s %9ld samples  %8.1f /s   late p50 %5lld  p99 %6lld  max %7lld us\n", name, d->count,
+           d->count / elapsed, d->late_us[d->count / 2], d->late_us[(long)(d->count * 0.99)],
+           d->late_us[d->count - 1]);
+}
+
+static bool Repeatable(Replay* replay, double seconds, Delivery* a, Delivery* b) {
+    Play(replay, 10.0f, seconds, a);
+    Play(replay, 10.0f, seconds, b);
+    long n = a->count < b->count ? a->count : b->count;
+    for (long i = 0; i < n; i++) {
+        if (a->pid[i] != b->pid[i] || a->offset_us[i] != b->offset_us[i] ||
+            memcmp(&a->value[i], &b->value[i], sizeof(float)) != 0) {
+            printf("runs differ at sample %ld\n", i);
+            return false;
+        }
+    }
+    printf("two 10x runs: first %ld samples identical (pid, value, offset)\n", n);
+    return n > 0;
+}
+
+static void Allocate(Delivery* d, long capacity) {
+    memset(d, 0, sizeof(*d));
+    d->capacity = capacity;
+    d->late_us = malloc(sizeof(long long) * capacity);
+    d->pid = malloc(capacity);
+    d->offset_us = malloc(sizeof(long long) * capacity);
+    d->value = malloc(sizeof(float) * capacity);
+}
+
+static void Release(Delivery* d) {
+    free(d->late_us);
+    free(d->pid);
+    free(d->offset_us);
+    free(d->value);
+}
+
+int main(int argc, char** argv) {
+    const char* path = NULL;
+    double seconds = 5.0;
+    int opt;
+    while ((opt = getopt(argc, argv, "f:s:")) != -1) {
+        switch (opt) {
+            case 'f': path = optarg; break;
+            case 's': seconds = atof(optarg); break;
+            default:
+                fprintf(stderr, "usage: %s [-f recording] [-s seconds]\n", argv[0]);
+                return 1;
+        }
+    }
+    bool recorded = false;
+    if (!path) {
+        if (!Record(RECORDING_DIR)) return 1;
+        path = RECORDING_DIR;
+        recorded = true;
+    }
+
+    Replay replay;
+    if (!Replay_Load(&replay, path)) return 1;
+    printf("%s: %ld samples over %.1f s, %d channels; %.0f s per run\n", path, replay.count,
+           replay.duration_us / 1e6, replay.num_channels, seconds);
+
+    Delivery a, b;
+    Allocate(&a, 20000000);
+    Allocate(&b, 20000000);
+    Report("1x", &replay, 1.0f, seconds, &a);
+    Report("10x", &replay, 10.0f, seconds, &a);
+    Report("100x", &replay, 100.0f, seconds, &a);
+    Report("flat out", &replay, 0.0f, seconds, &a);
+    bool ok = Repeatable(&replay, seconds, &a, &b);
+
+    Release(&a);
+    Release(&b);
+    Replay_Free(&replay);
+    if (recorded) RemoveSegments(RECORDING_DIR);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,204 @@
+// Contention microbenchmark: the seqlock snapshot in telemetry.c against the
+// mutex it replaced, with one writer (the OBD thread) and one reader (the
+// render loop) hammering the same channels.
+//
+// The writer publishes three channels either flat out or at a fixed rate; the
+// reader copies the snapshot in a loop and times every copy. Reported per
+// configuration: reads/s, read latency p50/p99/p99.9/max, publishes/s and
+// publish latency, and for the seqlock how often a read had to retry or kept
+// its previous copy. Tail latencies show the difference: a mutex reader waits
+// whenever the writer is descheduled holding the lock.
+//
+// Build: gcc -O2 bench/telemetry_bench.c telemetry.c -o telemetry_bench -lpthread
+// Usage: ./telemetry_bench [-t seconds] [-w writer_hz]   (writer_hz 0 = flat out;
+//                                                           default runs 0 and 1000)
+
+#define _GNU_SOURCE
+#include "../telemetry.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+
+// Every 8th duration is kept for the percentiles, the maximum is exact
+#define SAMPLE_EVERY 8
+#define MAX_SAMPLES (1 << 21)
+
+static long long NowNanos(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+typedef struct {
+    unsigned int* ns;
+    int count;
+    unsigned long total;
+    long long max_ns;
+} Timings;
+
+static void Record(Timings* t, long long ns) {
+    if (ns > t->max_ns) t->max_ns = ns;
+    if (t->total++ % SAMPLE_EVERY == 0 && t->count < MAX_SAMPLES) t->ns[t->count++] = (unsigned int)ns;
+}
+
+static int CompareUInt(const void* a, const void* b) {
+    unsigned int x = *(const unsigned int*)a, y = *(const unsigned int*)b;
+    return (x > y) - (x < y);
+}
+
+static double Percentile(const Timings* t, double p) {
+    if (t->count == 0) return 0.0;
+    int i = (int)(p * (t->count - 1));
+    return t->ns[i];
+}
+
+// The lock-based version the dashboard used before
+typedef struct {
+    pthread_mutex_t lock;
+    TelemetrySnapshot snap;
+} LockedTelemetry;
+
+static void LockedPublish(LockedTelemetry* lt, uint8_t pid, float value, long long timestamp_us) {
+    pthread_mutex_lock(&lt->lock);
+    TelemetrySnapshot* snap = &lt->snap;
+    int channel = 0;
+    while (channel < snap->num_channels && snap->pid[channel] != pid) channel++;
+    if (channel == snap->num_channels && channel < TELEMETRY_MAX_CHANNELS) {
+        snap->pid[channel] = pid;
+        snap->num_channels++;
+    }
+    if (channel < TELEMETRY_MAX_CHANNELS) {
+        snap->value[channel] = value;
+        snap->timestamp_us[channel] = timestamp_us;
+        snap->valid |= 1u << channel;
+        snap->updates++;
+    }
+    pthread_mutex_unlock(&lt->lock);
+}
+
+typedef struct {
+    bool use_mutex;
+    int writer_hz;
+    volatile bool running;
+    Telemetry telemetry;
+    LockedTelemetry locked;
+    Timings write_times;
+    Timings read_times;
+    unsigned long read_failures;
+} Bench;
+
+static void* Writer(void* arg) {
+    Bench* b = (Bench*)arg;
+    static const uint8_t PIDS[] = { 0x0C, 0x0D, 0x05 };
+    long long next = NowNanos();
+    long long period = b->writer_hz > 0 ? 1000000000LL / b->writer_hz : 0;
+    unsigned int n = 0;
+
+    while (b->running) {
+        if (period > 0) {
+            next += period;
+            long long wait = next - NowNanos();
+            if (wait > 0) {
+                struct timespec ts = { .tv_sec = wait / 1000000000LL, .tv_nsec = wait % 1000000000LL };
+                nanosleep(&ts, NULL);
+            }
+        }
+        uint8_t pid = PIDS[n++ % 3];
+        long long start = NowNanos();
+        if (b->use_mutex) LockedPublish(&b->locked, pid, (float)n, start / 1000);
+        else Telemetry_Publish(&b->telemetry, pid, (float)n, start / 1000);
+        Record(&b->write_times, NowNanos() - start);
+    }
+    return NULL;
+}
+
+static void* Reader(void* arg) {
+    Bench* b = (Bench*)arg;
+    TelemetrySnapshot snap;
+    memset(&snap, 0, sizeof(snap));
+    volatile float sink = 0.0f;
+
+    while (b->running) {
+        long long start = NowNanos();
+        if (b->use_mutex) {
+            pthread_mutex_lock(&b->locked.lock);
+            snap = b->locked.snap;
+            pthread_mutex_unlock(&b->locked.lock);
+        } else if (!Telemetry_Read(&b->telemetry, &snap)) {
+            b->read_failures++;
+        }
+        Record(&b->read_times, NowNanos() - start);
+        sink = snap.value[0];
+    }
+    (void)sink;
+    return NULL;
+}
+
+static void Run(bool use_mutex, int writer_hz, double seconds) {
+    static Bench b;
+    static unsigned int write_ns[MAX_SAMPLES], read_ns[MAX_SAMPLES];
+    memset(&b, 0, sizeof(b));
+    b.use_mutex = use_mutex;
+    b.writer_hz = writer_hz;
+    b.running = true;
+    b.write_times.ns = write_ns;
+    b.read_times.ns = read_ns;
+    Telemetry_Init(&b.telemetry);
+    pthread_mutex_init(&b.locked.lock, NULL);
+
+    pthread_t writer, reader;
+    pthread_create(&writer, NULL, Writer, &b);
+    pthread_create(&reader, NULL, Reader, &b);
+    struct timespec pause = { .tv_sec = (time_t)seconds, .tv_nsec = (long)((seconds - (time_t)seconds) * 1e9) };
+    nanosleep(&pause, NULL);
+    b.running = false;
+    pthread_join(writer, NULL);
+    pthread_join(reader, NULL);
+    pthread_mutex_destroy(&b.locked.lock);
+
+    qsort(b.read_times.ns, b.read_times.count, sizeof(unsigned int), CompareUInt);
+    qsort(b.write_times.ns, b.write_times.count, sizeof(unsigned int), CompareUInt);
+
+    char writer_name[16];
+    if (writer_hz > 0) snprintf(writer_name, sizeof(writer_name), "%d Hz", writer_hz);
+    else snprintf(writer_name, sizeof(writer_name), "flat out");
+    printf("%-8s %-9s %10.0f %7.0f %7.0f %8.0f %10.1f %11.0f %7.0f %9lu %8lu\n",
+           use_mutex ? "mutex" : "seqlock", writer_name, b.read_times.total / seconds,
+           Percentile(&b.read_times, 0.50), Percentile(&b.read_times, 0.99),
+           Percentile(&b.read_times, 0.999), b.read_times.max_ns / 1000.0,
+           b.write_times.total / seconds, Percentile(&b.write_times, 0.50),
+           use_mutex ? 0UL : (unsigned long)atomic_load(&b.telemetry.read_retries), b.read_failures);
+    fflush(stdout);
+}
+
+int main(int argc, char** argv) {
+    double seconds = 2.0;
+    int writer_hz = -1;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "t:w:")) != -1) {
+        switch (opt) {
+            case 't': seconds = atof(optarg); break;
+            case 'w': writer_hz = atoi(optarg); break;
+            default:
+                fprintf(stderr, "usage: %s [-t seconds] [-w writer_hz]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    printf("%ld CPU%s, snapshot %zu bytes\n", sysconf(_SC_NPROCESSORS_ONLN),
+           sysconf(_SC_NPROCESSORS_ONLN) == 1 ? "" : "s", sizeof(TelemetrySnapshot));
+    printf("%-8s %-9s %10s %7s %7s %8s %10s %11s %7s %9s %8s\n", "mode", "writer", "reads/s",
+           "p50 ns", "p99 ns", "p99.9 ns", "max us", "publishes/s", "pub ns", "retries", "kept");
+    const int rates[] = { 0, 1000 };
+    int num_rates = writer_hz >= 0 ? 1 : 2;
+    for (int r = 0; r < num_rates; r++) {
+        int hz = writer_hz >= 0 ? writer_hz : rates[r];
+        Run(true, hz, seconds);
+        Run(false, hz, seconds);
+    }
+    return 0;
+}
@@ -0,0 +1,175 @@
+// Stress test for telemetry.c: one writer publishing as fast as it can,
+// several readers copying snapshots, and a check of every copy for tearing.
+// Meant to run under ThreadSanitizer, which reports any access the seqlock
+// leaves unordered; the consistency checks catch copies that mix two
+// snapshots even where TSan has nothing to say.
+//
+// Every snapshot the writer publishes is derived from one counter n: channel
+// i holds n + i with timestamp n * 16 + i, the link status carries n in each
+// of its fields. A reader that sees anything else has a torn copy. Values
+// must also never go backwards for a reader.
+//
+// Build: gcc -O1 -g -fsanitize=thread bench/telemetry_stress.c telemetry.c -o telemetry_stress -lpthread
+// Usage: ./telemetry_stress [-t seconds] [-r readers]
+// Exit status 1 on any torn or stale copy.
+
+#include "../telemetry.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+
+#define MAX_READERS 8
+#define CHANNELS 6
+
+// Values stay exact in a float below 2^24
+#define COUNTER_WRAP (1u << 20)
+
+static Telemetry telemetry;
+static atomic_bool running;
+
+typedef struct {
+    unsigned long reads;
+    unsigned long failed;        // Gave up (kept the previous copy)
+    unsigned long link_reads;
+    unsigned long torn;
+    unsigned long backwards;
+} ReaderResult;
+
+static void* Writer(void* arg) {
+    unsigned long* published = (unsigned long*)arg;
+    unsigned int n = 0;
+    TelemetryLink link;
+    memset(&link, 0, sizeof(link));
+
+    while (atomic_load_explicit(&running, memory_order_relaxed)) {
+        n = (n + 1) % COUNTER_WRAP;
+        for (int i = 0; i < CHANNELS; i++) {
+            Telemetry_Publish(&telemetry, (uint8_t)(0x0C + i), (float)(n + i), (long long)n * 16 + i);
+        }
+        if ((n & 15) == 0) {
+            link.num_stats = 1 + n % OBD_SCHED_MAX_CHANNELS;
+            for (int i = 0; i < link.num_stats; i++) {
+                link.stats[i].pid = (uint8_t)n;
+                link.stats[i].achieved_hz = (float)n;
+            }
+            link.monitor_frames = n;
+            link.monitor_overruns = n;
+            Telemetry_PublishLink(&telemetry, &link);
+        }
+        (*published)++;
+    }
+    return NULL;
+}
+
+// Every channel of a snapshot must come from the same round of the writer.
+// The writer publishes channel by channel, so channels after the first may
+// still hold the previous round.
+static bool SnapshotConsistent(const TelemetrySnapshot* snap, unsigned int* base) {
+    if (snap->num_channels == 0) return true;
+    if (!(snap->valid & 1)) return false;
+    unsigned int n = (unsigned int)snap->value[0];
+    for (int i = 0; i < snap->num_channels; i++) {
+        if (snap->pid[i] != 0x0C + i || !(snap->valid & (1u << i))) return false;
+        unsigned int v = (unsigned int)snap->value[i] - i;
+        if (v != n && v != (n + COUNTER_WRAP - 1) % COUNTER_WRAP) return false;
+        if (snap->timestamp_us[i] != (long long)v * 16 + i) return false;
+    }
+    *base = n;
+    return true;
+}
+
+static bool LinkConsistent(const TelemetryLink* link) {
+    if (link->num_stats == 0) return true;
+    unsigned long n = link->monitor_frames;
+    if (link->monitor_overruns != n) return false;
+    if (link->num_stats != (int)(1 + n % OBD_SCHED_MAX_CHANNELS)) return false;
+    for (int i = 0; i < link->num_stats; i++) {
+        if (link->stats[i].pid != (uint8_t)n || link->stats[i].achieved_hz != (float)n) return false;
+    }
+    return true;
+}
+
+static void* Reader(void* arg) {
+    ReaderResult* result = (ReaderResult*)arg;
+    TelemetrySnapshot snap;
+    TelemetryLink link;
+    memset(&snap, 0, sizeof(snap));
+    memset(&link, 0, sizeof(link));
+    unsigned int last = 0;
+    uint32_t last_updates = 0;
+
+    while (atomic_load_explicit(&running, memory_order_relaxed)) {
+        if (!Telemetry_Read(&telemetry, &snap)) result->failed++;
+        result->reads++;
+        unsigned int base;
+        if (!SnapshotConsistent(&snap, &base)) {
+            result->torn++;
+        } else if (snap.num_channels > 0) {
+            // Forward, allowing for the counter wrapping
+            if ((base - last) % COUNTER_WRAP > COUNTER_WRAP / 2 || snap.updates - last_updates > 0x80000000u) {
+                result->backwards++;
+            }
+            last = base;
+            last_updates = snap.updates;
+        }
+
+        if ((result->reads & 7) == 0) {
+            if (Telemetry_ReadLink(&telemetry, &link)) result->link_reads++;
+            if (!LinkConsistent(&link)) result->torn++;
+        }
+    }
+    return NULL;
+}
+
+int main(int argc, char** argv) {
+    double seconds = 3.0;
+    int readers = 3;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "t:r:")) != -1) {
+        switch (opt) {
+            case 't': seconds = atof(optarg); break;
+            case 'r': readers = atoi(optarg); break;
+            default:
+                fprintf(stderr, "usage: %s [-t seconds] [-r readers]\n", argv[0]);
+                return 1;
+        }
+    }
+    if (readers < 1) readers = 1;
+    if (readers > MAX_READERS) readers = MAX_READERS;
+
+    Telemetry_Init(&telemetry);
+    atomic_store(&running, true);
+
+    unsigned long published = 0;
+    ReaderResult results[MAX_READERS];
+    memset(results, 0, sizeof(results));
+    pthread_t writer, reader_threads[MAX_READERS];
+    pthread_create(&writer, NULL, Writer, &published);
+    for (int i = 0; i < readers; i++) pthread_create(&reader_threads[i], NULL, Reader, &results[i]);
+
+    struct timespec pause = { .tv_sec = (time_t)seconds, .tv_nsec = (long)((seconds - (time_t)seconds) * 1e9) };
+    nanosleep(&pause, NULL);
+    atomic_store(&running, false);
+
+    pthread_join(writer, NULL);
+    ReaderResult total;
+    memset(&total, 0, sizeof(total));
+    for (int i = 0; i < readers; i++) {
+        pthread_join(reader_threads[i], NULL);
+        total.reads += results[i].reads;
+        total.failed += results[i].failed;
+        total.link_reads += results[i].link_reads;
+        total.torn += results[i].torn;
+        total.backwards += results[i].backwards;
+    }
+
+    printf("%lu rounds published (%d channels), %d readers\n", published, CHANNELS, readers);
+    printf("%lu snapshot reads, %lu link reads, %lu retries, %lu kept previous copy\n", total.reads,
+           total.link_reads, (unsigned long)atomic_load(&telemetry.read_retries), total.failed);
+    printf("%lu torn, %lu backwards\n", total.torn, total.backwards);
+    return (total.torn || total.backwards) ? 1 : 0;
+}
@@ -0,0 +1,182 @@
+// Stress test for timeseries.c: one writer appending as fast as it can,
+// several readers querying with TS_Latest, TS_Read and TS_Stats, and a check
+// of every result. Meant to run under ThreadSanitizer like
+// telemetry_stress.c; the checks catch results that mix overwritten samples
+// in, or that aren't samples at all, where TSan has nothing to say.
+//
+// Sample n (from 1) of every channel has timestamp n and value n mod 2^20,
+// so a result is right only if its timestamps are consecutive, each value
+// matches its timestamp, and nothing is older than the window asked for.
+// One channel has the smallest ring (16 samples): the writer laps readers
+// of it all the time, in the middle of their copies.
+//
+// Build: gcc -O1 -g -fsanitize=thread bench/timeseries_stress.c timeseries.c -o timeseries_stress -lpthread
+// Usage: ./timeseries_stress [-t seconds] [-r readers]
+// Exit status 1 on any wrong result.
+
+#include "../timeseries.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+
+#define MAX_READERS 8
+
+// Values stay exact in a float below 2^24
+#define VALUE_WRAP (1u << 20)
+
+// Small enough that the slow channel gets the minimum ring
+#define BUDGET (64u << 10)
+
+#define SMALL_PID 0x05
+#define LARGE_PID 0x0C
+
+// Longest TS_Read: more than the large ring holds
+#define MAX_READ 8192
+
+static TimeSeriesSet history;
+static atomic_bool running;
+
+typedef struct {
+    unsigned long latest;
+    unsigned long reads;
+    unsigned long short_reads;   // Lost samples to the writer (or the window)
+    unsigned long stats;
+    unsigned long wrong;
+    long long timestamps[MAX_READ];
+    float values[MAX_READ];
+} ReaderResult;
+
+static float ValueOf(long long n) {
+    return (float)(n % VALUE_WRAP);
+}
+
+static void* Writer(void* arg) {
+    unsigned long long* appended = (unsigned long long*)arg;
+    TimeSeries* small = TS_Channel(&history, SMALL_PID);
+    TimeSeries* large = TS_Channel(&history, LARGE_PID);
+    long long n = 0;
+
+    while (atomic_load_explicit(&running, memory_order_relaxed)) {
+        n++;
+        TS_Append(small, n, ValueOf(n));
+        TS_Append(large, n, ValueOf(n));
+    }
+    *appended = (unsigned long long)n;
+    return NULL;
+}
+
+static bool ReadConsistent(const long long* t, const float* v, int count, int max, long long since) {
+    if (count < 0 || count > max) return false;
+    for (int i = 0; i < count; i++) {
+        if (t[i] < since || t[i] < 1 || v[i] != ValueOf(t[i])) return false;
+        if (i > 0 && t[i] != t[i - 1] + 1) return false;
+    }
+    return true;
+}
+
+static bool StatsConsistent(const TimeSeriesStats* st, bool found, long long since) {
+    if (!found) return st->count == 0;
+    if (st->count <= 0 || st->first_us < since || st->first_us < 1) return false;
+    // Consecutive samples, newest last
+    if (st->last_us - st->first_us + 1 != st->count) return false;
+    long long lo = st->first_us % VALUE_WRAP, hi = st->last_us % VALUE_WRAP;
+    if (hi < lo) return true;    // Values wrapped inside the window
+    double mean = (lo + hi) / 2.0;
+    return st->min == (float)lo && st->max == (float)hi && st->mean > mean - 1.0 - mean * 1e-6 &&
+           st->mean < mean + 1.0 + mean * 1e-6;
+}
+
+static void* Reader(void* arg) {
+    ReaderResult* result = (ReaderResult*)arg;
+    TimeSeries* channels[] = { TS_Channel(&history, SMALL_PID), TS_Channel(&history, LARGE_PID) };
+    unsigned int seed = (unsigned int)(uintptr_t)arg;
+    long long last[2] = { 0, 0 };
+
+    while (atomic_load_explicit(&running, memory_order_relaxed)) {
+        int c = rand_r(&seed) & 1;
+        TimeSeries* series = channels[c];
+
+        long long t;
+        float v;
+        if (!TS_Latest(series, &t, &v)) continue;
+        if (v != ValueOf(t) || t < last[c]) result->wrong++;
+        last[c] = t;
+        result->latest++;
+
+        // Windows from nothing to more than the ring holds
+        long long since = t - (rand_r(&seed) % (2 * series->capacity));
+        int max = 1 + rand_r(&seed) % MAX_READ;
+        int count = TS_Read(series, since, result->timestamps, result->values, max);
+        if (!ReadConsistent(result->timestamps, result->values, count, max, since)) result->wrong++;
+        result->reads++;
+        long long wanted = t - since + 1;
+        if (wanted > max) wanted = max;
+        if (wanted > series->capacity) wanted = series->capacity;
+        if (count < wanted) result->short_reads++;
+
+        TimeSeriesStats st;
+        bool found = TS_Stats(series, since, &st);
+        if (!StatsConsistent(&st, found, since)) result->wrong++;
+        result->stats++;
+    }
+    return NULL;
+}
+
+int main(int argc, char** argv) {
+    double seconds = 3.0;
+    int readers = 3;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "t:r:")) != -1) {
+        switch (opt) {
+            case 't': seconds = atof(optarg); break;
+            case 'r': readers = atoi(optarg); break;
+            default:
+                fprintf(stderr, "usage: %s [-t seconds] [-r readers]\n", argv[0]);
+                return 1;
+        }
+    }
+    if (readers < 1) readers = 1;
+    if (readers > MAX_READERS) readers = MAX_READERS;
+
+    const TimeSeriesConfig configs[] = { { SMALL_PID, 0.01f }, { LARGE_PID, 100.0f } };
+    if (!TS_Init(&history, configs, 2, BUDGET)) {
+        fprintf(stderr, "Cannot allocate the history\n");
+        return 1;
+    }
+    atomic_store(&running, true);
+
+    unsigned long long appended = 0;
+    ReaderResult* results = calloc(readers, sizeof(ReaderResult));
+    pthread_t writer, reader_threads[MAX_READERS];
+    pthread_create(&writer, NULL, Writer, &appended);
+    for (int i = 0; i < readers; i++) pthread_create(&reader_threads[i], NULL, Reader, &results[i]);
+
+    struct timespec pause = { .tv_sec = (time_t)seconds, .tv_nsec = (long)((seconds - (time_t)seconds) * 1e9) };
+    nanosleep(&pause, NULL);
+    atomic_store(&running, false);
+
+    pthread_join(writer, NULL);
+    ReaderResult total;
+    memset(&total, 0, sizeof(total));
+    for (int i = 0; i < readers; i++) {
+        pthread_join(reader_threads[i], NULL);
+        total.latest += results[i].latest;
+        total.reads += results[i].reads;
+        total.short_reads += results[i].short_reads;
+        total.stats += results[i].stats;
+        total.wrong += results[i].wrong;
+    }
+
+    printf("%llu samples appended per channel (rings of %u and %u), %d readers\n", appended,
+           TS_Channel(&history, SMALL_PID)->capacity, TS_Channel(&history, LARGE_PID)->capacity, readers);
+    printf("%lu latest, %lu reads (%lu short: lapped by the writer), %lu stats\n", total.latest, total.reads,
+           total.short_reads, total.stats);
+    printf("%lu wrong\n", total.wrong);
+    free(results);
+    TS_Free(&history);
+    return total.wrong ? 1 : 0;
+}
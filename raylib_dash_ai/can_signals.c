@@ -0,0 +1,421 @@
+#define _GNU_SOURCE
+#include "can_signals.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+
+#ifdef __linux__
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <net/if.h>
+#include <linux/can.h>
+#include <linux/can/raw.h>
+#endif
+
+// Frames read per recvmmsg() call
+#define RECV_BATCH 32
+
+// Same clock as OBD_NowMicros, without linking the reader
+static long long NowMicros(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+// ---- Signal file ----
+
+bool CAN_ParseSignal(const char* line, CANSignal* signal) {
+    unsigned int pid;
+    char id_text[16];
+    char layout[32];
+    float scale, offset;
+    char name[CAN_SIGNAL_NAME] = "";
+
+    int fields = sscanf(line, "%x %15s %31s %f %f %31s", &pid, id_text, layout, &scale, &offset, name);
+    if (fields < 5 || pid > 0xFF) return false;
+
+    char* end;
+    unsigned long can_id = strtoul(id_text, &end, 16);
+    if (*end != '\0' || can_id > 0x1FFFFFFF) return false;
+
+    int start, length, order;
+    char sign;
+    if (sscanf(layout, "%d|%d@%d%c", &start, &length, &order, &sign) != 4) return false;
+    if (start < 0 || start > 63 || length < 1 || length > 64) return false;
+    if ((order != 0 && order != 1) || (sign != '+' && sign != '-')) return false;
+
+    memset(signal, 0, sizeof(*signal));
+    snprintf(signal->name, sizeof(signal->name), "%s", name);
+    signal->pid = (uint8_t)pid;
+    signal->can_id = (uint32_t)can_id;
+    signal->extended = can_id > 0x7FF;
+    signal->start_bit = (uint8_t)start;
+    signal->length = (uint8_t)length;
+    signal->big_endian = order == 0;
+    signal->is_signed = sign == '-';
+    signal->scale = scale;
+    signal->offset = offset;
+    signal->mask = length == 64 ? ~0ULL : (1ULL << length) - 1;
+
+    // Little endian: the frame is read as one little-endian word and the LSB
+    // sits at the start bit. Big endian: read as a big-endian word, where DBC
+    // bit 7 (MSB of byte 0) is word position 0 counting from the top.
+    int last;
+    if (signal->big_endian) {
+        int msb = (start / 8) * 8 + (7 - start % 8);
+        if (msb + length > 64) return false;
+        signal->shift = (uint8_t)(64 - msb - length);
+        last = msb + length - 1;
+    } else {
+        if (start + length > 64) return false;
+        signal->shift = (uint8_t)start;
+        last = start + length - 1;
+    }
+    signal->bytes = (uint8_t)(last / 8 + 1);
+    return true;
+}
+
+static int CompareSignals(const void* a, const void* b) {
+    const CANSignal* x = (const CANSignal*)a;
+    const CANSignal* y = (const CANSignal*)b;
+    return (x->can_id > y->can_id) - (x->can_id < y->can_id);
+}
+
+bool CAN_LoadSignals(CANSignalSet* set, const char* path) {
+    memset(set, 0, sizeof(*set));
+
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        fprintf(stderr, "Cannot open signal file %s\n", path);
+        return false;
+    }
+
+    char line[256];
+    int line_number = 0;
+    bool ok = true;
+    while (fgets(line, sizeof(line), file)) {
+        line_number++;
+        char* p = line;
+        while (isspace((unsigned char)*p)) p++;
+        if (*p == '\0' || *p == '#') continue;
+
+        if (set->num_signals == CAN_MAX_SIGNALS) {
+            fprintf(stderr, "%s:%d: more than %d signals\n", path, line_number, CAN_MAX_SIGNALS);
+            ok = false;
+            break;
+        }
+        if (!CAN_ParseSignal(p, &set->signals[set->num_signals])) {
+            fprintf(stderr, "%s:%d: bad signal definition\n", path, line_number);
+            ok = false;
+            break;
+        }
+        set->num_signals++;
+    }
+    fclose(file);
+
+    qsort(set->signals, set->num_signals, sizeof(CANSignal), CompareSignals);
+    return ok && set->num_signals > 0;
+}
+
+// ---- Decoding ----
+
+// Index of the first signal in a frame, or -1
+static int FindFrame(const CANSignalSet* set, uint32_t can_id) {
+    int lo = 0, hi = set->num_signals;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (set->signals[mid].can_id < can_id) lo = mid + 1;
+        else hi = mid;
+    }
+    return (lo < set->num_signals && set->signals[lo].can_id == can_id) ? lo : -1;
+}
+
+static float DecodeSignal(const CANSignal* signal, uint64_t little, uint64_t big) {
+    uint64_t raw = ((signal->big_endian ? big : little) >> signal->shift) & signal->mask;
+    if (signal->is_signed && signal->length < 64 && (raw >> (signal->length - 1)) & 1) {
+        raw |= ~signal->mask;  // Sign-extend
+    }
+    double value = signal->is_signed ? (double)(int64_t)raw : (double)raw;
+    return (float)(value * signal->scale + signal->offset);
+}
+
+// Decode a frame; indices[] (if given) receives each value's signal index
+static int Decode(const CANSignalSet* set, uint32_t can_id, const uint8_t* data, int len,
+                  OBDValue* out, int* indices, int max_out) {
+    int first = FindFrame(set, can_id);
+    if (first < 0) return 0;
+    if (len > 8) len = 8;
+
+    // Both byte orders of the frame, padded with zeros, once per frame
+    uint64_t little = 0, big = 0;
+    for (int i = 0; i < 8; i++) {
+        uint64_t b = i < len ? data[i] : 0;
+        little |= b << (8 * i);
+        big = (big << 8) | b;
+    }
+
+    int count = 0;
+    for (int i = first; i < set->num_signals && set->signals[i].can_id == can_id && count < max_out; i++) {
+        const CANSignal* signal = &set->signals[i];
+        if (signal->bytes > len) continue;  // Short frame: signal not present
+        OBDValue* value = &out[count];
+        memset(value, 0, sizeof(*value));
+        value->pid = signal->pid;
+        value->valid = true;
+        value->ecu = can_id;
+        value->value = DecodeSignal(signal, little, big);
+        if (indices) indices[count] = i;
+        count++;
+    }
+    return count;
+}
+
+int CAN_DecodeFrame(const CANSignalSet* set, uint32_t can_id, const uint8_t* data, int len,
+                    OBDValue* out, int max_out) {
+    return Decode(set, can_id, data, len, out, NULL, max_out);
+}
+
+// ---- candump ----
+
+static int HexDigit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    c = (char)toupper((unsigned char)c);
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+bool CAN_ParseCandumpLine(const char* line, double* time_s, uint32_t* can_id, bool* extended,
+                          uint8_t* data, int* len) {
+    const char* p = line;
+    *time_s = 0.0;
+    while (isspace((unsigned char)*p)) p++;
+
+    // Optional "(seconds)" timestamp
+    if (*p == '(') {
+        char* end;
+        *time_s = strtod(p + 1, &end);
+        if (end == p + 1 || *end != ')') return false;
+        p = end + 1;
+        while (isspace((unsigned char)*p)) p++;
+    }
+
+    // Interface name
+    while (*p && !isspace((unsigned char)*p)) p++;
+    while (isspace((unsigned char)*p)) p++;
+
+    // Identifier: 3 hex digits standard, 8 extended
+    const char* id_start = p;
+    uint32_t id = 0;
+    int digit;
+    while ((digit = HexDigit(*p)) >= 0) {
+        id = (id << 4) | (uint32_t)digit;
+        p++;
+    }
+    int id_len = (int)(p - id_start);
+    if (id_len == 0 || id_len > 8) return false;
+    *can_id = id;
+    *extended = id_len > 3;
+
+    *len = 0;
+    if (*p == '#') {
+        // Log format: "ID#data", "ID##<flags>data" for CAN FD, "ID#R" remote
+        p++;
+        if (*p == '#') return false;  // CAN FD frames don't carry our signals
+        if (*p == 'R') return false;
+        while (HexDigit(p[0]) >= 0 && HexDigit(p[1]) >= 0) {
+            if (*len == 8) return false;
+            data[(*len)++] = (uint8_t)(HexDigit(p[0]) << 4 | HexDigit(p[1]));
+            p += 2;
+            if (*p == '.') p++;
+        }
+        return true;
+    }
+
+    // Default format: "ID   [n]  b0 b1 ..."
+    while (isspace((unsigned char)*p)) p++;
+    int count;
+    if (sscanf(p, "[%d]", &count) != 1 || count < 0 || count > 8) return false;
+    p = strchr(p, ']') + 1;
+    for (int i = 0; i < count; i++) {
+        while (isspace((unsigned char)*p)) p++;
+        if (HexDigit(p[0]) < 0 || HexDigit(p[1]) < 0) return false;
+        data[i] = (uint8_t)(HexDigit(p[0]) << 4 | HexDigit(p[1]));
+        p += 2;
+    }
+    *len = count;
+    return true;
+}
+
+long CAN_DecodeCandump(const CANSignalSet* set, const char* path, OBDSampleFn on_sample, void* user) {
+    FILE* file = fopen(path, "r");
+    if (!file) return -1;
+
+    long frames = 0;
+    char line[256];
+    while (fgets(line, sizeof(line), file)) {
+        double time_s;
+        uint32_t can_id;
+        bool extended;
+        uint8_t data[8];
+        int len;
+        if (!CAN_ParseCandumpLine(line, &time_s, &can_id, &extended, data, &len)) continue;
+        frames++;
+
+        OBDValue values[CAN_MAX_SIGNALS];
+        int n = CAN_DecodeFrame(set, can_id, data, len, values, CAN_MAX_SIGNALS);
+        for (int i = 0; i < n; i++) on_sample(user, &values[i], (long long)(time_s * 1e6));
+    }
+    fclose(file);
+    return frames;
+}
+
+// ---- Listener ----
+
+#ifdef __linux__
+bool CAN_ListenOpen(CANListener* listener, const char* ifname, const CANSignalSet* set,
+                    OBDSampleFn on_sample, void* user) {
+    memset(listener, 0, sizeof(*listener));
+    listener->fd = -1;
+    listener->set = set;
+    listener->on_sample = on_sample;
+    listener->user = user;
+
+    unsigned int ifindex = if_nametoindex(ifname);
+    if (ifindex == 0) {
+        fprintf(stderr, "No CAN interface %s\n", ifname);
+        return false;
+    }
+    int fd = socket(PF_CAN, SOCK_RAW, CAN_RAW);
+    if (fd < 0) {
+        fprintf(stderr, "Error opening %s: %s\n", ifname, strerror(errno));
+        return false;
+    }
+
+    // One exact-match filter per frame, so the kernel drops everything else
+    struct can_filter filters[CAN_MAX_SIGNALS];
+    int num_filters = 0;
+    for (int i = 0; i < set->num_signals; i++) {
+        const CANSignal* signal = &set->signals[i];
+        if (i > 0 && set->signals[i - 1].can_id == signal->can_id) continue;
+        filters[num_filters].can_id = signal->can_id | (signal->extended ? CAN_EFF_FLAG : 0);
+        filters[num_filters].can_mask = (signal->extended ? CAN_EFF_MASK : CAN_SFF_MASK) |
+                                        CAN_EFF_FLAG | CAN_RTR_FLAG;
+        num_filters++;
+    }
+    setsockopt(fd, SOL_CAN_RAW, CAN_RAW_FILTER, filters, sizeof(struct can_filter) * num_filters);
+
+    struct sockaddr_can addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.can_family = AF_CAN;
+    addr.can_ifindex = (int)ifindex;
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+        fprintf(stderr, "Error binding %s: %s\n", ifname, strerror(errno));
+        close(fd);
+        return false;
+    }
+
+    listener->fd = fd;
+    printf("Listening on %s for %d signals in %d frames\n", ifname, set->num_signals, num_filters);
+    return true;
+}
+
+int CAN_ListenStep(CANListener* listener, int max_wait_ms) {
+    struct pollfd pfd = { .fd = listener->fd, .events = POLLIN };
+    int ready = poll(&pfd, 1, max_wait_ms);
+    if (ready < 0) return errno == EINTR ? 0 : -1;
+    if (ready == 0) return 0;
+    if (pfd.revents & (POLLERR | POLLHUP | POLLNVAL)) return -1;
+
+    struct can_frame frames[RECV_BATCH];
+    struct iovec iov[RECV_BATCH];
+    struct mmsghdr msgs[RECV_BATCH];
+    memset(msgs, 0, sizeof(msgs));
+    for (int i = 0; i < RECV_BATCH; i++) {
+        iov[i].iov_base = &frames[i];
+        iov[i].iov_len = sizeof(frames[i]);
+        msgs[i].msg_hdr.msg_iov = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    // Drain the queue a batch per system call
+    int delivered = 0;
+    for (;;) {
+        int n = recvmmsg(listener->fd, msgs, RECV_BATCH, MSG_DONTWAIT, NULL);
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) break;
+            return -1;
+        }
+        long long now = NowMicros();
+        for (int f = 0; f < n; f++) {
+            const struct can_frame* frame = &frames[f];
+            listener->frames++;
+
+            uint32_t can_id = frame->can_id & ((frame->can_id & CAN_EFF_FLAG) ? CAN_EFF_MASK : CAN_SFF_MASK);
+            OBDValue values[CAN_MAX_SIGNALS];
+            int indices[CAN_MAX_SIGNALS];
+            int count = Decode(listener->set, can_id, frame->data, frame->can_dlc, values, indices,
+                               CAN_MAX_SIGNALS);
+            for (int i = 0; i < count; i++) {
+                int s = indices[i];
+                if (listener->last_us[s] > 0) {
+                    float interval = (float)(now - listener->last_us[s]);
+                    if (listener->interval_us[s] <= 0.0f) listener->interval_us[s] = interval;
+                    else listener->interval_us[s] += 0.05f * (interval - listener->interval_us[s]);
+                }
+                listener->last_us[s] = now;
+                listener->on_sample(listener->user, &values[i], now);
+            }
+            delivered += count;
+        }
+        if (n < RECV_BATCH) break;
+    }
+    listener->samples += delivered;
+    return delivered;
+}
+
+void CAN_ListenClose(CANListener* listener) {
+    if (listener->fd >= 0) close(listener->fd);
+    listener->fd = -1;
+}
+#else
+bool CAN_ListenOpen(CANListener* listener, const char* ifname, const CANSignalSet* set,
+                    OBDSampleFn on_sample, void* user) {
+    memset(listener, 0, sizeof(*listener));
+    listener->fd = -1;
+    listener->set = set;
+    listener->on_sample = on_sample;
+    listener->user = user;
+    fprintf(stderr, "SocketCAN is not available on this system (%s)\n", ifname);
+    return false;
+}
+
+int CAN_ListenStep(CANListener* listener, int max_wait_ms) {
+    (void)listener;
+    (void)max_wait_ms;
+    return -1;
+}
+
+void CAN_ListenClose(CANListener* listener) {
+    listener->fd = -1;
+}
+#endif
+
+int CAN_ListenGetStats(const CANListener* listener, OBDChannelStats* out, int max_channels) {
+    long long now = NowMicros();
+    int count = 0;
+    for (int s = 0; s < listener->set->num_signals && count < max_channels; s++) {
+        float interval = listener->interval_us[s];
+        if (listener->last_us[s] > 0 && now - listener->last_us[s] > 2 * interval) {
+            interval = (float)(now - listener->last_us[s]);  // Gone quiet
+        }
+        OBDChannelStats* stats = &out[count++];
+        memset(stats, 0, sizeof(*stats));
+        stats->pid = listener->set->signals[s].pid;
+        stats->achieved_hz = interval > 0.0f ? 1e6f / interval : 0.0f;
+    }
+    return count;
+}
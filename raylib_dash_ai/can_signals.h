@@ -0,0 +1,97 @@
+#ifndef CAN_SIGNALS_H
+#define CAN_SIGNALS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "obd_reader.h"
+#include "obd_scheduler.h"
+
+// Passive decoding of the signals ECUs broadcast on the powertrain bus. A
+// signal file says where each value sits in which frame; the listener filters
+// the bus down to those frames and hands every decoded signal to the same
+// OBDSampleFn the poll scheduler uses, as if the PID it stands for had been
+// read. Nothing is ever sent.
+//
+// Signal file, one signal per line, '#' comments. Bit layout as in DBC files:
+// start|length@order sign, order 1 = little endian (Intel, start is the LSB),
+// 0 = big endian (Motorola, start is the MSB), sign '+' or '-'.
+//
+//   # pid  can_id  layout     scale   offset  name
+//   0C     0C9     24|16@1+   0.25    0       EngineSpeed
+//   0D     3E9     7|16@0+    0.01    0       VehicleSpeed
+//
+// value = raw * scale + offset, in the unit of the PID (see obd_pids.c).
+// CAN IDs are hex; IDs above 7FF are 29-bit. Frames are classic CAN (8 bytes).
+
+#define CAN_MAX_SIGNALS 64
+#define CAN_SIGNAL_NAME 32
+
+typedef struct {
+    char name[CAN_SIGNAL_NAME];
+    uint8_t pid;             // Delivered as this Mode 01 PID
+    uint32_t can_id;
+    bool extended;           // 29-bit identifier
+    uint8_t start_bit;
+    uint8_t length;          // 1..64 bits
+    bool big_endian;         // Motorola byte order
+    bool is_signed;
+    float scale;
+    float offset;
+    uint8_t shift;           // Right shift of the 64-bit frame word (precomputed)
+    uint8_t bytes;           // Frame length the signal needs
+    uint64_t mask;
+} CANSignal;
+
+typedef struct {
+    CANSignal signals[CAN_MAX_SIGNALS];   // Sorted by CAN ID
+    int num_signals;
+} CANSignalSet;
+
+// Load a signal file. Returns false (and says which line) on a bad line.
+bool CAN_LoadSignals(CANSignalSet* set, const char* path);
+
+// Parse one signal line ("0C 0C9 24|16@1+ 0.25 0 EngineSpeed")
+bool CAN_ParseSignal(const char* line, CANSignal* signal);
+
+// Decode every signal carried by one frame into out[] (pid, value, ecu =
+// CAN ID). Returns the number of values.
+int CAN_DecodeFrame(const CANSignalSet* set, uint32_t can_id, const uint8_t* data, int len,
+                    OBDValue* out, int max_out);
+
+// One line of candump output: log format "(1436509052.249713) vcan0 0C9#00A00F"
+// or the default "  vcan0  0C9   [3]  00 A0 0F". time_s is 0 when the line
+// has no timestamp. Returns false for anything else.
+bool CAN_ParseCandumpLine(const char* line, double* time_s, uint32_t* can_id, bool* extended,
+                          uint8_t* data, int* len);
+
+// Decode a candump file offline, delivering samples with the log's timestamps
+// (in microseconds). Returns the number of frames read, -1 if it can't be opened.
+long CAN_DecodeCandump(const CANSignalSet* set, const char* path, OBDSampleFn on_sample, void* user);
+
+// Listener on a SocketCAN interface
+typedef struct {
+    int fd;
+    const CANSignalSet* set;
+    OBDSampleFn on_sample;
+    void* user;
+    unsigned long frames;                  // Frames received
+    unsigned long samples;                 // Values delivered
+    long long last_us[CAN_MAX_SIGNALS];    // Per signal, for the rate statistics
+    float interval_us[CAN_MAX_SIGNALS];    // Smoothed time between updates
+} CANListener;
+
+// Open the interface with kernel filters for exactly the signal set's IDs
+bool CAN_ListenOpen(CANListener* listener, const char* ifname, const CANSignalSet* set,
+                    OBDSampleFn on_sample, void* user);
+
+// Wait up to max_wait_ms for frames, then decode everything queued.
+// Returns the number of values delivered, -1 on a socket error.
+int CAN_ListenStep(CANListener* listener, int max_wait_ms);
+
+// Update rate of each signal's PID, in the scheduler's stats format
+// (target_hz 0: broadcast, not requested)
+int CAN_ListenGetStats(const CANListener* listener, OBDChannelStats* out, int max_channels);
+
+void CAN_ListenClose(CANListener* listener);
+
+#endif // CAN_SIGNALS_H
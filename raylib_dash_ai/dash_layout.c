@@ -0,0 +1,163 @@
+#include "dash_layout.h"
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+
+static const char* KIND_NAMES[] = {
+    [GAUGE_TACHOMETER] = "tach",
+    [GAUGE_SPEEDOMETER] = "speed",
+    [GAUGE_TEMPERATURE] = "temp",
+};
+
+void Layout_Default(DashLayout* layout) {
+    *layout = (DashLayout){
+        .width = 1200,
+        .height = 700,
+        .text_scale = 1.0f,
+        .gauges = {
+            { GAUGE_TACHOMETER, 0x0C, 20.0f, {280, 280}, 150, 8000, 6000, 7000 },
+            { GAUGE_SPEEDOMETER, 0x0D, 10.0f, {680, 280}, 150, 200, 0, 0 },
+            { GAUGE_TEMPERATURE, 0x05, 0.5f, {1000, 500}, 120, 120, 90, 100 },
+        },
+        .num_gauges = 3,
+    };
+}
+
+// ---- Parsing ----
+
+static bool ParseKind(const char* name, GaugeKind* kind) {
+    for (int k = 0; k < (int)(sizeof(KIND_NAMES) / sizeof(KIND_NAMES[0])); k++) {
+        if (strcmp(name, KIND_NAMES[k]) == 0) {
+            *kind = (GaugeKind)k;
+            return true;
+        }
+    }
+    return false;
+}
+
+// "tach 0C 20  280 280 150  8000 6000 7000"
+static bool ParseGauge(const char* text, LayoutGauge* gauge) {
+    char kind[16];
+    unsigned int pid;
+    if (sscanf(text, "%15s %x %f %f %f %f %f %f %f", kind, &pid, &gauge->poll_hz, &gauge->center.x,
+               &gauge->center.y, &gauge->radius, &gauge->max, &gauge->warn, &gauge->redline) != 9) {
+        return false;
+    }
+    gauge->pid = (unsigned char)pid;
+    return ParseKind(kind, &gauge->kind) && pid <= 0xFF && gauge->poll_hz > 0.0f && gauge->radius > 0.0f &&
+           gauge->max > 0.0f;
+}
+
+static bool HasPID(const DashLayout* layout, unsigned char pid) {
+    for (int i = 0; i < layout->num_gauges; i++) {
+        if (layout->gauges[i].pid == pid) return true;
+    }
+    return false;
+}
+
+bool Layout_Load(DashLayout* layout, const char* path) {
+    memset(layout, 0, sizeof(*layout));
+    layout->text_scale = 1.0f;
+
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        fprintf(stderr, "Cannot open layout file %s\n", path);
+        return false;
+    }
+
+    char line[256];
+    int line_number = 0;
+    bool ok = true;
+    while (ok && fgets(line, sizeof(line), file)) {
+        line_number++;
+        char* p = line;
+        while (isspace((unsigned char)*p)) p++;
+        if (*p == '\0' || *p == '#') continue;
+
+        char directive[16];
+        int consumed = 0;
+        if (sscanf(p, "%15s%n", directive, &consumed) != 1) continue;
+        p += consumed;
+
+        if (strcmp(directive, "screen") == 0) {
+            if (sscanf(p, "%d %d", &layout->width, &layout->height) != 2 || layout->width <= 0 ||
+                layout->height <= 0) {
+                fprintf(stderr, "%s:%d: bad screen size\n", path, line_number);
+                ok = false;
+            }
+        } else if (strcmp(directive, "text") == 0) {
+            if (sscanf(p, "%f", &layout->text_scale) != 1 || layout->text_scale <= 0.0f) {
+                fprintf(stderr, "%s:%d: bad text scale\n", path, line_number);
+                ok = false;
+            }
+        } else if (strcmp(directive, "gauge") == 0) {
+            if (layout->num_gauges == LAYOUT_MAX_GAUGES) {
+                fprintf(stderr, "%s:%d: more than %d gauges\n", path, line_number, LAYOUT_MAX_GAUGES);
+                ok = false;
+            } else if (!ParseGauge(p, &layout->gauges[layout->num_gauges])) {
+                fprintf(stderr, "%s:%d: bad gauge definition\n", path, line_number);
+                ok = false;
+            } else if (HasPID(layout, layout->gauges[layout->num_gauges].pid)) {
+                // One needle per channel: the channel is polled and recorded once
+                fprintf(stderr, "%s:%d: PID %02X already has a gauge\n", path, line_number,
+                        layout->gauges[layout->num_gauges].pid);
+                ok = false;
+            } else {
+                layout->num_gauges++;
+            }
+        } else {
+            fprintf(stderr, "%s:%d: unknown directive %s\n", path, line_number, directive);
+            ok = false;
+        }
+    }
+    fclose(file);
+
+    if (ok && layout->width == 0) {
+        fprintf(stderr, "%s: no screen size\n", path);
+        ok = false;
+    }
+    if (ok && layout->num_gauges == 0) {
+        fprintf(stderr, "%s: no gauges\n", path);
+        ok = false;
+    }
+    if (!ok) memset(layout, 0, sizeof(*layout));
+    return ok;
+}
+
+// ---- Compiling ----
+
+void Layout_Compile(const DashLayout* layout, Dashboard* dash) {
+    memset(dash, 0, sizeof(*dash));
+    dash->count = layout->num_gauges;
+    for (int i = 0; i < layout->num_gauges; i++) {
+        const LayoutGauge* def = &layout->gauges[i];
+        Gauge* gauge = &dash->gauges[i];
+        *gauge = Gauge_Make(def->kind, def->center, def->radius, def->max, def->warn, def->redline);
+        dash->bounds[i] = Gauge_Bounds(gauge);
+        dash->pids[i] = def->pid;
+        dash->poll_hz[i] = def->poll_hz;
+
+        const GaugeStyle* style = &gauge->style;
+        bool alert = style->alert[0] != '\0' && def->redline > 0.0f;
+        dash->alerts[i] = (DashAlert){
+            .threshold = alert ? def->redline : INFINITY,
+            .text = style->alert,
+            .x = (int)(def->center.x + style->alert_pos.x),
+            .y = (int)(def->center.y + style->alert_pos.y),
+            .font_size = style->alert_font,
+        };
+    }
+}
+
+int Layout_Find(const Dashboard* dash, unsigned char pid) {
+    for (int i = 0; i < dash->count; i++) {
+        if (dash->pids[i] == pid) return i;
+    }
+    return -1;
+}
+
+void Layout_Unload(Dashboard* dash) {
+    for (int i = 0; i < dash->count; i++) Gauge_Unload(&dash->gauges[i]);
+    dash->count = 0;
+}
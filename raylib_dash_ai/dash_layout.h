@@ -0,0 +1,82 @@
+#ifndef DASH_LAYOUT_H
+#define DASH_LAYOUT_H
+
+#include "raylib/src/raylib.h"
+#include "gauges.h"
+#include <stdbool.h>
+
+// Dashboard layouts: the screen size and the gauges on it, one text file per
+// screen profile (layouts/*.layout), so the same binary serves every screen.
+//
+// Layout_Compile turns a layout into a Dashboard once, at startup: flat
+// arrays indexed by widget, in drawing order, every gauge resolved for its
+// size (gauges.h) with its screen bounds, channel and red zone warning
+// worked out. The frame loop walks the arrays; nothing in it looks at what
+// kind of gauge a widget is.
+//
+// File format, one directive per line, # comments:
+//
+//   screen  <width> <height>
+//   text    <scale>           HUD text and margins, 1 = as at 1200x700
+//   gauge   <kind> <pid> <poll_hz> <x> <y> <radius> <max> <warn> <red>
+//
+// kind is tach, speed or temp; pid is the Mode 01 PID (hex) the needle
+// shows and poll_hz how often to ask for it; warn and red start the warning
+// and red zones (0 = none). Gauges are drawn in file order, one per PID.
+
+#define LAYOUT_MAX_GAUGES 8
+
+typedef struct {
+    GaugeKind kind;
+    unsigned char pid;
+    float poll_hz;
+    Vector2 center;
+    float radius;
+    float max;
+    float warn;
+    float redline;
+} LayoutGauge;
+
+typedef struct {
+    int width;
+    int height;
+    float text_scale;
+    LayoutGauge gauges[LAYOUT_MAX_GAUGES];
+    int num_gauges;
+} DashLayout;
+
+// Text over a gauge while its needle is in the red zone
+typedef struct {
+    float threshold;         // INFINITY = never
+    const char* text;
+    int x;
+    int y;
+    int font_size;
+} DashAlert;
+
+// Parallel arrays, by widget
+typedef struct {
+    int count;
+    float values[LAYOUT_MAX_GAUGES];        // Needle positions this tick
+    Rectangle bounds[LAYOUT_MAX_GAUGES];
+    DashAlert alerts[LAYOUT_MAX_GAUGES];
+    unsigned char pids[LAYOUT_MAX_GAUGES];
+    float poll_hz[LAYOUT_MAX_GAUGES];
+    Gauge gauges[LAYOUT_MAX_GAUGES];
+} Dashboard;
+
+// The 1200x700 desktop layout (layouts/desktop.layout), built in
+void Layout_Default(DashLayout* layout);
+
+// Read a layout file; on failure the layout is left empty
+bool Layout_Load(DashLayout* layout, const char* path);
+
+// Widgets for the layout, needles at 0. No window needed.
+void Layout_Compile(const DashLayout* layout, Dashboard* dash);
+
+// Widget showing pid, or -1
+int Layout_Find(const Dashboard* dash, unsigned char pid);
+
+void Layout_Unload(Dashboard* dash);
+
+#endif // DASH_LAYOUT_H
@@ -0,0 +1,553 @@
+#include "drive_archive.h"
+#include "obd_pids.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+#include <unistd.h>
+#include <sys/types.h>
+
+// ---- Bit streams ----
+
+typedef struct {
+    uint8_t* out;
+    size_t bytes;
+    uint64_t acc;            // Pending bits in the low end
+    int bits;
+} BitWriter;
+
+typedef struct {
+    const uint8_t* in;
+    size_t bytes;
+    size_t pos;              // In bits
+} BitReader;
+
+// Append the low n bits of value (n <= 32)
+static void PutBits(BitWriter* w, uint64_t value, int n) {
+    w->acc = (w->acc << n) | (value & ((1ULL << n) - 1));
+    w->bits += n;
+    while (w->bits >= 8) {
+        w->bits -= 8;
+        w->out[w->bytes++] = (uint8_t)(w->acc >> w->bits);
+    }
+}
+
+static void PutBits64(BitWriter* w, uint64_t value) {
+    PutBits(w, value >> 32, 32);
+    PutBits(w, value & 0xFFFFFFFFULL, 32);
+}
+
+static size_t FlushBits(BitWriter* w) {
+    if (w->bits > 0) {
+        w->out[w->bytes++] = (uint8_t)(w->acc << (8 - w->bits));
+        w->bits = 0;
+    }
+    return w->bytes;
+}
+
+// Next n bits (n <= 32); reads past the end return zeros and are caught by
+// the caller checking pos
+static uint64_t GetBits(BitReader* r, int n) {
+    size_t byte = r->pos >> 3;
+    uint64_t window;
+    if (byte + 8 <= r->bytes) {
+        memcpy(&window, r->in + byte, 8);
+        window = __builtin_bswap64(window);
+    } else {
+        window = 0;
+        for (int i = 0; i < 8; i++) window = (window << 8) | (byte + i < r->bytes ? r->in[byte + i] : 0);
+    }
+    window <<= r->pos & 7;
+    r->pos += n;
+    return window >> (64 - n);
+}
+
+static uint64_t GetBits64(BitReader* r) {
+    uint64_t high = GetBits(r, 32);
+    return (high << 32) | GetBits(r, 32);
+}
+
+static uint64_t ZigZag(int64_t v) {
+    return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+}
+
+static int64_t UnZigZag(uint64_t v) {
+    return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+}
+
+// Signed integer in a variable-length bucket:
+//   0 | 10 + 7 bits | 110 + 9 bits | 1110 + 12 bits | 1111 + 64 bits
+static void PutBucket(BitWriter* w, int64_t v) {
+    uint64_t z = ZigZag(v);
+    if (z == 0) {
+        PutBits(w, 0, 1);
+    } else if (z < (1u << 7)) {
+        PutBits(w, (0x2ULL << 7) | z, 9);
+    } else if (z < (1u << 9)) {
+        PutBits(w, (0x6ULL << 9) | z, 12);
+    } else if (z < (1u << 12)) {
+        PutBits(w, (0xEULL << 12) | z, 16);
+    } else {
+        PutBits(w, 0xF, 4);
+        PutBits64(w, z);
+    }
+}
+
+static int64_t GetBucket(BitReader* r) {
+    if (!GetBits(r, 1)) return 0;
+    if (!GetBits(r, 1)) return UnZigZag(GetBits(r, 7));
+    if (!GetBits(r, 1)) return UnZigZag(GetBits(r, 9));
+    if (!GetBits(r, 1)) return UnZigZag(GetBits(r, 12));
+    return UnZigZag(GetBits64(r));
+}
+
+// ---- Chunk codec ----
+
+static uint32_t FloatBits(float f) {
+    uint32_t bits;
+    memcpy(&bits, &f, sizeof(bits));
+    return bits;
+}
+
+static float BitsFloat(uint32_t bits) {
+    float f;
+    memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+// Quantized timestamp (floor, also for times before the epoch)
+static int64_t Quantize(long long us, uint32_t unit) {
+    int64_t q = us / (int64_t)unit;
+    return (us % (int64_t)unit < 0) ? q - 1 : q;
+}
+
+// Value of a raw integer, rounded once to float. Done in double so that the
+// encoder's round-trip check and the decoder agree on every machine (no
+// fused multiply-add can change the result while the product is exact).
+static float RawValue(int64_t raw, const OBDPIDInfo* info) {
+    return (float)((double)raw * info->scale + info->offset);
+}
+
+// Raw integers for the values, if every one of them round-trips bit-exactly
+static bool ToRaw(uint8_t pid, const float* values, int n, int64_t* raw) {
+    const OBDPIDInfo* info = OBD_GetPIDInfo(pid);
+    if (!info || info->scale <= 0.0f) return false;
+    for (int i = 0; i < n; i++) {
+        if (!isfinite(values[i])) return false;
+        double r = ((double)values[i] - info->offset) / info->scale;
+        if (fabs(r) > 1e15) return false;
+        raw[i] = llround(r);
+        if (FloatBits(RawValue(raw[i], info)) != FloatBits(values[i])) return false;
+    }
+    return true;
+}
+
+size_t Archive_EncodeChunk(uint8_t pid, const long long* timestamps_us, const float* values, int n,
+                           uint32_t time_unit_us, bool raw_values, uint8_t* out, ArchiveChunk* chunk) {
+    memset(chunk, 0, sizeof(*chunk));
+    chunk->pid = pid;
+    chunk->count = (uint32_t)n;
+    if (n <= 0) return 0;
+    if (time_unit_us == 0) time_unit_us = 1;
+    BitWriter w = { out, 0, 0, 0 };
+
+    // Timestamps: first delta, then delta-of-deltas
+    int64_t first = Quantize(timestamps_us[0], time_unit_us);
+    int64_t previous = first;
+    int64_t previous_delta = 0;
+    for (int i = 1; i < n; i++) {
+        int64_t q = Quantize(timestamps_us[i], time_unit_us);
+        int64_t delta = q - previous;
+        PutBucket(&w, i == 1 ? delta : delta - previous_delta);
+        previous_delta = delta;
+        previous = q;
+    }
+    chunk->start_us = first * time_unit_us;
+    chunk->end_us = previous * time_unit_us;
+
+    float min = FLT_MAX, max = -FLT_MAX;
+    for (int i = 0; i < n; i++) {
+        if (values[i] < min) min = values[i];
+        if (values[i] > max) max = values[i];
+    }
+    chunk->min = min <= max ? min : NAN;
+    chunk->max = min <= max ? max : NAN;
+
+    // Values: raw integer deltas if exact, else XOR with the previous float
+    int64_t raw[ARCHIVE_CHUNK_SAMPLES];
+    if (raw_values && n <= ARCHIVE_CHUNK_SAMPLES && ToRaw(pid, values, n, raw)) {
+        chunk->encoding = ARCHIVE_VALUES_RAW;
+        PutBucket(&w, raw[0]);
+        for (int i = 1; i < n; i++) PutBucket(&w, raw[i] - raw[i - 1]);
+    } else {
+        chunk->encoding = ARCHIVE_VALUES_XOR;
+        uint32_t prev = FloatBits(values[0]);
+        PutBits(&w, prev, 32);
+        int lead = -1, trail = 0;   // Current window of meaningful bits
+        for (int i = 1; i < n; i++) {
+            uint32_t bits = FloatBits(values[i]);
+            uint32_t x = bits ^ prev;
+            prev = bits;
+            if (x == 0) {
+                PutBits(&w, 0, 1);
+                continue;
+            }
+            int l = __builtin_clz(x), t = __builtin_ctz(x);
+            if (lead >= 0 && l >= lead && t >= trail) {
+                PutBits(&w, 0x2, 2);
+                PutBits(&w, x >> trail, 32 - lead - trail);
+            } else {
+                int len = 32 - l - t;
+                PutBits(&w, 0x3, 2);
+                PutBits(&w, (uint64_t)l, 5);
+                PutBits(&w, (uint64_t)(len - 1), 5);
+                PutBits(&w, x >> t, len);
+                lead = l;
+                trail = t;
+            }
+        }
+    }
+
+    chunk->bytes = (uint32_t)FlushBits(&w);
+    return chunk->bytes;
+}
+
+int Archive_DecodeChunk(const ArchiveChunk* chunk, const uint8_t* data, uint32_t time_unit_us,
+                        long long* timestamps_us, float* values) {
+    int n = (int)chunk->count;
+    if (n <= 0) return 0;
+    if (n > ARCHIVE_CHUNK_SAMPLES) return -1;
+    if (time_unit_us == 0) time_unit_us = 1;
+    BitReader r = { data, chunk->bytes, 0 };
+
+    int64_t q = chunk->start_us / (int64_t)time_unit_us;
+    int64_t delta = 0;
+    timestamps_us[0] = q * time_unit_us;
+    for (int i = 1; i < n; i++) {
+        int64_t d = GetBucket(&r);
+        delta = i == 1 ? d : delta + d;
+        q += delta;
+        timestamps_us[i] = q * time_unit_us;
+    }
+
+    if (chunk->encoding == ARCHIVE_VALUES_RAW) {
+        const OBDPIDInfo* info = OBD_GetPIDInfo(chunk->pid);
+        if (!info) return -1;
+        int64_t raw = GetBucket(&r);
+        values[0] = RawValue(raw, info);
+        for (int i = 1; i < n; i++) {
+            raw += GetBucket(&r);
+            values[i] = RawValue(raw, info);
+        }
+    } else if (chunk->encoding == ARCHIVE_VALUES_XOR) {
+        uint32_t bits = (uint32_t)GetBits(&r, 32);
+        values[0] = BitsFloat(bits);
+        int lead = 0, trail = 0;
+        for (int i = 1; i < n; i++) {
+            if (GetBits(&r, 1)) {
+                if (GetBits(&r, 1)) {
+                    lead = (int)GetBits(&r, 5);
+                    int len = (int)GetBits(&r, 5) + 1;
+                    trail = 32 - lead - len;
+                    if (trail < 0) return -1;
+                }
+                bits ^= (uint32_t)GetBits(&r, 32 - lead - trail) << trail;
+            }
+            values[i] = BitsFloat(bits);
+        }
+    } else {
+        return -1;
+    }
+
+    if (r.pos > (size_t)chunk->bytes * 8) return -1;
+    if (timestamps_us[n - 1] != chunk->end_us) return -1;
+    return n;
+}
+
+// ---- Writing ----
+
+static bool WriteAt(FILE* file, uint64_t offset, const void* data, size_t bytes) {
+    return fseeko(file, (off_t)offset, SEEK_SET) == 0 && fwrite(data, 1, bytes, file) == bytes;
+}
+
+static bool ReadAt(FILE* file, uint64_t offset, void* data, size_t bytes) {
+    return fseeko(file, (off_t)offset, SEEK_SET) == 0 && fread(data, 1, bytes, file) == bytes;
+}
+
+static bool AllocWriter(ArchiveWriter* writer) {
+    writer->pending = calloc(ARCHIVE_MAX_CHANNELS, sizeof(ArchivePending));
+    writer->buffer = malloc(ARCHIVE_CHUNK_MAX_BYTES(ARCHIVE_CHUNK_SAMPLES));
+    memset(writer->slot, -1, sizeof(writer->slot));
+    writer->raw_values = true;
+    return writer->pending && writer->buffer;
+}
+
+static void FreeWriter(ArchiveWriter* writer) {
+    if (writer->file) fclose(writer->file);
+    free(writer->pending);
+    free(writer->buffer);
+    free(writer->index);
+    memset(writer, 0, sizeof(*writer));
+}
+
+bool Archive_Create(ArchiveWriter* writer, const char* path, uint32_t time_unit_us) {
+    memset(writer, 0, sizeof(*writer));
+    writer->file = fopen(path, "w+b");
+    if (!writer->file) {
+        fprintf(stderr, "Cannot create archive %s\n", path);
+        return false;
+    }
+    if (!AllocWriter(writer)) {
+        FreeWriter(writer);
+        return false;
+    }
+    memcpy(writer->header.magic, ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC));
+    writer->header.version = ARCHIVE_VERSION;
+    writer->header.time_unit_us = time_unit_us > 0 ? time_unit_us : ARCHIVE_DEFAULT_TIME_UNIT_US;
+    if (!WriteAt(writer->file, 0, &writer->header, sizeof(writer->header))) {
+        FreeWriter(writer);
+        return false;
+    }
+    writer->data_end = sizeof(ArchiveHeader);
+    return true;
+}
+
+bool Archive_Append(ArchiveWriter* writer, const char* path) {
+    if (access(path, F_OK) != 0) return Archive_Create(writer, path, ARCHIVE_DEFAULT_TIME_UNIT_US);
+
+    // The reader already knows how to find the index, or rebuild it
+    ArchiveReader reader;
+    if (!Archive_Open(&reader, path)) return false;
+    memset(writer, 0, sizeof(*writer));
+    writer->header = reader.header;
+    writer->index = reader.index;
+    writer->num_chunks = writer->index_capacity = reader.num_chunks;
+    writer->data_end = sizeof(ArchiveHeader);
+    for (int i = 0; i < reader.num_chunks; i++) {
+        uint64_t end = reader.index[i].offset + reader.index[i].bytes;
+        if (end > writer->data_end) writer->data_end = end;
+    }
+    reader.index = NULL;
+    Archive_Close(&reader);
+
+    // Cut the old index and trailer off before writing anything: until
+    // Archive_Finish writes the new ones, the file has no trailer and an
+    // append cut short is rebuilt from the chunk headers
+    writer->file = fopen(path, "r+b");
+    if (!writer->file || !AllocWriter(writer) || ftruncate(fileno(writer->file), (off_t)writer->data_end) != 0) {
+        fprintf(stderr, "Cannot open archive %s for writing\n", path);
+        FreeWriter(writer);
+        return false;
+    }
+    return true;
+}
+
+static void FlushChannel(ArchiveWriter* writer, ArchivePending* pending) {
+    if (pending->count == 0) return;
+    ArchiveChunk chunk;
+    size_t bytes = Archive_EncodeChunk(pending->pid, pending->timestamp_us, pending->value, pending->count,
+                                       writer->header.time_unit_us, writer->raw_values, writer->buffer, &chunk);
+    pending->count = 0;
+    chunk.offset = writer->data_end + sizeof(ArchiveChunk);
+
+    // Header copy of the index entry, then the data
+    if (!WriteAt(writer->file, writer->data_end, &chunk, sizeof(chunk)) ||
+        fwrite(writer->buffer, 1, bytes, writer->file) != bytes) {
+        writer->failed = true;
+        return;
+    }
+    writer->data_end = chunk.offset + bytes;
+
+    if (writer->num_chunks == writer->index_capacity) {
+        int capacity = writer->index_capacity ? writer->index_capacity * 2 : 256;
+        ArchiveChunk* index = realloc(writer->index, capacity * sizeof(ArchiveChunk));
+        if (!index) {
+            writer->failed = true;
+            return;
+        }
+        writer->index = index;
+        writer->index_capacity = capacity;
+    }
+    writer->index[writer->num_chunks++] = chunk;
+}
+
+bool Archive_Add(ArchiveWriter* writer, uint8_t pid, long long timestamp_us, float value) {
+    int s = writer->slot[pid];
+    if (s < 0) {
+        if (writer->num_pending == ARCHIVE_MAX_CHANNELS) {
+            writer->dropped++;
+            return false;
+        }
+        s = writer->num_pending++;
+        writer->slot[pid] = (int8_t)s;
+        writer->pending[s].pid = pid;
+    }
+    ArchivePending* pending = &writer->pending[s];
+    if (pending->count > 0 && timestamp_us < pending->timestamp_us[pending->count - 1]) {
+        FlushChannel(writer, pending);
+    }
+    pending->timestamp_us[pending->count] = timestamp_us;
+    pending->value[pending->count] = value;
+    pending->count++;
+    writer->samples++;
+    if (pending->count == ARCHIVE_CHUNK_SAMPLES) FlushChannel(writer, pending);
+    return !writer->failed;
+}
+
+bool Archive_Finish(ArchiveWriter* writer) {
+    for (int i = 0; i < writer->num_pending; i++) FlushChannel(writer, &writer->pending[i]);
+
+    ArchiveTrailer trailer = { .index_offset = writer->data_end, .num_chunks = (uint32_t)writer->num_chunks };
+    memcpy(trailer.magic, ARCHIVE_TRAILER_MAGIC, sizeof(ARCHIVE_TRAILER_MAGIC));
+    size_t index_bytes = writer->num_chunks * sizeof(ArchiveChunk);
+    if ((index_bytes > 0 && !WriteAt(writer->file, writer->data_end, writer->index, index_bytes)) ||
+        fwrite(&trailer, 1, sizeof(trailer), writer->file) != sizeof(trailer) || fflush(writer->file) != 0) {
+        writer->failed = true;
+    }
+    // Trim anything past the new trailer (left over when a damaged archive
+    // was appended to)
+    if (!writer->failed) {
+        off_t end = (off_t)(writer->data_end + index_bytes + sizeof(trailer));
+        if (ftruncate(fileno(writer->file), end) != 0 || fsync(fileno(writer->file)) != 0) writer->failed = true;
+    }
+    bool ok = !writer->failed;
+    FreeWriter(writer);
+    return ok;
+}
+
+// ---- Reading ----
+
+// An index entry whose data fits the read buffer and lies before end
+static bool ValidChunk(const ArchiveChunk* chunk, uint64_t end) {
+    return chunk->count >= 1 && chunk->count <= ARCHIVE_CHUNK_SAMPLES && chunk->encoding <= ARCHIVE_VALUES_RAW &&
+           chunk->bytes <= ARCHIVE_CHUNK_MAX_BYTES(chunk->count) &&
+           chunk->offset >= sizeof(ArchiveHeader) + sizeof(ArchiveChunk) && chunk->offset <= end &&
+           chunk->bytes <= end - chunk->offset && chunk->start_us <= chunk->end_us;
+}
+
+static bool ValidChunkHeader(const ArchiveChunk* chunk, uint64_t at, uint64_t file_size) {
+    return chunk->offset == at + sizeof(ArchiveChunk) && ValidChunk(chunk, file_size);
+}
+
+// Walk the chunk headers from the start when the index can't be trusted
+static bool RebuildIndex(ArchiveReader* reader, uint64_t file_size) {
+    int capacity = 0;
+    uint64_t at = sizeof(ArchiveHeader);
+    ArchiveChunk chunk;
+    while (at + sizeof(chunk) <= file_size && ReadAt(reader->file, at, &chunk, sizeof(chunk)) &&
+           ValidChunkHeader(&chunk, at, file_size)) {
+        if (reader->num_chunks == capacity) {
+            capacity = capacity ? capacity * 2 : 256;
+            ArchiveChunk* index = realloc(reader->index, capacity * sizeof(ArchiveChunk));
+            if (!index) return false;
+            reader->index = index;
+        }
+        reader->index[reader->num_chunks++] = chunk;
+        at = chunk.offset + chunk.bytes;
+    }
+    reader->recovered = true;
+    return true;
+}
+
+bool Archive_Open(ArchiveReader* reader, const char* path) {
+    memset(reader, 0, sizeof(*reader));
+    reader->file = fopen(path, "rb");
+    if (!reader->file) {
+        fprintf(stderr, "Cannot open archive %s\n", path);
+        return false;
+    }
+    if (!ReadAt(reader->file, 0, &reader->header, sizeof(reader->header)) ||
+        memcmp(reader->header.magic, ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC)) != 0 ||
+        reader->header.version != ARCHIVE_VERSION) {
+        fprintf(stderr, "%s: not a version %d drive archive\n", path, ARCHIVE_VERSION);
+        Archive_Close(reader);
+        return false;
+    }
+    fseeko(reader->file, 0, SEEK_END);
+    uint64_t file_size = (uint64_t)ftello(reader->file);
+
+    ArchiveTrailer trailer;
+    bool indexed = file_size >= sizeof(ArchiveHeader) + sizeof(trailer) &&
+                   ReadAt(reader->file, file_size - sizeof(trailer), &trailer, sizeof(trailer)) &&
+                   memcmp(trailer.magic, ARCHIVE_TRAILER_MAGIC, sizeof(ARCHIVE_TRAILER_MAGIC)) == 0 &&
+                   trailer.index_offset <= file_size &&
+                   trailer.index_offset + (uint64_t)trailer.num_chunks * sizeof(ArchiveChunk) + sizeof(trailer) ==
+                       file_size;
+    if (indexed && trailer.num_chunks > 0) {
+        reader->index = malloc(trailer.num_chunks * sizeof(ArchiveChunk));
+        indexed = reader->index &&
+                  ReadAt(reader->file, trailer.index_offset, reader->index, trailer.num_chunks * sizeof(ArchiveChunk));
+        // Queries read chunks into a fixed buffer: one bad entry and the
+        // index isn't trusted at all
+        for (uint32_t i = 0; indexed && i < trailer.num_chunks; i++) {
+            indexed = ValidChunk(&reader->index[i], trailer.index_offset);
+        }
+        if (indexed) reader->num_chunks = (int)trailer.num_chunks;
+    }
+    if (!indexed) {
+        free(reader->index);
+        reader->index = NULL;
+        reader->num_chunks = 0;
+        if (!RebuildIndex(reader, file_size)) {
+            Archive_Close(reader);
+            return false;
+        }
+        fprintf(stderr, "%s: index missing or damaged, rebuilt from %d chunks\n", path, reader->num_chunks);
+    }
+
+    reader->buffer = malloc(ARCHIVE_CHUNK_MAX_BYTES(ARCHIVE_CHUNK_SAMPLES));
+    if (!reader->buffer) {
+        Archive_Close(reader);
+        return false;
+    }
+    return true;
+}
+
+void Archive_Close(ArchiveReader* reader) {
+    if (reader->file) fclose(reader->file);
+    free(reader->index);
+    free(reader->buffer);
+    memset(reader, 0, sizeof(*reader));
+}
+
+ArchiveQuery Archive_QueryAll(void) {
+    ArchiveQuery query = {
+        .pid = -1,
+        .from_us = INT64_MIN,
+        .to_us = INT64_MAX,
+        .min_value = -INFINITY,
+        .max_value = INFINITY,
+    };
+    return query;
+}
+
+bool Archive_ChunkMatches(const ArchiveChunk* chunk, const ArchiveQuery* query) {
+    if (query->pid >= 0 && chunk->pid != query->pid) return false;
+    if (chunk->end_us < query->from_us || chunk->start_us > query->to_us) return false;
+    // A chunk of NaNs has no range; only an unbounded query wants it
+    if (isnan(chunk->min)) return query->min_value == -INFINITY && query->max_value == INFINITY;
+    return chunk->max >= query->min_value && chunk->min <= query->max_value;
+}
+
+long Archive_Query(ArchiveReader* reader, const ArchiveQuery* query, ArchiveSampleFn fn, void* user) {
+    long long t[ARCHIVE_CHUNK_SAMPLES];
+    float v[ARCHIVE_CHUNK_SAMPLES];
+    long matches = 0;
+    for (int c = 0; c < reader->num_chunks; c++) {
+        const ArchiveChunk* chunk = &reader->index[c];
+        if (!Archive_ChunkMatches(chunk, query)) continue;
+        if (!ReadAt(reader->file, chunk->offset, reader->buffer, chunk->bytes)) continue;
+        reader->chunks_read++;
+        reader->bytes_read += chunk->bytes;
+
+        int n = Archive_DecodeChunk(chunk, reader->buffer, reader->header.time_unit_us, t, v);
+        for (int i = 0; i < n; i++) {
+            if (t[i] < query->from_us || t[i] > query->to_us) continue;
+            if (!(v[i] >= query->min_value && v[i] <= query->max_value) &&
+                !(isnan(v[i]) && query->min_value == -INFINITY && query->max_value == INFINITY)) continue;
+            matches++;
+            if (fn && !fn(user, chunk->pid, t[i], v[i])) return matches;
+        }
+    }
+    return matches;
+}
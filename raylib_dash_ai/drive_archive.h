@@ -0,0 +1,177 @@
+#ifndef DRIVE_ARCHIVE_H
+#define DRIVE_ARCHIVE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Long-term storage for drive logs: each channel is cut into chunks of up to
+// ARCHIVE_CHUNK_SAMPLES samples, and each chunk stores its timestamps and its
+// values as two compressed columns (Gorilla-style, bit-packed):
+//
+//   timestamps  quantized to time_unit_us (1 ms by default); the first is in
+//               the index, then the first delta, then delta-of-deltas, which
+//               are 0 for a steady poll rate and small under jitter
+//   values      either the PID's raw integer (value = raw * scale + offset, as
+//               the ECU sent it) as deltas, when every value in the chunk
+//               round-trips exactly; or the XOR of each float with the
+//               previous one, storing only the bits that changed
+//
+// Both are lossless: decoding gives back the same floats, at the archive's
+// time resolution.
+//
+// An index at the end of the file holds each chunk's PID, time range and
+// min/max, so a query such as "RPM above 6000 in the last month" reads only the
+// chunks that can contain a match. Archives can be appended to: the old index
+// is cut off, the new chunks follow the old ones and a new index follows
+// them. Each chunk is also preceded by a copy of its index entry, so an
+// archive whose index was lost or damaged (an append cut short) is rebuilt by
+// scanning the chunks.
+//
+// Timestamps are wall-clock microseconds (Unix epoch).
+
+#define ARCHIVE_MAGIC "OBDARCH"
+#define ARCHIVE_TRAILER_MAGIC "OBDAIDX"
+#define ARCHIVE_VERSION 1
+
+#define ARCHIVE_CHUNK_SAMPLES 1024
+#define ARCHIVE_MAX_CHANNELS 32
+#define ARCHIVE_DEFAULT_TIME_UNIT_US 1000
+
+// Worst case encoded size of a chunk of n samples (64-bit escapes throughout)
+#define ARCHIVE_CHUNK_MAX_BYTES(n) (16 + (size_t)(n) * 18)
+
+typedef enum {
+    ARCHIVE_VALUES_XOR = 0,      // Float bits XOR previous
+    ARCHIVE_VALUES_RAW = 1       // PID raw integers, delta-encoded
+} ArchiveValueEncoding;
+
+// File header (32 bytes)
+typedef struct {
+    char magic[8];               // ARCHIVE_MAGIC
+    uint32_t version;
+    uint32_t time_unit_us;
+    uint8_t reserved[16];
+} ArchiveHeader;
+
+// Index entry (48 bytes)
+typedef struct {
+    int64_t start_us;            // First and last timestamp in the chunk
+    int64_t end_us;
+    uint64_t offset;             // Of the encoded data in the file
+    uint32_t bytes;
+    uint32_t count;
+    float min;
+    float max;
+    uint8_t pid;
+    uint8_t encoding;            // ArchiveValueEncoding
+    uint8_t reserved[6];
+} ArchiveChunk;
+
+// Last 24 bytes of the file
+typedef struct {
+    uint64_t index_offset;
+    uint32_t num_chunks;
+    uint32_t reserved;
+    char magic[8];               // ARCHIVE_TRAILER_MAGIC
+} ArchiveTrailer;
+
+_Static_assert(sizeof(ArchiveHeader) == 32, "ArchiveHeader must be 32 bytes");
+_Static_assert(sizeof(ArchiveChunk) == 48, "ArchiveChunk must be 48 bytes");
+_Static_assert(sizeof(ArchiveTrailer) == 24, "ArchiveTrailer must be 24 bytes");
+
+// Samples of one channel waiting to become a chunk
+typedef struct {
+    uint8_t pid;
+    int count;
+    long long timestamp_us[ARCHIVE_CHUNK_SAMPLES];
+    float value[ARCHIVE_CHUNK_SAMPLES];
+} ArchivePending;
+
+typedef struct {
+    FILE* file;
+    ArchiveHeader header;
+    ArchiveChunk* index;
+    int num_chunks;
+    int index_capacity;
+    uint64_t data_end;           // Where the next chunk goes
+    bool raw_values;             // Try ARCHIVE_VALUES_RAW (default true)
+    ArchivePending* pending;     // ARCHIVE_MAX_CHANNELS, allocated
+    int num_pending;
+    int8_t slot[256];            // Pending channel of each PID, -1 if none
+    uint8_t* buffer;             // One encoded chunk
+    bool failed;                 // A write failed
+    unsigned long samples;       // Added since Archive_Create/Append
+    unsigned long dropped;       // More channels than ARCHIVE_MAX_CHANNELS
+} ArchiveWriter;
+
+typedef struct {
+    FILE* file;
+    ArchiveHeader header;
+    ArchiveChunk* index;
+    int num_chunks;
+    bool recovered;              // Index rebuilt from the chunk headers
+    uint8_t* buffer;
+    // Work done by queries since Archive_Open
+    unsigned long chunks_read;
+    unsigned long bytes_read;
+} ArchiveReader;
+
+// Which samples a query returns: all of them after Archive_QueryAll, then
+// narrow any field
+typedef struct {
+    int pid;                     // -1 = every channel
+    long long from_us;           // Inclusive time range
+    long long to_us;
+    float min_value;             // Inclusive value range
+    float max_value;
+} ArchiveQuery;
+
+// Called for each matching sample, chunk by chunk; return false to stop
+typedef bool (*ArchiveSampleFn)(void* user, uint8_t pid, long long timestamp_us, float value);
+
+// ---- Chunk codec ----
+
+// Encode n samples of one channel (timestamps not decreasing) into out, which
+// must hold ARCHIVE_CHUNK_MAX_BYTES(n). Fills every field of chunk except
+// offset. Returns the encoded size.
+size_t Archive_EncodeChunk(uint8_t pid, const long long* timestamps_us, const float* values, int n,
+                           uint32_t time_unit_us, bool raw_values, uint8_t* out, ArchiveChunk* chunk);
+
+// Decode a chunk's data into chunk->count samples. Returns the number
+// decoded, -1 if the data is inconsistent with the index entry.
+int Archive_DecodeChunk(const ArchiveChunk* chunk, const uint8_t* data, uint32_t time_unit_us,
+                        long long* timestamps_us, float* values);
+
+// ---- Writing ----
+
+// New archive (replaces the file)
+bool Archive_Create(ArchiveWriter* writer, const char* path, uint32_t time_unit_us);
+
+// Add chunks to an existing archive, or create it
+bool Archive_Append(ArchiveWriter* writer, const char* path);
+
+// Buffer one sample; a channel's chunk is written when full, or when its
+// time goes backwards
+bool Archive_Add(ArchiveWriter* writer, uint8_t pid, long long timestamp_us, float value);
+
+// Write the remaining chunks and the index, and close. Returns false if
+// anything failed to write.
+bool Archive_Finish(ArchiveWriter* writer);
+
+// ---- Reading ----
+
+bool Archive_Open(ArchiveReader* reader, const char* path);
+void Archive_Close(ArchiveReader* reader);
+
+ArchiveQuery Archive_QueryAll(void);
+
+// Whether a chunk can hold samples matching the query (from the index alone)
+bool Archive_ChunkMatches(const ArchiveChunk* chunk, const ArchiveQuery* query);
+
+// Decode the chunks that can match and pass on the samples that do, in file
+// order (per channel, oldest first). Returns the number of matching samples.
+long Archive_Query(ArchiveReader* reader, const ArchiveQuery* query, ArchiveSampleFn fn, void* user);
+
+#endif // DRIVE_ARCHIVE_H
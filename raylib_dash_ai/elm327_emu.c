@@ -0,0 +1,1142 @@
+#define _GNU_SOURCE
+#include "elm327_emu.h"
+#include "obd_pids.h"
+#include "can_signals.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <poll.h>
+#include <termios.h>
+#include <time.h>
+#include <ctype.h>
+#ifdef __linux__
+#include <sys/socket.h>
+#include <net/if.h>
+#include <linux/can.h>
+#include <linux/can/raw.h>
+#endif
+
+#define ELM_VERSION "ELM327 v1.5"
+
+static long long NowMicros(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+static void SleepMicros(long long us) {
+    if (us <= 0) return;
+    struct timespec ts = { .tv_sec = us / 1000000, .tv_nsec = (us % 1000000) * 1000 };
+    nanosleep(&ts, NULL);
+}
+
+// xorshift32: the same seed gives the same faults and jitter on every run
+static float Random(ELMEmulator* emu) {
+    uint32_t x = emu->rng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    emu->rng = x;
+    return (x >> 8) / 16777216.0f;
+}
+
+static bool Roll(ELMEmulator* emu, float rate) {
+    return rate > 0.0f && Random(emu) < rate;
+}
+
+void ELM_SetSupported(ELMECU* ecu, uint8_t pid) {
+    ecu->supported[pid >> 5] |= 1U << (pid & 31);
+}
+
+static bool IsSupported(const ELMECU* ecu, uint8_t pid) {
+    return (ecu->supported[pid >> 5] >> (pid & 31)) & 1U;
+}
+
+ELMConfig ELM_DefaultConfig(void) {
+    static const uint8_t pids[] = {
+        0x01, 0x03, 0x04, 0x05, 0x06, 0x07, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0x10,
+        0x11, 0x13, 0x1C, 0x1F, 0x21, 0x2F, 0x33, 0x42, 0x46, 0x49, 0x5C
+    };
+    ELMConfig config = {
+        .protocol = 6,
+        .vin = "1FTSTANDIN0000042",
+        .ecu_latency_us = 10000,
+        .at_latency_us = 200,
+        .baud = 38400,
+        .search_ms = 1500,
+        .listen_wait = true,
+        .num_ecus = 1,
+        .seed = 1,
+        .trace_loop = true,
+        .monitor_buffer = 512,
+    };
+    config.ecus[0].header = 0x7E8;
+    for (size_t i = 0; i < sizeof(pids); i++) ELM_SetSupported(&config.ecus[0], pids[i]);
+    return config;
+}
+
+// ---- Values ----
+
+static int CompareTracePoints(const void* a, const void* b) {
+    const ELMTracePoint* x = (const ELMTracePoint*)a;
+    const ELMTracePoint* y = (const ELMTracePoint*)b;
+    if (x->pid != y->pid) return x->pid - y->pid;
+    return (x->time_s > y->time_s) - (x->time_s < y->time_s);
+}
+
+bool ELM_LoadTrace(ELMTrace* trace, const char* path) {
+    memset(trace, 0, sizeof(*trace));
+    for (int i = 0; i < 256; i++) trace->first[i] = -1;
+
+    FILE* file = fopen(path, "r");
+    if (!file) return false;
+
+    int capacity = 0;
+    char line[256];
+    while (fgets(line, sizeof(line), file)) {
+        for (char* p = line; *p; p++) {
+            if (*p == ',') *p = ' ';
+        }
+        char* p = line;
+        while (isspace((unsigned char)*p)) p++;
+        if (*p == '\0' || *p == '#') continue;
+
+        float time_s, value;
+        unsigned int pid;
+        if (sscanf(p, "%f %x %f", &time_s, &pid, &value) != 3 || pid > 0xFF) continue;
+
+        if (trace->count == capacity) {
+            capacity = capacity ? capacity * 2 : 256;
+            ELMTracePoint* grown = realloc(trace->points, sizeof(ELMTracePoint) * capacity);
+            if (!grown) break;
+            trace->points = grown;
+        }
+        trace->points[trace->count++] = (ELMTracePoint){ time_s, (uint8_t)pid, value };
+        if (time_s > trace->duration_s) trace->duration_s = time_s;
+    }
+    fclose(file);
+
+    qsort(trace->points, trace->count, sizeof(ELMTracePoint), CompareTracePoints);
+    for (int i = 0; i < trace->count; i++) {
+        uint8_t pid = trace->points[i].pid;
+        if (trace->first[pid] < 0) trace->first[pid] = i;
+        trace->num[pid]++;
+    }
+    return trace->count > 0;
+}
+
+void ELM_FreeTrace(ELMTrace* trace) {
+    free(trace->points);
+    trace->points = NULL;
+    trace->count = 0;
+}
+
+// Piecewise-linear value of one PID's keyframes
+static float TraceValue(const ELMTrace* trace, uint8_t pid, double time_s) {
+    const ELMTracePoint* points = &trace->points[trace->first[pid]];
+    int n = trace->num[pid];
+    if (time_s <= points[0].time_s) return points[0].value;
+    if (time_s >= points[n - 1].time_s) return points[n - 1].value;
+
+    int lo = 0, hi = n - 1;
+    while (hi - lo > 1) {
+        int mid = (lo + hi) / 2;
+        if (points[mid].time_s <= time_s) lo = mid;
+        else hi = mid;
+    }
+    float span = points[hi].time_s - points[lo].time_s;
+    float t = span > 0.0f ? (float)(time_s - points[lo].time_s) / span : 1.0f;
+    return points[lo].value + (points[hi].value - points[lo].value) * t;
+}
+
+// Built-in drive cycle: revving every 10 s, speed over 40 s, engine warming up
+static float SyntheticValue(uint8_t pid, double t) {
+    float rev = 0.5f - 0.5f * (float)cos(2.0 * M_PI * t / 10.0);
+    float coolant = 90.0f - 70.0f * (float)exp(-t / 60.0);
+    switch (pid) {
+        case 0x04: return 15.0f + 70.0f * rev;
+        case 0x05: return coolant;
+        case 0x0B: return 30.0f + 70.0f * rev;
+        case 0x0C: return 800.0f + 2600.0f * rev;
+        case 0x0D: return 60.0f - 60.0f * (float)cos(2.0 * M_PI * t / 40.0);
+        case 0x0E: return 10.0f + 20.0f * rev;
+        case 0x0F: return 25.0f;
+        case 0x10: return 3.0f + 40.0f * rev;
+        case 0x11: return 5.0f + 80.0f * rev;
+        case 0x1F: return (float)t;
+        case 0x2F: return 62.0f;
+        case 0x33: return 101.0f;
+        case 0x42: return 14.1f;
+        case 0x46: return 22.0f;
+        case 0x5C: return coolant - 5.0f;
+    }
+    const OBDPIDInfo* info = OBD_GetPIDInfo(pid);
+    if (!info || info->unit[0] == '\0') return 0.0f;   // Status bytes
+    return (info->min + info->max) / 2.0f;
+}
+
+float ELM_Value(const ELMEmulator* emu, uint8_t pid, double time_s) {
+    const ELMTrace* trace = &emu->trace;
+    if (trace->count == 0 || trace->first[pid] < 0) return SyntheticValue(pid, time_s);
+    if (emu->config.trace_loop && trace->duration_s > 0.0f) time_s = fmod(time_s, trace->duration_s);
+    return TraceValue(trace, pid, time_s);
+}
+
+// ---- Output ----
+
+typedef struct {
+    char text[2048];
+    int len;
+} Reply;
+
+static void Put(Reply* reply, const char* text) {
+    int n = snprintf(reply->text + reply->len, sizeof(reply->text) - reply->len, "%s", text);
+    if (n > 0) reply->len += n;
+    if (reply->len >= (int)sizeof(reply->text)) reply->len = sizeof(reply->text) - 1;
+}
+
+static void PutByte(const ELMEmulator* emu, Reply* reply, uint8_t b) {
+    char hex[4];
+    snprintf(hex, sizeof(hex), emu->spaces ? "%02X " : "%02X", b);
+    Put(reply, hex);
+}
+
+static void EndLine(const ELMEmulator* emu, Reply* reply) {
+    Put(reply, emu->linefeeds ? "\r\n" : "\r");
+}
+
+// Write at the speed of the serial link. The master is non-blocking, so a
+// client that stops reading loses output instead of stalling the emulator.
+static void Send(ELMEmulator* emu, const Reply* reply) {
+    if (reply->len == 0) return;
+    if (emu->config.baud > 0) SleepMicros((long long)reply->len * 10 * 1000000 / emu->config.baud);
+    int written = 0;
+    while (written < reply->len) {
+        ssize_t n = write(emu->master_fd, reply->text + written, reply->len - written);
+        if (n <= 0) break;
+        written += n;
+    }
+    emu->stats.bytes_sent += written;
+}
+
+static void SendText(ELMEmulator* emu, const char* text) {
+    Reply reply = { .len = 0 };
+    Put(&reply, text);
+    Send(emu, &reply);
+}
+
+static void SendLine(ELMEmulator* emu, const char* text) {
+    Reply reply = { .len = 0 };
+    Put(&reply, text);
+    EndLine(emu, &reply);
+    Send(emu, &reply);
+}
+
+// Blank line and prompt that end every reply
+static void SendPrompt(ELMEmulator* emu) {
+    Reply reply = { .len = 0 };
+    EndLine(emu, &reply);
+    Put(&reply, ">");
+    Send(emu, &reply);
+}
+
+static bool IsCAN(int protocol) {
+    return protocol >= 6;
+}
+
+// Format one ECU message the way the adapter prints it. CAN: one line for up
+// to 7 bytes, otherwise ISO-TP frames ("014" + "0:", "1:" ... with headers
+// off; header + PCI bytes with headers on, padded to 8 bytes). Older
+// protocols: one line per message, with a 3-byte header and checksum when
+// headers are on.
+static void FormatMessage(const ELMEmulator* emu, const ELMECU* ecu, const uint8_t* msg, int len,
+                          Reply* reply) {
+    char header[16];
+    int protocol = emu->config.protocol;
+
+    if (!IsCAN(protocol)) {
+        uint8_t line[16];
+        int n = 0;
+        if (protocol >= 4) line[n++] = 0x80 | len;        // ISO 14230 format byte
+        else line[n++] = protocol == 1 ? 0x41 : 0x48;
+        line[n++] = protocol >= 4 ? 0xF1 : 0x6B;
+        line[n++] = (uint8_t)ecu->header;
+        memcpy(line + n, msg, len);
+        n += len;
+        uint8_t sum = 0;
+        for (int i = 0; i < n; i++) sum += line[i];
+        line[n++] = sum;
+
+        int start = emu->headers ? 0 : 3;
+        int end = emu->headers ? n : n - 1;
+        for (int i = start; i < end; i++) PutByte(emu, reply, line[i]);
+        EndLine(emu, reply);
+        return;
+    }
+
+    bool long_header = protocol == 7 || protocol == 9;
+    snprintf(header, sizeof(header), long_header ? "%08X" : "%03X", ecu->header);
+    if (emu->spaces) strcat(header, " ");
+
+    if (len <= 7) {
+        if (emu->headers) {
+            Put(reply, header);
+            PutByte(emu, reply, (uint8_t)len);
+        }
+        for (int i = 0; i < len; i++) PutByte(emu, reply, msg[i]);
+        if (emu->headers) {
+            for (int i = len; i < 7; i++) PutByte(emu, reply, 0x55);
+        }
+        EndLine(emu, reply);
+        return;
+    }
+
+    if (!emu->headers) {
+        char count[12];
+        snprintf(count, sizeof(count), "%03X", len);
+        Put(reply, count);
+        EndLine(emu, reply);
+    }
+    int i = 0;
+    for (int frame = 0; i < len; frame++) {
+        int chunk = (frame == 0) ? 6 : 7;
+        if (emu->headers) {
+            Put(reply, header);
+            if (frame == 0) {
+                PutByte(emu, reply, 0x10 | (len >> 8));
+                PutByte(emu, reply, len & 0xFF);
+            } else {
+                PutByte(emu, reply, 0x20 | (frame & 0x0F));
+            }
+        } else {
+            char index[8];
+            snprintf(index, sizeof(index), emu->spaces ? "%X: " : "%X:", frame & 0x0F);
+            Put(reply, index);
+        }
+        for (int k = 0; k < chunk; k++, i++) PutByte(emu, reply, i < len ? msg[i] : 0x00);
+        EndLine(emu, reply);
+    }
+}
+
+// Overwrite a few characters with line noise, keeping line ends
+static void Corrupt(ELMEmulator* emu, Reply* reply) {
+    static const char noise[] = "G?.#~Zq0F\x7F";
+    int hits = 1 + (int)(Random(emu) * 3);
+    for (int h = 0; h < hits && reply->len > 0; h++) {
+        int at = (int)(Random(emu) * reply->len);
+        if (reply->text[at] == '\r' || reply->text[at] == '\n') continue;
+        reply->text[at] = noise[(int)(Random(emu) * (sizeof(noise) - 1))];
+    }
+}
+
+// ---- Requests ----
+
+static uint32_t SupportBitmap(const ELMECU* ecu, int base) {
+    uint32_t bits = 0;
+    for (int i = 1; i <= 32 && base + i <= 0xFF; i++) {
+        int pid = base + i;
+        bool on = IsSupported(ecu, (uint8_t)pid);
+        if (i == 32) {
+            // Next range is "supported" when anything beyond it is
+            on = false;
+            for (int p = pid + 1; p <= 0xFF && !on; p++) on = IsSupported(ecu, (uint8_t)p);
+        }
+        if (on) bits |= 1U << (32 - i);
+    }
+    return bits;
+}
+
+// Build one ECU's Mode 01 answer; returns its length (1 = nothing to say)
+static int Mode01Message(ELMEmulator* emu, const ELMECU* ecu, const uint8_t* pids, int num_pids,
+                         double time_s, uint8_t* msg) {
+    int len = 0;
+    msg[len++] = 0x41;
+    for (int i = 0; i < num_pids; i++) {
+        uint8_t pid = pids[i];
+        if ((pid & 0x1F) == 0) {
+            uint32_t bits = SupportBitmap(ecu, pid);
+            if (pid != 0 && !IsSupported(ecu, pid) && bits == 0) continue;
+            msg[len++] = pid;
+            msg[len++] = (uint8_t)(bits >> 24);
+            msg[len++] = (uint8_t)(bits >> 16);
+            msg[len++] = (uint8_t)(bits >> 8);
+            msg[len++] = (uint8_t)bits;
+            continue;
+        }
+        if (!IsSupported(ecu, pid)) continue;
+        uint8_t data[4];
+        int n = OBD_EncodePID(pid, ELM_Value(emu, pid, time_s), data);
+        if (n == 0) continue;
+        msg[len++] = pid;
+        memcpy(msg + len, data, n);
+        len += n;
+    }
+    return len;
+}
+
+// How long a real ELM327 keeps listening for further ECUs after an answer when
+// no response count was given: the full ATST time with adaptive timing off,
+// otherwise a margin over the response time it has learned (rough model).
+static int ListenWaitMs(const ELMEmulator* emu) {
+    int learned_ms = emu->config.ecu_latency_us / 1000;
+    int wait_ms = emu->st_ms;
+    if (emu->adaptive == 1 && learned_ms * 2 + 20 < wait_ms) wait_ms = learned_ms * 2 + 20;
+    if (emu->adaptive == 2 && learned_ms + 8 < wait_ms) wait_ms = learned_ms + 8;
+    return wait_ms;
+}
+
+static bool InOutage(const ELMEmulator* emu, long long now) {
+    const ELMConfig* config = &emu->config;
+    if (config->outage_ms <= 0 || config->outage_period_ms <= 0) return false;
+    long long phase_ms = ((now - emu->start_us) / 1000) % config->outage_period_ms;
+    return phase_ms >= config->outage_period_ms - config->outage_ms;
+}
+
+// Mode 01/09 request: hex digits, optionally ending in a response-count digit
+static void HandleOBDRequest(ELMEmulator* emu, const char* line) {
+    const ELMConfig* config = &emu->config;
+    emu->stats.obd_requests++;
+
+    int digits = strlen(line);
+    int max_answers = 0;
+    if (digits % 2 == 1) max_answers = line[--digits] - '0';
+    if (max_answers < 0 || max_answers > 9) max_answers = 0;
+
+    uint8_t bytes[8];
+    int num_bytes = 0;
+    for (int i = 0; i + 1 < digits && num_bytes < (int)sizeof(bytes); i += 2) {
+        unsigned int b;
+        if (sscanf(line + i, "%2x", &b) != 1) {
+            SendLine(emu, "?");
+            SendPrompt(emu);
+            return;
+        }
+        bytes[num_bytes++] = (uint8_t)b;
+    }
+
+    // Faults decided up front so the random sequence doesn't depend on timing
+    bool drop = Roll(emu, config->drop_rate) || InOutage(emu, NowMicros());
+    bool no_data = Roll(emu, config->no_data_rate);
+    bool garbage = Roll(emu, config->garbage_rate);
+    long long jitter = config->latency_jitter_us > 0 ? (long long)(Random(emu) * config->latency_jitter_us) : 0;
+
+    if (emu->searching) {
+        SleepMicros((long long)config->search_ms * 1000);
+        emu->searching = false;
+        SendLine(emu, "SEARCHING...");
+    }
+    if (drop) {
+        emu->stats.dropped++;
+        return;
+    }
+
+    SleepMicros(config->ecu_latency_us + jitter);
+    if (no_data || num_bytes < 2) {
+        if (no_data) emu->stats.no_data++;
+        SendLine(emu, "NO DATA");
+        SendPrompt(emu);
+        return;
+    }
+
+    double time_s = (NowMicros() - emu->start_us) / 1e6;
+    int answers = 0;
+    int last_delay = 0;
+    for (int e = 0; e < config->num_ecus; e++) {
+        const ELMECU* ecu = &config->ecus[e];
+        uint8_t msg[64];
+        int len = 0;
+
+        if (bytes[0] == 0x01) {
+            // Older protocols take one PID per request
+            if (IsCAN(config->protocol) || num_bytes == 2) {
+                len = Mode01Message(emu, ecu, bytes + 1, num_bytes - 1, time_s, msg);
+            }
+        } else if (bytes[0] == 0x09 && e == 0 && num_bytes == 2) {
+            if (bytes[1] == 0x00) {
+                uint8_t support[] = { 0x49, 0x00, 0x40, 0x00, 0x00, 0x00 };   // PID 02 only
+                memcpy(msg, support, sizeof(support));
+                len = sizeof(support);
+            } else if (bytes[1] == 0x02 && config->vin) {
+                if (IsCAN(config->protocol)) {
+                    msg[0] = 0x49; msg[1] = 0x02; msg[2] = 0x01;
+                    memcpy(msg + 3, config->vin, 17);
+                    len = 20;
+                } else {
+                    // Five numbered messages of four characters, the first padded
+                    Reply reply = { .len = 0 };
+                    char padded[20] = { 0, 0, 0 };
+                    memcpy(padded + 3, config->vin, 17);
+                    for (int seq = 1; seq <= 5; seq++) {
+                        uint8_t part[7] = { 0x49, 0x02, (uint8_t)seq };
+                        memcpy(part + 3, padded + (seq - 1) * 4, 4);
+                        FormatMessage(emu, ecu, part, sizeof(part), &reply);
+                    }
+                    if (garbage) Corrupt(emu, &reply);
+                    Send(emu, &reply);
+                    answers++;
+                    continue;
+                }
+            }
+        }
+        if (len <= 1) continue;
+        if (max_answers > 0 && answers >= max_answers) break;
+
+        SleepMicros((long long)(ecu->delay_us - last_delay));
+        last_delay = ecu->delay_us;
+
+        Reply reply = { .len = 0 };
+        FormatMessage(emu, ecu, msg, len, &reply);
+        if (garbage) Corrupt(emu, &reply);
+        Send(emu, &reply);
+        answers++;
+    }
+
+    if (answers == 0) {
+        SendLine(emu, "NO DATA");
+    } else if (config->listen_wait && !(max_answers > 0 && answers >= max_answers)) {
+        SleepMicros((long long)ListenWaitMs(emu) * 1000);
+    }
+    if (garbage) emu->stats.garbage++;
+    SendPrompt(emu);
+}
+
+// ---- Monitor mode ----
+
+// Bus traffic for ATMA: every parseable candump line, times made relative
+static bool LoadBus(ELMEmulator* emu, const char* path) {
+    FILE* file = fopen(path, "r");
+    if (!file) return false;
+
+    int capacity = 0;
+    double first_s = 0.0;
+    char line[256];
+    while (fgets(line, sizeof(line), file)) {
+        double time_s;
+        ELMBusFrame frame;
+        int len;
+        if (!CAN_ParseCandumpLine(line, &time_s, &frame.id, &frame.extended, frame.data, &len)) continue;
+        frame.len = (uint8_t)len;
+
+        if (emu->bus_count == capacity) {
+            capacity = capacity ? capacity * 2 : 1024;
+            ELMBusFrame* grown = realloc(emu->bus, sizeof(ELMBusFrame) * capacity);
+            if (!grown) break;
+            emu->bus = grown;
+        }
+        if (emu->bus_count == 0) first_s = time_s;
+        frame.time_us = (long long)((time_s - first_s) * 1e6);
+        if (emu->bus_count > 0 && frame.time_us < emu->bus[emu->bus_count - 1].time_us) {
+            frame.time_us = emu->bus[emu->bus_count - 1].time_us;  // Keep replay order monotonic
+        }
+        emu->bus[emu->bus_count++] = frame;
+    }
+    fclose(file);
+
+    if (emu->bus_count == 0) return false;
+    // Loop with the log's average frame spacing between the last and first frame
+    long long last = emu->bus[emu->bus_count - 1].time_us;
+    emu->bus_duration_us = last + (emu->bus_count > 1 ? last / (emu->bus_count - 1) : 1000);
+    return true;
+}
+
+// Print a frame the way the adapter shows it while monitoring
+static void FormatBusFrame(const ELMEmulator* emu, const ELMBusFrame* frame, Reply* reply) {
+    if (emu->headers) {
+        char header[16];
+        snprintf(header, sizeof(header), frame->extended ? "%08X" : "%03X", frame->id);
+        Put(reply, header);
+        if (emu->spaces) Put(reply, " ");
+    }
+    for (int i = 0; i < frame->len; i++) PutByte(emu, reply, frame->data[i]);
+    EndLine(emu, reply);
+}
+
+// Hand the serial line what it could have sent of the monitor output by `until`.
+// *line_free_us is when the line finished sending everything before.
+static void Drain(ELMEmulator* emu, Reply* pending, long long* line_free_us, long long until) {
+    int baud = emu->config.baud;
+    if (pending->len == 0) {
+        if (*line_free_us < until) *line_free_us = until;
+        return;
+    }
+    int sendable = pending->len;
+    if (baud > 0) {
+        if (until <= *line_free_us) return;
+        long long bytes = (until - *line_free_us) * baud / 10 / 1000000;
+        if (bytes < sendable) sendable = (int)bytes;
+    }
+    if (sendable == 0) return;
+
+    ssize_t n = write(emu->master_fd, pending->text, sendable);
+    if (n <= 0) return;
+    emu->stats.bytes_sent += n;
+    memmove(pending->text, pending->text + n, pending->len - n);
+    pending->len -= (int)n;
+    if (baud > 0) *line_free_us += (long long)n * 10 * 1000000 / baud;
+    else *line_free_us = until;
+}
+
+// ATMA / STMA: print every bus frame that passes the filter until the host
+// sends a character. The log plays on a loop from the emulator's start, so
+// frames sent while nobody monitors are missed. Frames go into the output
+// buffer as they appear on the bus and leave it at the serial rate; when the
+// buffer can't take a frame the adapter gives up with BUFFER FULL, as a real
+// ELM327 does.
+static void Monitor(ELMEmulator* emu) {
+    const ELMConfig* config = &emu->config;
+    Reply pending = { .len = 0 };
+    int capacity = config->monitor_buffer > 0 ? config->monitor_buffer : 512;
+    if (capacity > (int)sizeof(pending.text) - 1) capacity = sizeof(pending.text) - 1;
+
+    // Pick up the bus where it is now
+    long long now = NowMicros();
+    long long line_free_us = now;     // When the serial line has sent everything so far
+    long long start = emu->start_us;
+    long long loop_offset = 0;
+    int next = 0;
+    if (emu->bus_count > 0) {
+        long long elapsed = now - start;
+        loop_offset = elapsed - elapsed % emu->bus_duration_us;
+        int lo = 0, hi = emu->bus_count;
+        while (lo < hi) {
+            int mid = (lo + hi) / 2;
+            if (emu->bus[mid].time_us <= elapsed - loop_offset) lo = mid + 1;
+            else hi = mid;
+        }
+        next = lo;
+        if (next == emu->bus_count) {
+            next = 0;
+            loop_offset += emu->bus_duration_us;
+        }
+    }
+
+    while (emu->running) {
+        now = NowMicros();
+
+        // Frames that have appeared on the bus by now
+        while (emu->bus_count > 0) {
+            const ELMBusFrame* frame = &emu->bus[next];
+            long long due = start + loop_offset + frame->time_us;
+            if (due > now) break;
+            if (++next == emu->bus_count) {
+                next = 0;
+                loop_offset += emu->bus_duration_us;
+            }
+            if ((frame->id & emu->filter_mask) != (emu->filter_id & emu->filter_mask)) continue;
+
+            Reply line = { .len = 0 };
+            FormatBusFrame(emu, frame, &line);
+            Drain(emu, &pending, &line_free_us, due);
+            if (pending.len + line.len > capacity) {
+                Send(emu, &pending);
+                SendLine(emu, "BUFFER FULL");
+                SendPrompt(emu);
+                emu->stats.buffer_full++;
+                return;
+            }
+            memcpy(pending.text + pending.len, line.text, line.len);
+            pending.len += line.len;
+            emu->stats.monitor_frames++;
+        }
+
+        Drain(emu, &pending, &line_free_us, now);
+
+        // Any character from the host stops monitoring
+        int wait_ms = pending.len > 0 ? 1 : 10;
+        if (emu->bus_count > 0) {
+            long long due = start + loop_offset + emu->bus[next].time_us - NowMicros();
+            if (due < wait_ms * 1000LL) wait_ms = due > 0 ? (int)((due + 999) / 1000) : 0;
+        }
+        struct pollfd pfd = { .fd = emu->master_fd, .events = POLLIN };
+        if (poll(&pfd, 1, wait_ms) > 0) {
+            char discard[64];
+            if (read(emu->master_fd, discard, sizeof(discard)) > 0) {
+                Send(emu, &pending);
+                SendLine(emu, "STOPPED");
+                SendPrompt(emu);
+                return;
+            }
+        }
+    }
+}
+
+// ATCRA / ATCF / ATCM argument: hex digits, 'X' for "don't care" (ATCRA only)
+static bool ParseFilter(const char* arg, uint32_t* id, uint32_t* mask) {
+    int digits = strlen(arg);
+    if (digits != 3 && digits != 8) return false;
+    *id = 0;
+    *mask = 0;
+    for (int i = 0; i < digits; i++) {
+        char c = arg[i];
+        *id <<= 4;
+        *mask <<= 4;
+        if (c == 'X') continue;
+        if (!isxdigit((unsigned char)c)) return false;
+        *id |= (uint32_t)(isdigit((unsigned char)c) ? c - '0' : c - 'A' + 10);
+        *mask |= 0xF;
+    }
+    return true;
+}
+
+static void ResetAdapter(ELMEmulator* emu) {
+    emu->echo = true;
+    emu->linefeeds = false;
+    emu->spaces = true;
+    emu->headers = false;
+    emu->adaptive = 1;
+    emu->st_ms = 0x32 * 4;
+    emu->searching = true;
+    emu->filter_id = 0;
+    emu->filter_mask = 0;
+}
+
+// Settings commands that take "0"/"1" and just answer OK
+static bool SetFlag(const char* arg, bool* flag) {
+    if ((arg[0] != '0' && arg[0] != '1') || arg[1] != '\0') return false;
+    *flag = arg[0] == '1';
+    return true;
+}
+
+static const char* ProtocolName(int protocol) {
+    switch (protocol) {
+        case 1: return "SAE J1850 PWM";
+        case 2: return "SAE J1850 VPW";
+        case 3: return "ISO 9141-2";
+        case 4: return "ISO 14230-4 (KWP 5BAUD)";
+        case 5: return "ISO 14230-4 (KWP FAST)";
+        case 6: return "ISO 15765-4 (CAN 11/500)";
+        case 7: return "ISO 15765-4 (CAN 29/500)";
+        case 8: return "ISO 15765-4 (CAN 11/250)";
+        case 9: return "ISO 15765-4 (CAN 29/250)";
+    }
+    return "AUTO";
+}
+
+// AT command (without the "AT"); returns the reply line, or NULL for "?"
+static const char* HandleAT(ELMEmulator* emu, const char* cmd) {
+    static char text[64];
+    bool flag;
+    unsigned int value;
+
+    if (strcmp(cmd, "Z") == 0 || strcmp(cmd, "WS") == 0 || strcmp(cmd, "D") == 0) {
+        ResetAdapter(emu);
+        if (cmd[0] == 'D') return "OK";
+        // ATZ/ATWS print the version after a blank line
+        SendText(emu, emu->linefeeds ? "\r\n" : "\r");
+        return ELM_VERSION;
+    }
+    if (strcmp(cmd, "I") == 0) return ELM_VERSION;
+    if (strcmp(cmd, "@1") == 0) return "OBDII to RS232 Interpreter";
+    if (strcmp(cmd, "RV") == 0) return "14.2V";
+    if (strcmp(cmd, "DP") == 0) {
+        snprintf(text, sizeof(text), "%s%s", emu->searching ? "AUTO, " : "", ProtocolName(emu->config.protocol));
+        return text;
+    }
+    if (strcmp(cmd, "DPN") == 0) {
+        snprintf(text, sizeof(text), "A%X", emu->config.protocol);
+        return text;
+    }
+    if (cmd[0] == 'E' && SetFlag(cmd + 1, &emu->echo)) return "OK";
+    if (cmd[0] == 'L' && SetFlag(cmd + 1, &emu->linefeeds)) return "OK";
+    if (cmd[0] == 'H' && SetFlag(cmd + 1, &emu->headers)) return "OK";
+    if (cmd[0] == 'S' && SetFlag(cmd + 1, &emu->spaces)) return "OK";
+    if (strncmp(cmd, "AT", 2) == 0 && cmd[2] >= '0' && cmd[2] <= '2' && cmd[3] == '\0') {
+        emu->adaptive = cmd[2] - '0';
+        return "OK";
+    }
+    if (strncmp(cmd, "ST", 2) == 0 && sscanf(cmd + 2, "%x", &value) == 1) {
+        emu->st_ms = value ? value * 4 : 0x32 * 4;
+        return "OK";
+    }
+    if (strncmp(cmd, "SP", 2) == 0 || strncmp(cmd, "TP", 2) == 0) {
+        // ATSP0 / ATSPAn search; ATSPn with the bus protocol connects directly
+        const char* arg = cmd + 2;
+        if (*arg == 'A') arg++;
+        if (sscanf(arg, "%x", &value) != 1) return NULL;
+        emu->searching = value == 0 || cmd[2] == 'A' || (int)value != emu->config.protocol;
+        return "OK";
+    }
+    if (cmd[0] == 'M' && SetFlag(cmd + 1, &flag)) return "OK";
+    if (cmd[0] == 'R' && SetFlag(cmd + 1, &flag)) return "OK";
+    if (cmd[0] == 'V' && SetFlag(cmd + 1, &flag)) return "OK";
+    if (strncmp(cmd, "CAF", 3) == 0 && SetFlag(cmd + 3, &flag)) return "OK";
+    if (strncmp(cmd, "CFC", 3) == 0 && SetFlag(cmd + 3, &flag)) return "OK";
+    if (strcmp(cmd, "AL") == 0 || strcmp(cmd, "NL") == 0 || strcmp(cmd, "PC") == 0) return "OK";
+    if (strncmp(cmd, "CRA", 3) == 0) {
+        // ATCRA alone (and ATAR) go back to showing everything
+        if (cmd[3] == '\0') emu->filter_mask = 0;
+        else if (!ParseFilter(cmd + 3, &emu->filter_id, &emu->filter_mask)) return NULL;
+        return "OK";
+    }
+    if (strcmp(cmd, "AR") == 0) {
+        emu->filter_mask = 0;
+        return "OK";
+    }
+    if (strncmp(cmd, "CF", 2) == 0 || strncmp(cmd, "CM", 2) == 0) {
+        uint32_t bits, unused;
+        if (!ParseFilter(cmd + 2, &bits, &unused)) return NULL;
+        if (cmd[1] == 'F') emu->filter_id = bits;
+        else emu->filter_mask = bits;
+        return "OK";
+    }
+    if (strncmp(cmd, "SH", 2) == 0) return "OK";
+    return NULL;
+}
+
+static void HandleLine(ELMEmulator* emu, const char* line) {
+    emu->stats.commands++;
+
+    // Monitoring replies line by line with no prompt until it is stopped
+    if (strcmp(line, "ATMA") == 0 || (emu->config.stn && strcmp(line, "STMA") == 0)) {
+        Monitor(emu);
+        return;
+    }
+    if (emu->config.stn && strcmp(line, "STI") == 0) {
+        SendLine(emu, "STN1110 v4.0.1");
+        SendPrompt(emu);
+        return;
+    }
+
+    if (strncmp(line, "AT", 2) == 0) {
+        SleepMicros(emu->config.at_latency_us);
+        const char* text = HandleAT(emu, line + 2);
+        SendLine(emu, text ? text : "?");
+        SendPrompt(emu);
+        return;
+    }
+
+    for (const char* p = line; *p; p++) {
+        if (!isxdigit((unsigned char)*p)) {
+            SendLine(emu, "?");
+            SendPrompt(emu);
+            return;
+        }
+    }
+    HandleOBDRequest(emu, line);
+}
+
+static void* EmulatorThread(void* arg) {
+    ELMEmulator* emu = (ELMEmulator*)arg;
+    char line[128];
+    char last[128] = "";
+    int len = 0;
+
+    while (emu->running) {
+        struct pollfd pfd = { .fd = emu->master_fd, .events = POLLIN };
+        if (poll(&pfd, 1, 50) <= 0) continue;
+
+        char buf[256];
+        ssize_t n = read(emu->master_fd, buf, sizeof(buf));
+        if (n <= 0) {
+            SleepMicros(1000);
+            continue;
+        }
+
+        for (ssize_t i = 0; i < n; i++) {
+            char c = buf[i];
+            if (c == ' ' || c == '\n' || c == '\0') continue;
+            if (c != '\r') {
+                if (len < (int)sizeof(line) - 1) line[len++] = (char)toupper((unsigned char)c);
+                continue;
+            }
+            line[len] = '\0';
+            len = 0;
+
+            // A bare carriage return repeats the last command
+            if (line[0] == '\0') strcpy(line, last);
+            else strcpy(last, line);
+            if (line[0] == '\0') continue;
+
+            if (emu->echo) {
+                SendText(emu, line);
+                SendText(emu, "\r");
+            }
+            HandleLine(emu, line);
+        }
+    }
+    return NULL;
+}
+
+// ---- SocketCAN ----
+
+#ifdef __linux__
+static bool SendCANFrame(ELMEmulator* emu, uint32_t id, const uint8_t* data, int len) {
+    struct can_frame frame;
+    memset(&frame, 0, sizeof(frame));
+    frame.can_id = id;
+    frame.can_dlc = 8;
+    memset(frame.data, 0x55, sizeof(frame.data));
+    memcpy(frame.data, data, len);
+    if (write(emu->can_fd, &frame, sizeof(frame)) != (ssize_t)sizeof(frame)) return false;
+    emu->stats.bytes_sent += sizeof(frame.data);
+    return true;
+}
+
+// Wait for the tester's flow control to an ECU. Returns the block size and
+// separation time it asks for, or false if it aborts or never answers.
+static bool WaitFlowControl(ELMEmulator* emu, uint32_t id, int* block_size, int* st_us) {
+    long long deadline = NowMicros() + 1000000;
+    while (emu->running) {
+        long long left = deadline - NowMicros();
+        if (left <= 0) return false;
+        struct pollfd pfd = { .fd = emu->can_fd, .events = POLLIN };
+        if (poll(&pfd, 1, (int)((left + 999) / 1000)) <= 0) continue;
+
+        struct can_frame frame;
+        if (read(emu->can_fd, &frame, sizeof(frame)) != (ssize_t)sizeof(frame)) continue;
+        if ((frame.can_id & CAN_SFF_MASK) != id || frame.can_dlc < 3 || (frame.data[0] >> 4) != 3) continue;
+
+        int status = frame.data[0] & 0x0F;
+        if (status == 1) {
+            deadline = NowMicros() + 1000000;  // Wait: the tester will send another
+            continue;
+        }
+        if (status != 0) return false;         // Overflow/abort
+        *block_size = frame.data[1];
+        int st = frame.data[2];
+        *st_us = st <= 0x7F ? st * 1000 : (st >= 0xF1 && st <= 0xF9 ? (st - 0xF0) * 100 : 127000);
+        return true;
+    }
+    return false;
+}
+
+// Send one ECU message as ISO-TP: a single frame, or a first frame and
+// consecutive frames paced by the tester's flow control
+static void SendISOTP(ELMEmulator* emu, const ELMECU* ecu, const uint8_t* msg, int len) {
+    uint8_t data[8];
+    if (len <= 7) {
+        data[0] = (uint8_t)len;
+        memcpy(data + 1, msg, len);
+        SendCANFrame(emu, ecu->header, data, len + 1);
+        return;
+    }
+
+    data[0] = 0x10 | (uint8_t)(len >> 8);
+    data[1] = (uint8_t)len;
+    memcpy(data + 2, msg, 6);
+    if (!SendCANFrame(emu, ecu->header, data, 8)) return;
+
+    uint32_t tester = ecu->header - 8;
+    int block_size, st_us;
+    if (!WaitFlowControl(emu, tester, &block_size, &st_us)) return;
+
+    int sent = 6;
+    int in_block = 0;
+    for (int seq = 1; sent < len; seq++) {
+        if (block_size > 0 && in_block == block_size) {
+            if (!WaitFlowControl(emu, tester, &block_size, &st_us)) return;
+            in_block = 0;
+        }
+        SleepMicros(st_us);
+        int chunk = len - sent < 7 ? len - sent : 7;
+        data[0] = 0x20 | (seq & 0x0F);
+        memcpy(data + 1, msg + sent, chunk);
+        if (!SendCANFrame(emu, ecu->header, data, chunk + 1)) return;
+        sent += chunk;
+        in_block++;
+    }
+}
+
+// Single-frame request on 7DF (every ECU) or 7E0+n (ECU n only). Faults as on
+// the serial side, except that CAN frames can't arrive garbled: the checksum
+// fails and the frame is lost, so garbage counts as a drop.
+static void HandleCANRequest(ELMEmulator* emu, uint32_t id, const uint8_t* bytes, int num_bytes) {
+    const ELMConfig* config = &emu->config;
+    emu->stats.obd_requests++;
+
+    bool drop = Roll(emu, config->drop_rate) || InOutage(emu, NowMicros());
+    bool no_data = Roll(emu, config->no_data_rate);
+    bool garbage = Roll(emu, config->garbage_rate);
+    long long jitter = config->latency_jitter_us > 0 ? (long long)(Random(emu) * config->latency_jitter_us) : 0;
+    if (drop || garbage) {
+        if (drop) emu->stats.dropped++;
+        else emu->stats.garbage++;
+        return;
+    }
+    if (no_data || num_bytes < 2) {
+        if (no_data) emu->stats.no_data++;
+        return;  // ECUs without an answer stay silent
+    }
+
+    SleepMicros(config->ecu_latency_us + jitter);
+    double time_s = (NowMicros() - emu->start_us) / 1e6;
+    int last_delay = 0;
+    for (int e = 0; e < config->num_ecus; e++) {
+        const ELMECU* ecu = &config->ecus[e];
+        if (id != 0x7DF && id != ecu->header - 8) continue;
+
+        uint8_t msg[64];
+        int len = 0;
+        if (bytes[0] == 0x01) {
+            len = Mode01Message(emu, ecu, bytes + 1, num_bytes - 1, time_s, msg);
+        } else if (bytes[0] == 0x09 && e == 0 && num_bytes == 2) {
+            if (bytes[1] == 0x00) {
+                uint8_t support[] = { 0x49, 0x00, 0x40, 0x00, 0x00, 0x00 };   // PID 02 only
+                memcpy(msg, support, sizeof(support));
+                len = sizeof(support);
+            } else if (bytes[1] == 0x02 && config->vin) {
+                msg[0] = 0x49; msg[1] = 0x02; msg[2] = 0x01;
+                memcpy(msg + 3, config->vin, 17);
+                len = 20;
+            }
+        }
+        if (len <= 1) continue;
+
+        SleepMicros((long long)(ecu->delay_us - last_delay));
+        last_delay = ecu->delay_us;
+        SendISOTP(emu, ecu, msg, len);
+    }
+}
+
+static void* CANThread(void* arg) {
+    ELMEmulator* emu = (ELMEmulator*)arg;
+    while (emu->running) {
+        struct pollfd pfd = { .fd = emu->can_fd, .events = POLLIN };
+        if (poll(&pfd, 1, 50) <= 0) continue;
+
+        struct can_frame frame;
+        if (read(emu->can_fd, &frame, sizeof(frame)) != (ssize_t)sizeof(frame)) continue;
+        if (frame.can_dlc < 2) continue;
+
+        // Requests are single frames; stray flow controls are ignored
+        int len = frame.data[0];
+        if ((len >> 4) != 0 || len == 0 || len > frame.can_dlc - 1) continue;
+        emu->stats.commands++;
+        HandleCANRequest(emu, frame.can_id & CAN_SFF_MASK, frame.data + 1, len);
+    }
+    return NULL;
+}
+
+static bool OpenCAN(ELMEmulator* emu, const char* ifname) {
+    unsigned int ifindex = if_nametoindex(ifname);
+    if (ifindex == 0) {
+        fprintf(stderr, "ELM327 emulator: no CAN interface %s\n", ifname);
+        return false;
+    }
+    emu->can_fd = socket(PF_CAN, SOCK_RAW, CAN_RAW);
+    if (emu->can_fd < 0) {
+        perror("socket(PF_CAN)");
+        return false;
+    }
+
+    // Functional requests and physical requests/flow control to 7E0-7E7
+    struct can_filter filters[2] = {
+        { .can_id = 0x7DF, .can_mask = CAN_SFF_MASK | CAN_EFF_FLAG | CAN_RTR_FLAG },
+        { .can_id = 0x7E0, .can_mask = 0x7F8 | CAN_EFF_FLAG | CAN_RTR_FLAG },
+    };
+    setsockopt(emu->can_fd, SOL_CAN_RAW, CAN_RAW_FILTER, filters, sizeof(filters));
+
+    struct sockaddr_can addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.can_family = AF_CAN;
+    addr.can_ifindex = (int)ifindex;
+    if (bind(emu->can_fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+        perror(ifname);
+        return false;
+    }
+    return true;
+}
+#endif
+
+// Settings, trace and clock shared by the pty and the CAN front end
+static bool Prepare(ELMEmulator* emu, const ELMConfig* config) {
+    memset(emu, 0, sizeof(*emu));
+    emu->config = *config;
+    emu->master_fd = -1;
+    emu->slave_fd = -1;
+    emu->can_fd = -1;
+    for (int i = 0; i < 256; i++) emu->trace.first[i] = -1;
+    if (emu->config.num_ecus < 1) emu->config.num_ecus = 1;
+    if (emu->config.num_ecus > ELM_MAX_ECUS) emu->config.num_ecus = ELM_MAX_ECUS;
+
+    if (config->trace_path && !ELM_LoadTrace(&emu->trace, config->trace_path)) {
+        fprintf(stderr, "ELM327 emulator: cannot load trace %s\n", config->trace_path);
+        return false;
+    }
+    if (config->candump_path && !LoadBus(emu, config->candump_path)) {
+        fprintf(stderr, "ELM327 emulator: cannot load candump log %s\n", config->candump_path);
+        ELM_FreeTrace(&emu->trace);
+        return false;
+    }
+    emu->rng = config->seed ? config->seed : 1;
+    emu->start_us = NowMicros();
+    return true;
+}
+
+bool ELM_StartCAN(ELMEmulator* emu, const ELMConfig* config, const char* ifname) {
+    if (!Prepare(emu, config)) return false;
+#ifdef __linux__
+    emu->config.protocol = 6;
+    for (int e = 0; e < emu->config.num_ecus; e++) emu->config.ecus[e].header = 0x7E8 + e;
+    snprintf(emu->slave_path, sizeof(emu->slave_path), "%s", ifname);
+
+    if (!OpenCAN(emu, ifname)) {
+        ELM_Stop(emu);
+        return false;
+    }
+    emu->running = true;
+    if (pthread_create(&emu->thread, NULL, CANThread, emu) != 0) {
+        emu->running = false;
+        ELM_Stop(emu);
+        return false;
+    }
+    return true;
+#else
+    fprintf(stderr, "ELM327 emulator: SocketCAN is not available on this system (%s)\n", ifname);
+    ELM_Stop(emu);
+    return false;
+#endif
+}
+
+bool ELM_Start(ELMEmulator* emu, const ELMConfig* config) {
+    if (!Prepare(emu, config)) return false;
+
+    emu->master_fd = posix_openpt(O_RDWR | O_NOCTTY);
+    if (emu->master_fd < 0 || grantpt(emu->master_fd) != 0 || unlockpt(emu->master_fd) != 0) {
+        perror("posix_openpt");
+        ELM_Stop(emu);
+        return false;
+    }
+    snprintf(emu->slave_path, sizeof(emu->slave_path), "%s", ptsname(emu->master_fd));
+    fcntl(emu->master_fd, F_SETFL, fcntl(emu->master_fd, F_GETFL) | O_NONBLOCK);
+
+    // Raw until a client configures it; held open so the master never sees a hang-up
+    emu->slave_fd = open(emu->slave_path, O_RDWR | O_NOCTTY);
+    if (emu->slave_fd >= 0) {
+        struct termios tty;
+        if (tcgetattr(emu->slave_fd, &tty) == 0) {
+            cfmakeraw(&tty);
+            tcsetattr(emu->slave_fd, TCSANOW, &tty);
+        }
+    }
+
+    ResetAdapter(emu);
+    emu->running = true;
+    if (pthread_create(&emu->thread, NULL, EmulatorThread, emu) != 0) {
+        emu->running = false;
+        ELM_Stop(emu);
+        return false;
+    }
+    return true;
+}
+
+void ELM_Stop(ELMEmulator* emu) {
+    if (emu->running) {
+        emu->running = false;
+        pthread_join(emu->thread, NULL);
+    }
+    if (emu->slave_fd >= 0) close(emu->slave_fd);
+    if (emu->master_fd >= 0) close(emu->master_fd);
+    if (emu->can_fd >= 0) close(emu->can_fd);
+    emu->slave_fd = -1;
+    emu->master_fd = -1;
+    emu->can_fd = -1;
+    ELM_FreeTrace(&emu->trace);
+    free(emu->bus);
+    emu->bus = NULL;
+    emu->bus_count = 0;
+}
@@ -0,0 +1,151 @@
+#ifndef ELM327_EMU_H
+#define ELM327_EMU_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <pthread.h>
+
+// ELM327 emulator on a pseudo-terminal. ELM_Start opens a pty and answers on
+// its master side from a background thread; OBD_Init(conn, emu.slave_path)
+// talks to it exactly like a real adapter. ELM_StartCAN puts the same ECUs on
+// a SocketCAN interface instead (vcan0), answering ISO 15765-4 frames for
+// obd_can.c. Used by the benchmarks and by tools/elm327_emu_main.c.
+
+#define ELM_MAX_ECUS 4
+
+// One ECU on the emulated bus
+typedef struct {
+    uint32_t header;         // 11-bit (0x7E8), 29-bit (0x18DAF110) or source address (0x10)
+    int delay_us;            // Answers this much after the first ECU
+    uint32_t supported[8];   // Mode 01 PIDs it answers (bit pid & 31 of word pid >> 5)
+} ELMECU;
+
+typedef struct {
+    int protocol;            // ATDPN number the search finds: 6-9 CAN, 1-5 older protocols
+    const char* vin;         // Mode 09 PID 02 answer (NULL = no VIN)
+
+    // Timing
+    int ecu_latency_us;      // ECU response time for OBD requests
+    int latency_jitter_us;   // Random extra latency, 0..jitter
+    int at_latency_us;       // Adapter-only (AT) commands
+    int baud;                // Replies are paced to this serial rate (0 = no pacing)
+    int search_ms;           // Protocol search on the first request after ATSP0
+    bool listen_wait;        // Keep listening for more ECUs after the last answer
+                             // (skipped when the request has a response count)
+
+    // Bus
+    ELMECU ecus[ELM_MAX_ECUS];
+    int num_ecus;
+
+    // Faults, each rolled per OBD request
+    float drop_rate;         // No reply and no prompt at all (reader times out)
+    float no_data_rate;      // "NO DATA" instead of the answer
+    float garbage_rate;      // Answer with corrupted characters
+    int outage_period_ms;    // Every period the link goes silent...
+    int outage_ms;           // ...for this long (0 = no outages)
+    unsigned int seed;       // Fault and jitter random sequence
+
+    // Values: a trace file (see ELM_LoadTrace) or built-in drive cycle
+    const char* trace_path;  // NULL = synthetic values for every PID
+    bool trace_loop;         // Start the trace over at its end
+
+    // Monitor mode (ATMA, STMA): bus traffic replayed from a candump log
+    const char* candump_path; // NULL = quiet bus
+    int monitor_buffer;      // Output buffer; overrunning it ends monitoring with BUFFER FULL
+    bool stn;                // Answer STI and STMA like an STN11xx
+} ELMConfig;
+
+// Keyframes of a trace, sorted by PID and time
+typedef struct {
+    float time_s;
+    uint8_t pid;
+    float value;
+} ELMTracePoint;
+
+// One frame of the replayed bus traffic
+typedef struct {
+    long long time_us;       // Since the first frame of the log
+    uint32_t id;
+    bool extended;
+    uint8_t len;
+    uint8_t data[8];
+} ELMBusFrame;
+
+typedef struct {
+    ELMTracePoint* points;
+    int count;
+    int first[256];          // Index of each PID's first point (-1 = not in trace)
+    int num[256];
+    float duration_s;
+} ELMTrace;
+
+// Counters, updated by the emulator thread
+typedef struct {
+    long commands;
+    long obd_requests;
+    long dropped;
+    long no_data;
+    long garbage;
+    long bytes_sent;
+    long monitor_frames;     // Frames printed in monitor mode
+    long buffer_full;        // Monitor runs ended by BUFFER FULL
+} ELMStats;
+
+typedef struct {
+    ELMConfig config;
+    ELMTrace trace;
+    ELMBusFrame* bus;        // candump_path frames, in time order
+    int bus_count;
+    long long bus_duration_us;
+    int master_fd;
+    int slave_fd;            // Held open so the pty survives clients closing it
+    int can_fd;              // ELM_StartCAN: raw CAN socket
+    char slave_path[64];     // pty path, or the CAN interface name
+    pthread_t thread;
+    volatile bool running;
+    long long start_us;
+    unsigned int rng;
+
+    // Adapter state, as changed by AT commands
+    bool echo;
+    bool linefeeds;
+    bool spaces;
+    bool headers;
+    int adaptive;            // ATAT0-2
+    int st_ms;               // ATST
+    bool searching;          // ATSP0: the next OBD request runs the protocol search
+    uint32_t filter_id;      // ATCRA / ATCF: monitor shows frames where
+    uint32_t filter_mask;    // (id & mask) == (filter_id & mask); ATCM sets the mask
+
+    ELMStats stats;
+} ELMEmulator;
+
+// One 7E8 ECU answering the usual dashboard PIDs, 10 ms latency, 38400 baud,
+// 512-byte monitor buffer
+ELMConfig ELM_DefaultConfig(void);
+
+// Open the pty and start answering. Returns false if the pty or the trace
+// file can't be opened.
+bool ELM_Start(ELMEmulator* emu, const ELMConfig* config);
+
+// Answer on a SocketCAN interface instead of a pty: functional requests on
+// 7DF, physical requests on 7E0+n, replies from 7E8+n (11-bit, protocol 6).
+// Returns false if the interface can't be opened or SocketCAN is missing.
+bool ELM_StartCAN(ELMEmulator* emu, const ELMConfig* config, const char* ifname);
+
+// Stop the thread and close the pty (or CAN socket)
+void ELM_Stop(ELMEmulator* emu);
+
+// Mark a PID as supported by an ECU
+void ELM_SetSupported(ELMECU* ecu, uint8_t pid);
+
+// Load a trace: one keyframe per line, "time_s pid value" separated by spaces
+// or commas, PID in hex, value in the units of OBD_PID_TABLE, '#' comments.
+// Values are interpolated linearly between a PID's keyframes.
+bool ELM_LoadTrace(ELMTrace* trace, const char* path);
+void ELM_FreeTrace(ELMTrace* trace);
+
+// Value of a PID at a time since start (trace, or the built-in drive cycle)
+float ELM_Value(const ELMEmulator* emu, uint8_t pid, double time_s);
+
+#endif // ELM327_EMU_H
@@ -0,0 +1,179 @@
+#include "frame_pacer.h"
+#include <math.h>
+#include <time.h>
+
+#define STATS_WINDOW_US 1000000LL
+
+// Same clock as OBD_NowMicros, without linking the reader
+static long long NowMicros(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+static long long CPUMicros(clockid_t clock) {
+    struct timespec ts;
+    if (clock_gettime(clock, &ts) != 0) return 0;
+    return (long long)ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+static void SleepMicros(long long us) {
+    if (us <= 0) return;
+    struct timespec ts = { .tv_sec = us / 1000000, .tv_nsec = (us % 1000000) * 1000 };
+    nanosleep(&ts, NULL);
+}
+
+FramePacerConfig Pacer_DefaultConfig(void) {
+    int refresh = GetMonitorRefreshRate(GetCurrentMonitor());
+    FramePacerConfig config = {
+        .idle_fps = 10.0f,
+        .active_fps = refresh > 0 ? (float)refresh : 60.0f,
+        .hold_s = 0.5f,
+    };
+    return config;
+}
+
+void Pacer_Init(FramePacer* pacer, const FramePacerConfig* config) {
+    *pacer = (FramePacer){ .config = *config };
+    long long now = NowMicros();
+    pacer->deadline_us = now;
+    pacer->window_us = now;
+    pacer->window_cpu_us = CPUMicros(CLOCK_PROCESS_CPUTIME_ID);
+    pacer->window_render_cpu_us = CPUMicros(CLOCK_THREAD_CPUTIME_ID);
+    Pacer_DamageAll(pacer);
+}
+
+void Pacer_Motion(FramePacer* pacer, long long now_us) {
+    pacer->active = true;
+    pacer->last_motion_us = now_us;
+}
+
+// ---- Damage ----
+
+static bool Overlap(Rectangle a, Rectangle b) {
+    return a.x < b.x + b.width && b.x < a.x + a.width && a.y < b.y + b.height && b.y < a.y + a.height;
+}
+
+static Rectangle Union(Rectangle a, Rectangle b) {
+    float x0 = fminf(a.x, b.x), y0 = fminf(a.y, b.y);
+    float x1 = fmaxf(a.x + a.width, b.x + b.width), y1 = fmaxf(a.y + a.height, b.y + b.height);
+    return (Rectangle){ x0, y0, x1 - x0, y1 - y0 };
+}
+
+// Whole pixels, so the scissor covers every pixel the area touches
+static Rectangle Snap(Rectangle area) {
+    float x0 = floorf(area.x), y0 = floorf(area.y);
+    return (Rectangle){ x0, y0, ceilf(area.x + area.width) - x0, ceilf(area.y + area.height) - y0 };
+}
+
+void Pacer_Damage(FramePacer* pacer, Rectangle area) {
+    if (area.width <= 0.0f || area.height <= 0.0f) return;
+    area = Snap(area);
+
+    // Absorb every rectangle it overlaps; the union can overlap others that
+    // the area alone didn't, so go round again until nothing changes
+    bool merged = true;
+    while (merged) {
+        merged = false;
+        for (int i = 0; i < pacer->num_damage; i++) {
+            if (!Overlap(area, pacer->damage[i])) continue;
+            area = Union(area, pacer->damage[i]);
+            pacer->damage[i] = pacer->damage[--pacer->num_damage];
+            merged = true;
+            break;
+        }
+    }
+
+    if (pacer->num_damage == PACER_MAX_DAMAGE) {
+        for (int i = 0; i < pacer->num_damage; i++) area = Union(area, pacer->damage[i]);
+        pacer->num_damage = 0;
+    }
+    pacer->damage[pacer->num_damage++] = area;
+}
+
+void Pacer_DamageAll(FramePacer* pacer) {
+    pacer->num_damage = 0;
+    Pacer_Damage(pacer, (Rectangle){ 0, 0, (float)GetScreenWidth(), (float)GetScreenHeight() });
+}
+
+bool Pacer_NeedsFrame(const FramePacer* pacer) {
+    return pacer->num_damage > 0;
+}
+
+bool Pacer_Damaged(const FramePacer* pacer, Rectangle area) {
+    for (int i = 0; i < pacer->num_damage; i++) {
+        if (Overlap(area, pacer->damage[i])) return true;
+    }
+    return false;
+}
+
+static bool Covered(const FramePacer* pacer, Rectangle area) {
+    for (int i = 0; i < pacer->num_damage; i++) {
+        Rectangle d = pacer->damage[i];
+        if (area.x >= d.x && area.y >= d.y && area.x + area.width <= d.x + d.width &&
+            area.y + area.height <= d.y + d.height) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void Pacer_DamageWhole(FramePacer* pacer, const Rectangle* areas, int count) {
+    // Damage only grows, so this ends
+    bool grown = true;
+    while (grown) {
+        grown = false;
+        for (int i = 0; i < count; i++) {
+            if (!Pacer_Damaged(pacer, areas[i]) || Covered(pacer, Snap(areas[i]))) continue;
+            Pacer_Damage(pacer, areas[i]);
+            grown = true;
+        }
+    }
+}
+
+// ---- Ticks ----
+
+float Pacer_Rate(const FramePacer* pacer) {
+    return pacer->active ? pacer->config.active_fps : pacer->config.idle_fps;
+}
+
+static void UpdateStats(FramePacer* pacer, long long now) {
+    if (now - pacer->window_us < STATS_WINDOW_US) return;
+
+    float seconds = (now - pacer->window_us) / 1e6f;
+    long long cpu = CPUMicros(CLOCK_PROCESS_CPUTIME_ID);
+    long long render_cpu = CPUMicros(CLOCK_THREAD_CPUTIME_ID);
+    pacer->drawn_per_s = pacer->window_drawn / seconds;
+    pacer->skipped_per_s = pacer->window_skipped / seconds;
+    pacer->cpu_percent = (cpu - pacer->window_cpu_us) / 1e4f / seconds;
+    pacer->render_cpu_percent = (render_cpu - pacer->window_render_cpu_us) / 1e4f / seconds;
+    pacer->window_us = now;
+    pacer->window_drawn = 0;
+    pacer->window_skipped = 0;
+    pacer->window_cpu_us = cpu;
+    pacer->window_render_cpu_us = render_cpu;
+}
+
+void Pacer_EndTick(FramePacer* pacer, bool drawn) {
+    if (drawn) {
+        pacer->frames_drawn++;
+        pacer->window_drawn++;
+    } else {
+        pacer->frames_skipped++;
+        pacer->window_skipped++;
+    }
+    pacer->num_damage = 0;
+
+    long long now = NowMicros();
+    UpdateStats(pacer, now);
+    if (pacer->active && now - pacer->last_motion_us > (long long)(pacer->config.hold_s * 1e6f)) {
+        pacer->active = false;
+    }
+
+    // Next deadline a period on; after a stall (or a drop from the active
+    // rate) start again from now rather than catching up
+    long long period = (long long)(1e6f / Pacer_Rate(pacer));
+    pacer->deadline_us += period;
+    if (pacer->deadline_us < now || pacer->deadline_us > now + period) pacer->deadline_us = now + period;
+    SleepMicros(pacer->deadline_us - now);
+}
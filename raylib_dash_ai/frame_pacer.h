@@ -0,0 +1,98 @@
+#ifndef FRAME_PACER_H
+#define FRAME_PACER_H
+
+#include "raylib/src/raylib.h"
+#include <stdbool.h>
+
+// On-demand rendering: the render loop ticks at a rate that follows what is
+// on screen, and a tick draws only the regions that changed.
+//
+// Each tick the loop reports two things:
+//
+//   motion   something is animating (a needle still on its way): the loop
+//            ticks at the active rate, the display's refresh, and stays
+//            there for hold_s after the last motion
+//   damage   rectangles whose pixels changed since they were last drawn
+//
+// With no motion the loop drops to the idle rate, which only bounds how late
+// a key press or a new sample is noticed. A tick with no damage draws
+// nothing at all (a skipped frame): no batch, no swap.
+//
+// Damage is kept as a few screen rectangles: one that overlaps another is
+// merged into it, and past PACER_MAX_DAMAGE everything becomes one. The
+// caller redraws each of them under a scissor over its cached background,
+// drawing only the widgets that intersect it (Pacer_Damaged). Widgets that
+// can't be drawn in part are first damaged whole (Pacer_DamageWhole).
+//
+// Waiting between ticks sleeps on the monotonic clock (no busy wait), on
+// deadlines a whole period apart, so the rate holds whatever a tick costs.
+//
+// Statistics, over windows of a second: frames drawn and skipped per
+// second, and CPU use of the process (all threads) and of the render thread.
+
+#define PACER_MAX_DAMAGE 8
+
+typedef struct {
+    float idle_fps;          // When nothing moves
+    float active_fps;        // While something does (display refresh)
+    float hold_s;            // Stay active this long after the last motion
+} FramePacerConfig;
+
+typedef struct {
+    FramePacerConfig config;
+    bool active;
+    long long last_motion_us;
+    long long deadline_us;   // Start of the next tick
+
+    // Damage of the current tick
+    Rectangle damage[PACER_MAX_DAMAGE];
+    int num_damage;
+
+    // Statistics
+    unsigned long frames_drawn;
+    unsigned long frames_skipped;
+    float drawn_per_s;       // Over the last full window
+    float skipped_per_s;
+    float cpu_percent;       // Process, all threads; 100 = one core
+    float render_cpu_percent;
+    long long window_us;
+    unsigned long window_drawn;
+    unsigned long window_skipped;
+    long long window_cpu_us;
+    long long window_render_cpu_us;
+} FramePacer;
+
+// Idle at 10 FPS, active at the refresh rate of the current monitor (60 if
+// it can't be read), holding for half a second. Needs the window.
+FramePacerConfig Pacer_DefaultConfig(void);
+
+void Pacer_Init(FramePacer* pacer, const FramePacerConfig* config);
+
+// Something is animating: tick at the active rate
+void Pacer_Motion(FramePacer* pacer, long long now_us);
+
+// This rectangle needs drawing this tick
+void Pacer_Damage(FramePacer* pacer, Rectangle area);
+
+// The whole screen needs drawing (first frame, mode switches, window events)
+void Pacer_DamageAll(FramePacer* pacer);
+
+// Whether this tick draws anything
+bool Pacer_NeedsFrame(const FramePacer* pacer);
+
+// Whether area intersects any damaged rectangle, so must be drawn again
+bool Pacer_Damaged(const FramePacer* pacer, Rectangle area);
+
+// Areas that can only be redrawn whole (a needle redrawn inside the scissor
+// and not outside would tear): each one any damage touches is damaged
+// whole, until that touches no more. Call after the last Pacer_Damage.
+void Pacer_DamageWhole(FramePacer* pacer, const Rectangle* areas, int count);
+
+// End the tick: count it as drawn or skipped, clear the damage, update the
+// statistics and sleep until the next tick is due
+void Pacer_EndTick(FramePacer* pacer, bool drawn);
+
+// Current tick rate
+float Pacer_Rate(const FramePacer* pacer);
+
+#endif // FRAME_PACER_H
@@ -0,0 +1,156 @@
+#include "gauge_geometry.h"
+#include <math.h>
+#include <stdlib.h>
+
+#define TRIG_MASK (GEO_TRIG_STEPS - 1)
+#define QUARTER_TURN (GEO_TRIG_STEPS / 4)
+
+// One extra entry so interpolation never wraps
+static float sineTable[GEO_TRIG_STEPS + 1];
+static Vector2 unitCircle[GEO_CIRCLE_SEGMENTS + 1];
+static bool initialized = false;
+
+void Geo_Init(void) {
+    if (initialized) return;
+    for (int i = 0; i <= GEO_TRIG_STEPS; i++) {
+        sineTable[i] = (float)sin(i * (2.0 * M_PI / GEO_TRIG_STEPS));
+    }
+    for (int i = 0; i < GEO_CIRCLE_SEGMENTS; i++) {
+        double angle = i * (2.0 * M_PI / GEO_CIRCLE_SEGMENTS);
+        unitCircle[i] = (Vector2){ (float)cos(angle), (float)sin(angle) };
+    }
+    unitCircle[GEO_CIRCLE_SEGMENTS] = unitCircle[0];
+    initialized = true;
+}
+
+void Geo_SinCos(float degrees, float* s, float* c) {
+    float pos = degrees * (GEO_TRIG_STEPS / 360.0f);
+    int i = (int)pos;
+    if (pos < (float)i) i--;   // Floor for negative angles, without libm
+    float f = pos - (float)i;
+
+    int si = i & TRIG_MASK;
+    int ci = (i + QUARTER_TURN) & TRIG_MASK;
+    *s = sineTable[si] + (sineTable[si + 1] - sineTable[si]) * f;
+    *c = sineTable[ci] + (sineTable[ci + 1] - sineTable[ci]) * f;
+}
+
+Vector2 Geo_OnCircle(Vector2 center, float degrees, float radius) {
+    float s, c;
+    Geo_SinCos(degrees, &s, &c);
+    return (Vector2){ center.x + c * radius, center.y + s * radius };
+}
+
+const Vector2* Geo_UnitCircle(void) {
+    return unitCircle;
+}
+
+int Geo_CircleSegments(float radius) {
+    if (radius < 16.0f) return GEO_CIRCLE_SEGMENTS / 4;
+    if (radius < 48.0f) return GEO_CIRCLE_SEGMENTS / 2;
+    return GEO_CIRCLE_SEGMENTS;
+}
+
+// ---- Meshes ----
+
+static bool Reserve(GeoMesh* mesh, int vertices) {
+    if (mesh->count + vertices <= mesh->capacity) return true;
+    int capacity = mesh->capacity ? mesh->capacity * 2 : 768;
+    while (capacity < mesh->count + vertices) capacity *= 2;
+    Vector2* v = realloc(mesh->vertices, sizeof(Vector2) * capacity);
+    if (!v) return false;
+    mesh->vertices = v;
+    Color* c = realloc(mesh->colors, sizeof(Color) * (capacity / 3));
+    if (!c) return false;
+    mesh->colors = c;
+    mesh->capacity = capacity;
+    return true;
+}
+
+void Geo_AddTriangle(GeoMesh* mesh, Vector2 a, Vector2 b, Vector2 c, Color color) {
+    if (!Reserve(mesh, 3)) return;
+    // Counter-clockwise on screen (y down) is a negative cross product;
+    // the other winding would be culled
+    float cross = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+    if (cross > 0.0f) {
+        Vector2 t = b;
+        b = c;
+        c = t;
+    }
+    mesh->colors[mesh->count / 3] = color;
+    mesh->vertices[mesh->count++] = a;
+    mesh->vertices[mesh->count++] = b;
+    mesh->vertices[mesh->count++] = c;
+}
+
+void Geo_AddLine(GeoMesh* mesh, Vector2 start, Vector2 end, float thick, Color color) {
+    float dx = end.x - start.x, dy = end.y - start.y;
+    float length = sqrtf(dx * dx + dy * dy);
+    if (length <= 0.0f || thick <= 0.0f) return;
+    float scale = thick / (2.0f * length);
+    Vector2 side = { -scale * dy, scale * dx };
+
+    Vector2 p1 = { start.x + side.x, start.y + side.y };
+    Vector2 p2 = { start.x - side.x, start.y - side.y };
+    Vector2 p3 = { end.x + side.x, end.y + side.y };
+    Vector2 p4 = { end.x - side.x, end.y - side.y };
+    Geo_AddTriangle(mesh, p1, p2, p3, color);
+    Geo_AddTriangle(mesh, p2, p4, p3, color);
+}
+
+void Geo_AddCircle(GeoMesh* mesh, Vector2 center, float radius, Color color) {
+    int segments = Geo_CircleSegments(radius);
+    int step = GEO_CIRCLE_SEGMENTS / segments;
+    for (int i = 0; i < GEO_CIRCLE_SEGMENTS; i += step) {
+        Vector2 a = unitCircle[i], b = unitCircle[i + step];
+        Geo_AddTriangle(mesh, center, (Vector2){ center.x + a.x * radius, center.y + a.y * radius },
+                        (Vector2){ center.x + b.x * radius, center.y + b.y * radius }, color);
+    }
+}
+
+// Outline of a rounded rectangle, clockwise from the top left corner
+static int RoundedOutline(Rectangle rect, float radius, Vector2* points) {
+    int step = GEO_CIRCLE_SEGMENTS / Geo_CircleSegments(radius);
+    int quarter = GEO_CIRCLE_SEGMENTS / 4;
+    Vector2 corners[4] = {
+        { rect.x + radius, rect.y + radius },                            // Top left, from 180 degrees
+        { rect.x + rect.width - radius, rect.y + radius },               // Top right, from 270
+        { rect.x + rect.width - radius, rect.y + rect.height - radius }, // Bottom right, from 0
+        { rect.x + radius, rect.y + rect.height - radius },              // Bottom left, from 90
+    };
+    int first[4] = { 2 * quarter, 3 * quarter, 0, quarter };
+    int n = 0;
+    for (int k = 0; k < 4; k++) {
+        for (int i = first[k]; i <= first[k] + quarter; i += step) {
+            Vector2 u = unitCircle[i];
+            points[n++] = (Vector2){ corners[k].x + u.x * radius, corners[k].y + u.y * radius };
+        }
+    }
+    return n;
+}
+
+void Geo_AddRoundedRect(GeoMesh* mesh, Rectangle rect, float radius, Color color) {
+    Vector2 points[4 * (GEO_CIRCLE_SEGMENTS / 4 + 1)];
+    int n = RoundedOutline(rect, radius, points);
+    Vector2 middle = { rect.x + rect.width / 2, rect.y + rect.height / 2 };
+    for (int i = 0; i < n; i++) {
+        Geo_AddTriangle(mesh, middle, points[i], points[(i + 1) % n], color);
+    }
+}
+
+void Geo_AddRoundedRectLines(GeoMesh* mesh, Rectangle rect, float radius, float thick, Color color) {
+    Vector2 points[4 * (GEO_CIRCLE_SEGMENTS / 4 + 1)];
+    int n = RoundedOutline(rect, radius, points);
+    for (int i = 0; i < n; i++) {
+        Geo_AddLine(mesh, points[i], points[(i + 1) % n], thick, color);
+    }
+}
+
+void Geo_FreeMesh(GeoMesh* mesh) {
+    free(mesh->vertices);
+    free(mesh->colors);
+    mesh->vertices = NULL;
+    mesh->colors = NULL;
+    mesh->count = 0;
+    mesh->capacity = 0;
+}
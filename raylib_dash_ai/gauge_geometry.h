@@ -0,0 +1,63 @@
+#ifndef GAUGE_GEOMETRY_H
+#define GAUGE_GEOMETRY_H
+
+#include "raylib/src/raylib.h"
+#include <stdbool.h>
+
+// Trigonometry and shapes for the gauges, computed once instead of every
+// frame.
+//
+// Angles come from a sine table with GEO_TRIG_STEPS entries per turn,
+// interpolated linearly between entries (error below 5e-6): a lookup and a
+// multiply-add instead of a libm call, which is slow on the Pi's ARMv6/v7
+// cores. Cosine is the same table a quarter turn on.
+//
+// Static shapes (bezel circles, ticks, colour zones) are built once into a
+// mesh: a packed array of triangles relative to the gauge's centre, each
+// counter-clockwise on screen, as raylib draws them. Drawing the mesh is
+// then one pass over the array with no maths beyond adding the centre.
+//
+// Pure computation: nothing here needs a window or calls raylib.
+
+#define GEO_TRIG_STEPS 1024          // Sine table entries per turn (power of two)
+#define GEO_CIRCLE_SEGMENTS 64       // Segments of the largest circles
+
+// Build the sine table (repeat calls do nothing). Geo_SinCos and the mesh
+// builders need it.
+void Geo_Init(void);
+
+void Geo_SinCos(float degrees, float* s, float* c);
+
+// Point at an angle (degrees, clockwise from +x on screen) and distance
+Vector2 Geo_OnCircle(Vector2 center, float degrees, float radius);
+
+// GEO_CIRCLE_SEGMENTS + 1 unit vectors around the circle, the last equal to
+// the first
+const Vector2* Geo_UnitCircle(void);
+
+// Segments for a circle of this radius, like raylib's smoothness rule:
+// 16, 32 or GEO_CIRCLE_SEGMENTS
+int Geo_CircleSegments(float radius);
+
+typedef struct {
+    Vector2* vertices;       // Three per triangle
+    Color* colors;           // One per triangle
+    int count;               // Vertices
+    int capacity;
+} GeoMesh;
+
+void Geo_AddTriangle(GeoMesh* mesh, Vector2 a, Vector2 b, Vector2 c, Color color);
+
+// A thick line as two triangles, the same quad DrawLineEx draws
+void Geo_AddLine(GeoMesh* mesh, Vector2 start, Vector2 end, float thick, Color color);
+
+// A filled circle as a fan
+void Geo_AddCircle(GeoMesh* mesh, Vector2 center, float radius, Color color);
+
+// A filled rounded rectangle and its outline, corners of the given radius
+void Geo_AddRoundedRect(GeoMesh* mesh, Rectangle rect, float radius, Color color);
+void Geo_AddRoundedRectLines(GeoMesh* mesh, Rectangle rect, float radius, float thick, Color color);
+
+void Geo_FreeMesh(GeoMesh* mesh);
+
+#endif // GAUGE_GEOMETRY_H
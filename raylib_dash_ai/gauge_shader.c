@@ -0,0 +1,263 @@
+#include "gauge_shader.h"
+#include "raylib/src/rlgl.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ---- Shader source ----
+
+// Prepended to the body for the GL version raylib was built for; the body
+// reads IN varyings and writes FRAG_COLOR
+static const char HEADER_GLSL100[] =
+    "#version 100\n"
+    "#ifdef GL_FRAGMENT_PRECISION_HIGH\n"
+    "precision highp float;\n"
+    "#else\n"
+    "precision mediump float;\n"
+    "#endif\n"
+    "#define IN varying\n"
+    "#define TEXTURE texture2D\n"
+    "#define FRAG_COLOR gl_FragColor\n";
+
+static const char HEADER_GLSL120[] =
+    "#version 120\n"
+    "#define IN varying\n"
+    "#define TEXTURE texture2D\n"
+    "#define FRAG_COLOR gl_FragColor\n";
+
+static const char HEADER_GLSL300ES[] =
+    "#version 300 es\n"
+    "precision highp float;\n"
+    "#define IN in\n"
+    "#define TEXTURE texture\n"
+    "out vec4 finalColor;\n"
+    "#define FRAG_COLOR finalColor\n";
+
+static const char HEADER_GLSL330[] =
+    "#version 330\n"
+    "#define IN in\n"
+    "#define TEXTURE texture\n"
+    "out vec4 finalColor;\n"
+    "#define FRAG_COLOR finalColor\n";
+
+// Colours are gauges.c's raylib colours. Compositing is premultiplied, so
+// only the bezel's anti-aliased rim ends up translucent.
+static const char FRAGMENT_BODY[] =
+    "IN vec2 fragTexCoord;\n"
+    "IN vec4 fragColor;\n"
+    "uniform sampler2D texture0;\n"
+    "uniform vec4 gaugeGeometry;\n"   // half size, radius, warn, red
+    "uniform vec4 gaugeScale;\n"      // intervals, minor per step, major inner, major thick
+    "uniform vec4 gaugeMinor;\n"      // minor inner, minor thick, zone inner, zone outer
+    "uniform vec4 gaugeNeedle;\n"     // angle, length, half width, shadow
+    "uniform vec4 gaugeNeedleColor;\n"
+    "uniform vec4 gaugeHub;\n"        // radius, core, readout corner
+    "uniform vec4 gaugeReadout;\n"    // x, y, width, height
+    "\n"
+    "const float START = 2.35619449;\n"        // 135 degrees
+    "const float SWEEP = 4.71238898;\n"        // 270 degrees
+    "const float TURN = 6.28318531;\n"
+    "const vec4 BLACK = vec4(0.0, 0.0, 0.0, 1.0);\n"
+    "const vec4 DARKGRAY = vec4(0.314, 0.314, 0.314, 1.0);\n"
+    "const vec4 GRAY = vec4(0.51, 0.51, 0.51, 1.0);\n"
+    "const vec4 FACE = vec4(0.078, 0.078, 0.118, 1.0);\n"
+    "const vec4 WHITE = vec4(1.0);\n"
+    "const vec4 YELLOW = vec4(0.992, 0.976, 0.0, 1.0);\n"
+    "const vec4 RED = vec4(0.902, 0.161, 0.216, 1.0);\n"
+    "const vec4 SHADOW = vec4(0.0, 0.0, 0.0, 0.392);\n"
+    "const vec4 ZONE_NORMAL = vec4(0.0, 1.0, 0.0, 0.078);\n"
+    "const vec4 ZONE_WARN = vec4(1.0, 1.0, 0.0, 0.157);\n"
+    "const vec4 ZONE_RED = vec4(1.0, 0.0, 0.0, 0.157);\n"
+    "\n"
+    // One pixel of anti-aliasing across the edge, d < 0 inside
+    "float Coverage(float d) { return clamp(0.5 - d, 0.0, 1.0); }\n"
+    "\n"
+    "vec4 Over(vec4 dst, vec4 paint, float coverage) {\n"
+    "    float a = paint.a * coverage;\n"
+    "    return vec4(paint.rgb * a, a) + dst * (1.0 - a);\n"
+    "}\n"
+    "\n"
+    // Radial line from inner to outer at an angle
+    "float Tick(vec2 p, float angle, float inner, float outer, float thick) {\n"
+    "    vec2 dir = vec2(cos(angle), sin(angle));\n"
+    "    float along = dot(p, dir);\n"
+    "    float across = abs(p.x * dir.y - p.y * dir.x);\n"
+    "    return max(abs(along - 0.5 * (inner + outer)) - 0.5 * (outer - inner), across - 0.5 * thick);\n"
+    "}\n"
+    "\n"
+    // Triangle from a base of half width w at the centre to a tip at length l
+    "float Needle(vec2 p, float angle, float l, float w) {\n"
+    "    vec2 dir = vec2(cos(angle), sin(angle));\n"
+    "    float along = dot(p, dir);\n"
+    "    float across = abs(p.x * dir.y - p.y * dir.x);\n"
+    "    float side = (across * l + along * w - w * l) / sqrt(l * l + w * w);\n"
+    // The sides meet at a shallow angle: cut the tip off at l, or its
+    // anti-aliasing would reach several pixels past it
+    "    return max(side, max(-along, along - l));\n"
+    "}\n"
+    "\n"
+    "float RoundedBox(vec2 p, vec4 box, float corner) {\n"
+    "    vec2 q = abs(p - box.xy - 0.5 * box.zw) - 0.5 * box.zw + corner;\n"
+    "    return length(max(q, 0.0)) + min(max(q.x, q.y), 0.0) - corner;\n"
+    "}\n"
+    "\n"
+    "void main() {\n"
+    // Pixels from the centre, y down; the quad's texture is bottom up
+    "    vec2 p = vec2(fragTexCoord.x - 0.5, 0.5 - fragTexCoord.y) * 2.0 * gaugeGeometry.x;\n"
+    "    float radius = gaugeGeometry.y;\n"
+    "    float r = length(p);\n"
+    "    if (r > radius + 11.0) {\n"
+    "        FRAG_COLOR = vec4(0.0);\n"
+    "        return;\n"
+    "    }\n"
+    "\n"
+    "    vec4 c = vec4(0.0);\n"
+    "    c = Over(c, BLACK, Coverage(r - radius - 10.0));\n"
+    "    c = Over(c, DARKGRAY, Coverage(r - radius - 5.0));\n"
+    "    c = Over(c, FACE, Coverage(r - radius));\n"
+    "\n"
+    // Ticks and zones only live near the rim
+    "    float rimInner = radius - gaugeScale.z;\n"
+    "    if (gaugeMinor.w > 0.0) rimInner = min(rimInner, gaugeMinor.z);\n"
+    "    if (r > rimInner - 2.0) {\n"
+    // Position along the scale, 0 to 1; the gap below wraps to the nearer end
+    "        float a = atan(p.y, p.x);\n"
+    "        if (a < START) a += TURN;\n"
+    "        float t = (a - START) / SWEEP;\n"
+    "        if (t > 7.0 / 6.0) t -= 4.0 / 3.0;\n"
+    "\n"
+    // Nearest major tick
+    "        float n = gaugeScale.x;\n"
+    "        float kf = clamp(floor(t * n + 0.5), 0.0, n) / n;\n"
+    "        vec4 tickColor = kf >= gaugeGeometry.w ? RED : (kf >= gaugeGeometry.z ? YELLOW : WHITE);\n"
+    "        c = Over(c, tickColor, Coverage(Tick(p, START + SWEEP * kf, radius - gaugeScale.z, radius - 10.0,\n"
+    "                                             gaugeScale.w)));\n"
+    "\n"
+    // Nearest minor tick, unless it is a major one
+    "        float perStep = gaugeScale.y;\n"
+    "        if (perStep > 1.5) {\n"
+    "            float m = n * perStep;\n"
+    "            float j = clamp(floor(t * m + 0.5), 0.0, m);\n"
+    "            if (mod(j + 0.5, perStep) > 1.0) {\n"
+    "                c = Over(c, GRAY, Coverage(Tick(p, START + SWEEP * j / m, radius - gaugeMinor.x,\n"
+    "                                                radius - 10.0, gaugeMinor.y)));\n"
+    "            }\n"
+    "        }\n"
+    "\n"
+    "        if (gaugeMinor.w > 0.0) {\n"
+    "            vec4 zone = t >= gaugeGeometry.w ? ZONE_RED : (t >= gaugeGeometry.z ? ZONE_WARN : ZONE_NORMAL);\n"
+    "            float band = max(gaugeMinor.z - r, r - gaugeMinor.w);\n"
+    "            float ends = max(-t, t - 1.0) * SWEEP * r;\n"
+    "            c = Over(c, zone, Coverage(max(band, ends)));\n"
+    "        }\n"
+    "    }\n"
+    "\n"
+    // Labels and caption, premultiplied
+    "    vec4 text = TEXTURE(texture0, fragTexCoord);\n"
+    "    c = text + c * (1.0 - text.a);\n"
+    "\n"
+    "    if (r < gaugeNeedle.y + 4.0) {\n"
+    "        if (gaugeNeedle.w > 0.5) {\n"
+    "            c = Over(c, SHADOW, Coverage(Needle(p - vec2(2.0), gaugeNeedle.x, gaugeNeedle.y, gaugeNeedle.z)));\n"
+    "        }\n"
+    "        c = Over(c, gaugeNeedleColor, Coverage(Needle(p, gaugeNeedle.x, gaugeNeedle.y, gaugeNeedle.z)));\n"
+    "    }\n"
+    "    c = Over(c, BLACK, Coverage(r - gaugeHub.x - 2.0));\n"
+    "    c = Over(c, DARKGRAY, Coverage(r - gaugeHub.x));\n"
+    "    c = Over(c, gaugeNeedleColor, Coverage(r - gaugeHub.y));\n"
+    "\n"
+    "    if (gaugeReadout.z > 0.0) {\n"
+    "        float box = RoundedBox(p, gaugeReadout, gaugeHub.z);\n"
+    "        c = Over(c, BLACK, Coverage(box));\n"
+    "        c = Over(c, DARKGRAY, Coverage(abs(box) - 0.5));\n"
+    "    }\n"
+    "\n"
+    "    FRAG_COLOR = c.a > 0.0 ? vec4(c.rgb / c.a, c.a) : vec4(0.0);\n"
+    "}\n";
+
+// ---- Loading ----
+
+enum { LOC_GEOMETRY, LOC_SCALE, LOC_MINOR, LOC_NEEDLE, LOC_NEEDLE_COLOR, LOC_HUB, LOC_READOUT, NUM_LOCS };
+
+static const char* UNIFORM_NAMES[NUM_LOCS] = {
+    "gaugeGeometry", "gaugeScale", "gaugeMinor", "gaugeNeedle", "gaugeNeedleColor", "gaugeHub", "gaugeReadout",
+};
+
+static Shader shader;
+static int locs[NUM_LOCS];
+static bool ready = false;
+
+bool GaugeShader_Load(void) {
+    if (ready) return true;
+
+    const char* header;
+    switch (rlGetVersion()) {
+        case RL_OPENGL_ES_20: header = HEADER_GLSL100; break;
+        case RL_OPENGL_21: header = HEADER_GLSL120; break;
+        case RL_OPENGL_ES_30: header = HEADER_GLSL300ES; break;
+        case RL_OPENGL_33:
+        case RL_OPENGL_43: header = HEADER_GLSL330; break;
+        default:
+            fprintf(stderr, "Gauge shader needs OpenGL 2.1 or OpenGL ES 2.0\n");
+            return false;
+    }
+
+    size_t headerLen = strlen(header);
+    char* source = malloc(headerLen + sizeof(FRAGMENT_BODY));
+    if (!source) return false;
+    memcpy(source, header, headerLen);
+    memcpy(source + headerLen, FRAGMENT_BODY, sizeof(FRAGMENT_BODY));
+
+    // raylib's default vertex shader supplies fragTexCoord and fragColor
+    shader = LoadShaderFromMemory(NULL, source);
+    free(source);
+    if (shader.id == 0 || shader.id == rlGetShaderIdDefault()) {
+        fprintf(stderr, "Cannot compile the gauge shader\n");
+        return false;
+    }
+    for (int i = 0; i < NUM_LOCS; i++) {
+        locs[i] = GetShaderLocation(shader, UNIFORM_NAMES[i]);
+    }
+    ready = true;
+    return true;
+}
+
+bool GaugeShader_Ready(void) {
+    return ready;
+}
+
+// ---- Drawing ----
+
+static void SetVec4(int loc, float x, float y, float z, float w) {
+    float value[4] = { x, y, z, w };
+    SetShaderValue(shader, locs[loc], value, SHADER_UNIFORM_VEC4);
+}
+
+void GaugeShader_Draw(const GaugeShaderParams* params, Texture2D text) {
+    if (!ready) return;
+
+    // Changing shaders flushes the batch, so the quad is drawn with these
+    // uniforms before the next gauge sets its own
+    BeginShaderMode(shader);
+    SetVec4(LOC_GEOMETRY, params->half_size, params->radius, params->warn, params->red);
+    SetVec4(LOC_SCALE, params->intervals, params->minor_per_step, params->major_inner, params->major_thick);
+    SetVec4(LOC_MINOR, params->minor_inner, params->minor_thick, params->zone_inner, params->zone_outer);
+    SetVec4(LOC_NEEDLE, params->needle_angle, params->needle_length, params->needle_width,
+            params->needle_shadow ? 1.0f : 0.0f);
+    Color nc = params->needle_color;
+    SetVec4(LOC_NEEDLE_COLOR, nc.r / 255.0f, nc.g / 255.0f, nc.b / 255.0f, nc.a / 255.0f);
+    SetVec4(LOC_HUB, params->hub_radius, params->hub_core, params->readout_corner, 0.0f);
+    SetVec4(LOC_READOUT, params->readout.x, params->readout.y, params->readout.width, params->readout.height);
+
+    float size = 2.0f * params->half_size;
+    DrawTexturePro(text, (Rectangle){ 0, 0, (float)text.width, -(float)text.height },
+                   (Rectangle){ params->center.x - params->half_size, params->center.y - params->half_size, size, size },
+                   (Vector2){ 0, 0 }, 0.0f, WHITE);
+    EndShaderMode();
+}
+
+void GaugeShader_Unload(void) {
+    if (!ready) return;
+    UnloadShader(shader);
+    ready = false;
+}
@@ -0,0 +1,65 @@
+#ifndef GAUGE_SHADER_H
+#define GAUGE_SHADER_H
+
+#include "raylib/src/raylib.h"
+#include <stdbool.h>
+
+// Gauges as signed distance fields: one quad per gauge, shaded by a
+// fragment shader that works out, for every pixel, how far it is from the
+// bezel rings, the nearest tick, the colour zone band, the needle, the hub
+// and the readout box. Each shape gets one pixel of anti-aliasing at any
+// size, and a gauge is a single draw call whatever its scale.
+//
+// Text (scale labels, caption) can't be a distance field here. It comes
+// from a texture the size of the quad, rendered once, which the shader
+// composites between the face and the needle. The readout digits are
+// drawn on top, from their glyph atlas (readout.h).
+//
+// The shader is GLSL 1.00 with a version header chosen at load time. It
+// runs on GLES2 (raylib built with GRAPHICS_API_OPENGL_ES2, the Pi) as
+// well as desktop GL 2.1/3.3: no loops, and nothing past GLES2's minimum
+// of 16 uniform vectors.
+
+typedef struct {
+    Vector2 center;
+    float half_size;         // Half the quad's side, pixels
+    float radius;            // Face radius; the bezel reaches radius + 10
+
+    // Ticks run inwards from radius - 10
+    float intervals;         // Between the first and last major tick
+    float minor_per_step;    // Minor intervals per major one (1 = none)
+    float major_inner;       // Major ticks end at radius - major_inner
+    float major_thick;
+    float minor_inner;
+    float minor_thick;
+
+    float zone_inner;        // Colour zone band radii (zone_outer 0 = none)
+    float zone_outer;
+    float warn;              // Fractions of full scale where the yellow and
+    float red;               // red zones start (above 1 = none)
+
+    float needle_angle;      // Radians, clockwise from +x
+    float needle_length;
+    float needle_width;      // Half the base
+    bool needle_shadow;
+    Color needle_color;
+    float hub_radius;
+    float hub_core;
+
+    Rectangle readout;       // Box relative to the centre (width 0 = none)
+    float readout_corner;
+} GaugeShaderParams;
+
+// Compile the shader for the running GL version. Needs the window; false
+// (reason on stderr) means keep drawing gauges immediately.
+bool GaugeShader_Load(void);
+
+bool GaugeShader_Ready(void);
+
+// One gauge; text is the texture of its labels, a render texture of side
+// 2 * half_size (bottom-up, as render textures are)
+void GaugeShader_Draw(const GaugeShaderParams* params, Texture2D text);
+
+void GaugeShader_Unload(void);
+
+#endif // GAUGE_SHADER_H
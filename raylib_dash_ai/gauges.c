@@ -0,0 +1,434 @@
+#include "gauges.h"
+#include "gauge_shader.h"
+#include "raylib/src/rlgl.h"
+#include <stdio.h>
+#include <math.h>
+
+// Every scale sweeps clockwise from bottom left to bottom right
+#define START_ANGLE 135.0f
+#define END_ANGLE 405.0f
+
+// Room around the bezel in a face texture
+#define FACE_MARGIN 12
+
+// Readout box corners, as a fraction of its shorter side (DrawRectangleRounded)
+#define READOUT_ROUNDNESS 0.2f
+
+// Tachometer colour zone band, inwards from the radius (at the reference radius)
+#define ZONE_INNER 35.0f
+#define ZONE_OUTER 5.0f
+
+// Scaled down text stops here: the default font's own size
+#define MIN_FONT_SIZE 10.0f
+
+static const Color FACE_COLOR = { 20, 20, 30, 255 };
+
+// Each kind of gauge as drawn at its reference radius. Gauge_Make scales
+// the sizes to the gauge's own radius.
+static const GaugeStyle STYLES[] = {
+    [GAUGE_TACHOMETER] = { 1000.0f, 5, 30, 3.0f, 20, 1.5f, 60, 20, 1, 1000.0f, true,
+                           40, 8, true, 10, 6, 120, 50, 20, 35, 30, 4, "",
+                           // Orange, red past the redline; lime digits
+                           { {255, 161, 0, 255}, {255, 161, 0, 255}, {230, 41, 55, 255} },
+                           { {0, 158, 47, 255}, {0, 158, 47, 255}, {0, 158, 47, 255} },
+                           "RPM x1000", {-50, -90}, 15, "REDLINE!", {-70, 100}, 30, 150 },
+    [GAUGE_SPEEDOMETER] = { 20.0f, 2, 25, 2.5f, 18, 1.2f, 50, 16, 2, 1.0f, false,
+                            35, 6, false, 8, 5, 80, 35, 15, 25, 20, 3, "",
+                            // Sky blue
+                            { {102, 191, 255, 255}, {102, 191, 255, 255}, {102, 191, 255, 255} },
+                            { {102, 191, 255, 255}, {102, 191, 255, 255}, {102, 191, 255, 255} },
+                            "km/h", {-22, -70}, 14, "", {0, 0}, 0, 150 },
+    [GAUGE_TEMPERATURE] = { 20.0f, 1, 25, 2.5f, 0, 0.0f, 45, 14, 1, 1.0f, false,
+                            30, 6, false, 8, 5, 70, 35, 15, 22, 22, 1, "°C",
+                            // Lime, yellow, red, digits too
+                            { {0, 158, 47, 255}, {253, 249, 0, 255}, {230, 41, 55, 255} },
+                            { {0, 158, 47, 255}, {253, 249, 0, 255}, {230, 41, 55, 255} },
+                            "COOLANT °C", {-45, -60}, 13, "", {0, 0}, 0, 120 },
+};
+
+static bool useShader = false;
+
+static float ValueAngle(const Gauge* gauge, float value) {
+    if (value < 0.0f) value = 0.0f;
+    if (value > gauge->max) value = gauge->max;
+    return START_ANGLE + (END_ANGLE - START_ANGLE) * (value / gauge->max);
+}
+
+static int NumSteps(const Gauge* gauge) {
+    return (int)(gauge->max / gauge->style.step_value) + 1;
+}
+
+typedef enum { ZONE_NORMAL, ZONE_WARN, ZONE_RED } Zone;
+
+static Zone ValueZone(const Gauge* gauge, float value) {
+    if (gauge->redline > 0.0f && value >= gauge->redline) return ZONE_RED;
+    if (gauge->warn > 0.0f && value >= gauge->warn) return ZONE_WARN;
+    return ZONE_NORMAL;
+}
+
+// Tick and label colour
+static Color ZoneColor(const Gauge* gauge, float value) {
+    switch (ValueZone(gauge, value)) {
+        case ZONE_RED: return RED;
+        case ZONE_WARN: return YELLOW;
+        default: return WHITE;
+    }
+}
+
+// Needle and hub colour
+static Color NeedleColor(const Gauge* gauge, float value) {
+    return gauge->style.needle_colors[ValueZone(gauge, value)];
+}
+
+// ---- Geometry ----
+
+static const Vector2 ORIGIN = { 0.0f, 0.0f };
+
+// Sizes for the gauge's radius: fonts stay legible, flags and counts as they are
+static GaugeStyle ScaleStyle(const GaugeStyle* base, float scale) {
+    GaugeStyle style = *base;
+    float* sizes[] = {
+        &style.major_inner, &style.major_thick, &style.minor_inner, &style.minor_thick, &style.label_radius,
+        &style.needle_inset, &style.needle_width, &style.hub_radius, &style.hub_core, &style.readout_width,
+        &style.readout_height, &style.readout_top, &style.readout_text_top, &style.caption_pos.x, &style.caption_pos.y,
+        &style.alert_pos.x, &style.alert_pos.y,
+    };
+    for (int i = 0; i < (int)(sizeof(sizes) / sizeof(sizes[0])); i++) *sizes[i] *= scale;
+    int* fonts[] = { &style.label_font, &style.readout_font, &style.caption_font, &style.alert_font };
+    for (int i = 0; i < (int)(sizeof(fonts) / sizeof(fonts[0])); i++) {
+        *fonts[i] = (int)fmaxf(MIN_FONT_SIZE, roundf(*fonts[i] * scale));
+    }
+    return style;
+}
+
+static void BuildBezel(Gauge* gauge) {
+    Geo_AddCircle(&gauge->face_mesh, ORIGIN, gauge->radius + 10, BLACK);
+    Geo_AddCircle(&gauge->face_mesh, ORIGIN, gauge->radius + 5, DARKGRAY);
+    Geo_AddCircle(&gauge->face_mesh, ORIGIN, gauge->radius, FACE_COLOR);
+}
+
+// Major ticks with labels, minor ticks between them
+static void BuildScale(Gauge* gauge, const GaugeStyle* style) {
+    float radius = gauge->radius;
+    int numSteps = NumSteps(gauge);
+    for (int i = 0; i < numSteps; i++) {
+        float value = gauge->max * i / (numSteps - 1);
+        float angle = START_ANGLE + (END_ANGLE - START_ANGLE) * i / (numSteps - 1);
+        Color tickColor = ZoneColor(gauge, value);
+        Geo_AddLine(&gauge->face_mesh, Geo_OnCircle(ORIGIN, angle, radius - 10),
+                    Geo_OnCircle(ORIGIN, angle, radius - style->major_inner), style->major_thick, tickColor);
+
+        if (i % style->label_every == 0 && gauge->num_labels < GAUGE_MAX_LABELS) {
+            GaugeLabel* label = &gauge->labels[gauge->num_labels++];
+            label->pos = Geo_OnCircle(ORIGIN, angle, radius - style->label_radius);
+            snprintf(label->text, sizeof(label->text), "%d", (int)(value / style->label_divisor));
+            label->font_size = style->label_font;
+            label->color = tickColor;
+        }
+    }
+
+    int numMinor = (numSteps - 1) * style->minor_per_step;
+    for (int i = 0; i < numMinor && style->minor_per_step > 1; i++) {
+        if (i % style->minor_per_step == 0) continue;
+        float angle = START_ANGLE + (END_ANGLE - START_ANGLE) * i / (float)numMinor;
+        Geo_AddLine(&gauge->face_mesh, Geo_OnCircle(ORIGIN, angle, radius - 10),
+                    Geo_OnCircle(ORIGIN, angle, radius - style->minor_inner), style->minor_thick, GRAY);
+    }
+}
+
+static void BuildZones(Gauge* gauge) {
+    // A line per degree
+    for (int angle = START_ANGLE; angle < END_ANGLE; angle++) {
+        float value = (angle - START_ANGLE) / (END_ANGLE - START_ANGLE) * gauge->max;
+
+        static const Color zoneColors[] = { {0, 255, 0, 20}, {255, 255, 0, 40}, {255, 0, 0, 40} };
+        Color zoneColor = zoneColors[ValueZone(gauge, value)];
+
+        Geo_AddLine(&gauge->face_mesh, Geo_OnCircle(ORIGIN, angle, gauge->radius - ZONE_INNER * gauge->scale),
+                    Geo_OnCircle(ORIGIN, angle, gauge->radius - ZONE_OUTER * gauge->scale), 2.0f, zoneColor);
+    }
+}
+
+static Rectangle ReadoutBox(const GaugeStyle* style) {
+    return (Rectangle){ -style->readout_width / 2, style->readout_top, style->readout_width, style->readout_height };
+}
+
+static float ReadoutCorner(const GaugeStyle* style) {
+    return fminf(style->readout_width, style->readout_height) * READOUT_ROUNDNESS / 2;
+}
+
+static void BuildReadout(Gauge* gauge, const GaugeStyle* style) {
+    Rectangle box = ReadoutBox(style);
+    Geo_AddRoundedRect(&gauge->readout_mesh, box, ReadoutCorner(style), BLACK);
+    Geo_AddRoundedRectLines(&gauge->readout_mesh, box, ReadoutCorner(style), 1.0f, DARKGRAY);
+}
+
+Gauge Gauge_Make(GaugeKind kind, Vector2 center, float radius, float max, float warn, float redline) {
+    Geo_Init();
+    Gauge gauge = { .kind = kind, .center = center, .radius = radius, .max = max, .warn = warn, .redline = redline };
+    gauge.scale = radius / STYLES[kind].reference_radius;
+    gauge.style = ScaleStyle(&STYLES[kind], gauge.scale);
+    const GaugeStyle* style = &gauge.style;
+    BuildBezel(&gauge);
+    BuildScale(&gauge, style);
+    if (style->zones) BuildZones(&gauge);
+    BuildReadout(&gauge, style);
+    gauge.readout = Readout_Make(style->readout_font, style->readout_digits, style->readout_suffix);
+    return gauge;
+}
+
+// Triangles straight into the render batch, offset to the centre
+static void DrawMeshAt(const GeoMesh* mesh, Vector2 center) {
+    rlCheckRenderBatchLimit(mesh->count);
+    rlBegin(RL_TRIANGLES);
+    for (int i = 0; i < mesh->count; i += 3) {
+        Color color = mesh->colors[i / 3];
+        const Vector2* v = &mesh->vertices[i];
+        rlColor4ub(color.r, color.g, color.b, color.a);
+        rlVertex2f(center.x + v[0].x, center.y + v[0].y);
+        rlVertex2f(center.x + v[1].x, center.y + v[1].y);
+        rlVertex2f(center.x + v[2].x, center.y + v[2].y);
+    }
+    rlEnd();
+}
+
+// DrawCircleV from the unit circle table
+static void DrawDisc(Vector2 center, float radius, Color color) {
+    const Vector2* unit = Geo_UnitCircle();
+    int step = GEO_CIRCLE_SEGMENTS / Geo_CircleSegments(radius);
+    rlCheckRenderBatchLimit(3 * GEO_CIRCLE_SEGMENTS);
+    rlBegin(RL_TRIANGLES);
+    rlColor4ub(color.r, color.g, color.b, color.a);
+    for (int i = 0; i < GEO_CIRCLE_SEGMENTS; i += step) {
+        rlVertex2f(center.x, center.y);
+        rlVertex2f(center.x + unit[i + step].x * radius, center.y + unit[i + step].y * radius);
+        rlVertex2f(center.x + unit[i].x * radius, center.y + unit[i].y * radius);
+    }
+    rlEnd();
+}
+
+// ---- Faces ----
+
+// Labels and caption
+static void DrawFaceText(const Gauge* gauge, Vector2 center) {
+    for (int i = 0; i < gauge->num_labels; i++) {
+        const GaugeLabel* label = &gauge->labels[i];
+        int labelWidth = MeasureText(label->text, label->font_size);
+        DrawText(label->text, center.x + label->pos.x - labelWidth / 2, center.y + label->pos.y - label->font_size / 2,
+                 label->font_size, label->color);
+    }
+
+    const GaugeStyle* style = &gauge->style;
+    DrawText(style->caption, center.x + style->caption_pos.x, center.y + style->caption_pos.y, style->caption_font,
+             LIGHTGRAY);
+}
+
+void Gauge_DrawFace(const Gauge* gauge, Vector2 center) {
+    DrawMeshAt(&gauge->face_mesh, center);
+    DrawFaceText(gauge, center);
+}
+
+// ---- Values ----
+
+// Triangle needle from the hub out to length, with an optional drop shadow
+static void DrawNeedleShape(Vector2 center, float angle, float length, float baseWidth, bool shadow, Color color) {
+    float s, c;
+    Geo_SinCos(angle, &s, &c);
+    Vector2 tip = { center.x + c * length, center.y + s * length };
+    // A quarter turn either side: (cos, sin) of angle -/+ 90 is (s, -c) / (-s, c)
+    Vector2 base1 = { center.x + s * baseWidth, center.y - c * baseWidth };
+    Vector2 base2 = { center.x - s * baseWidth, center.y + c * baseWidth };
+
+    // tip, base1, base2 is counter-clockwise on screen at every angle, so
+    // one triangle shows
+    if (shadow) {
+        DrawTriangle((Vector2){tip.x + 2, tip.y + 2}, (Vector2){base1.x + 2, base1.y + 2},
+                     (Vector2){base2.x + 2, base2.y + 2}, (Color){0, 0, 0, 100});
+    }
+    DrawTriangle(tip, base1, base2, color);
+}
+
+static void DrawHub(Vector2 center, float radius, float core, Color color) {
+    DrawDisc(center, radius + 2, BLACK);
+    DrawDisc(center, radius, DARKGRAY);
+    DrawDisc(center, core, color);
+}
+
+// Digits over the readout box
+static void DrawReadoutText(Gauge* gauge, float value) {
+    const GaugeStyle* style = &gauge->style;
+    Readout_Set(&gauge->readout, (int)value);
+    Readout_Draw(&gauge->readout, (Vector2){ gauge->center.x, gauge->center.y + style->readout_text_top },
+                 style->readout_colors[ValueZone(gauge, value)]);
+}
+
+void Gauge_DrawValue(Gauge* gauge, float value) {
+    const GaugeStyle* style = &gauge->style;
+    Vector2 center = gauge->center;
+    Color color = NeedleColor(gauge, value);
+    DrawNeedleShape(center, ValueAngle(gauge, value), gauge->radius - style->needle_inset, style->needle_width,
+                    style->needle_shadow, color);
+    DrawHub(center, style->hub_radius, style->hub_core, color);
+    DrawMeshAt(&gauge->readout_mesh, center);
+    DrawReadoutText(gauge, value);
+}
+
+// ---- Face cache ----
+
+static int FaceHalfSize(const Gauge* gauge) {
+    return (int)ceilf(gauge->radius) + 10 + FACE_MARGIN;
+}
+
+// Start drawing into a texture of side 2 * FaceHalfSize, cleared
+static bool BeginBake(const Gauge* gauge, RenderTexture2D* target) {
+    int half = FaceHalfSize(gauge);
+    if (target->id == 0 || target->texture.width != half * 2) {
+        if (target->id != 0) UnloadRenderTexture(*target);
+        *target = LoadRenderTexture(half * 2, half * 2);
+        if (target->id == 0) return false;
+    }
+
+    // Colour blends as usual, but alpha adds up: translucent zones over the
+    // opaque face leave it opaque, so the blit doesn't show the background
+    BeginTextureMode(*target);
+    ClearBackground(BLANK);
+    rlSetBlendFactorsSeparate(RL_SRC_ALPHA, RL_ONE_MINUS_SRC_ALPHA, RL_ONE, RL_ONE_MINUS_SRC_ALPHA, RL_FUNC_ADD,
+                              RL_FUNC_ADD);
+    BeginBlendMode(BLEND_CUSTOM_SEPARATE);
+    return true;
+}
+
+static void EndBake(void) {
+    EndBlendMode();
+    EndTextureMode();
+}
+
+bool Gauge_PrepareFace(Gauge* gauge) {
+    // Without its atlas the readout still draws, as text
+    Readout_Prepare(&gauge->readout);
+
+    Vector2 middle = { (float)FaceHalfSize(gauge), (float)FaceHalfSize(gauge) };
+    if (useShader) {
+        // The shader draws the face; only its text goes into a texture
+        if (gauge->text_ready) return true;
+        if (!BeginBake(gauge, &gauge->text)) return false;
+        DrawFaceText(gauge, middle);
+        EndBake();
+        gauge->text_ready = true;
+        return true;
+    }
+
+    if (gauge->face_ready) return true;
+    if (!BeginBake(gauge, &gauge->face)) return false;
+    Gauge_DrawFace(gauge, middle);
+    EndBake();
+    gauge->face_ready = true;
+    return true;
+}
+
+// ---- Shader backend ----
+
+bool Gauge_UseShader(bool enable) {
+    useShader = enable && GaugeShader_Load();
+    return useShader;
+}
+
+bool Gauge_ShaderActive(void) {
+    return useShader;
+}
+
+void Gauge_UnloadShader(void) {
+    GaugeShader_Unload();
+    useShader = false;
+}
+
+static void DrawWithShader(Gauge* gauge, float value) {
+    const GaugeStyle* style = &gauge->style;
+    GaugeShaderParams params = {
+        .center = gauge->center,
+        .half_size = (float)FaceHalfSize(gauge),
+        .radius = gauge->radius,
+        .intervals = (float)(NumSteps(gauge) - 1),
+        .minor_per_step = (float)style->minor_per_step,
+        .major_inner = style->major_inner,
+        .major_thick = style->major_thick,
+        .minor_inner = style->minor_inner,
+        .minor_thick = style->minor_thick,
+        .zone_inner = style->zones ? gauge->radius - ZONE_INNER * gauge->scale : 0.0f,
+        .zone_outer = style->zones ? gauge->radius - ZONE_OUTER * gauge->scale : 0.0f,
+        .warn = gauge->warn > 0.0f ? gauge->warn / gauge->max : 2.0f,
+        .red = gauge->redline > 0.0f ? gauge->redline / gauge->max : 2.0f,
+        .needle_angle = ValueAngle(gauge, value) * DEG2RAD,
+        .needle_length = gauge->radius - style->needle_inset,
+        .needle_width = style->needle_width,
+        .needle_shadow = style->needle_shadow,
+        .needle_color = NeedleColor(gauge, value),
+        .hub_radius = style->hub_radius,
+        .hub_core = style->hub_core,
+        .readout = ReadoutBox(style),
+        .readout_corner = ReadoutCorner(style),
+    };
+    GaugeShader_Draw(&params, gauge->text.texture);
+    DrawReadoutText(gauge, value);
+}
+
+// ---- Drawing ----
+
+void Gauge_Draw(Gauge* gauge, float value) {
+    gauge->drawn_value = value;
+    gauge->drawn = true;
+    if (useShader && gauge->text_ready) {
+        DrawWithShader(gauge, value);
+        return;
+    }
+
+    if (gauge->face_ready) {
+        // Render textures are stored bottom up: flip while blitting
+        float size = (float)gauge->face.texture.width;
+        int half = FaceHalfSize(gauge);
+        DrawTextureRec(gauge->face.texture, (Rectangle){ 0, 0, size, -size },
+                       (Vector2){ gauge->center.x - half, gauge->center.y - half }, WHITE);
+    } else {
+        Gauge_DrawFace(gauge, gauge->center);
+    }
+    Gauge_DrawValue(gauge, value);
+}
+
+// ---- Damage tracking ----
+
+Rectangle Gauge_Bounds(const Gauge* gauge) {
+    int half = FaceHalfSize(gauge);
+    return (Rectangle){ gauge->center.x - half, gauge->center.y - half, 2.0f * half, 2.0f * half };
+}
+
+float Gauge_ValueTolerance(const Gauge* gauge) {
+    float length = gauge->radius - gauge->style.needle_inset;
+    float pixelsPerUnit = (END_ANGLE - START_ANGLE) * DEG2RAD * length / gauge->max;
+    return 0.25f / pixelsPerUnit;
+}
+
+bool Gauge_Changed(const Gauge* gauge, float value) {
+    if (!gauge->drawn) return true;
+    if (fabsf(value - gauge->drawn_value) >= Gauge_ValueTolerance(gauge)) return true;
+    if ((int)value != (int)gauge->drawn_value) return true;
+    return ValueZone(gauge, value) != ValueZone(gauge, gauge->drawn_value);
+}
+
+void Gauge_InvalidateFace(Gauge* gauge) {
+    gauge->face_ready = false;
+    gauge->text_ready = false;
+    gauge->drawn = false;
+}
+
+void Gauge_Unload(Gauge* gauge) {
+    if (gauge->face.id != 0) UnloadRenderTexture(gauge->face);
+    if (gauge->text.id != 0) UnloadRenderTexture(gauge->text);
+    gauge->face = (RenderTexture2D){0};
+    gauge->text = (RenderTexture2D){0};
+    gauge->face_ready = false;
+    gauge->text_ready = false;
+    Geo_FreeMesh(&gauge->face_mesh);
+    Geo_FreeMesh(&gauge->readout_mesh);
+    gauge->num_labels = 0;
+    Readout_Unload(&gauge->readout);
+}
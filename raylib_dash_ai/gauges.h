@@ -0,0 +1,166 @@
+#ifndef GAUGES_H
+#define GAUGES_H
+
+#include "raylib/src/raylib.h"
+#include "gauge_geometry.h"
+#include "readout.h"
+#include <stdbool.h>
+
+// The dashboard's round gauges, drawn in two layers:
+//
+//   face    bezel, ticks, labels, colour zones and caption: everything that
+//           only changes with the gauge's size or scale
+//   value   needle, hub and digital readout
+//
+// The face can be drawn straight to the screen, or rendered once into a
+// texture and then blitted each frame as a single quad. A cached face is
+// rendered again only after Gauge_InvalidateFace (a resize, a new scale).
+//
+// Ticks, zones, bezel and the readout box are built into meshes once, by
+// Gauge_Make; a frame only offsets them to the centre. The needle takes a
+// table lookup for its angle (gauge_geometry.h), so drawing a gauge makes
+// no trigonometry calls. The readout digits come from a glyph atlas
+// (readout.h), laid out again only when the displayed number changes.
+//
+// Optionally (Gauge_UseShader) each gauge is instead one quad shaded as
+// signed distance fields (gauge_shader.h): anti-aliased at any size, one draw
+// call plus the readout digits. The face's text is then the only thing
+// prepared into a texture. Without the shader, or on a GL it doesn't
+// compile for, gauges draw as above.
+//
+// Render textures and the shader need the window: set gauges up after
+// InitWindow, and unload them before CloseWindow.
+
+#define GAUGE_MAX_LABELS 16
+
+typedef struct {
+    Vector2 pos;             // Centre of the text, relative to the gauge's
+    char text[8];
+    int font_size;
+    Color color;
+} GaugeLabel;
+
+typedef enum {
+    GAUGE_TACHOMETER,
+    GAUGE_SPEEDOMETER,
+    GAUGE_TEMPERATURE
+} GaugeKind;
+
+// Sizes (pixels unless noted) and colours of a kind of gauge. Gauge_Make
+// resolves them for the gauge's radius, so drawing it looks nothing up by
+// kind.
+typedef struct {
+    float step_value;        // Scale units between major ticks
+    int minor_per_step;      // Minor intervals per major one (1 = none)
+    float major_inner;       // Ticks run from radius - 10 to radius - inner
+    float major_thick;
+    float minor_inner;
+    float minor_thick;
+    float label_radius;      // Labels at radius - label_radius
+    int label_font;
+    int label_every;         // Label every n-th major tick
+    float label_divisor;     // Label = value / divisor
+    bool zones;              // Colour zone band
+
+    float needle_inset;      // Needle length = radius - inset
+    float needle_width;      // Half the base
+    bool needle_shadow;
+    float hub_radius;
+    float hub_core;
+
+    float readout_width;
+    float readout_height;
+    float readout_top;       // Box top below the centre
+    int readout_font;
+    float readout_text_top;
+    int readout_digits;      // Zero padded to this many
+    const char* readout_suffix;
+
+    Color needle_colors[3];  // Needle and hub, by zone: normal, warn, red
+    Color readout_colors[3];
+    const char* caption;
+    Vector2 caption_pos;     // Top left, relative to the centre
+    int caption_font;
+    const char* alert;       // Shown in the red zone ("" = nothing)
+    Vector2 alert_pos;       // Top left, relative to the centre
+    int alert_font;
+
+    float reference_radius;  // Radius the sizes are for
+} GaugeStyle;
+
+typedef struct {
+    GaugeKind kind;
+    Vector2 center;
+    float radius;
+    float max;               // Full scale (the scale starts at 0)
+    float warn;              // Start of the yellow zone (0 = none)
+    float redline;           // Start of the red zone (0 = none)
+    float scale;             // Radius over the kind's reference radius
+    GaugeStyle style;        // Resolved for the radius
+
+    // Geometry relative to the centre, shared by copies of the gauge
+    GeoMesh face_mesh;       // Bezel, colour zones and ticks
+    GeoMesh readout_mesh;    // Box behind the digital readout
+    GaugeLabel labels[GAUGE_MAX_LABELS];
+    int num_labels;
+    Readout readout;
+
+    // Cached face
+    RenderTexture2D face;
+    bool face_ready;
+
+    // Labels and caption for the shader
+    RenderTexture2D text;
+    bool text_ready;
+
+    // Value of the last Gauge_Draw, for damage tracking
+    float drawn_value;
+    bool drawn;
+} Gauge;
+
+// Geometry built, face not rendered yet. Needs no window.
+Gauge Gauge_Make(GaugeKind kind, Vector2 center, float radius, float max, float warn, float redline);
+
+// Face drawn immediately at center (also what the cache is rendered from)
+void Gauge_DrawFace(const Gauge* gauge, Vector2 center);
+
+// Needle, hub and readout for a value
+void Gauge_DrawValue(Gauge* gauge, float value);
+
+// Render the face (with the shader: its text) and the readout's digits into
+// textures if they aren't there yet. Call outside BeginDrawing/EndDrawing; returns false if the
+// texture can't be created.
+bool Gauge_PrepareFace(Gauge* gauge);
+
+// Whole gauge: through the shader if active and prepared, else the cached
+// face if prepared (immediate otherwise), then the value
+void Gauge_Draw(Gauge* gauge, float value);
+
+// Square the whole gauge draws within, on screen
+Rectangle Gauge_Bounds(const Gauge* gauge);
+
+// Smallest change of value that moves the needle tip a quarter of a pixel
+float Gauge_ValueTolerance(const Gauge* gauge);
+
+// Whether drawing value would change the gauge's pixels since the last
+// Gauge_Draw: the needle moved by the tolerance or more, or the readout's
+// number or the needle's colour changed. Always true before the first draw
+// and after Gauge_InvalidateFace.
+bool Gauge_Changed(const Gauge* gauge, float value);
+
+// Switch all gauges to the shader (compiled on first use) or back. Returns
+// whether the shader is now in use; false when enabling means it isn't
+// available and gauges stay as they were. Prepare faces again after a switch.
+bool Gauge_UseShader(bool enable);
+
+bool Gauge_ShaderActive(void);
+
+void Gauge_UnloadShader(void);
+
+// Render the face again before the next Gauge_Draw (size or scale changed)
+void Gauge_InvalidateFace(Gauge* gauge);
+
+// Frees the textures and the geometry; the gauge can't be drawn after
+void Gauge_Unload(Gauge* gauge);
+
+#endif // GAUGES_H
@@ -0,0 +1,178 @@
+#include "needle_motion.h"
+#include "obd_pids.h"
+#include <math.h>
+#include <string.h>
+
+// A critically damped spring covers 90% of a step in 3.89 / omega
+#define SPRING_90_PERCENT 3.89f
+
+NeedleTuning Needle_DefaultTuning(uint8_t pid) {
+    NeedleTuning tuning = {
+        .filter = NEEDLE_SPRING,
+        .response_s = 1.0f,
+        .min_cutoff_hz = 0.5f,
+        .beta = 0.0f,
+        .d_cutoff_hz = 1.0f,
+        .latency_s = 0.0f,
+        .max_lead_s = 0.0f,
+        .slope_samples = 3,
+    };
+    switch (pid) {
+        case 0x0C:   // Engine speed: quick, and worth leading
+            tuning.response_s = 0.1f;
+            tuning.latency_s = 0.05f;
+            tuning.max_lead_s = 0.15f;
+            break;
+        case 0x0D:   // Vehicle speed
+            tuning.response_s = 0.3f;
+            tuning.latency_s = 0.05f;
+            tuning.max_lead_s = 0.25f;
+            break;
+        default:     // Temperatures, pressures: slow, never extrapolated
+            break;
+    }
+    const OBDPIDInfo* info = OBD_GetPIDInfo(pid);
+    if (info && info->max > info->min) {
+        tuning.min = info->min;
+        tuning.max = info->max;
+    }
+    return tuning;
+}
+
+void Needle_Init(NeedleMotion* needle, const NeedleTuning* tuning, float initial) {
+    memset(needle, 0, sizeof(*needle));
+    needle->tuning = *tuning;
+    if (needle->tuning.slope_samples < 2) needle->tuning.slope_samples = 2;
+    if (needle->tuning.slope_samples > NEEDLE_HISTORY) needle->tuning.slope_samples = NEEDLE_HISTORY;
+    needle->position = initial;
+    needle->previous_target = initial;
+}
+
+void Needle_AddSample(NeedleMotion* needle, long long timestamp_us, float value) {
+    if (needle->num_samples > 0) {
+        int newest = (needle->next + NEEDLE_HISTORY - 1) % NEEDLE_HISTORY;
+        if (timestamp_us <= needle->sample_us[newest]) return;
+    }
+    needle->sample_us[needle->next] = timestamp_us;
+    needle->sample[needle->next] = value;
+    needle->next = (needle->next + 1) % NEEDLE_HISTORY;
+    if (needle->num_samples < NEEDLE_HISTORY) needle->num_samples++;
+}
+
+// Target now and how fast it is moving (units/s)
+static void Estimate(const NeedleMotion* needle, long long now_us, float* target, float* slope) {
+    const NeedleTuning* tuning = &needle->tuning;
+    *slope = 0.0f;
+    if (needle->num_samples == 0) {
+        *target = needle->position;
+        return;
+    }
+    int newest = (needle->next + NEEDLE_HISTORY - 1) % NEEDLE_HISTORY;
+    *target = needle->sample[newest];
+
+    int k = needle->num_samples < tuning->slope_samples ? needle->num_samples : tuning->slope_samples;
+    if (tuning->max_lead_s > 0.0f && k >= 2) {
+        // Least-squares slope over the newest k samples, times relative to the newest
+        float mean_t = 0.0f, mean_v = 0.0f;
+        float t[NEEDLE_HISTORY], v[NEEDLE_HISTORY];
+        for (int i = 0; i < k; i++) {
+            int slot = (newest - i + NEEDLE_HISTORY) % NEEDLE_HISTORY;
+            t[i] = (needle->sample_us[slot] - needle->sample_us[newest]) / 1e6f;
+            v[i] = needle->sample[slot];
+            mean_t += t[i];
+            mean_v += v[i];
+        }
+        mean_t /= k;
+        mean_v /= k;
+        float num = 0.0f, den = 0.0f;
+        for (int i = 0; i < k; i++) {
+            num += (t[i] - mean_t) * (v[i] - mean_v);
+            den += (t[i] - mean_t) * (t[i] - mean_t);
+        }
+        if (den > 0.0f) *slope = num / den;
+
+        // A sample arriving now describes the engine latency_s ago
+        float lead = (now_us - needle->sample_us[newest]) / 1e6f + tuning->latency_s;
+        if (lead > tuning->max_lead_s) {
+            lead = tuning->max_lead_s;
+            *slope = 0.0f;   // Out of data: hold the extrapolated value
+        }
+        if (lead > 0.0f) *target += *slope * lead;
+    }
+
+    if (tuning->max > tuning->min) {
+        if (*target < tuning->min) *target = tuning->min;
+        if (*target > tuning->max) *target = tuning->max;
+    }
+}
+
+float Needle_Target(const NeedleMotion* needle, long long now_us) {
+    float target, slope;
+    Estimate(needle, now_us, &target, &slope);
+    return target;
+}
+
+// Exact step of a critically damped spring toward a target moving at
+// target_speed: in the target's frame y'' = -2w y' - w^2 y, whose solution
+// over dt is closed-form, so the path doesn't depend on how dt is sliced.
+static void SpringStep(NeedleMotion* needle, float target, float target_speed, float dt) {
+    float omega = SPRING_90_PERCENT / (needle->tuning.response_s > 0.001f ? needle->tuning.response_s : 0.001f);
+    float y0 = needle->position - (target - target_speed * dt);
+    float v0 = needle->velocity - target_speed;
+    float c2 = v0 + omega * y0;
+    float e = expf(-omega * dt);
+    float y = (y0 + c2 * dt) * e;
+    float vy = (c2 - omega * (y0 + c2 * dt)) * e;
+    needle->position = target + y;
+    needle->velocity = target_speed + vy;
+}
+
+static float Alpha(float cutoff_hz, float dt) {
+    float tau = 1.0f / (2.0f * (float)M_PI * cutoff_hz);
+    return 1.0f / (1.0f + tau / dt);
+}
+
+// One-euro filter step: smooth the target's speed, raise the cutoff with it
+static void OneEuroStep(NeedleMotion* needle, float target, float dt) {
+    const NeedleTuning* tuning = &needle->tuning;
+    float speed = (target - needle->previous_target) / dt;
+    needle->filtered_speed += Alpha(tuning->d_cutoff_hz, dt) * (speed - needle->filtered_speed);
+    float cutoff = tuning->min_cutoff_hz + tuning->beta * fabsf(needle->filtered_speed);
+    needle->position += Alpha(cutoff, dt) * (target - needle->position);
+    needle->velocity = needle->filtered_speed;
+}
+
+static float Advance(NeedleMotion* needle, long long now_us, float target, float target_speed) {
+    if (!needle->started) {
+        needle->started = true;
+        needle->last_update_us = now_us;
+        needle->previous_target = target;
+        return needle->position;
+    }
+    float dt = (now_us - needle->last_update_us) / 1e6f;
+    if (dt <= 0.0f) return needle->position;
+    needle->last_update_us = now_us;
+
+    if (needle->tuning.filter == NEEDLE_ONE_EURO) OneEuroStep(needle, target, dt);
+    else SpringStep(needle, target, target_speed, dt);
+    needle->previous_target = target;
+    return needle->position;
+}
+
+float Needle_Update(NeedleMotion* needle, long long now_us) {
+    float target, slope;
+    Estimate(needle, now_us, &target, &slope);
+    return Advance(needle, now_us, target, slope);
+}
+
+float Needle_UpdateTo(NeedleMotion* needle, long long now_us, float target) {
+    return Advance(needle, now_us, target, 0.0f);
+}
+
+bool Needle_Settled(const NeedleMotion* needle, float tolerance) {
+    if (!needle->started) return true;
+    if (fabsf(needle->previous_target - needle->position) > tolerance) return false;
+    // The one-euro filter only closes in on the target; a spring can carry on past it
+    if (needle->tuning.filter == NEEDLE_SPRING) return fabsf(needle->velocity) * needle->tuning.response_s <= tolerance;
+    return true;
+}
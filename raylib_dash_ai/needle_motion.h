@@ -0,0 +1,79 @@
+#ifndef NEEDLE_MOTION_H
+#define NEEDLE_MOTION_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Needle motion driven by sample timestamps and real frame times, so a gauge
+// moves the same at 20 FPS as at 144 FPS.
+//
+// Samples go in with the time they arrived. The target the needle chases is
+// the newest sample, optionally extrapolated along the slope of the last few
+// samples to the present plus the acquisition latency (a sample arriving now
+// describes the engine latency_s ago). The needle follows that target either
+// as a critically damped spring, integrated exactly for each frame's dt, or
+// through a one-euro filter (a low-pass whose cutoff rises with speed: steady
+// when still, quick when moving).
+//
+// Times are microseconds on one monotonic clock (OBD_NowMicros).
+
+// Samples kept for the extrapolation slope
+#define NEEDLE_HISTORY 4
+
+typedef enum {
+    NEEDLE_SPRING = 0,       // Critically damped spring
+    NEEDLE_ONE_EURO          // One-euro filter (Casiez et al. 2012)
+} NeedleFilter;
+
+typedef struct {
+    NeedleFilter filter;
+    float response_s;        // Spring: time to cover 90% of a step
+    float min_cutoff_hz;     // One-euro: cutoff at rest (lower = steadier)
+    float beta;              // One-euro: cutoff increase per unit/s of speed
+    float d_cutoff_hz;       // One-euro: cutoff for the speed estimate
+    float latency_s;         // Age of a sample when it arrives
+    float max_lead_s;        // Longest extrapolation past the newest sample (0 = none)
+    int slope_samples;       // Samples in the slope fit, 2..NEEDLE_HISTORY
+    float min;               // Clamp for the target (ignored when max <= min)
+    float max;
+} NeedleTuning;
+
+typedef struct {
+    NeedleTuning tuning;
+    long long sample_us[NEEDLE_HISTORY];   // Newest samples, ring
+    float sample[NEEDLE_HISTORY];
+    int num_samples;
+    int next;
+    float position;          // Displayed value
+    float velocity;          // Spring state, units/s
+    float filtered_speed;    // One-euro speed estimate
+    float previous_target;
+    long long last_update_us;
+    bool started;            // Has been updated at least once
+} NeedleMotion;
+
+// Tuning for a Mode 01 PID: fast for RPM, moderate for speed, slow and
+// without extrapolation for temperatures and anything else
+NeedleTuning Needle_DefaultTuning(uint8_t pid);
+
+// Start at a value, with no samples
+void Needle_Init(NeedleMotion* needle, const NeedleTuning* tuning, float initial);
+
+// A new sample and its arrival time. Samples not newer than the last are ignored.
+void Needle_AddSample(NeedleMotion* needle, long long timestamp_us, float value);
+
+// Best estimate of the value right now: the newest sample, extrapolated as
+// far as the tuning allows. Returns the needle position if there are no samples.
+float Needle_Target(const NeedleMotion* needle, long long now_us);
+
+// Advance to now toward Needle_Target; returns the position to draw
+float Needle_Update(NeedleMotion* needle, long long now_us);
+
+// Advance to now toward an explicit target (no samples, no extrapolation)
+float Needle_UpdateTo(NeedleMotion* needle, long long now_us, float target);
+
+// At rest: within tolerance of the target of the last update, and (spring)
+// not moving fast enough to leave it within the response time
+bool Needle_Settled(const NeedleMotion* needle, float tolerance);
+
+#endif // NEEDLE_MOTION_H
@@ -0,0 +1,105 @@
+#include "obd_cache.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+// File layout: OBDCacheHeader, then `count` entries, most recent first.
+// Written to a temporary file, synced and renamed, so a crash or a power cut
+// leaves the old cache.
+#define OBD_CACHE_MAGIC       0x4344424FU   // "OBDC"
+#define OBD_CACHE_VERSION     1
+#define OBD_CACHE_MAX_ENTRIES 16
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t count;
+    uint32_t checksum;       // FNV-1a over the entries
+} OBDCacheHeader;
+
+static uint32_t Checksum(const void* data, size_t len) {
+    const uint8_t* bytes = (const uint8_t*)data;
+    uint32_t hash = 2166136261U;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= bytes[i];
+        hash *= 16777619U;
+    }
+    return hash;
+}
+
+// Load all entries; returns the count (0 if the file is missing or invalid)
+static int LoadEntries(const char* cache_path, OBDCacheEntry* entries) {
+    FILE* file = fopen(cache_path, "rb");
+    if (!file) return 0;
+
+    OBDCacheHeader header;
+    int count = 0;
+    if (fread(&header, sizeof(header), 1, file) == 1 &&
+        header.magic == OBD_CACHE_MAGIC &&
+        header.version == OBD_CACHE_VERSION &&
+        header.count <= OBD_CACHE_MAX_ENTRIES &&
+        fread(entries, sizeof(OBDCacheEntry), header.count, file) == header.count &&
+        Checksum(entries, sizeof(OBDCacheEntry) * header.count) == header.checksum) {
+        count = header.count;
+    }
+
+    fclose(file);
+    return count;
+}
+
+bool OBD_CacheLookup(const char* cache_path, const char* device_path, OBDCacheEntry* entry) {
+    OBDCacheEntry entries[OBD_CACHE_MAX_ENTRIES];
+    if (strlen(device_path) >= sizeof(entries[0].device_path)) return false;   // Never stored
+    int count = LoadEntries(cache_path, entries);
+
+    for (int i = 0; i < count; i++) {
+        entries[i].device_path[sizeof(entries[i].device_path) - 1] = '\0';
+        if (strcmp(entries[i].device_path, device_path) == 0) {
+            *entry = entries[i];
+            entry->vin[sizeof(entry->vin) - 1] = '\0';
+            return true;
+        }
+    }
+    return false;
+}
+
+bool OBD_CacheStore(const char* cache_path, const OBDCacheEntry* entry) {
+    if (memchr(entry->device_path, '\0', sizeof(entry->device_path)) == NULL) return false;
+    OBDCacheEntry entries[OBD_CACHE_MAX_ENTRIES];
+    int old_count = LoadEntries(cache_path, entries);
+
+    // New entry first, then the others minus the one it replaces
+    OBDCacheEntry updated[OBD_CACHE_MAX_ENTRIES];
+    int count = 0;
+    updated[count++] = *entry;
+    for (int i = 0; i < old_count && count < OBD_CACHE_MAX_ENTRIES; i++) {
+        bool same = entry->vin[0] ? strcmp(entries[i].vin, entry->vin) == 0
+                                  : (entries[i].vin[0] == '\0' &&
+                                     strcmp(entries[i].device_path, entry->device_path) == 0);
+        if (!same) updated[count++] = entries[i];
+    }
+
+    OBDCacheHeader header = {
+        .magic = OBD_CACHE_MAGIC,
+        .version = OBD_CACHE_VERSION,
+        .count = (uint16_t)count,
+        .checksum = Checksum(updated, sizeof(OBDCacheEntry) * count)
+    };
+
+    char tmp_path[512];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", cache_path);
+    FILE* file = fopen(tmp_path, "wb");
+    if (!file) return false;
+
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+              fwrite(updated, sizeof(OBDCacheEntry), count, file) == (size_t)count;
+    // On disk before the rename, or a power cut (every ignition off) can
+    // leave the renamed file empty
+    ok = ok && fflush(file) == 0 && fsync(fileno(file)) == 0;
+    ok = (fclose(file) == 0) && ok;
+    if (!ok || rename(tmp_path, cache_path) != 0) {
+        remove(tmp_path);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,31 @@
+#ifndef OBD_CACHE_H
+#define OBD_CACHE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// What OBD_Init learned about a vehicle, saved so the next connection can skip
+// the ATSP0 protocol search and the supported-PID bitmap queries.
+typedef struct {
+    char vin[18];            // Mode 09 PID 02, "" if the vehicle doesn't report one
+    char device_path[110];   // Adapter the vehicle was last seen on (longer paths aren't cached)
+    uint8_t protocol;        // ATDPN protocol number
+    uint8_t response_count;  // Accepted response-count suffix (0 = none)
+    uint8_t multi_pid;       // Batched Mode 01 requests work
+    uint8_t reserved;
+    uint8_t bitmap00[4];     // Raw reply to 0100, used to confirm the vehicle
+    uint32_t supported[8];   // Supported PID bits (bit pid & 31 of word pid >> 5)
+} OBDCacheEntry;
+
+// Most recent entry for an adapter path. Returns false if the file is missing,
+// unreadable, corrupt, or has no entry for the path (always, for a path too
+// long to store).
+bool OBD_CacheLookup(const char* cache_path, const char* device_path, OBDCacheEntry* entry);
+
+// Save an entry, replacing the one with the same VIN (or the same adapter path
+// when there is no VIN). Most recent entries are kept; the oldest drop off.
+// Returns false if the file can't be written or the device path isn't
+// terminated within its field.
+bool OBD_CacheStore(const char* cache_path, const OBDCacheEntry* entry);
+
+#endif // OBD_CACHE_H
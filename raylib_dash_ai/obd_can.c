@@ -0,0 +1,271 @@
+#include "obd_can.h"
+#include <stdio.h>
+#include <string.h>
+
+#ifdef __linux__
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <net/if.h>
+#include <linux/can.h>
+#include <linux/can/raw.h>
+#include <linux/can/isotp.h>
+
+// OBD frames are always 8 bytes; unused bytes are padding
+#define PADDING 0x00
+
+// ECUs on the 7E8-7EF reply range
+#define MAX_ECUS 8
+
+// Longest wait for the next frame of a multi-frame reply (ISO 15765-4 N_Cr)
+#define FRAME_GAP_MS 150
+
+bool OBD_CANIsInterface(const char* name) {
+    if (name == NULL || name[0] == '\0' || strchr(name, '/') != NULL) return false;
+    if (strlen(name) >= IFNAMSIZ) return false;
+    return if_nametoindex(name) != 0;
+}
+
+bool OBD_CANOpen(OBDConnection* conn, const char* ifname, bool isotp) {
+    unsigned int ifindex = if_nametoindex(ifname);
+    if (ifindex == 0) {
+        fprintf(stderr, "No CAN interface %s\n", ifname);
+        return false;
+    }
+
+    int fd = isotp ? socket(PF_CAN, SOCK_DGRAM, CAN_ISOTP) : socket(PF_CAN, SOCK_RAW, CAN_RAW);
+    if (fd < 0) {
+        fprintf(stderr, "Error opening %s: %s\n", ifname, strerror(errno));
+        return false;
+    }
+
+    struct sockaddr_can addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.can_family = AF_CAN;
+    addr.can_ifindex = (int)ifindex;
+
+    if (isotp) {
+        // The kernel does segmentation and flow control; pad single frames to
+        // 8 bytes as ISO 15765-4 requires
+        struct can_isotp_options opts;
+        memset(&opts, 0, sizeof(opts));
+        opts.flags = CAN_ISOTP_TX_PADDING;
+        opts.txpad_content = PADDING;
+        setsockopt(fd, SOL_CAN_ISOTP, CAN_ISOTP_OPTS, &opts, sizeof(opts));
+        addr.can_addr.tp.tx_id = OBD_CAN_PHYSICAL_ID;
+        addr.can_addr.tp.rx_id = OBD_CAN_REPLY_ID;
+    } else {
+        // Only 11-bit data frames from the ECU reply range reach us
+        struct can_filter filter = {
+            .can_id = OBD_CAN_REPLY_ID,
+            .can_mask = (CAN_SFF_MASK & ~(MAX_ECUS - 1)) | CAN_EFF_FLAG | CAN_RTR_FLAG
+        };
+        setsockopt(fd, SOL_CAN_RAW, CAN_RAW_FILTER, &filter, sizeof(filter));
+    }
+
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+        fprintf(stderr, "Error binding %s: %s\n", ifname, strerror(errno));
+        close(fd);
+        return false;
+    }
+
+    conn->fd = fd;
+    conn->isotp = isotp;
+    return true;
+}
+
+static bool SendFrame(int fd, uint32_t id, const uint8_t* data, int len) {
+    struct can_frame frame;
+    memset(&frame, 0, sizeof(frame));
+    frame.can_id = id;
+    frame.can_dlc = 8;
+    memset(frame.data, PADDING, sizeof(frame.data));
+    memcpy(frame.data, data, len);
+    return write(fd, &frame, sizeof(frame)) == (ssize_t)sizeof(frame);
+}
+
+// Wait for input until a deadline: 1 readable, 0 deadline passed, -1 error
+static int WaitReadable(int fd, long long deadline) {
+    for (;;) {
+        long long left = deadline - OBD_NowMicros();
+        if (left <= 0) return 0;
+        struct pollfd pfd = { .fd = fd, .events = POLLIN };
+        int ready = poll(&pfd, 1, (int)((left + 999) / 1000));
+        if (ready < 0 && errno == EINTR) continue;
+        if (ready < 0 || (pfd.revents & (POLLERR | POLLHUP | POLLNVAL))) return -1;
+        if (ready > 0) return 1;
+    }
+}
+
+// Functional request on 7DF; every ECU's reply is reassembled here. Single
+// frames complete at once, first frames get a clear-to-send flow control on
+// the ECU's physical ID and their consecutive frames are collected in order.
+static OBDStatus RawRequest(OBDConnection* conn, const uint8_t* request, int len, int answers,
+                            OBDRecord* records, int max_records, int* num_records) {
+    struct can_frame frame;
+    int received[MAX_ECUS];
+    int next_seq[MAX_ECUS];
+    bool done[MAX_ECUS];
+    int count = 0;
+    int complete = 0;
+    if (max_records > MAX_ECUS) max_records = MAX_ECUS;
+
+    // Late answers to an earlier request would be taken for this one
+    while (recv(conn->fd, &frame, sizeof(frame), MSG_DONTWAIT) > 0) {}
+
+    uint8_t single[8];
+    single[0] = (uint8_t)len;
+    memcpy(single + 1, request, len);
+    if (!SendFrame(conn->fd, OBD_CAN_REQUEST_ID, single, len + 1)) return OBD_ERR_IO;
+
+    long long start = OBD_NowMicros();
+    long long deadline = start + conn->ecu_timeout_ms * 1000LL;
+    long long hard_deadline = start + conn->timeout_ms * 1000LL;
+
+    while (answers == 0 || complete < answers) {
+        int ready = WaitReadable(conn->fd, deadline < hard_deadline ? deadline : hard_deadline);
+        if (ready < 0) return OBD_ERR_IO;
+        if (ready == 0) break;
+
+        ssize_t n = read(conn->fd, &frame, sizeof(frame));
+        if (n < 0 && (errno == EAGAIN || errno == EINTR)) continue;
+        if (n != (ssize_t)sizeof(frame)) return OBD_ERR_IO;
+        if (frame.can_dlc < 2) continue;
+
+        uint32_t ecu = frame.can_id & CAN_SFF_MASK;
+        int type = frame.data[0] >> 4;
+        int s = 0;
+        while (s < count && records[s].ecu != ecu) s++;
+
+        if (type == 0 || type == 1) {
+            // Start of an ECU's reply (one per ECU and request)
+            if (s < count || count == max_records) continue;
+            OBDRecord* record = &records[s];
+            count++;
+            record->ecu = ecu;
+            done[s] = false;
+
+            if (type == 0) {
+                int size = frame.data[0] & 0x0F;
+                if (size == 0 || size > frame.can_dlc - 1) size = 0;
+                memcpy(record->bytes, frame.data + 1, size);
+                record->len = record->expected = size;
+                done[s] = true;
+                if (size > 0) complete++;
+                continue;
+            }
+
+            record->expected = ((frame.data[0] & 0x0F) << 8) | frame.data[1];
+            if (record->expected < 8) {
+                record->len = 0;  // Would have fit a single frame: malformed
+                done[s] = true;
+                continue;
+            }
+            record->len = 6;
+            memcpy(record->bytes, frame.data + 2, 6);
+            received[s] = 6;
+            next_seq[s] = 1;
+
+            // Clear to send the rest at once, no separation time
+            const uint8_t flow[3] = { 0x30, 0x00, 0x00 };
+            if (!SendFrame(conn->fd, ecu - (OBD_CAN_REPLY_ID - OBD_CAN_PHYSICAL_ID), flow, sizeof(flow))) {
+                return OBD_ERR_IO;
+            }
+        } else if (type == 2 && s < count && !done[s]) {
+            OBDRecord* record = &records[s];
+            if ((frame.data[0] & 0x0F) != (next_seq[s] & 0x0F)) {
+                done[s] = true;  // Lost a frame: the reply stays incomplete
+                continue;
+            }
+            next_seq[s]++;
+
+            int take = record->expected - received[s];
+            if (take > 7) take = 7;
+            if (take > frame.can_dlc - 1) take = frame.can_dlc - 1;
+            int room = OBD_RECORD_BYTES - record->len;
+            memcpy(record->bytes + record->len, frame.data + 1, take < room ? take : room);
+            record->len += take < room ? take : room;
+            received[s] += take;
+            if (received[s] >= record->expected) {
+                done[s] = true;
+                if (record->len == record->expected) complete++;
+            }
+        } else {
+            continue;
+        }
+
+        // A reply still in flight keeps the request open
+        for (int i = 0; i < count; i++) {
+            if (done[i]) continue;
+            long long gap_deadline = OBD_NowMicros() + FRAME_GAP_MS * 1000LL;
+            if (deadline < gap_deadline) deadline = gap_deadline;
+            break;
+        }
+    }
+
+    *num_records = count;
+    return complete > 0 ? OBD_OK : OBD_ERR_TIMEOUT;
+}
+
+// Physical request to 7E0 over a kernel ISO-TP socket: one ECU, one read
+static OBDStatus IsotpRequest(OBDConnection* conn, const uint8_t* request, int len,
+                              OBDRecord* records, int max_records, int* num_records) {
+    uint8_t stale[OBD_RECORD_BYTES];
+    while (recv(conn->fd, stale, sizeof(stale), MSG_DONTWAIT) > 0) {}
+
+    if (max_records < 1) return OBD_ERR_OVERFLOW;
+    if (write(conn->fd, request, len) != len) return OBD_ERR_IO;
+
+    long long deadline = OBD_NowMicros() + (conn->ecu_timeout_ms + FRAME_GAP_MS) * 1000LL;
+    for (;;) {
+        int ready = WaitReadable(conn->fd, deadline);
+        if (ready < 0) return OBD_ERR_IO;
+        if (ready == 0) return OBD_ERR_TIMEOUT;
+
+        ssize_t n = read(conn->fd, records[0].bytes, OBD_RECORD_BYTES);
+        if (n < 0 && (errno == EAGAIN || errno == EINTR)) continue;
+        if (n <= 0) return OBD_ERR_IO;
+        records[0].ecu = OBD_CAN_REPLY_ID;
+        records[0].len = records[0].expected = (int)n;
+        *num_records = 1;
+        return OBD_OK;
+    }
+}
+
+OBDStatus OBD_CANRequest(OBDConnection* conn, const uint8_t* request, int len, int answers,
+                         OBDRecord* records, int max_records, int* num_records) {
+    *num_records = 0;
+    if (conn->fd < 0) return OBD_ERR_NOT_CONNECTED;
+    if (len < 1 || len > 7) return OBD_ERR_OVERFLOW;
+    if (conn->isotp) return IsotpRequest(conn, request, len, records, max_records, num_records);
+    return RawRequest(conn, request, len, answers, records, max_records, num_records);
+}
+
+#else
+
+bool OBD_CANIsInterface(const char* name) {
+    (void)name;
+    return false;
+}
+
+bool OBD_CANOpen(OBDConnection* conn, const char* ifname, bool isotp) {
+    (void)conn;
+    (void)isotp;
+    fprintf(stderr, "SocketCAN is not available on this system (%s)\n", ifname);
+    return false;
+}
+
+OBDStatus OBD_CANRequest(OBDConnection* conn, const uint8_t* request, int len, int answers,
+                         OBDRecord* records, int max_records, int* num_records) {
+    (void)conn;
+    (void)request;
+    (void)len;
+    (void)answers;
+    (void)records;
+    (void)max_records;
+    *num_records = 0;
+    return OBD_ERR_NOT_CONNECTED;
+}
+
+#endif
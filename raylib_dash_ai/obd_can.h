@@ -0,0 +1,35 @@
+#ifndef OBD_CAN_H
+#define OBD_CAN_H
+
+#include "obd_reader.h"
+#include "obd_parse.h"
+
+// SocketCAN transport for obd_reader.c. Requests go straight onto the bus as
+// ISO 15765-4 frames and replies come back as binary records, with no ELM327
+// in between. Linux only; elsewhere OBD_CANIsInterface() is always false.
+
+// Functional (broadcast) request ID and the ECU reply range 7E8-7EF.
+// Physical requests to ECU n go to 7E0 + n.
+#define OBD_CAN_REQUEST_ID   0x7DF
+#define OBD_CAN_REPLY_ID     0x7E8
+#define OBD_CAN_PHYSICAL_ID  0x7E0
+
+// Default time the ECUs get to answer (ISO 15765-4 P2 is 50 ms)
+#define OBD_CAN_DEFAULT_P2_MS 50
+
+// Whether a device name is a SocketCAN interface ("can0", "vcan0") rather
+// than a tty path
+bool OBD_CANIsInterface(const char* name);
+
+// Open the interface into conn->fd. Raw mode sends functional 7DF requests and
+// reassembles multi-frame replies itself (all ECUs); ISO-TP mode uses a kernel
+// CAN_ISOTP socket addressed physically to 7E0/7E8 (engine ECU only).
+bool OBD_CANOpen(OBDConnection* conn, const char* ifname, bool isotp);
+
+// Send one request (service byte + parameters, at most 7 bytes) and collect
+// the answers. Returns after `answers` complete replies (0 = wait out
+// conn->ecu_timeout_ms for every ECU). OBD_ERR_TIMEOUT if nobody answered.
+OBDStatus OBD_CANRequest(OBDConnection* conn, const uint8_t* request, int len, int answers,
+                         OBDRecord* records, int max_records, int* num_records);
+
+#endif // OBD_CAN_H
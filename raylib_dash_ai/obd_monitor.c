@@ -0,0 +1,264 @@
+#include "obd_monitor.h"
+#include "obd_parse.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <sys/uio.h>
+
+#define RING_MASK (OBD_MONITOR_RING - 1)
+
+// Values one frame can carry (several signals may share a frame)
+#define MAX_FRAME_VALUES 16
+
+// Write a monitor command, which gets no prompt back
+static bool WriteText(int fd, const char* text, int timeout_ms) {
+    int len = strlen(text);
+    int sent = 0;
+    long long deadline = OBD_NowMicros() + timeout_ms * 1000LL;
+    while (sent < len) {
+        int n = write(fd, text + sent, len - sent);
+        if (n > 0) {
+            sent += n;
+            continue;
+        }
+        if (n < 0 && errno != EAGAIN && errno != EINTR) return false;
+
+        long long remaining = deadline - OBD_NowMicros();
+        if (remaining <= 0) return false;
+        struct pollfd pfd = { .fd = fd, .events = POLLOUT };
+        poll(&pfd, 1, (int)((remaining + 999) / 1000));
+    }
+    return true;
+}
+
+static bool Setting(OBDConnection* conn, const char* cmd) {
+    char response[64];
+    if (OBD_SendCommand(conn, cmd, response, sizeof(response)) != OBD_OK) return false;
+    return strstr(response, "OK") != NULL;
+}
+
+// Narrowest adapter filter that passes every ID of the set: ATCRA for a single
+// ID, otherwise the bits all IDs share (ATCF) under a mask of those bits (ATCM).
+// Sets with both 11- and 29-bit IDs are left to the software filter.
+static bool SetAdapterFilter(OBDMonitor* mon) {
+    const CANSignalSet* set = mon->set;
+    if (set->num_signals == 0) return false;
+
+    uint32_t all = set->signals[0].can_id;
+    uint32_t any = set->signals[0].can_id;
+    bool extended = set->signals[0].extended;
+    for (int i = 1; i < set->num_signals; i++) {
+        if (set->signals[i].extended != extended) return false;
+        all &= set->signals[i].can_id;
+        any |= set->signals[i].can_id;
+    }
+
+    int digits = extended ? 8 : 3;
+    uint32_t width = extended ? 0x1FFFFFFF : 0x7FF;
+    char cmd[32];
+    if (all == any) {
+        snprintf(cmd, sizeof(cmd), "ATCRA%0*X\r", digits, all);
+        return Setting(mon->conn, cmd);
+    }
+    uint32_t mask = ~(all ^ any) & width;
+    snprintf(cmd, sizeof(cmd), "ATCF%0*X\r", digits, all & mask);
+    if (!Setting(mon->conn, cmd)) return false;
+    snprintf(cmd, sizeof(cmd), "ATCM%0*X\r", digits, mask);
+    return Setting(mon->conn, cmd);
+}
+
+// Back to the settings OBD_Init left: no receive filter, ISO-TP formatting,
+// headers and spaces as they were
+static void RestoreSettings(OBDMonitor* mon) {
+    OBDConnection* conn = mon->conn;
+    Setting(conn, "ATCRA\r");
+    Setting(conn, "ATCAF1\r");
+    Setting(conn, (mon->features & OBD_FEATURE_HEADERS) ? "ATH1\r" : "ATH0\r");
+    Setting(conn, (mon->features & OBD_FEATURE_SPACES_OFF) ? "ATS0\r" : "ATS1\r");
+    conn->features = mon->features;
+}
+
+bool OBD_MonitorStart(OBDMonitor* mon, OBDConnection* conn, const CANSignalSet* set,
+                      bool adapter_filter, OBDSampleFn on_sample, void* user) {
+    memset(mon, 0, sizeof(*mon));
+    mon->conn = conn;
+    mon->set = set;
+    mon->on_sample = on_sample;
+    mon->user = user;
+
+    if (conn->transport != OBD_TRANSPORT_ELM327 || conn->fd < 0) {
+        fprintf(stderr, "Monitor mode needs an ELM327 adapter\n");
+        return false;
+    }
+    if (conn->protocol < 6) {
+        fprintf(stderr, "Monitor mode needs a CAN protocol (adapter is on protocol %X)\n", conn->protocol);
+        return false;
+    }
+    mon->features = conn->features;
+
+    // Headers tell the frames apart; without CAN auto formatting every data
+    // byte is shown, not just an ISO-TP payload. No spaces: a third fewer
+    // bytes per frame on the serial link.
+    if (!Setting(conn, "ATH1\r") || !Setting(conn, "ATCAF0\r")) {
+        fprintf(stderr, "Adapter rejected the monitor settings\n");
+        RestoreSettings(mon);
+        return false;
+    }
+    Setting(conn, "ATS0\r");
+    if (adapter_filter) mon->adapter_filter = SetAdapterFilter(mon);
+
+    char response[64];
+    mon->stn = OBD_SendCommand(conn, "STI\r", response, sizeof(response)) == OBD_OK &&
+               strncmp(response, "STN", 3) == 0;
+    mon->command = mon->stn ? "STMA\r" : "ATMA\r";
+
+    if (!WriteText(conn->fd, mon->command, conn->timeout_ms)) {
+        RestoreSettings(mon);
+        return false;
+    }
+    mon->active = true;
+    return true;
+}
+
+// One line of adapter output: a frame ("0C9 00 A0 0F 00 00 00 00 00", the
+// header 3 or 8 digits) or a message. Returns the values delivered.
+static int HandleLine(OBDMonitor* mon, const char* text, int len, long long timestamp_us) {
+    mon->lines++;
+
+    uint8_t nibbles[8 + 16];
+    int digits = 0;
+    for (int i = 0; i < len; i++) {
+        uint8_t c = OBD_HEX_CLASS[(unsigned char)text[i]];
+        if (c == OBD_HEX_SPACE) continue;
+        if (c >= 16 || digits == (int)sizeof(nibbles)) {
+            if (len >= 11 && memcmp(text, "BUFFER FULL", 11) == 0) {
+                mon->buffer_full = true;
+                mon->overruns++;
+            } else {
+                mon->bad_lines++;
+            }
+            return 0;
+        }
+        nibbles[digits++] = c;
+    }
+
+    // Two digits per data byte, so the parity of the count gives the header:
+    // odd for 11-bit IDs, even for 29-bit
+    int header = (digits & 1) ? 3 : 8;
+    if (digits < header) {
+        mon->bad_lines++;
+        return 0;
+    }
+    uint32_t id = 0;
+    for (int i = 0; i < header; i++) id = (id << 4) | nibbles[i];
+    uint8_t data[8];
+    int data_len = (digits - header) / 2;
+    for (int i = 0; i < data_len; i++) {
+        data[i] = (uint8_t)((nibbles[header + 2 * i] << 4) | nibbles[header + 2 * i + 1]);
+    }
+    mon->frames++;
+
+    OBDValue values[MAX_FRAME_VALUES];
+    int count = CAN_DecodeFrame(mon->set, id, data, data_len, values, MAX_FRAME_VALUES);
+    for (int i = 0; i < count; i++) mon->on_sample(mon->user, &values[i], timestamp_us);
+    mon->samples += count;
+    return count;
+}
+
+// The adapter left monitor mode (BUFFER FULL, or it was reset): start again
+static bool Restart(OBDMonitor* mon) {
+    mon->buffer_full = false;
+    mon->restarts++;
+    return WriteText(mon->conn->fd, mon->command, mon->conn->timeout_ms);
+}
+
+// Split everything new in the ring into lines. A line is handled in place
+// unless it wraps around the end of the ring.
+static int ProcessLines(OBDMonitor* mon, long long timestamp_us) {
+    int delivered = 0;
+    while (mon->scan != mon->head) {
+        char c = mon->ring[mon->scan & RING_MASK];
+        mon->scan++;
+        if (OBD_HEX_CLASS[(unsigned char)c] != OBD_HEX_EOL) continue;
+
+        unsigned int start = mon->tail;
+        int len = (int)(mon->scan - 1 - start);
+        mon->tail = mon->scan;
+        if (len > OBD_MONITOR_LINE) {
+            mon->lines++;
+            mon->bad_lines++;
+        } else if (len > 0) {
+            unsigned int at = start & RING_MASK;
+            if (at + len <= OBD_MONITOR_RING) {
+                delivered += HandleLine(mon, mon->ring + at, len, timestamp_us);
+            } else {
+                char line[OBD_MONITOR_LINE];
+                int first = OBD_MONITOR_RING - at;
+                memcpy(line, mon->ring + at, first);
+                memcpy(line + first, mon->ring, len - first);
+                delivered += HandleLine(mon, line, len, timestamp_us);
+            }
+        }
+        if (c == '>' && mon->active && !Restart(mon)) return -1;
+    }
+
+    // A "line" that fills the whole ring is noise, not a frame
+    if (mon->head - mon->tail == OBD_MONITOR_RING) {
+        mon->lines++;
+        mon->bad_lines++;
+        mon->tail = mon->head;
+    }
+    return delivered;
+}
+
+int OBD_MonitorStep(OBDMonitor* mon, int max_wait_ms) {
+    if (!mon->active) return -1;
+    int fd = mon->conn->fd;
+
+    struct pollfd pfd = { .fd = fd, .events = POLLIN };
+    int ready = poll(&pfd, 1, max_wait_ms);
+    if (ready < 0) return errno == EINTR ? 0 : -1;
+    if (ready == 0) return 0;
+    if (!(pfd.revents & POLLIN)) return -1;
+
+    // Read straight into the free part of the ring, both pieces if it wraps
+    unsigned int room = OBD_MONITOR_RING - (mon->head - mon->tail);
+    unsigned int at = mon->head & RING_MASK;
+    unsigned int first = OBD_MONITOR_RING - at < room ? OBD_MONITOR_RING - at : room;
+    struct iovec iov[2] = {
+        { .iov_base = mon->ring + at, .iov_len = first },
+        { .iov_base = mon->ring, .iov_len = room - first },
+    };
+    ssize_t n = readv(fd, iov, iov[1].iov_len > 0 ? 2 : 1);
+    if (n < 0) return (errno == EAGAIN || errno == EINTR) ? 0 : -1;
+    if (n == 0) return -1;  // Hung up
+    mon->head += (unsigned int)n;
+    mon->bytes += (unsigned long)n;
+
+    return ProcessLines(mon, OBD_NowMicros());
+}
+
+void OBD_MonitorStop(OBDMonitor* mon) {
+    if (!mon->active) return;
+    mon->active = false;
+    int fd = mon->conn->fd;
+
+    // Any character ends monitoring. A space is ignored by an adapter that
+    // had already stopped on its own.
+    if (WriteText(fd, " ", mon->conn->timeout_ms)) {
+        long long deadline = OBD_NowMicros() + mon->conn->timeout_ms * 1000LL;
+        char buf[256];
+        for (;;) {
+            long long remaining = deadline - OBD_NowMicros();
+            if (remaining <= 0) break;
+            struct pollfd pfd = { .fd = fd, .events = POLLIN };
+            if (poll(&pfd, 1, (int)((remaining + 999) / 1000)) <= 0) continue;
+            ssize_t n = read(fd, buf, sizeof(buf));
+            if (n <= 0) break;
+            if (memchr(buf, '>', n) != NULL) break;
+        }
+    }
+    RestoreSettings(mon);
+}
@@ -0,0 +1,70 @@
+#ifndef OBD_MONITOR_H
+#define OBD_MONITOR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "obd_reader.h"
+#include "obd_scheduler.h"
+#include "can_signals.h"
+
+// Passive decoding through an ELM327 or STN adapter. Monitor-all mode (ATMA,
+// or STMA on STN chips) prints every CAN frame the adapter sees, one line per
+// frame, until the host sends a character. The stream is read into a ring
+// buffer, split into lines as they arrive and decoded with a CAN signal set
+// (can_signals.h), so an adapter on a tty gives the same samples as a
+// SocketCAN listener.
+//
+// The adapter's own receive filter (ATCRA for one ID, ATCF/ATCM for several)
+// keeps frames nobody decodes off the serial line; IDs that slip through the
+// mask are dropped in software. When the bus outruns the serial link the
+// adapter stops with BUFFER FULL; monitoring is restarted at once and the
+// overrun counted.
+//
+// While monitoring, the connection takes no other commands: OBD_MonitorStop
+// puts the adapter back for OBD_SendCommand / OBD_ReadPIDs.
+
+// Receive ring, a power of two. Holds ~200 frame lines.
+#define OBD_MONITOR_RING 8192
+
+// Longest line taken as a frame ("18DAF110 00 11 22 33 44 55 66 77" and a DLC)
+#define OBD_MONITOR_LINE 64
+
+typedef struct {
+    OBDConnection* conn;
+    const CANSignalSet* set;
+    OBDSampleFn on_sample;
+    void* user;
+    bool active;
+    bool stn;                  // STN11xx: STMA, larger buffer, faster UART
+    bool adapter_filter;       // ATCRA / ATCF+ATCM in use
+    bool buffer_full;          // BUFFER FULL seen, restart at the prompt
+    const char* command;       // "ATMA\r" or "STMA\r"
+    unsigned int features;     // conn->features before monitoring (restored at stop)
+    char ring[OBD_MONITOR_RING];
+    unsigned int head;         // Bytes written into the ring (wraps)
+    unsigned int tail;         // Start of the current, unfinished line
+    unsigned int scan;         // Next byte to look at for a line end
+
+    unsigned long bytes;       // Received
+    unsigned long lines;       // Non-empty lines
+    unsigned long frames;      // Lines that were CAN frames
+    unsigned long bad_lines;   // Adapter errors (CAN ERROR, <RX ERROR) and garbled lines
+    unsigned long overruns;    // BUFFER FULL
+    unsigned long restarts;    // Monitoring restarted after the adapter stopped it
+    unsigned long samples;     // Values delivered
+} OBDMonitor;
+
+// Put the adapter into monitor-all mode for the signal set's IDs. Needs an
+// ELM327 transport on a CAN protocol (6-C). With adapter_filter false every
+// frame crosses the serial link and the filtering is all in software.
+bool OBD_MonitorStart(OBDMonitor* mon, OBDConnection* conn, const CANSignalSet* set,
+                      bool adapter_filter, OBDSampleFn on_sample, void* user);
+
+// Wait up to max_wait_ms for adapter output and decode every complete line.
+// Returns the number of values delivered, -1 if the adapter is gone.
+int OBD_MonitorStep(OBDMonitor* mon, int max_wait_ms);
+
+// Stop monitoring and restore the connection's settings
+void OBD_MonitorStop(OBDMonitor* mon);
+
+#endif // OBD_MONITOR_H
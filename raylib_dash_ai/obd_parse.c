@@ -0,0 +1,350 @@
+#include "obd_parse.h"
+#include <string.h>
+
+#define O OBD_HEX_OTHER
+#define S OBD_HEX_SPACE
+#define E OBD_HEX_EOL
+#define C OBD_HEX_COLON
+
+const uint8_t OBD_HEX_CLASS[256] = {
+    O, O, O, O, O, O, O, O, O, S, E, O, O, E, O, O,   // 0x00  \t \n \r
+    O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, O,   // 0x10
+    S, O, O, O, O, O, O, O, O, O, O, O, O, O, O, O,   // 0x20  ' '
+    0, 1, 2, 3, 4, 5, 6, 7, 8, 9, C, O, O, O, E, O,   // 0x30  0-9 : >
+    O,10,11,12,13,14,15, O, O, O, O, O, O, O, O, O,   // 0x40  A-F
+    O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, O,   // 0x50
+    O,10,11,12,13,14,15, O, O, O, O, O, O, O, O, O,   // 0x60  a-f
+    O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, O,   // 0x70
+    O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, O,   // 0x80
+    O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, O,
+    O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, O,
+    O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, O,
+    O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, O,
+    O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, O,
+    O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, O,
+    O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, O,
+};
+
+#undef O
+#undef S
+#undef E
+#undef C
+
+OBDParseStatus OBD_ParseHex(const char* buf, size_t len, uint8_t* out, int max_out, int* num_out) {
+    const uint8_t* p = (const uint8_t*)buf;
+    const uint8_t* end = p + len;
+    int count = 0;
+    int high = -1;           // First digit of the byte in progress
+
+    for (; p < end; p++) {
+        uint8_t v = OBD_HEX_CLASS[*p];
+        if (v < 16) {
+            if (high < 0) {
+                high = v;
+                continue;
+            }
+            if (count >= max_out) {
+                *num_out = count;
+                return OBD_PARSE_TOO_LONG;
+            }
+            out[count++] = (uint8_t)((high << 4) | v);
+            high = -1;
+        } else if (v != OBD_HEX_SPACE) {
+            *num_out = count;
+            return OBD_PARSE_BAD_CHAR;
+        }
+    }
+
+    *num_out = count;
+    if (high >= 0) return OBD_PARSE_ODD_DIGITS;
+    return count > 0 ? OBD_PARSE_OK : OBD_PARSE_EMPTY;
+}
+
+// One line as it is being scanned
+typedef struct {
+    uint32_t header;         // First header_chars digits
+    uint32_t lead;           // First 8 digits (byte-count lines)
+    int digits;              // Digits after the header / frame index
+    int high;                // First digit of the byte in progress (-1 = none)
+    int len;
+    uint8_t bytes[OBD_RECORD_BYTES];
+    int frame;               // Frame index before ':' (-1 = none)
+    bool spaces;
+    bool in_first_word;
+    bool text;               // First word isn't hex: adapter message, not data
+    bool bad_char;
+    bool overflow;
+    bool any;                // Line has any characters
+} LineState;
+
+typedef struct {
+    const OBDReplyFormat* format;
+    OBDRecord* records;
+    int max_records;
+    OBDParseResult result;
+    OBDRecord* current;      // Multi-frame message being filled (ATH0)
+    int next_frame;          // Expected next frame index (ATH0)
+    int pending_expected;    // Byte count announced by a "00A" line (ATH0)
+} SplitState;
+
+static void ResetLine(LineState* line) {
+    line->header = 0;
+    line->lead = 0;
+    line->digits = 0;
+    line->high = -1;
+    line->len = 0;
+    line->frame = -1;
+    line->spaces = false;
+    line->in_first_word = true;
+    line->text = false;
+    line->bad_char = false;
+    line->overflow = false;
+    line->any = false;
+}
+
+static void Fail(SplitState* state, OBDParseStatus status) {
+    state->result.bad_lines++;
+    if (state->result.status == OBD_PARSE_OK) state->result.status = status;
+}
+
+static OBDRecord* NewRecord(SplitState* state, uint32_t ecu, int expected) {
+    if (state->result.records >= state->max_records) {
+        Fail(state, OBD_PARSE_TOO_LONG);
+        return NULL;
+    }
+    OBDRecord* record = &state->records[state->result.records++];
+    record->ecu = ecu;
+    record->len = 0;
+    record->expected = expected;
+    record->next_frame = 1;
+    return record;
+}
+
+static void Append(OBDRecord* record, const uint8_t* bytes, int len) {
+    int limit = record->expected > 0 ? record->expected : OBD_RECORD_BYTES;
+    if (limit > OBD_RECORD_BYTES) limit = OBD_RECORD_BYTES;
+    if (len > limit - record->len) len = limit - record->len;
+    if (len <= 0) return;
+    memcpy(record->bytes + record->len, bytes, len);
+    record->len += len;
+}
+
+// "00A": three digits announcing the length of a multi-frame reply (ATH0)
+static bool IsByteCountLine(const SplitState* state, const LineState* line) {
+    return state->format->header_chars == 0 && line->frame < 0 && line->digits == 3 && !line->spaces;
+}
+
+// ATH0: single lines, or a "00A" byte count followed by "0:", "1:", ... frames
+static void FinishPlainLine(SplitState* state, const LineState* line) {
+    if (line->frame >= 0) {
+        if (line->frame == 0) {
+            state->current = NewRecord(state, 0, state->pending_expected);
+            state->next_frame = 1;
+            if (state->pending_expected > OBD_RECORD_BYTES) Fail(state, OBD_PARSE_TOO_LONG);
+        } else if (!state->current || line->frame != state->next_frame) {
+            Fail(state, OBD_PARSE_BAD_FRAME);
+            state->current = NULL;
+            return;
+        } else {
+            state->next_frame = (state->next_frame + 1) & 0x0F;
+        }
+        if (state->current) Append(state->current, line->bytes, line->len);
+        return;
+    }
+
+    if (IsByteCountLine(state, line)) {
+        state->pending_expected = (int)line->lead;
+        state->current = NULL;
+        return;
+    }
+
+    state->current = NULL;
+    state->pending_expected = 0;
+    OBDRecord* record = NewRecord(state, 0, 0);
+    if (record) Append(record, line->bytes, line->len);
+}
+
+// ATH1: every line starts with the sender's header. CAN lines carry the ISO-TP
+// PCI byte; older protocols end each line with a checksum byte.
+static void FinishHeaderedLine(SplitState* state, const LineState* line) {
+    const uint8_t* b = line->bytes;
+    int n = line->len;
+    if (n < 2) {
+        Fail(state, OBD_PARSE_BAD_HEADER);
+        return;
+    }
+
+    if (!state->format->is_can) {
+        OBDRecord* record = NewRecord(state, line->header & 0xFF, 0);
+        if (record) Append(record, b, n - 1);
+        return;
+    }
+
+    switch (b[0] >> 4) {
+        case 0: {
+            // Single frame: PCI low nibble is the length
+            int len = b[0] & 0x0F;
+            if (len == 0 || len > n - 1) {
+                Fail(state, OBD_PARSE_BAD_FRAME);
+                return;
+            }
+            OBDRecord* record = NewRecord(state, line->header, 0);
+            if (record) Append(record, b + 1, len);
+            return;
+        }
+        case 1: {
+            // First frame: 12-bit total length, then the first data bytes
+            int expected = ((b[0] & 0x0F) << 8) | b[1];
+            if (expected < 8) {
+                Fail(state, OBD_PARSE_BAD_FRAME);
+                return;
+            }
+            // Longer than a record holds: kept, but never complete
+            if (expected > OBD_RECORD_BYTES) Fail(state, OBD_PARSE_TOO_LONG);
+            OBDRecord* record = NewRecord(state, line->header, expected);
+            if (record) Append(record, b + 2, n - 2);
+            return;
+        }
+        case 2:
+            // Consecutive frame: append to this ECU's message in progress
+            for (int r = state->result.records - 1; r >= 0; r--) {
+                OBDRecord* record = &state->records[r];
+                if (record->ecu != line->header || record->len >= record->expected) continue;
+                if ((b[0] & 0x0F) != record->next_frame) {
+                    // Out of order or repeated: the message stays incomplete
+                    record->next_frame = -1;
+                    Fail(state, OBD_PARSE_BAD_FRAME);
+                    return;
+                }
+                record->next_frame = (record->next_frame + 1) & 0x0F;
+                Append(record, b + 1, n - 1);
+                return;
+            }
+            Fail(state, OBD_PARSE_BAD_FRAME);
+            return;
+        default:
+            Fail(state, OBD_PARSE_BAD_FRAME);
+            return;
+    }
+}
+
+static void FinishLine(SplitState* state, const LineState* line) {
+    if (!line->any) return;
+    if (line->text) {
+        state->result.text_lines++;
+        return;
+    }
+    if (line->digits == 0 && line->frame < 0) return;   // Blank line
+
+    OBDParseStatus status = OBD_PARSE_OK;
+    if (line->bad_char) status = OBD_PARSE_BAD_CHAR;
+    else if (line->overflow) status = OBD_PARSE_TOO_LONG;
+    else if (line->high >= 0 && !IsByteCountLine(state, line)) status = OBD_PARSE_ODD_DIGITS;
+    else if (line->digits < state->format->header_chars) status = OBD_PARSE_BAD_HEADER;
+    if (status != OBD_PARSE_OK) {
+        Fail(state, status);
+        return;
+    }
+
+    if (state->format->header_chars > 0) FinishHeaderedLine(state, line);
+    else FinishPlainLine(state, line);
+}
+
+OBDParseResult OBD_SplitRecords(const char* buf, size_t len, const OBDReplyFormat* format,
+                                OBDRecord* records, int max_records) {
+    SplitState state;
+    memset(&state, 0, sizeof(state));
+    state.format = format;
+    state.records = records;
+    state.max_records = max_records;
+
+    const int header_chars = format->header_chars;
+    LineState line;
+    ResetLine(&line);
+
+    const uint8_t* p = (const uint8_t*)buf;
+    const uint8_t* end = p + len;
+    while (p < end) {
+        uint8_t v = OBD_HEX_CLASS[*p++];
+
+        if (v < 16) {
+            line.any = true;
+            if (line.digits < 8 && line.frame < 0) line.lead = (line.lead << 4) | v;
+            if (line.digits < header_chars) {
+                line.header = (line.header << 4) | v;
+                line.digits++;
+                continue;
+            }
+            line.digits++;
+            if (line.high < 0) {
+                line.high = v;
+            } else if (line.len < OBD_RECORD_BYTES) {
+                line.bytes[line.len++] = (uint8_t)((line.high << 4) | v);
+                line.high = -1;
+            } else {
+                line.overflow = true;
+                line.high = -1;
+            }
+            continue;
+        }
+
+        switch (v) {
+            case OBD_HEX_SPACE:
+                if (line.any) {
+                    line.spaces = true;
+                    line.in_first_word = false;
+                }
+                break;
+            case OBD_HEX_EOL:
+                FinishLine(&state, &line);
+                ResetLine(&line);
+                break;
+            case OBD_HEX_COLON:
+                // Frame index: one digit, no bytes yet, headers off
+                line.any = true;
+                if (header_chars == 0 && line.frame < 0 && line.digits == 1 && line.len == 0) {
+                    line.frame = line.high;
+                    line.high = -1;
+                    line.digits = 0;
+                    line.spaces = false;
+                } else {
+                    line.bad_char = true;
+                }
+                line.in_first_word = false;
+                break;
+            default:
+                line.any = true;
+                if (line.in_first_word) {
+                    // Adapter message: skip to the end of the line
+                    line.text = true;
+                    while (p < end && OBD_HEX_CLASS[*p] != OBD_HEX_EOL) p++;
+                } else {
+                    line.bad_char = true;
+                }
+                break;
+        }
+    }
+    FinishLine(&state, &line);
+
+    // Multi-frame messages the reply stopped short of
+    for (int r = 0; r < state.result.records; r++) {
+        if (records[r].len < records[r].expected) {
+            if (state.result.status == OBD_PARSE_OK) state.result.status = OBD_PARSE_TRUNCATED;
+        }
+    }
+    return state.result;
+}
+
+const char* OBD_ParseStatusString(OBDParseStatus status) {
+    switch (status) {
+        case OBD_PARSE_OK:         return "ok";
+        case OBD_PARSE_EMPTY:      return "empty";
+        case OBD_PARSE_ODD_DIGITS: return "odd number of hex digits";
+        case OBD_PARSE_BAD_CHAR:   return "non-hex character in data";
+        case OBD_PARSE_TOO_LONG:   return "too long";
+        case OBD_PARSE_BAD_HEADER: return "line shorter than its header";
+        case OBD_PARSE_BAD_FRAME:  return "invalid ISO-TP frame";
+        case OBD_PARSE_TRUNCATED:  return "multi-frame message incomplete";
+    }
+    return "unknown";
+}
@@ -0,0 +1,68 @@
+#ifndef OBD_PARSE_H
+#define OBD_PARSE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Largest message kept per ECU (VIN is 20 bytes, six batched PIDs at most 31)
+#define OBD_RECORD_BYTES 64
+
+// Character classes in OBD_HEX_CLASS: values 0x00-0x0F are hex digits
+#define OBD_HEX_SPACE  0x10      // ' ', '\t'
+#define OBD_HEX_EOL    0x20      // '\r', '\n', '>'
+#define OBD_HEX_COLON  0x30      // ':' after an ISO-TP frame index
+#define OBD_HEX_OTHER  0x40      // Anything else (text such as "SEARCHING...")
+
+// Nibble value or class of every byte
+extern const uint8_t OBD_HEX_CLASS[256];
+
+typedef enum {
+    OBD_PARSE_OK = 0,
+    OBD_PARSE_EMPTY,         // No hex digits at all
+    OBD_PARSE_ODD_DIGITS,    // A byte is missing its second digit
+    OBD_PARSE_BAD_CHAR,      // Non-hex character inside hex data
+    OBD_PARSE_TOO_LONG,      // More bytes or messages than the output holds
+    OBD_PARSE_BAD_HEADER,    // Line too short for its header
+    OBD_PARSE_BAD_FRAME,     // Invalid ISO-TP frame, or a continuation without a start
+    OBD_PARSE_TRUNCATED      // Multi-frame message ended before its length was reached
+} OBDParseStatus;
+
+// One ECU answer
+typedef struct {
+    uint32_t ecu;            // Header of the sender (0 when headers are off)
+    int len;
+    int expected;            // ISO-TP total length (0 for single-frame); len < expected = incomplete
+    int next_frame;          // ATH1: sequence number of the next consecutive frame (-1 = one was out of order)
+    uint8_t bytes[OBD_RECORD_BYTES];
+} OBDRecord;
+
+// How the adapter formats replies
+typedef struct {
+    int header_chars;        // 0 (ATH0), 3 (11-bit CAN), 8 (29-bit CAN) or 6 (older protocols)
+    bool is_can;             // Headered lines carry an ISO-TP PCI byte
+} OBDReplyFormat;
+
+// Totals for one OBD_SplitRecords call
+typedef struct {
+    int records;
+    int text_lines;          // Non-data lines that were skipped ("SEARCHING...", "BUS INIT: ...OK")
+    int bad_lines;           // Data lines that were rejected
+    OBDParseStatus status;   // First problem found, OBD_PARSE_OK if none
+} OBDParseResult;
+
+// Decode hex digits in buf[0..len) into out, ignoring spaces. buf needs no
+// terminating NUL. *num_out is set to the bytes decoded before any error.
+OBDParseStatus OBD_ParseHex(const char* buf, size_t len, uint8_t* out, int max_out, int* num_out);
+
+// Split a complete reply (any mix of '\r'/'\n' line ends) into per-ECU records
+// in one pass: single lines, "00A" + "0:"/"1:" multi-frame replies (ATH0), and
+// headered lines with ISO-TP reassembly (ATH1). Bad lines are skipped and
+// reported in the result; good lines around them are still returned.
+OBDParseResult OBD_SplitRecords(const char* buf, size_t len, const OBDReplyFormat* format,
+                                OBDRecord* records, int max_records);
+
+// Human-readable name of a parse status
+const char* OBD_ParseStatusString(OBDParseStatus status);
+
+#endif // OBD_PARSE_H
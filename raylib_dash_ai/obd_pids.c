@@ -0,0 +1,175 @@
+#include "obd_pids.h"
+#include <stddef.h>
+
+// Raw value extractors
+static float RawA(const uint8_t* d)       { return d[0]; }
+static float RawAB(const uint8_t* d)      { return d[0] * 256.0f + d[1]; }
+static float RawABSigned(const uint8_t* d) { return (float)(int16_t)((d[0] << 8) | d[1]); }
+static float RawABCD(const uint8_t* d) {
+    return (float)(((uint32_t)d[0] << 24) | ((uint32_t)d[1] << 16) | ((uint32_t)d[2] << 8) | d[3]);
+}
+
+#define PID(bytes, raw, scale, offset, min, max, name, unit) \
+    { bytes, raw, scale, offset, min, max, name, unit }
+
+// Common formulas
+#define PERCENT(name)      PID(1, RawA, 100.0f / 255.0f, 0.0f, 0.0f, 100.0f, name, "%")
+#define TRIM(name)         PID(1, RawA, 100.0f / 128.0f, -100.0f, -100.0f, 99.2f, name, "%")
+#define TEMP(name)         PID(1, RawA, 1.0f, -40.0f, -40.0f, 215.0f, name, "°C")
+#define COUNT8(name, unit) PID(1, RawA, 1.0f, 0.0f, 0.0f, 255.0f, name, unit)
+#define COUNT16(name, unit) PID(2, RawAB, 1.0f, 0.0f, 0.0f, 65535.0f, name, unit)
+#define STATUS(bytes, name) PID(bytes, RawA, 1.0f, 0.0f, 0.0f, 255.0f, name, "")
+#define BITMAP(name)       PID(4, RawABCD, 1.0f, 0.0f, 0.0f, 4294967295.0f, name, "")
+#define O2_VOLTAGE(name)   PID(2, RawA, 1.0f / 200.0f, 0.0f, 0.0f, 1.275f, name, "V")
+#define O2_LAMBDA(name)    PID(4, RawAB, 2.0f / 65536.0f, 0.0f, 0.0f, 2.0f, name, "ratio")
+#define CAT_TEMP(name)     PID(2, RawAB, 0.1f, -40.0f, -40.0f, 6513.5f, name, "°C")
+#define TORQUE(name)       PID(1, RawA, 1.0f, -125.0f, -125.0f, 130.0f, name, "%")
+
+const OBDPIDInfo OBD_PID_TABLE[256] = {
+    [0x00] = BITMAP("PIDs supported 01-20"),
+    [0x01] = PID(4, RawA, 1.0f, 0.0f, 0.0f, 255.0f, "Monitor status since DTCs cleared", ""),
+    [0x02] = PID(2, RawAB, 1.0f, 0.0f, 0.0f, 65535.0f, "Freeze frame DTC", ""),
+    [0x03] = STATUS(2, "Fuel system status"),
+    [0x04] = PERCENT("Calculated engine load"),
+    [0x05] = TEMP("Engine coolant temperature"),
+    [0x06] = TRIM("Short term fuel trim bank 1"),
+    [0x07] = TRIM("Long term fuel trim bank 1"),
+    [0x08] = TRIM("Short term fuel trim bank 2"),
+    [0x09] = TRIM("Long term fuel trim bank 2"),
+    [0x0A] = PID(1, RawA, 3.0f, 0.0f, 0.0f, 765.0f, "Fuel pressure", "kPa"),
+    [0x0B] = COUNT8("Intake manifold absolute pressure", "kPa"),
+    [0x0C] = PID(2, RawAB, 0.25f, 0.0f, 0.0f, 16383.75f, "Engine RPM", "rpm"),
+    [0x0D] = COUNT8("Vehicle speed", "km/h"),
+    [0x0E] = PID(1, RawA, 0.5f, -64.0f, -64.0f, 63.5f, "Timing advance", "°"),
+    [0x0F] = TEMP("Intake air temperature"),
+    [0x10] = PID(2, RawAB, 0.01f, 0.0f, 0.0f, 655.35f, "MAF air flow rate", "g/s"),
+    [0x11] = PERCENT("Throttle position"),
+    [0x12] = STATUS(1, "Commanded secondary air status"),
+    [0x13] = STATUS(1, "Oxygen sensors present (2 banks)"),
+    [0x14] = O2_VOLTAGE("Oxygen sensor 1 voltage"),
+    [0x15] = O2_VOLTAGE("Oxygen sensor 2 voltage"),
+    [0x16] = O2_VOLTAGE("Oxygen sensor 3 voltage"),
+    [0x17] = O2_VOLTAGE("Oxygen sensor 4 voltage"),
+    [0x18] = O2_VOLTAGE("Oxygen sensor 5 voltage"),
+    [0x19] = O2_VOLTAGE("Oxygen sensor 6 voltage"),
+    [0x1A] = O2_VOLTAGE("Oxygen sensor 7 voltage"),
+    [0x1B] = O2_VOLTAGE("Oxygen sensor 8 voltage"),
+    [0x1C] = STATUS(1, "OBD standard"),
+    [0x1D] = STATUS(1, "Oxygen sensors present (4 banks)"),
+    [0x1E] = STATUS(1, "Auxiliary input status"),
+    [0x1F] = COUNT16("Run time since engine start", "s"),
+    [0x20] = BITMAP("PIDs supported 21-40"),
+    [0x21] = COUNT16("Distance traveled with MIL on", "km"),
+    [0x22] = PID(2, RawAB, 0.079f, 0.0f, 0.0f, 5177.265f, "Fuel rail pressure (vacuum)", "kPa"),
+    [0x23] = PID(2, RawAB, 10.0f, 0.0f, 0.0f, 655350.0f, "Fuel rail gauge pressure", "kPa"),
+    [0x24] = O2_LAMBDA("Oxygen sensor 1 equivalence ratio"),
+    [0x25] = O2_LAMBDA("Oxygen sensor 2 equivalence ratio"),
+    [0x26] = O2_LAMBDA("Oxygen sensor 3 equivalence ratio"),
+    [0x27] = O2_LAMBDA("Oxygen sensor 4 equivalence ratio"),
+    [0x28] = O2_LAMBDA("Oxygen sensor 5 equivalence ratio"),
+    [0x29] = O2_LAMBDA("Oxygen sensor 6 equivalence ratio"),
+    [0x2A] = O2_LAMBDA("Oxygen sensor 7 equivalence ratio"),
+    [0x2B] = O2_LAMBDA("Oxygen sensor 8 equivalence ratio"),
+    [0x2C] = PERCENT("Commanded EGR"),
+    [0x2D] = TRIM("EGR error"),
+    [0x2E] = PERCENT("Commanded evaporative purge"),
+    [0x2F] = PERCENT("Fuel tank level input"),
+    [0x30] = COUNT8("Warm-ups since codes cleared", ""),
+    [0x31] = COUNT16("Distance traveled since codes cleared", "km"),
+    [0x32] = PID(2, RawABSigned, 0.25f, 0.0f, -8192.0f, 8191.75f, "Evap system vapor pressure", "Pa"),
+    [0x33] = COUNT8("Absolute barometric pressure", "kPa"),
+    [0x34] = O2_LAMBDA("Oxygen sensor 1 equivalence ratio (current)"),
+    [0x35] = O2_LAMBDA("Oxygen sensor 2 equivalence ratio (current)"),
+    [0x36] = O2_LAMBDA("Oxygen sensor 3 equivalence ratio (current)"),
+    [0x37] = O2_LAMBDA("Oxygen sensor 4 equivalence ratio (current)"),
+    [0x38] = O2_LAMBDA("Oxygen sensor 5 equivalence ratio (current)"),
+    [0x39] = O2_LAMBDA("Oxygen sensor 6 equivalence ratio (current)"),
+    [0x3A] = O2_LAMBDA("Oxygen sensor 7 equivalence ratio (current)"),
+    [0x3B] = O2_LAMBDA("Oxygen sensor 8 equivalence ratio (current)"),
+    [0x3C] = CAT_TEMP("Catalyst temperature bank 1 sensor 1"),
+    [0x3D] = CAT_TEMP("Catalyst temperature bank 2 sensor 1"),
+    [0x3E] = CAT_TEMP("Catalyst temperature bank 1 sensor 2"),
+    [0x3F] = CAT_TEMP("Catalyst temperature bank 2 sensor 2"),
+    [0x40] = BITMAP("PIDs supported 41-60"),
+    [0x41] = PID(4, RawA, 1.0f, 0.0f, 0.0f, 255.0f, "Monitor status this drive cycle", ""),
+    [0x42] = PID(2, RawAB, 0.001f, 0.0f, 0.0f, 65.535f, "Control module voltage", "V"),
+    [0x43] = PID(2, RawAB, 100.0f / 255.0f, 0.0f, 0.0f, 25700.0f, "Absolute load value", "%"),
+    [0x44] = PID(2, RawAB, 2.0f / 65536.0f, 0.0f, 0.0f, 2.0f, "Commanded air-fuel equivalence ratio", "ratio"),
+    [0x45] = PERCENT("Relative throttle position"),
+    [0x46] = TEMP("Ambient air temperature"),
+    [0x47] = PERCENT("Absolute throttle position B"),
+    [0x48] = PERCENT("Absolute throttle position C"),
+    [0x49] = PERCENT("Accelerator pedal position D"),
+    [0x4A] = PERCENT("Accelerator pedal position E"),
+    [0x4B] = PERCENT("Accelerator pedal position F"),
+    [0x4C] = PERCENT("Commanded throttle actuator"),
+    [0x4D] = COUNT16("Time run with MIL on", "min"),
+    [0x4E] = COUNT16("Time since codes cleared", "min"),
+    [0x4F] = PID(4, RawA, 1.0f, 0.0f, 0.0f, 255.0f, "Maximum equivalence ratio", "ratio"),
+    [0x50] = PID(4, RawA, 10.0f, 0.0f, 0.0f, 2550.0f, "Maximum MAF air flow rate", "g/s"),
+    [0x51] = STATUS(1, "Fuel type"),
+    [0x52] = PERCENT("Ethanol fuel"),
+    [0x53] = PID(2, RawAB, 0.005f, 0.0f, 0.0f, 327.675f, "Absolute evap system vapor pressure", "kPa"),
+    [0x54] = PID(2, RawABSigned, 1.0f, 0.0f, -32768.0f, 32767.0f, "Evap system vapor pressure", "Pa"),
+    [0x55] = PID(2, RawA, 100.0f / 128.0f, -100.0f, -100.0f, 99.2f, "Short term secondary O2 trim bank 1", "%"),
+    [0x56] = PID(2, RawA, 100.0f / 128.0f, -100.0f, -100.0f, 99.2f, "Long term secondary O2 trim bank 1", "%"),
+    [0x57] = PID(2, RawA, 100.0f / 128.0f, -100.0f, -100.0f, 99.2f, "Short term secondary O2 trim bank 2", "%"),
+    [0x58] = PID(2, RawA, 100.0f / 128.0f, -100.0f, -100.0f, 99.2f, "Long term secondary O2 trim bank 2", "%"),
+    [0x59] = PID(2, RawAB, 10.0f, 0.0f, 0.0f, 655350.0f, "Fuel rail absolute pressure", "kPa"),
+    [0x5A] = PERCENT("Relative accelerator pedal position"),
+    [0x5B] = PERCENT("Hybrid battery pack remaining life"),
+    [0x5C] = TEMP("Engine oil temperature"),
+    [0x5D] = PID(2, RawAB, 1.0f / 128.0f, -210.0f, -210.0f, 301.992f, "Fuel injection timing", "°"),
+    [0x5E] = PID(2, RawAB, 0.05f, 0.0f, 0.0f, 3276.75f, "Engine fuel rate", "L/h"),
+    [0x5F] = STATUS(1, "Emission requirements"),
+    [0x60] = BITMAP("PIDs supported 61-80"),
+    [0x61] = TORQUE("Driver's demand engine torque"),
+    [0x62] = TORQUE("Actual engine torque"),
+    [0x63] = COUNT16("Engine reference torque", "Nm"),
+    [0x80] = BITMAP("PIDs supported 81-A0"),
+    [0xA0] = BITMAP("PIDs supported A1-C0"),
+    [0xA6] = PID(4, RawABCD, 0.1f, 0.0f, 0.0f, 429496729.5f, "Odometer", "km"),
+    [0xC0] = BITMAP("PIDs supported C1-E0"),
+};
+
+const OBDPIDInfo* OBD_GetPIDInfo(uint8_t pid) {
+    const OBDPIDInfo* info = &OBD_PID_TABLE[pid];
+    return info->bytes ? info : NULL;
+}
+
+int OBD_PIDDataLength(uint8_t pid) {
+    return OBD_PID_TABLE[pid].bytes;
+}
+
+float OBD_DecodePID(uint8_t pid, const uint8_t* data) {
+    const OBDPIDInfo* info = &OBD_PID_TABLE[pid];
+    if (!info->raw) return 0.0f;
+    return info->raw(data) * info->scale + info->offset;
+}
+
+int OBD_EncodePID(uint8_t pid, float value, uint8_t* data) {
+    const OBDPIDInfo* info = &OBD_PID_TABLE[pid];
+    if (!info->raw) return 0;
+
+    if (value < info->min) value = info->min;
+    if (value > info->max) value = info->max;
+    double raw = (value - info->offset) / info->scale;
+    long long n = (long long)(raw < 0 ? raw - 0.5 : raw + 0.5);
+
+    for (int i = 0; i < info->bytes; i++) data[i] = 0;
+    if (info->raw == RawA) {
+        data[0] = (uint8_t)(n < 0 ? 0 : n > 255 ? 255 : n);
+    } else if (info->raw == RawAB || info->raw == RawABSigned) {
+        if (info->raw == RawAB) n = n < 0 ? 0 : n > 65535 ? 65535 : n;
+        else n = n < -32768 ? -32768 : n > 32767 ? 32767 : n;
+        data[0] = (uint8_t)((n >> 8) & 0xFF);
+        data[1] = (uint8_t)(n & 0xFF);
+    } else {
+        uint32_t u = (uint32_t)(n < 0 ? 0 : n > 4294967295LL ? 4294967295LL : n);
+        data[0] = (uint8_t)(u >> 24);
+        data[1] = (uint8_t)(u >> 16);
+        data[2] = (uint8_t)(u >> 8);
+        data[3] = (uint8_t)u;
+    }
+    return info->bytes;
+}
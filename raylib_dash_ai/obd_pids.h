@@ -0,0 +1,38 @@
+#ifndef OBD_PIDS_H
+#define OBD_PIDS_H
+
+#include <stdint.h>
+
+// Raw integer from the reply data bytes (A, A*256+B, ...)
+typedef float (*OBDRawFn)(const uint8_t* data);
+
+// One SAE J1979 Mode 01 PID. Every value decodes the same way:
+//     value = raw(data) * scale + offset
+typedef struct {
+    uint8_t bytes;           // Data bytes in the reply (0 = PID not in the table)
+    OBDRawFn raw;
+    float scale;
+    float offset;
+    float min;               // Range of the decoded value
+    float max;
+    const char* name;
+    const char* unit;
+} OBDPIDInfo;
+
+// Indexed directly by PID number
+extern const OBDPIDInfo OBD_PID_TABLE[256];
+
+// Table entry for a PID, or NULL if it isn't a known Mode 01 PID
+const OBDPIDInfo* OBD_GetPIDInfo(uint8_t pid);
+
+// Number of data bytes the ECU returns for a PID (0 if unknown)
+int OBD_PIDDataLength(uint8_t pid);
+
+// Decode data bytes to engineering units (0 for unknown PIDs)
+float OBD_DecodePID(uint8_t pid, const uint8_t* data);
+
+// Inverse of OBD_DecodePID: fill data with the bytes that decode to value
+// (clamped to the PID's range). Returns the number of bytes, 0 if unknown.
+int OBD_EncodePID(uint8_t pid, float value, uint8_t* data);
+
+#endif // OBD_PIDS_H
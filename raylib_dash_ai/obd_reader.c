@@ -1,4 +1,8 @@
 #include "obd_reader.h"
+#include "obd_pids.h"
+#include "obd_cache.h"
+#include "obd_parse.h"
+#include "obd_can.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -6,13 +10,90 @@
 #include <fcntl.h>
 #include <errno.h>
 #include <termios.h>
+#include <poll.h>
+#include <ctype.h>
+#include <time.h>
+
+static void DetectProtocol(OBDConnection* conn);
+static bool RestoreCachedVehicle(OBDConnection* conn, const char* cache_path);
+static void SaveCachedVehicle(const OBDConnection* conn, const char* cache_path);
+
+// Monotonic clock in microseconds, used for command deadlines
+long long OBD_NowMicros(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+OBDInitProfile OBD_DefaultProfile(void) {
+    OBDInitProfile profile = {
+        .spaces_off = true,
+        .linefeeds_off = true,
+        .headers = false,
+        .adaptive_timing = 2,
+        .timeout_ms = 100,
+        .response_count = 1,
+        .cache_path = OBD_DEFAULT_CACHE_PATH
+    };
+    return profile;
+}
+
+// Send a setting and keep it only if the adapter answers "OK"
+static bool ProbeSetting(OBDConnection* conn, const char* cmd) {
+    char response[64];
+    if (OBD_SendCommand(conn, cmd, response, sizeof(response)) != OBD_OK) return false;
+    return strstr(response, "OK") != NULL;
+}
+
+// Apply the latency profile one setting at a time. Clones and old firmware
+// reject some of these with '?'; each rejected step is simply left out.
+static void ApplyProfile(OBDConnection* conn, const OBDInitProfile* profile) {
+    char cmd[16];
+
+    conn->features = 0;
+    if (profile->spaces_off && ProbeSetting(conn, "ATS0\r")) conn->features |= OBD_FEATURE_SPACES_OFF;
+    if (profile->linefeeds_off && ProbeSetting(conn, "ATL0\r")) conn->features |= OBD_FEATURE_LINEFEEDS_OFF;
+    if (ProbeSetting(conn, profile->headers ? "ATH1\r" : "ATH0\r") && profile->headers) {
+        conn->features |= OBD_FEATURE_HEADERS;
+    }
+    if (profile->adaptive_timing >= 0 && profile->adaptive_timing <= 2) {
+        snprintf(cmd, sizeof(cmd), "ATAT%d\r", profile->adaptive_timing);
+        if (ProbeSetting(conn, cmd)) conn->features |= OBD_FEATURE_ADAPTIVE_TIMING;
+    }
+    if (profile->timeout_ms > 0) {
+        // ATST takes the ECU response timeout in 4 ms units
+        int units = profile->timeout_ms / 4;
+        if (units < 1) units = 1;
+        if (units > 0xFF) units = 0xFF;
+        snprintf(cmd, sizeof(cmd), "ATST%02X\r", units);
+        if (ProbeSetting(conn, cmd)) conn->features |= OBD_FEATURE_TIMEOUT;
+    }
+}
+
+// Try the response-count suffix ("01001" = PID 00, return after 1 answer).
+// Needs a known protocol; ELM327 firmware before v1.3 answers '?'.
+static void ProbeResponseCount(OBDConnection* conn, int count) {
+    char cmd[16];
+    char response[256];
+
+    conn->response_count = 0;
+    if (count < 1 || count > 0xF || conn->protocol == 0) return;
+
+    snprintf(cmd, sizeof(cmd), "0100%X\r", count);
+    if (OBD_SendCommand(conn, cmd, response, sizeof(response)) != OBD_OK) return;
+    if (strstr(response, "41") == NULL) return;
+    conn->response_count = count;
+}
 
 // Initialize the OBD connection
 bool OBD_Init(OBDConnection* conn, const char* device_path) {
-    conn->connected = false;
-    strncpy(conn->device_path, device_path, sizeof(conn->device_path) - 1);
+    OBDInitProfile profile = OBD_DefaultProfile();
+    return OBD_InitWithProfile(conn, device_path, &profile);
+}
 
-    // Open serial port
+// Open the serial port, reset the ELM327 and apply the profile
+static bool OpenAdapter(OBDConnection* conn, const char* device_path, const OBDInitProfile* profile) {
+    // Open serial port (non-blocking; OBD_SendCommand waits with poll())
     conn->fd = open(device_path, O_RDWR | O_NOCTTY | O_NDELAY);
     if (conn->fd == -1) {
         fprintf(stderr, "Error opening %s: %s\n", device_path, strerror(errno));
@@ -38,12 +119,12 @@ bool OBD_Init(OBDConnection* conn, const char* device_path) {
 
     // Raw input mode
     options.c_lflag &= ~(ICANON | ECHO | ECHOE | ISIG);
-    options.c_iflag &= ~(IXON | IXOFF | IXANY);
+    options.c_iflag &= ~(IXON | IXOFF | IXANY | ICRNL | INLCR | IGNCR);
     options.c_oflag &= ~OPOST;
 
-    // Set timeout
+    // Reads never block in the kernel; timeouts are handled by poll()
     options.c_cc[VMIN] = 0;
-    options.c_cc[VTIME] = 10;  // 1 second timeout
+    options.c_cc[VTIME] = 0;
 
     tcsetattr(conn->fd, TCSANOW, &options);
     tcflush(conn->fd, TCIOFLUSH);
@@ -51,169 +132,572 @@ bool OBD_Init(OBDConnection* conn, const char* device_path) {
     // Initialize ELM327
     char response[256];
 
-    // Reset device
-    if (!OBD_SendCommand(conn, "ATZ\r", response, sizeof(response))) {
+    // Reset device (the banner takes up to a second on real adapters)
+    if (OBD_SendCommandTimeout(conn, "ATZ\r", response, sizeof(response), 3000) != OBD_OK) {
         fprintf(stderr, "Failed to reset ELM327\n");
         close(conn->fd);
+        conn->fd = -1;
         return false;
     }
-    usleep(100000); // Wait 100ms
 
     // Turn off echo
     OBD_SendCommand(conn, "ATE0\r", response, sizeof(response));
 
-    // Set protocol to automatic
-    OBD_SendCommand(conn, "ATSP0\r", response, sizeof(response));
+    // Compact, fast replies
+    ApplyProfile(conn, profile);
+    return true;
+}
+
+bool OBD_InitWithProfile(OBDConnection* conn, const char* device_path, const OBDInitProfile* profile) {
+    conn->connected = false;
+    conn->features = 0;
+    conn->protocol = 0;
+    conn->multi_pid = false;
+    conn->batch_failures = 0;
+    conn->response_count = 0;
+    conn->pids_known = false;
+    conn->vin[0] = '\0';
+    memset(conn->bitmap00, 0, sizeof(conn->bitmap00));
+    memset(conn->supported, 0, sizeof(conn->supported));
+    conn->timeout_ms = OBD_DEFAULT_TIMEOUT_MS;
+    conn->last_status = OBD_OK;
+    conn->transport = OBD_TRANSPORT_ELM327;
+    conn->isotp = false;
+    conn->ecu_timeout_ms = 0;
+    strncpy(conn->device_path, device_path, sizeof(conn->device_path) - 1);
+    conn->device_path[sizeof(conn->device_path) - 1] = '\0';
+
+    bool cached;
+    if (OBD_CANIsInterface(device_path)) {
+        // Straight onto the bus: no adapter to reset and no protocol search.
+        // The bit rate is whatever the interface was brought up with.
+        if (!OBD_CANOpen(conn, device_path, profile->can_isotp)) return false;
+        conn->transport = OBD_TRANSPORT_SOCKETCAN;
+        conn->protocol = 6;
+        conn->multi_pid = true;
+        conn->response_count = profile->response_count;
+        conn->ecu_timeout_ms = profile->timeout_ms > 0 ? profile->timeout_ms : OBD_CAN_DEFAULT_P2_MS;
+
+        cached = profile->cache_path && RestoreCachedVehicle(conn, profile->cache_path);
+        if (!cached && OBD_DiscoverPIDs(conn)) {
+            OBD_ReadVIN(conn, conn->vin, sizeof(conn->vin));
+            if (profile->cache_path) SaveCachedVehicle(conn, profile->cache_path);
+        }
+    } else {
+        if (!OpenAdapter(conn, device_path, profile)) return false;
+
+        cached = profile->cache_path && RestoreCachedVehicle(conn, profile->cache_path);
+        if (!cached) {
+            // Set protocol to automatic
+            char response[256];
+            OBD_SendCommand(conn, "ATSP0\r", response, sizeof(response));
+
+            DetectProtocol(conn);
+
+            // Several ECUs may answer; only skip the wait for stragglers when we
+            // don't need their headers
+            if (!(conn->features & OBD_FEATURE_HEADERS)) ProbeResponseCount(conn, profile->response_count);
+
+            if (conn->protocol != 0 && OBD_DiscoverPIDs(conn)) {
+                OBD_ReadVIN(conn, conn->vin, sizeof(conn->vin));
+                if (profile->cache_path) SaveCachedVehicle(conn, profile->cache_path);
+            }
+        }
+    }
+
+    int num_supported = 0;
+    for (int pid = 1; pid < 256; pid++) {
+        if ((pid & 0x1F) != 0 && conn->pids_known && OBD_IsPIDSupported(conn, (uint8_t)pid)) num_supported++;
+    }
 
     conn->connected = true;
-    printf("OBD-II connected on %s\n", device_path);
+    printf("OBD-II connected on %s (protocol %X, %d PIDs supported%s%s%s)\n", device_path,
+           conn->protocol, num_supported, conn->vin[0] ? ", VIN " : "", conn->vin,
+           cached ? ", from cache" : "");
     return true;
 }
 
-// Send command and receive response
-bool OBD_SendCommand(OBDConnection* conn, const char* cmd, char* response, int response_size) {
-    if (!conn->connected) return false;
+static void SaveCachedVehicle(const OBDConnection* conn, const char* cache_path) {
+    OBDCacheEntry entry;
+    memset(&entry, 0, sizeof(entry));
+    // A cut-off path would never match the adapter again
+    if (strlen(conn->device_path) >= sizeof(entry.device_path)) {
+        fprintf(stderr, "Not caching the vehicle: device path %s is too long\n", conn->device_path);
+        return;
+    }
+    snprintf(entry.vin, sizeof(entry.vin), "%s", conn->vin);
+    snprintf(entry.device_path, sizeof(entry.device_path), "%s", conn->device_path);
+    entry.protocol = (uint8_t)conn->protocol;
+    entry.response_count = (uint8_t)conn->response_count;
+    entry.multi_pid = conn->multi_pid;
+    memcpy(entry.bitmap00, conn->bitmap00, sizeof(entry.bitmap00));
+    memcpy(entry.supported, conn->supported, sizeof(entry.supported));
+
+    if (!OBD_CacheStore(cache_path, &entry)) {
+        fprintf(stderr, "Could not write vehicle cache %s\n", cache_path);
+    }
+}
 
-    // Clear buffers
-    tcflush(conn->fd, TCIOFLUSH);
+// Reconnect to the vehicle last seen on this adapter: select its protocol
+// directly instead of searching, and confirm it is the same car from the 0100
+// bitmap (and the VIN, if it has one) before trusting the cached PID list.
+static bool RestoreCachedVehicle(OBDConnection* conn, const char* cache_path) {
+    OBDCacheEntry entry;
+    if (!OBD_CacheLookup(cache_path, conn->device_path, &entry) || entry.protocol == 0) return false;
+
+    if (conn->transport == OBD_TRANSPORT_ELM327) {
+        char cmd[16];
+        char response[256];
+        snprintf(cmd, sizeof(cmd), "ATSP%X\r", entry.protocol);
+        if (OBD_SendCommand(conn, cmd, response, sizeof(response)) != OBD_OK) return false;
+
+        conn->protocol = entry.protocol;
+        conn->multi_pid = entry.multi_pid;
+        conn->response_count = (conn->features & OBD_FEATURE_HEADERS) ? 0 : entry.response_count;
+    }
 
-    // Send command
-    int len = strlen(cmd);
-    int written = write(conn->fd, cmd, len);
-    if (written != len) {
-        fprintf(stderr, "Failed to write command\n");
+    // The first request opens the bus; allow for that like the search does
+    int saved_timeout = conn->timeout_ms;
+    conn->timeout_ms = 5000;
+    OBDValue bitmap;
+    bool same = OBD_ReadPID(conn, 0x00, &bitmap) && bitmap.len == 4 &&
+                memcmp(bitmap.data, entry.bitmap00, 4) == 0;
+    conn->timeout_ms = saved_timeout;
+
+    char vin[18];
+    if (same && entry.vin[0]) same = OBD_ReadVIN(conn, vin, sizeof(vin)) && strcmp(vin, entry.vin) == 0;
+
+    if (!same) {
+        if (conn->transport == OBD_TRANSPORT_ELM327) {
+            conn->protocol = 0;
+            conn->multi_pid = false;
+            conn->response_count = 0;
+        }
         return false;
     }
 
-    // Read response
-    usleep(100000); // Wait 100ms for response
-
-    int total = 0;
-    int attempts = 0;
-    memset(response, 0, response_size);
+    memcpy(conn->bitmap00, entry.bitmap00, sizeof(conn->bitmap00));
+    memcpy(conn->supported, entry.supported, sizeof(conn->supported));
+    memcpy(conn->vin, entry.vin, sizeof(conn->vin));
+    conn->pids_known = true;
+    return true;
+}
 
-    while (total < response_size - 1 && attempts < 50) {
-        int n = read(conn->fd, response + total, response_size - total - 1);
+// Write the whole command, waiting for the tty to drain if it is full
+static bool WriteAll(int fd, const char* data, int len, long long deadline) {
+    int sent = 0;
+    while (sent < len) {
+        int n = write(fd, data + sent, len - sent);
         if (n > 0) {
-            total += n;
-            // Check if we got the prompt character '>'
-            if (strchr(response, '>') != NULL) {
-                break;
-            }
+            sent += n;
+            continue;
         }
-        usleep(20000); // Wait 20ms between reads
-        attempts++;
+        if (n < 0 && errno != EAGAIN && errno != EINTR) return false;
+
+        long long remaining = deadline - OBD_NowMicros();
+        if (remaining <= 0) return false;
+        struct pollfd pfd = { .fd = fd, .events = POLLOUT };
+        poll(&pfd, 1, (int)((remaining + 999) / 1000));
     }
+    return true;
+}
 
-    response[total] = '\0';
-    return total > 0;
+OBDStatus OBD_SendCommand(OBDConnection* conn, const char* cmd, char* response, int response_size) {
+    int timeout_ms = conn->timeout_ms > 0 ? conn->timeout_ms : OBD_DEFAULT_TIMEOUT_MS;
+    return OBD_SendCommandTimeout(conn, cmd, response, response_size, timeout_ms);
 }
 
-// Parse hex response (e.g., "41 0C 1A F8" -> bytes)
-static bool ParseHexResponse(const char* response, unsigned char* bytes, int* num_bytes) {
-    *num_bytes = 0;
-    char temp[3] = {0};
-    const char* ptr = response;
+// Send command and receive response. The reply is read as it arrives and the
+// call returns the moment the '>' prompt shows up; only the bytes from the
+// latest read() are scanned for it.
+static OBDStatus Exchange(OBDConnection* conn, const char* cmd, char* response,
+                          int response_size, int timeout_ms) {
+    if (response_size > 0) response[0] = '\0';
+    if (conn->fd < 0) return OBD_ERR_NOT_CONNECTED;
 
-    while (*ptr) {
-        // Skip non-hex characters
-        while (*ptr && !(((*ptr >= '0') && (*ptr <= '9')) ||
-                        ((*ptr >= 'A') && (*ptr <= 'F')) ||
-                        ((*ptr >= 'a') && (*ptr <= 'f')))) {
-            ptr++;
-        }
+    long long deadline = OBD_NowMicros() + (long long)timeout_ms * 1000;
+
+    // Drop anything left over from a previous reply that timed out
+    tcflush(conn->fd, TCIFLUSH);
 
-        if (!*ptr) break;
+    // Send command
+    if (!WriteAll(conn->fd, cmd, strlen(cmd), deadline)) {
+        fprintf(stderr, "Failed to write command\n");
+        return OBD_ERR_IO;
+    }
 
-        // Read two hex digits
-        temp[0] = *ptr++;
-        if (!*ptr) break;
-        temp[1] = *ptr++;
-        temp[2] = '\0';
+    // Read until the prompt. Bytes that don't fit the caller's buffer are
+    // still drained into a scratch buffer so the link stays in sync.
+    int total = 0;
+    int capacity = response_size - 1;
+    bool overflow = false;
+    char scratch[64];
+
+    for (;;) {
+        long long remaining = deadline - OBD_NowMicros();
+        if (remaining <= 0) {
+            if (capacity >= 0) response[total] = '\0';
+            return OBD_ERR_TIMEOUT;
+        }
 
-        bytes[*num_bytes] = (unsigned char)strtol(temp, NULL, 16);
-        (*num_bytes)++;
+        struct pollfd pfd = { .fd = conn->fd, .events = POLLIN };
+        int ready = poll(&pfd, 1, (int)((remaining + 999) / 1000));
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            return OBD_ERR_IO;
+        }
+        if (ready == 0) continue;
+        if (!(pfd.revents & POLLIN)) return OBD_ERR_IO;
+
+        char* dst = (total < capacity) ? response + total : scratch;
+        int space = (total < capacity) ? capacity - total : (int)sizeof(scratch);
+        int n = read(conn->fd, dst, space);
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EINTR) continue;
+            return OBD_ERR_IO;
+        }
+        if (n == 0) return OBD_ERR_IO;  // Hung up
 
-        if (*num_bytes >= 64) break;  // Safety limit
+        const char* prompt = memchr(dst, '>', n);
+        int kept = prompt ? (int)(prompt - dst) : n;
+        if (dst == scratch) {
+            for (int i = 0; i < kept; i++) {
+                if (!isspace((unsigned char)scratch[i])) overflow = true;
+            }
+        } else {
+            total += kept;
+        }
+        if (prompt) break;
     }
 
-    return *num_bytes > 0;
+    // Trim surrounding whitespace (the ELM327 ends every reply with "\r\r")
+    while (total > 0 && isspace((unsigned char)response[total - 1])) total--;
+    response[total] = '\0';
+    int start = 0;
+    while (start < total && isspace((unsigned char)response[start])) start++;
+    if (start > 0) {
+        memmove(response, response + start, total - start + 1);
+        total -= start;
+    }
+
+    if (overflow) return OBD_ERR_OVERFLOW;
+    if (total == 1 && response[0] == '?') return OBD_ERR_REJECTED;
+    if (total == 0 || strstr(response, "NO DATA") != NULL) return OBD_ERR_NO_DATA;
+    return OBD_OK;
 }
 
-// Read RPM (PID 01 0C)
-int OBD_ReadRPM(OBDConnection* conn) {
-    char response[256];
+OBDStatus OBD_SendCommandTimeout(OBDConnection* conn, const char* cmd, char* response,
+                                 int response_size, int timeout_ms) {
+    if (conn->transport != OBD_TRANSPORT_ELM327) {
+        if (response_size > 0) response[0] = '\0';
+        conn->last_status = OBD_ERR_REJECTED;  // No adapter to take text commands
+        return conn->last_status;
+    }
+    conn->last_status = Exchange(conn, cmd, response, response_size, timeout_ms);
+    return conn->last_status;
+}
 
-    if (!OBD_SendCommand(conn, "010C\r", response, sizeof(response))) {
-        return -1;
+const char* OBD_StatusString(OBDStatus status) {
+    switch (status) {
+        case OBD_OK:                return "ok";
+        case OBD_ERR_NOT_CONNECTED: return "not connected";
+        case OBD_ERR_IO:            return "I/O error";
+        case OBD_ERR_TIMEOUT:       return "timeout";
+        case OBD_ERR_NO_DATA:       return "no data";
+        case OBD_ERR_OVERFLOW:      return "reply too long";
+        case OBD_ERR_REJECTED:      return "command rejected";
     }
+    return "unknown";
+}
 
-    // Response format: "41 0C XX XX" where XXXX is RPM * 4
-    unsigned char bytes[64];
-    int num_bytes;
+#define OBD_MAX_MESSAGES 8
 
-    if (!ParseHexResponse(response, bytes, &num_bytes)) {
-        return -1;
+// Split a reply into per-ECU messages according to the adapter's header setting.
+// Lines the parser rejects are dropped; the rest of the reply is still used.
+static int SplitReply(const OBDConnection* conn, const char* response, OBDRecord* msgs, int max_msgs) {
+    OBDReplyFormat format = { .header_chars = 0, .is_can = conn->protocol >= 6 };
+    if (conn->features & OBD_FEATURE_HEADERS) {
+        format.header_chars = format.is_can ? ((conn->protocol == 7 || conn->protocol == 9) ? 8 : 3) : 6;
     }
+    return OBD_SplitRecords(response, strlen(response), &format, msgs, max_msgs).records;
+}
 
-    // Check if response is valid (41 0C is the header)
-    if (num_bytes < 4 || bytes[0] != 0x41 || bytes[1] != 0x0C) {
-        return -1;
+// Send a binary request (service + parameters) and collect the per-ECU
+// answers. The ELM327 gets it as hex text, with the response-count suffix when
+// answers > 0; SocketCAN puts it on the bus as is.
+static OBDStatus Request(OBDConnection* conn, const uint8_t* request, int len, int answers,
+                         OBDRecord* msgs, int max_msgs, int* num_msgs) {
+    *num_msgs = 0;
+    if (conn->transport == OBD_TRANSPORT_SOCKETCAN) {
+        conn->last_status = OBD_CANRequest(conn, request, len, answers, msgs, max_msgs, num_msgs);
+        return conn->last_status;
     }
 
-    // RPM = ((A * 256) + B) / 4
-    int rpm = ((bytes[2] * 256) + bytes[3]) / 4;
-    return rpm;
+    char cmd[8 + OBD_MAX_PIDS_PER_REQUEST * 2];
+    int pos = 0;
+    for (int i = 0; i < len && pos + 4 < (int)sizeof(cmd); i++) pos += sprintf(cmd + pos, "%02X", request[i]);
+    if (answers > 0) pos += sprintf(cmd + pos, "%X", answers);
+    cmd[pos++] = '\r';
+    cmd[pos] = '\0';
+
+    char response[512];
+    OBDStatus status = OBD_SendCommand(conn, cmd, response, sizeof(response));
+    if (status == OBD_OK) *num_msgs = SplitReply(conn, response, msgs, max_msgs);
+    return status;
 }
 
-// Read vehicle speed (PID 01 0D)
-int OBD_ReadSpeed(OBDConnection* conn) {
-    char response[256];
+// PIDs 00, 20, ... E0 list the PIDs supported in the next range
+static bool IsBitmapPID(uint8_t pid) {
+    return (pid & 0x1F) == 0;
+}
+
+// Send one Mode 01 request for up to OBD_MAX_PIDS_PER_REQUEST PIDs and fill in
+// every value found in the (possibly multi-ECU) reply. Returns values found.
+static int RequestPIDs(OBDConnection* conn, const uint8_t* pids, int n, OBDValue* out,
+                       OBDStatus* status) {
+    uint8_t request[1 + OBD_MAX_PIDS_PER_REQUEST];
+    request[0] = 0x01;
+    memcpy(request + 1, pids, n);
+
+    // Returning after the first ECU's answer only suits a lone PID: another
+    // ECU may hold the rest of a batch, or bits of its own in a support bitmap
+    bool lone = n == 1 && !IsBitmapPID(pids[0]);
+    OBDRecord msgs[OBD_MAX_MESSAGES];
+    int num_msgs;
+    *status = Request(conn, request, 1 + n, lone ? conn->response_count : 0, msgs, OBD_MAX_MESSAGES, &num_msgs);
+    if (*status != OBD_OK) return 0;
+
+    int found = 0;
+    for (int m = 0; m < num_msgs; m++) {
+        const unsigned char* b = msgs[m].bytes;
+        int len = msgs[m].len;
+        if (len < 2 || b[0] != 0x41 || msgs[m].expected > len) continue;
+
+        // Walk the (PID, data...) pairs; stop at padding or an unknown PID
+        int i = 1;
+        while (i < len) {
+            uint8_t pid = b[i];
+            int data_len = OBD_PIDDataLength(pid);
+            if (data_len == 0) {
+                if (n != 1 || pid != pids[0]) break;
+                data_len = len - i - 1;  // Lone PID of unknown size: take the rest
+                if (data_len > 4) data_len = 4;
+            }
+            if (data_len <= 0 || i + 1 + data_len > len) break;
+
+            for (int k = 0; k < n; k++) {
+                if (pids[k] != pid) continue;
+                if (out[k].valid) {
+                    // Support bitmaps add up over the ECUs; otherwise the
+                    // first ECU to answer wins
+                    if (!IsBitmapPID(pid) || data_len != 4 || out[k].len != 4) continue;
+                    for (int j = 0; j < 4; j++) out[k].data[j] |= b[i + 1 + j];
+                    break;
+                }
+                out[k].pid = pid;
+                out[k].valid = true;
+                out[k].ecu = msgs[m].ecu;
+                out[k].len = (uint8_t)data_len;
+                memcpy(out[k].data, &b[i + 1], data_len);
+                out[k].value = OBD_DecodePID(pid, out[k].data);
+                found++;
+                break;
+            }
+            i += 1 + data_len;
+        }
+    }
+
+    return found;
+}
 
-    if (!OBD_SendCommand(conn, "010D\r", response, sizeof(response))) {
-        return -1;
+// Request a group of PIDs and copy the answers back to their slots in out[]
+static int RequestGroup(OBDConnection* conn, const uint8_t* pids, const int* slots, int count,
+                        OBDValue* out) {
+    OBDValue values[OBD_MAX_PIDS_PER_REQUEST];
+    memset(values, 0, sizeof(values));
+
+    OBDStatus status;
+    int got = RequestPIDs(conn, pids, count, values, &status);
+    if (count > 1 && got > 0) {
+        conn->batch_failures = 0;
+    } else if (count > 1 && status != OBD_ERR_TIMEOUT && status != OBD_ERR_IO) {
+        // A reply we can't use ("?", or nothing for any PID): fall back to
+        // single requests. Only a run of these where singles do work turns
+        // batching off, so one garbled frame doesn't cost the whole session;
+        // conn->multi_pid (what gets cached) is left as detected.
+        for (int k = 0; k < count; k++) got += RequestPIDs(conn, &pids[k], 1, &values[k], &status);
+        if (got > 0 && conn->batch_failures < OBD_MAX_BATCH_FAILURES) conn->batch_failures++;
     }
 
-    unsigned char bytes[64];
-    int num_bytes;
+    for (int k = 0; k < count; k++) {
+        if (values[k].valid) out[slots[k]] = values[k];
+    }
+    return got;
+}
 
-    if (!ParseHexResponse(response, bytes, &num_bytes)) {
-        return -1;
+int OBD_ReadPIDs(OBDConnection* conn, const uint8_t* pids, int n, OBDValue* out) {
+    for (int i = 0; i < n; i++) {
+        memset(&out[i], 0, sizeof(out[i]));
+        out[i].pid = pids[i];
     }
 
-    if (num_bytes < 3 || bytes[0] != 0x41 || bytes[1] != 0x0D) {
-        return -1;
+    uint8_t batch[OBD_MAX_PIDS_PER_REQUEST];
+    int slots[OBD_MAX_PIDS_PER_REQUEST];
+    int count = 0;
+    int found = 0;
+
+    for (int i = 0; i < n; i++) {
+        // Never spend a round trip on a PID the vehicle said it doesn't have
+        if (!OBD_IsPIDSupported(conn, pids[i])) continue;
+
+        // PIDs of unknown size can't be split out of a batched reply: send alone
+        if (!OBD_CanBatch(conn) || OBD_PIDDataLength(pids[i]) == 0) {
+            found += RequestGroup(conn, &pids[i], &i, 1, out);
+            continue;
+        }
+
+        batch[count] = pids[i];
+        slots[count] = i;
+        if (++count == OBD_MAX_PIDS_PER_REQUEST) {
+            found += RequestGroup(conn, batch, slots, count, out);
+            count = 0;
+        }
     }
+    if (count > 0) found += RequestGroup(conn, batch, slots, count, out);
 
-    return bytes[2];  // Speed in km/h
+    return found;
 }
 
-// Read coolant temperature (PID 01 05)
-int OBD_ReadCoolantTemp(OBDConnection* conn) {
-    char response[256];
+bool OBD_CanBatch(const OBDConnection* conn) {
+    return conn->multi_pid && conn->batch_failures < OBD_MAX_BATCH_FAILURES;
+}
 
-    if (!OBD_SendCommand(conn, "0105\r", response, sizeof(response))) {
-        return -1;
+bool OBD_IsPIDSupported(const OBDConnection* conn, uint8_t pid) {
+    // The bitmap PIDs themselves are always allowed so discovery can run
+    if (!conn->pids_known || (pid & 0x1F) == 0) return true;
+    return (conn->supported[pid >> 5] >> (pid & 31)) & 1;
+}
+
+// Mark the PIDs listed in a support bitmap reply (PID base + 1 .. base + 32)
+static void AddSupportBitmap(OBDConnection* conn, uint8_t base, const uint8_t* data) {
+    for (int bit = 0; bit < 32; bit++) {
+        if (!(data[bit / 8] & (0x80 >> (bit % 8)))) continue;
+        int pid = base + 1 + bit;
+        if (pid > 0xFF) break;
+        conn->supported[pid >> 5] |= 1U << (pid & 31);
     }
+}
 
-    unsigned char bytes[64];
-    int num_bytes;
+bool OBD_DiscoverPIDs(OBDConnection* conn) {
+    memset(conn->supported, 0, sizeof(conn->supported));
+    conn->pids_known = false;
+
+    OBDValue values[8];
+    const uint8_t ranges[] = { 0x00, 0x20, 0x40, 0x60, 0x80, 0xA0, 0xC0, 0xE0 };
+
+    if (OBD_CanBatch(conn)) {
+        // Ask for every range at once; ECUs only answer the ranges they have
+        if (OBD_ReadPIDs(conn, ranges, 8, values) == 0 || !values[0].valid) return false;
+    } else {
+        // One range at a time, following the "next range supported" bit so
+        // slow protocols don't wait out a timeout on ranges that don't exist
+        memset(values, 0, sizeof(values));
+        for (int i = 0; i < 8; i++) {
+            if (!OBD_ReadPID(conn, ranges[i], &values[i]) || values[i].len != 4) break;
+            if (!(values[i].data[3] & 0x01)) break;
+        }
+        if (!values[0].valid) return false;
+    }
 
-    if (!ParseHexResponse(response, bytes, &num_bytes)) {
-        return -1;
+    for (int i = 0; i < 8; i++) {
+        if (values[i].valid && values[i].len == 4) AddSupportBitmap(conn, ranges[i], values[i].data);
     }
+    memcpy(conn->bitmap00, values[0].data, sizeof(conn->bitmap00));
+    conn->pids_known = true;
+    return true;
+}
+
+// Ask the adapter which protocol it settled on. The first request after ATSP0
+// triggers the search, so it gets a long deadline.
+static void DetectProtocol(OBDConnection* conn) {
+    char response[256];
+
+    conn->protocol = 0;
+    conn->multi_pid = false;
+
+    if (OBD_SendCommandTimeout(conn, "0100\r", response, sizeof(response), 8000) != OBD_OK) return;
+    if (OBD_SendCommand(conn, "ATDPN\r", response, sizeof(response)) != OBD_OK) return;
+
+    // Reply is the protocol number, prefixed with 'A' when chosen automatically
+    int len = strlen(response);
+    if (len == 0 || OBD_HEX_CLASS[(unsigned char)response[len - 1]] >= 16) return;
+    conn->protocol = OBD_HEX_CLASS[(unsigned char)response[len - 1]];
+
+    // ISO 15765-4 CAN (6-9) and user CAN (A-C) take up to six PIDs per request
+    conn->multi_pid = conn->protocol >= 6;
+}
+
+bool OBD_ReadPID(OBDConnection* conn, uint8_t pid, OBDValue* out) {
+    return OBD_ReadPIDs(conn, &pid, 1, out) == 1;
+}
 
-    if (num_bytes < 3 || bytes[0] != 0x41 || bytes[1] != 0x05) {
-        return -1;
+// Read the VIN (Mode 09 PID 02). CAN sends one 20-byte ISO-TP message
+// "49 02 01" + 17 characters; older protocols send five numbered messages
+// "49 02 nn" + 4 bytes, the first padded with zeros.
+bool OBD_ReadVIN(OBDConnection* conn, char* vin, int vin_size) {
+    if (vin_size > 0) vin[0] = '\0';
+    if (vin_size < 18) return false;
+
+    const uint8_t request[] = { 0x09, 0x02 };
+    OBDRecord msgs[OBD_MAX_MESSAGES];
+    int num_msgs;
+    if (Request(conn, request, sizeof(request), 0, msgs, OBD_MAX_MESSAGES, &num_msgs) != OBD_OK) return false;
+
+    char text[64];
+    int len = 0;
+    for (int seq = 0; seq <= 5; seq++) {
+        for (int m = 0; m < num_msgs; m++) {
+            const unsigned char* b = msgs[m].bytes;
+            if (msgs[m].len < 4 || b[0] != 0x49 || b[1] != 0x02 || msgs[m].expected > msgs[m].len) continue;
+            bool single = msgs[m].len >= 20;
+            if ((single && seq != 0) || (!single && b[2] != seq)) continue;
+            for (int i = 3; i < msgs[m].len && len < (int)sizeof(text) - 1; i++) {
+                if (isalnum(b[i])) text[len++] = (char)b[i];
+            }
+            break;
+        }
     }
+    if (len < 17) return false;
+
+    // Keep the last 17 characters (skips any leading pad)
+    memcpy(vin, text + len - 17, 17);
+    vin[17] = '\0';
+    return true;
+}
 
-    return bytes[2] - 40;  // Temperature = A - 40
+// Read RPM (PID 01 0C)
+int OBD_ReadRPM(OBDConnection* conn) {
+    OBDValue value;
+    return OBD_ReadPID(conn, 0x0C, &value) ? (int)value.value : -1;
+}
+
+// Read vehicle speed (PID 01 0D)
+int OBD_ReadSpeed(OBDConnection* conn) {
+    OBDValue value;
+    return OBD_ReadPID(conn, 0x0D, &value) ? (int)value.value : -1;
+}
+
+// Read coolant temperature (PID 01 05)
+int OBD_ReadCoolantTemp(OBDConnection* conn) {
+    OBDValue value;
+    return OBD_ReadPID(conn, 0x05, &value) ? (int)value.value : -1;
 }
 
 // Close connection
 void OBD_Close(OBDConnection* conn) {
     if (conn->connected) {
         close(conn->fd);
+        conn->fd = -1;
         conn->connected = false;
         printf("OBD-II disconnected\n");
     }
@@ -2,18 +2,136 @@
 #define OBD_READER_H
 
 #include <stdbool.h>
+#include <stdint.h>
+
+// Default per-command deadline. Slow Bluetooth adapters answer well inside this,
+// and a missing prompt after it means the adapter or the bus is gone.
+#define OBD_DEFAULT_TIMEOUT_MS 1000
+
+// Where OBD_DefaultProfile() caches what it learns about each vehicle
+#define OBD_DEFAULT_CACHE_PATH "obd_vehicles.cache"
+
+// ELM327 limit for Mode 01 PIDs packed into one request (CAN protocols only)
+#define OBD_MAX_PIDS_PER_REQUEST 6
+
+// Batched requests that fail in a row (while single PIDs work) before
+// OBD_ReadPIDs stops batching for the rest of the connection
+#define OBD_MAX_BATCH_FAILURES 3
+
+// Result of a single command/response exchange with the adapter
+typedef enum {
+    OBD_OK = 0,
+    OBD_ERR_NOT_CONNECTED,   // No open device
+    OBD_ERR_IO,              // write/read/poll failed or the device hung up
+    OBD_ERR_TIMEOUT,         // No '>' prompt before the deadline
+    OBD_ERR_NO_DATA,         // Prompt arrived but the reply was empty or "NO DATA"
+    OBD_ERR_OVERFLOW,        // Reply did not fit the caller's buffer (tail discarded)
+    OBD_ERR_REJECTED         // Adapter answered '?' (unknown command)
+} OBDStatus;
+
+// How OBDConnection reaches the bus
+typedef enum {
+    OBD_TRANSPORT_ELM327 = 0,    // ELM327 adapter on a tty (text protocol)
+    OBD_TRANSPORT_SOCKETCAN      // SocketCAN interface, binary ISO 15765-4 frames
+} OBDTransport;
+
+// Adapter settings that were accepted during OBD_Init (OBDConnection.features)
+#define OBD_FEATURE_SPACES_OFF       0x01   // ATS0
+#define OBD_FEATURE_LINEFEEDS_OFF    0x02   // ATL0
+#define OBD_FEATURE_HEADERS          0x04   // ATH1
+#define OBD_FEATURE_ADAPTIVE_TIMING  0x08   // ATATn
+#define OBD_FEATURE_TIMEOUT          0x10   // ATSTxx
+
+// Settings OBD_Init sends after the reset. Every step is probed and skipped if
+// the adapter rejects it.
+typedef struct {
+    bool spaces_off;         // ATS0: no spaces between hex bytes
+    bool linefeeds_off;      // ATL0: lines end in '\r' only
+    bool headers;            // ATH1: keep headers to tell ECUs apart (ATH0 otherwise)
+    int adaptive_timing;     // ATAT0-2, or -1 to leave the adapter default
+    int timeout_ms;          // ATST in ms (4 ms steps), or 0 to leave the default
+    int response_count;      // Mode 01 suffix: return after this many answers (0 = off)
+    const char* cache_path;  // Per-vehicle protocol/PID cache file (NULL = don't cache)
+    bool can_isotp;          // SocketCAN: kernel ISO-TP socket to 7E0 instead of raw 7DF frames
+} OBDInitProfile;
 
 typedef struct {
-    int fd;                  // File descriptor for serial port
+    int fd;                  // File descriptor for serial port (or CAN socket)
     bool connected;
-    char device_path[256];   // e.g., "/dev/tty.OBD-II-Port" or "COM3"
+    char device_path[256];   // e.g., "/dev/tty.OBD-II-Port", "COM3" or "can0"
+    OBDTransport transport;
+    bool isotp;              // SocketCAN: kernel ISO-TP socket in use
+    int ecu_timeout_ms;      // SocketCAN: how long ECUs get to answer (ATST on an ELM327)
+    int timeout_ms;          // Deadline for each OBD_SendCommand exchange
+    OBDStatus last_status;   // Result of the most recent exchange
+    int protocol;            // ATDPN protocol number (0 = unknown)
+    bool multi_pid;          // Adapter/ECU accept several PIDs per request (as detected)
+    int batch_failures;      // Unusable batched replies in a row since the last good one
+    unsigned int features;   // OBD_FEATURE_* flags the adapter accepted
+    int response_count;      // Response-count suffix in use (0 = none)
+    bool pids_known;         // supported[] holds the ECU's bitmaps
+    uint32_t supported[8];   // Supported Mode 01 PIDs (bit pid & 31 of word pid >> 5)
+    uint8_t bitmap00[4];     // Raw 0100 reply, identifies the vehicle for the cache
+    char vin[18];            // Vehicle identification number ("" if unknown)
 } OBDConnection;
 
-// Initialize OBD connection
+// One Mode 01 value as returned by OBD_ReadPIDs
+typedef struct {
+    uint8_t pid;
+    bool valid;              // false if no ECU answered for this PID
+    uint32_t ecu;            // Header of the answering ECU (0 when headers are off)
+    uint8_t len;             // Number of data bytes
+    uint8_t data[4];         // Raw data bytes A..D
+    float value;             // Decoded value in the unit from OBD_PID_TABLE
+} OBDValue;
+
+// Initialize OBD connection with the default (low-latency) profile. A device
+// path naming a SocketCAN interface ("can0", "vcan0") talks to the bus
+// directly instead of through an ELM327.
 bool OBD_Init(OBDConnection* conn, const char* device_path);
 
-// Send command and get response
-bool OBD_SendCommand(OBDConnection* conn, const char* cmd, char* response, int response_size);
+// Initialize OBD connection with explicit adapter settings
+bool OBD_InitWithProfile(OBDConnection* conn, const char* device_path, const OBDInitProfile* profile);
+
+// Compact replies, aggressive adaptive timing, 100 ms ECU timeout, return
+// after the first ECU answers, and cache vehicles in OBD_DEFAULT_CACHE_PATH
+OBDInitProfile OBD_DefaultProfile(void);
+
+// Send command and get response (without the trailing '>' prompt).
+// Returns as soon as the prompt arrives, or OBD_ERR_TIMEOUT after conn->timeout_ms.
+// ELM327 only: on SocketCAN there is no adapter and this is OBD_ERR_REJECTED.
+OBDStatus OBD_SendCommand(OBDConnection* conn, const char* cmd, char* response, int response_size);
+
+// Same as OBD_SendCommand with an explicit deadline (e.g. ATZ needs longer)
+OBDStatus OBD_SendCommandTimeout(OBDConnection* conn, const char* cmd, char* response,
+                                 int response_size, int timeout_ms);
+
+// Monotonic clock in microseconds (deadlines and sample timestamps)
+long long OBD_NowMicros(void);
+
+// Human-readable name of a status code
+const char* OBD_StatusString(OBDStatus status);
+
+// Read several Mode 01 PIDs, packing up to OBD_MAX_PIDS_PER_REQUEST into one
+// request on CAN and falling back to one request per PID otherwise.
+// Fills out[0..n-1] in the order of pids[]; returns the number of valid values.
+int OBD_ReadPIDs(OBDConnection* conn, const uint8_t* pids, int n, OBDValue* out);
+
+// Read one Mode 01 PID (any PID in obd_pids.c). Returns true if it was answered.
+bool OBD_ReadPID(OBDConnection* conn, uint8_t pid, OBDValue* out);
+
+// Query the 0100/0120/0140/... support bitmaps into conn->supported
+bool OBD_DiscoverPIDs(OBDConnection* conn);
+
+// Whether requests are batched: the protocol allows it and batches haven't
+// failed OBD_MAX_BATCH_FAILURES times in a row on this connection
+bool OBD_CanBatch(const OBDConnection* conn);
+
+// Whether the vehicle reported a PID (always true before discovery)
+bool OBD_IsPIDSupported(const OBDConnection* conn, uint8_t pid);
+
+// Read the 17-character VIN (Mode 09 PID 02); vin_size must be at least 18
+bool OBD_ReadVIN(OBDConnection* conn, char* vin, int vin_size);
 
 // Read RPM from vehicle (returns RPM value, or -1 on error)
 int OBD_ReadRPM(OBDConnection* conn);
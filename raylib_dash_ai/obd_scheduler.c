@@ -0,0 +1,210 @@
+#include "obd_scheduler.h"
+#include <string.h>
+#include <time.h>
+
+#define STATS_WINDOW_US   1000000LL
+#define MAX_STRETCH       20.0f
+
+// Lateness (in periods) above which a window counts as saturated, and below
+// which an existing back-off is relaxed again
+#define LATE_SATURATED    0.5f
+#define LATE_RELAXED      0.1f
+
+static void SleepMicros(long long us) {
+    if (us <= 0) return;
+    struct timespec ts = { .tv_sec = us / 1000000, .tv_nsec = (us % 1000000) * 1000 };
+    nanosleep(&ts, NULL);
+}
+
+static long long BasePeriod(const OBDScheduleChannel* channel) {
+    return (long long)(1000000.0f / channel->target_hz);
+}
+
+void OBD_SchedulerInit(OBDScheduler* sched, OBDConnection* conn, OBDSampleFn on_sample, void* user) {
+    memset(sched, 0, sizeof(*sched));
+    sched->conn = conn;
+    sched->on_sample = on_sample;
+    sched->user = user;
+    sched->request_us = 50000.0f;  // Until the first request is measured
+    sched->stretch = 1.0f;
+    sched->window_start_us = OBD_NowMicros();
+}
+
+bool OBD_SchedulerAddChannel(OBDScheduler* sched, uint8_t pid, float target_hz) {
+    if (sched->num_channels >= OBD_SCHED_MAX_CHANNELS || target_hz <= 0.0f) return false;
+    if (!OBD_IsPIDSupported(sched->conn, pid)) return false;
+
+    OBDScheduleChannel* channel = &sched->channels[sched->num_channels++];
+    memset(channel, 0, sizeof(*channel));
+    channel->pid = pid;
+    channel->target_hz = target_hz;
+    channel->period_us = BasePeriod(channel);
+    channel->next_due_us = OBD_NowMicros();  // First sample right away
+    return true;
+}
+
+// Once per stats window: measure achieved rates and link load, and stretch or
+// relax every period by the same factor so relative rates are kept under load
+static void CloseStatsWindow(OBDScheduler* sched, long long now) {
+    long long elapsed = now - sched->window_start_us;
+    if (elapsed < STATS_WINDOW_US) return;
+
+    // A channel is behind when its samples come in well below the rate it is
+    // scheduled for (rates come from sample intervals, so slow channels like
+    // coolant temperature report correctly without a long window)
+    bool behind = false;
+    for (int i = 0; i < sched->num_channels; i++) {
+        OBDScheduleChannel* channel = &sched->channels[i];
+        unsigned int requests = channel->window_samples + channel->window_misses;
+        channel->miss_rate = requests ? (float)channel->window_misses / requests : 0.0f;
+        channel->window_samples = 0;
+        channel->window_misses = 0;
+
+        long long silence = now - channel->last_sample_us;
+        float rate = channel->interval_us > 0.0f ? 1000000.0f / channel->interval_us : 0.0f;
+        if (channel->last_sample_us == 0 || silence > 2 * channel->interval_us) {
+            rate = channel->last_sample_us ? 1000000.0f / silence : 0.0f;
+        }
+        channel->achieved_hz = rate;
+        if (channel->interval_us > 0.0f && rate < 0.9f * 1000000.0f / channel->period_us) behind = true;
+    }
+
+    sched->load = (float)sched->window_busy_us / elapsed;
+    float lateness = sched->window_served ? sched->window_lateness / sched->window_served : 0.0f;
+    sched->saturated = lateness > LATE_SATURATED || (sched->load > 0.9f && behind);
+
+    if (sched->window_timeouts > 0) {
+        // Gaps from timeouts say nothing about bandwidth; leave the rates alone
+    } else if (sched->saturated) {
+        sched->stretch *= 1.25f;
+        if (sched->stretch > MAX_STRETCH) sched->stretch = MAX_STRETCH;
+    } else if (lateness < LATE_RELAXED && sched->load < 0.8f && sched->stretch > 1.0f) {
+        sched->stretch /= 1.1f;
+        if (sched->stretch < 1.0f) sched->stretch = 1.0f;
+    }
+    for (int i = 0; i < sched->num_channels; i++) {
+        OBDScheduleChannel* channel = &sched->channels[i];
+        channel->period_us = (long long)(BasePeriod(channel) * sched->stretch);
+    }
+
+    sched->window_start_us = now;
+    sched->window_busy_us = 0;
+    sched->window_lateness = 0.0f;
+    sched->window_served = 0;
+    sched->window_timeouts = 0;
+}
+
+int OBD_SchedulerStep(OBDScheduler* sched, int max_wait_ms) {
+    if (sched->num_channels == 0) {
+        SleepMicros((long long)max_wait_ms * 1000);
+        return 0;
+    }
+
+    // Sleep until the earliest deadline instead of a fixed interval
+    long long now = OBD_NowMicros();
+    long long earliest = sched->channels[0].next_due_us;
+    for (int i = 1; i < sched->num_channels; i++) {
+        if (sched->channels[i].next_due_us < earliest) earliest = sched->channels[i].next_due_us;
+    }
+    if (earliest > now) {
+        long long wait = earliest - now;
+        if (wait > (long long)max_wait_ms * 1000) {
+            SleepMicros((long long)max_wait_ms * 1000);
+            CloseStatsWindow(sched, OBD_NowMicros());
+            return 0;
+        }
+        SleepMicros(wait);
+        now = OBD_NowMicros();
+    }
+
+    // Everything due before this request would come back rides along with it.
+    // Earliest deadline first, insertion-sorted (few channels).
+    long long horizon = now + (long long)(sched->request_us / 2);
+    int due[OBD_SCHED_MAX_CHANNELS];
+    int num_due = 0;
+    for (int i = 0; i < sched->num_channels; i++) {
+        long long deadline = sched->channels[i].next_due_us;
+        if (deadline > horizon) continue;
+        int pos = num_due++;
+        while (pos > 0 && sched->channels[due[pos - 1]].next_due_us > deadline) {
+            due[pos] = due[pos - 1];
+            pos--;
+        }
+        due[pos] = i;
+    }
+
+    int batch = OBD_CanBatch(sched->conn) ? OBD_MAX_PIDS_PER_REQUEST : 1;
+    if (num_due > batch) num_due = batch;
+
+    uint8_t pids[OBD_MAX_PIDS_PER_REQUEST];
+    OBDValue values[OBD_MAX_PIDS_PER_REQUEST];
+    for (int k = 0; k < num_due; k++) pids[k] = sched->channels[due[k]].pid;
+
+    long long start = OBD_NowMicros();
+    OBD_ReadPIDs(sched->conn, pids, num_due, values);
+    long long end = OBD_NowMicros();
+
+    bool timed_out = sched->conn->last_status == OBD_ERR_TIMEOUT;
+    sched->last_request_us = end - start;
+    if (timed_out) {
+        // A dead link isn't a busy one: keep the timeout out of the round-trip
+        // estimate and the load, and start every channel afresh
+        sched->window_timeouts++;
+        for (int i = 0; i < sched->num_channels; i++) {
+            if (sched->channels[i].next_due_us < end) sched->channels[i].next_due_us = end;
+        }
+    } else {
+        sched->request_us += 0.2f * ((end - start) - sched->request_us);
+        sched->window_busy_us += end - start;
+    }
+
+    // The ECU sampled somewhere inside the round trip; the midpoint is the
+    // best single estimate
+    long long timestamp = start + (end - start) / 2;
+
+    int delivered = 0;
+    for (int k = 0; k < num_due; k++) {
+        OBDScheduleChannel* channel = &sched->channels[due[k]];
+        channel->requests++;
+
+        long long late = start - channel->next_due_us;
+        if (late > 0) sched->window_lateness += (float)late / channel->period_us;
+        sched->window_served++;
+
+        // Keep the average rate when slightly late, but never build a backlog
+        if (!timed_out) channel->next_due_us += channel->period_us;
+        if (channel->next_due_us < end) channel->next_due_us = end;
+
+        if (values[k].valid) {
+            if (channel->last_sample_us != 0) {
+                float interval = (float)(timestamp - channel->last_sample_us);
+                if (channel->interval_us <= 0.0f) channel->interval_us = interval;
+                else channel->interval_us += 0.2f * (interval - channel->interval_us);
+            }
+            channel->last_sample_us = timestamp;
+            channel->window_samples++;
+            channel->samples++;
+            delivered++;
+            if (sched->on_sample) sched->on_sample(sched->user, &values[k], timestamp);
+        } else {
+            channel->window_misses++;
+            if (timed_out) channel->timeouts++;
+        }
+    }
+
+    CloseStatsWindow(sched, end);
+    return delivered;
+}
+
+int OBD_SchedulerGetStats(const OBDScheduler* sched, OBDChannelStats* out, int max_channels) {
+    int count = sched->num_channels < max_channels ? sched->num_channels : max_channels;
+    for (int i = 0; i < count; i++) {
+        const OBDScheduleChannel* channel = &sched->channels[i];
+        out[i].pid = channel->pid;
+        out[i].target_hz = channel->target_hz;
+        out[i].scheduled_hz = 1000000.0f / channel->period_us;
+        out[i].achieved_hz = channel->achieved_hz;
+        out[i].miss_rate = channel->miss_rate;
+    }
+    return count;
+}
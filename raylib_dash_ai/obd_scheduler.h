@@ -0,0 +1,69 @@
+#ifndef OBD_SCHEDULER_H
+#define OBD_SCHEDULER_H
+
+#include "obd_reader.h"
+
+#define OBD_SCHED_MAX_CHANNELS 32
+
+// Called once per answered PID, from the thread running OBD_SchedulerStep.
+// timestamp_us is on the OBD_NowMicros() clock.
+typedef void (*OBDSampleFn)(void* user, const OBDValue* value, long long timestamp_us);
+
+typedef struct {
+    uint8_t pid;
+    float target_hz;         // Requested sample rate
+    long long period_us;     // Current period (stretched when the link is saturated)
+    long long next_due_us;   // Deadline of the next sample
+    long long last_sample_us;
+    float interval_us;       // Smoothed time between valid samples
+    unsigned int window_samples;
+    unsigned int window_misses;
+    float achieved_hz;       // Valid samples per second (from interval_us)
+    float miss_rate;         // Fraction of requests that got no answer
+    unsigned long requests;  // Totals since OBD_SchedulerInit
+    unsigned long samples;
+    unsigned long timeouts;  // Requests that ended without a prompt
+} OBDScheduleChannel;
+
+// Achieved versus requested rate for one channel
+typedef struct {
+    uint8_t pid;
+    float target_hz;
+    float scheduled_hz;      // Rate the scheduler is aiming for after back-off
+    float achieved_hz;
+    float miss_rate;
+} OBDChannelStats;
+
+typedef struct {
+    OBDConnection* conn;
+    OBDScheduleChannel channels[OBD_SCHED_MAX_CHANNELS];
+    int num_channels;
+    OBDSampleFn on_sample;
+    void* user;
+
+    float request_us;        // Smoothed round-trip time of one request
+    long long last_request_us; // Round-trip time of the request being delivered
+    float load;              // Fraction of the last stats window spent in requests
+    float stretch;           // Period multiplier applied while saturated (1 = none)
+    bool saturated;          // Channels are falling behind their deadlines
+    long long window_start_us;
+    long long window_busy_us;
+    float window_lateness;   // Sum of (lateness / period) over served samples
+    unsigned int window_served;
+    unsigned int window_timeouts;
+} OBDScheduler;
+
+// Prepare a scheduler for an initialized connection
+void OBD_SchedulerInit(OBDScheduler* sched, OBDConnection* conn, OBDSampleFn on_sample, void* user);
+
+// Poll a PID at the given rate. PIDs the vehicle doesn't support are refused.
+bool OBD_SchedulerAddChannel(OBDScheduler* sched, uint8_t pid, float target_hz);
+
+// Wait (at most max_wait_ms) for the earliest deadline, then send one request
+// with the channels that are due, most overdue first. Returns samples delivered.
+int OBD_SchedulerStep(OBDScheduler* sched, int max_wait_ms);
+
+// Copy per-channel rates into out[]; returns the number of channels
+int OBD_SchedulerGetStats(const OBDScheduler* sched, OBDChannelStats* out, int max_channels);
+
+#endif // OBD_SCHEDULER_H
@@ -0,0 +1,146 @@
+#include "readout.h"
+#include "raylib/src/rlgl.h"
+#include <string.h>
+#include <math.h>
+
+// Atlas slots after the ten digits
+#define SLOT_MINUS 10
+#define SLOT_SUFFIX 11
+
+// Empty columns between atlas slots
+#define SLOT_GAP 2
+
+static const char DIGIT_PAIRS[] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+Readout Readout_Make(int fontSize, int minDigits, const char* suffix) {
+    Readout readout = { .font_size = fontSize, .min_digits = minDigits };
+    if (readout.min_digits > READOUT_MAX_DIGITS) readout.min_digits = READOUT_MAX_DIGITS;
+    strncpy(readout.suffix, suffix ? suffix : "", sizeof(readout.suffix) - 1);
+    return readout;
+}
+
+int Readout_Format(int value, int minDigits, char* out) {
+    // Digits come out right to left, two per division
+    char digits[READOUT_MAX_DIGITS];
+    unsigned int v = value < 0 ? 0u - (unsigned int)value : (unsigned int)value;
+    int n = 0;
+    while (v >= 100) {
+        unsigned int pair = (v % 100) * 2;
+        v /= 100;
+        digits[n++] = DIGIT_PAIRS[pair + 1];
+        digits[n++] = DIGIT_PAIRS[pair];
+    }
+    digits[n++] = DIGIT_PAIRS[v * 2 + 1];
+    if (v >= 10) digits[n++] = DIGIT_PAIRS[v * 2];
+
+    // As printf's %0*d: the sign counts towards the width
+    int len = 0;
+    if (value < 0) {
+        out[len++] = '-';
+        minDigits--;
+    }
+    if (minDigits > READOUT_MAX_DIGITS) minDigits = READOUT_MAX_DIGITS;
+    while (n < minDigits) digits[n++] = '0';
+    while (n > 0) out[len++] = digits[--n];
+    out[len] = '\0';
+    return len;
+}
+
+static float SlotX(int slot, float cell) {
+    return slot * (cell + SLOT_GAP);
+}
+
+bool Readout_Prepare(Readout* readout) {
+    if (readout->atlas_ready) return true;
+    int size = readout->font_size;
+
+    // DrawText's spacing for the default font
+    readout->spacing = (float)(size / 10);
+    int cell = MeasureText("-", size);
+    for (int d = 0; d < 10; d++) {
+        char digit[2] = { (char)('0' + d), '\0' };
+        int width = MeasureText(digit, size);
+        if (width > cell) cell = width;
+    }
+    readout->cell = (float)cell;
+    readout->suffix_width = readout->suffix[0] ? (float)MeasureText(readout->suffix, size) : 0.0f;
+    readout->widths[0] = 0.0f;
+    for (int n = 1; n <= READOUT_MAX_GLYPHS; n++) {
+        readout->widths[n] = n * readout->cell + (n - 1) * readout->spacing;
+    }
+
+    int width = (int)(SlotX(SLOT_SUFFIX, readout->cell) + readout->suffix_width) + 1;
+    readout->atlas = LoadRenderTexture(width, size);
+    if (readout->atlas.id == 0) return false;
+
+    // Alpha as drawn, not squared by blending onto the cleared texture
+    BeginTextureMode(readout->atlas);
+    ClearBackground(BLANK);
+    rlSetBlendFactorsSeparate(RL_SRC_ALPHA, RL_ONE_MINUS_SRC_ALPHA, RL_ONE, RL_ONE_MINUS_SRC_ALPHA, RL_FUNC_ADD,
+                              RL_FUNC_ADD);
+    BeginBlendMode(BLEND_CUSTOM_SEPARATE);
+    for (int slot = 0; slot <= SLOT_MINUS; slot++) {
+        char glyph[2] = { slot == SLOT_MINUS ? '-' : (char)('0' + slot), '\0' };
+        int x = (int)SlotX(slot, readout->cell) + (cell - MeasureText(glyph, size)) / 2;
+        DrawText(glyph, x, 0, size, WHITE);
+    }
+    if (readout->suffix[0]) DrawText(readout->suffix, (int)SlotX(SLOT_SUFFIX, readout->cell), 0, size, WHITE);
+    EndBlendMode();
+    EndTextureMode();
+    readout->atlas_ready = true;
+    return true;
+}
+
+bool Readout_Set(Readout* readout, int value) {
+    if (readout->laid_out && value == readout->value) return false;
+    readout->value = value;
+    readout->laid_out = true;
+
+    int len = Readout_Format(value, readout->min_digits, readout->text);
+    for (int i = 0; i < len; i++) {
+        readout->glyphs[i] = readout->text[i] == '-' ? SLOT_MINUS : (unsigned char)(readout->text[i] - '0');
+    }
+    readout->num_glyphs = len;
+    memcpy(readout->text + len, readout->suffix, strlen(readout->suffix) + 1);
+    return true;
+}
+
+float Readout_Width(const Readout* readout) {
+    if (!readout->laid_out) return 0.0f;
+    if (!readout->atlas_ready) return (float)MeasureText(readout->text, readout->font_size);
+
+    float width = readout->widths[readout->num_glyphs];
+    if (readout->suffix[0]) width += readout->spacing + readout->suffix_width;
+    return width;
+}
+
+void Readout_Draw(const Readout* readout, Vector2 top, Color color) {
+    if (!readout->laid_out) return;
+    float width = Readout_Width(readout);
+    if (!readout->atlas_ready) {
+        DrawText(readout->text, top.x - (int)width / 2, top.y, readout->font_size, color);
+        return;
+    }
+
+    // Whole pixels, so the atlas maps texel for texel
+    Vector2 pos = { floorf(top.x - width / 2), floorf(top.y) };
+    float height = (float)readout->font_size;
+    for (int i = 0; i < readout->num_glyphs; i++) {
+        Rectangle source = { SlotX(readout->glyphs[i], readout->cell), 0, readout->cell, -height };
+        DrawTextureRec(readout->atlas.texture, source, pos, color);
+        pos.x += readout->cell + readout->spacing;
+    }
+    if (readout->suffix[0]) {
+        Rectangle source = { SlotX(SLOT_SUFFIX, readout->cell), 0, readout->suffix_width, -height };
+        DrawTextureRec(readout->atlas.texture, source, pos, color);
+    }
+}
+
+void Readout_Unload(Readout* readout) {
+    if (readout->atlas.id != 0) UnloadRenderTexture(readout->atlas);
+    readout->atlas = (RenderTexture2D){0};
+    readout->atlas_ready = false;
+}
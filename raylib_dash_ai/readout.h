@@ -0,0 +1,67 @@
+#ifndef READOUT_H
+#define READOUT_H
+
+#include "raylib/src/raylib.h"
+#include <stdbool.h>
+
+// Digital readout of an integer in the default font, without per-frame
+// text work.
+//
+// The digits, a minus sign and an optional suffix ("°C") are rasterised
+// once, white, into an atlas at the readout's font size. Digits are laid out
+// in cells as wide as the widest digit, so the width depends only on how many
+// digits there are (widths are computed once per glyph count) and a centred
+// readout doesn't jitter as its value changes. Only a change in the
+// displayed integer lays the glyphs out again; a frame draws the laid-out
+// glyphs as textured quads from the atlas, in one batch, tinted any colour.
+//
+// Until the atlas is prepared (it needs the window) the readout falls back
+// to DrawText.
+
+#define READOUT_MAX_DIGITS 10
+#define READOUT_MAX_GLYPHS 11        // Sign and digits
+
+typedef struct {
+    int font_size;
+    int min_digits;          // Zero padded to this many digits
+    char suffix[8];
+
+    // Atlas: digit slots 0-9, the minus sign, then the suffix
+    RenderTexture2D atlas;
+    bool atlas_ready;
+    float cell;              // Width of a digit slot
+    float spacing;           // Between glyphs, as DrawText spaces them
+    float suffix_width;
+    float widths[READOUT_MAX_GLYPHS + 1];   // Layout width by glyph count, before the suffix
+
+    // Current layout
+    int value;
+    bool laid_out;
+    char text[READOUT_MAX_GLYPHS + 8];      // With the suffix, for the DrawText fallback
+    int num_glyphs;
+    unsigned char glyphs[READOUT_MAX_GLYPHS];   // Atlas slot of each glyph
+} Readout;
+
+Readout Readout_Make(int fontSize, int minDigits, const char* suffix);
+
+// Rasterise the atlas if it isn't there yet. Call outside
+// BeginDrawing/EndDrawing; returns false if the texture can't be created.
+bool Readout_Prepare(Readout* readout);
+
+// Show value: lays the glyphs out again only if it differs from the value
+// shown. Returns whether it did (the readout needs redrawing).
+bool Readout_Set(Readout* readout, int value);
+
+// Width of the current value as drawn, suffix included
+float Readout_Width(const Readout* readout);
+
+// The current value, its top edge centred on top
+void Readout_Draw(const Readout* readout, Vector2 top, Color color);
+
+void Readout_Unload(Readout* readout);
+
+// value as decimal digits, zero padded to minDigits, with a leading '-' if
+// negative; returns the length. out needs room for 12 characters.
+int Readout_Format(int value, int minDigits, char* out);
+
+#endif // READOUT_H
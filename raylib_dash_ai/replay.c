@@ -0,0 +1,313 @@
+#include "replay.h"
+#include "telemetry_log.h"
+#include "drive_archive.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#define STATS_WINDOW_US 1000000LL
+
+// Same clock as OBD_NowMicros, without linking the reader
+static long long NowMicros(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+static void SleepMicros(long long us) {
+    if (us <= 0) return;
+    struct timespec ts = { .tv_sec = us / 1000000, .tv_nsec = (us % 1000000) * 1000 };
+    nanosleep(&ts, NULL);
+}
+
+// ---- Loading ----
+
+static bool Push(Replay* replay, long* capacity, uint8_t pid, long long recorded_us, float value) {
+    if (replay->count == *capacity) {
+        long grown = *capacity ? *capacity * 2 : 65536;
+        ReplaySample* samples = realloc(replay->samples, sizeof(ReplaySample) * grown);
+        if (!samples) return false;
+        replay->samples = samples;
+        *capacity = grown;
+    }
+    ReplaySample* s = &replay->samples[replay->count++];
+    s->recorded_us = recorded_us;
+    s->value = value;
+    s->pid = pid;
+    return true;
+}
+
+static bool LoadSegment(Replay* replay, long* capacity, const char* path) {
+    TLogReader reader;
+    if (!TLog_ReaderOpen(&reader, path)) return false;
+    TLogRecord record;
+    bool ok = true;
+    while (ok && TLog_ReaderNext(&reader, &record)) {
+        ok = Push(replay, capacity, record.pid, record.timestamp_us + reader.header.clock_offset_us, record.value);
+    }
+    TLog_ReaderClose(&reader);
+    return ok;
+}
+
+static int CompareName(const void* a, const void* b) {
+    return strcmp(*(char* const*)a, *(char* const*)b);
+}
+
+static bool LoadDirectory(Replay* replay, long* capacity, const char* dir) {
+    DIR* d = opendir(dir);
+    if (!d) {
+        fprintf(stderr, "Cannot open %s\n", dir);
+        return false;
+    }
+    char** paths = NULL;
+    int n = 0, allocated = 0;
+    struct dirent* entry;
+    while ((entry = readdir(d))) {
+        size_t len = strlen(entry->d_name);
+        if (len <= 5 || strcmp(entry->d_name + len - 5, ".tlog") != 0) continue;
+        if (n == allocated) {
+            allocated = allocated ? allocated * 2 : 64;
+            paths = realloc(paths, sizeof(char*) * allocated);
+        }
+        paths[n] = malloc(strlen(dir) + len + 2);
+        sprintf(paths[n], "%s/%s", dir, entry->d_name);
+        n++;
+    }
+    closedir(d);
+    qsort(paths, n, sizeof(char*), CompareName);
+
+    for (int i = 0; i < n; i++) {
+        // A segment that won't open costs its own records, not the whole drive
+        if (!LoadSegment(replay, capacity, paths[i])) fprintf(stderr, "Skipping %s\n", paths[i]);
+        free(paths[i]);
+    }
+    free(paths);
+    return true;
+}
+
+typedef struct {
+    Replay* replay;
+    long* capacity;
+    bool ok;
+} ArchiveLoad;
+
+static bool AddArchiveSample(void* user, uint8_t pid, long long timestamp_us, float value) {
+    ArchiveLoad* load = (ArchiveLoad*)user;
+    load->ok = Push(load->replay, load->capacity, pid, timestamp_us, value);
+    return load->ok;
+}
+
+static bool LoadArchive(Replay* replay, long* capacity, const char* path) {
+    ArchiveReader reader;
+    if (!Archive_Open(&reader, path)) return false;
+    ArchiveQuery all = Archive_QueryAll();
+    ArchiveLoad load = { replay, capacity, true };
+    Archive_Query(&reader, &all, AddArchiveSample, &load);
+    Archive_Close(&reader);
+    return load.ok;
+}
+
+// Oldest first; equal times keep their order in the file
+static int CompareRecorded(const void* a, const void* b) {
+    const ReplaySample* x = (const ReplaySample*)a;
+    const ReplaySample* y = (const ReplaySample*)b;
+    if (x->recorded_us != y->recorded_us) return x->recorded_us < y->recorded_us ? -1 : 1;
+    return (x->play_us > y->play_us) - (x->play_us < y->play_us);
+}
+
+static ReplayChannel* Channel(Replay* replay, uint8_t pid) {
+    for (int c = 0; c < replay->num_channels; c++) {
+        if (replay->channels[c].pid == pid) return &replay->channels[c];
+    }
+    if (replay->num_channels == OBD_SCHED_MAX_CHANNELS) return NULL;
+    ReplayChannel* channel = &replay->channels[replay->num_channels++];
+    channel->pid = pid;
+    return channel;
+}
+
+bool Replay_Load(Replay* replay, const char* path) {
+    memset(replay, 0, sizeof(*replay));
+    long capacity = 0;
+
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        fprintf(stderr, "Cannot open %s\n", path);
+        return false;
+    }
+    char magic[8] = "";
+    if (!S_ISDIR(st.st_mode)) {
+        FILE* f = fopen(path, "rb");
+        if (!f) {
+            fprintf(stderr, "Cannot open %s\n", path);
+            return false;
+        }
+        if (fread(magic, 1, sizeof(magic), f) != sizeof(magic)) magic[0] = '\0';
+        fclose(f);
+    }
+
+    bool ok;
+    if (S_ISDIR(st.st_mode)) ok = LoadDirectory(replay, &capacity, path);
+    else if (memcmp(magic, ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC)) == 0) ok = LoadArchive(replay, &capacity, path);
+    else ok = LoadSegment(replay, &capacity, path);
+    if (!ok || replay->count == 0) {
+        if (ok) fprintf(stderr, "%s: no samples to replay\n", path);
+        Replay_Free(replay);
+        return false;
+    }
+
+    // An archive comes channel by channel, and segments of separate sessions
+    // may interleave: sort by time, using play_us (not set yet) as the
+    // original position for a stable order
+    for (long i = 0; i < replay->count; i++) replay->samples[i].play_us = i;
+    qsort(replay->samples, replay->count, sizeof(ReplaySample), CompareRecorded);
+
+    long long play = 0;
+    for (long i = 0; i < replay->count; i++) {
+        ReplaySample* s = &replay->samples[i];
+        if (i > 0) {
+            long long gap = s->recorded_us - replay->samples[i - 1].recorded_us;
+            play += gap < REPLAY_MAX_GAP_US ? gap : REPLAY_MAX_GAP_US;
+        }
+        s->play_us = play;
+        ReplayChannel* channel = Channel(replay, s->pid);
+        if (channel) channel->count++;
+    }
+    replay->duration_us = play;
+    for (int c = 0; c < replay->num_channels; c++) {
+        ReplayChannel* channel = &replay->channels[c];
+        channel->recorded_hz = play > 0 ? channel->count * 1e6f / play : 0.0f;
+    }
+    return true;
+}
+
+void Replay_Free(Replay* replay) {
+    free(replay->samples);
+    memset(replay, 0, sizeof(*replay));
+}
+
+// ---- Playback ----
+
+void Replay_Start(Replay* replay, float speed, bool loop, OBDSampleFn on_sample, void* user) {
+    replay->on_sample = on_sample;
+    replay->user = user;
+    replay->loop = loop;
+    replay->speed = speed > 0.0f ? speed : 0.0f;
+    atomic_store(&replay->requested_speed, replay->speed);
+    replay->next = 0;
+    replay->start_us = NowMicros();
+    replay->window_us = replay->start_us;
+    memset(replay->achieved_hz, 0, sizeof(replay->achieved_hz));
+    for (int c = 0; c < replay->num_channels; c++) replay->channels[c].window = 0;
+    replay->delivered = 0;
+    replay->loops = 0;
+    replay->max_late_us = 0;
+}
+
+void Replay_SetSpeed(Replay* replay, float speed) {
+    atomic_store(&replay->requested_speed, speed > 0.0f ? speed : 0.0f);
+}
+
+// Position in the recording the replay has reached, in play_us
+static long long PlayPosition(const Replay* replay, long long now) {
+    if (replay->speed > 0.0f) return (long long)((now - replay->start_us) * (double)replay->speed);
+    return replay->next < replay->count ? replay->samples[replay->next].play_us : replay->duration_us;
+}
+
+static long long DueMicros(const Replay* replay, long i) {
+    return replay->start_us + (long long)(replay->samples[i].play_us / (double)replay->speed);
+}
+
+static void Deliver(Replay* replay, long i, long long timestamp_us) {
+    const ReplaySample* s = &replay->samples[i];
+    OBDValue value;
+    memset(&value, 0, sizeof(value));
+    value.pid = s->pid;
+    value.valid = true;
+    value.value = s->value;
+    replay->on_sample(replay->user, &value, timestamp_us);
+    replay->delivered++;
+    for (int c = 0; c < replay->num_channels; c++) {
+        if (replay->channels[c].pid == s->pid) {
+            replay->channels[c].window++;
+            break;
+        }
+    }
+}
+
+int Replay_Step(Replay* replay, int max_wait_ms) {
+    long long now = NowMicros();
+
+    float requested = atomic_load(&replay->requested_speed);
+    if (requested != replay->speed) {
+        // Keep the position: what is due now stays due now
+        long long position = PlayPosition(replay, now);
+        replay->speed = requested;
+        if (requested > 0.0f) replay->start_us = now - (long long)(position / (double)requested);
+        replay->max_late_us = 0;   // Lateness is per speed
+    }
+
+    if (now - replay->window_us >= STATS_WINDOW_US) {
+        float seconds = (now - replay->window_us) / 1e6f;
+        for (int c = 0; c < replay->num_channels; c++) {
+            replay->achieved_hz[c] = replay->channels[c].window / seconds;
+            replay->channels[c].window = 0;
+        }
+        replay->window_us = now;
+    }
+
+    if (replay->next >= replay->count) {
+        if (!replay->loop) return -1;
+        // Start over after a gap, as after the end of a drive
+        replay->next = 0;
+        replay->loops++;
+        if (replay->speed > 0.0f) {
+            replay->start_us += (long long)((replay->duration_us + REPLAY_MAX_GAP_US) / (double)replay->speed);
+        }
+    }
+
+    int delivered = 0;
+    if (replay->speed <= 0.0f) {
+        while (replay->next < replay->count && delivered < REPLAY_BURST) {
+            Deliver(replay, replay->next++, NowMicros());
+            delivered++;
+        }
+        return delivered;
+    }
+
+    while (replay->next < replay->count) {
+        long long due = DueMicros(replay, replay->next);
+        if (due > now) break;
+        if (now - due > replay->max_late_us) replay->max_late_us = now - due;
+        Deliver(replay, replay->next++, due);
+        delivered++;
+    }
+
+    // Sleep until the next sample is due, or up to max_wait_ms
+    if (delivered == 0 && replay->next < replay->count) {
+        long long wait = DueMicros(replay, replay->next) - now;
+        if (wait > max_wait_ms * 1000LL) wait = max_wait_ms * 1000LL;
+        SleepMicros(wait);
+    }
+    return delivered;
+}
+
+float Replay_Position(const Replay* replay) {
+    if (replay->count == 0) return 0.0f;
+    return (float)replay->next / replay->count;
+}
+
+int Replay_GetStats(const Replay* replay, OBDChannelStats* out, int max_channels) {
+    int count = 0;
+    for (int c = 0; c < replay->num_channels && count < max_channels; c++) {
+        OBDChannelStats* stats = &out[count++];
+        memset(stats, 0, sizeof(*stats));
+        stats->pid = replay->channels[c].pid;
+        stats->target_hz = replay->channels[c].recorded_hz * replay->speed;
+        stats->scheduled_hz = stats->target_hz;
+        stats->achieved_hz = replay->achieved_hz[c];
+    }
+    return count;
+}
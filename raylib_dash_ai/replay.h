@@ -0,0 +1,98 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include "obd_scheduler.h"
+
+// Play a recorded drive back through the same sample callback the OBD thread
+// uses, so everything downstream (telemetry, history, needles) sees it as it
+// would see a car.
+//
+// A recording is a drive recorder segment (.tlog), a directory of them, or a
+// drive archive (.dar). It is loaded whole and sorted by time, then played on
+// the OBD_NowMicros clock:
+//
+//   speed 1     each sample is delivered when it is due, with the time it is
+//               due as its timestamp: the original spacing, whatever the
+//               thread's scheduling did
+//   speed N     the same, N times faster (or slower below 1)
+//   speed 0     as fast as possible, stamped with the time of delivery
+//
+// Given the same recording and speed, a replay delivers the same samples in
+// the same order at the same offsets from its start, every time.
+//
+// Gaps longer than REPLAY_MAX_GAP_US (between drives, or between segments of
+// an archive) are cut to that, and a looping replay starts over after one
+// such gap.
+
+#define REPLAY_MAX_GAP_US 2000000LL
+
+// Samples delivered per Replay_Step at speed 0, so a stop request is still
+// noticed quickly
+#define REPLAY_BURST 256
+
+typedef struct {
+    long long play_us;       // Offset in the replay, gaps cut
+    long long recorded_us;   // Wall clock when it was recorded
+    float value;
+    uint8_t pid;
+} ReplaySample;
+
+// Delivery rate of one PID, for the overlay
+typedef struct {
+    uint8_t pid;
+    float recorded_hz;       // Average rate in the recording
+    unsigned long count;     // Samples in the recording
+    unsigned long window;    // Delivered in the current window
+} ReplayChannel;
+
+typedef struct {
+    ReplaySample* samples;
+    long count;
+    long long duration_us;   // play_us of the last sample
+    ReplayChannel channels[OBD_SCHED_MAX_CHANNELS];
+    int num_channels;
+
+    OBDSampleFn on_sample;
+    void* user;
+    bool loop;
+    _Atomic float requested_speed;   // Set by any thread, applied by Replay_Step
+    float speed;
+
+    // Playback (the replay thread's)
+    long next;               // Sample to deliver next
+    long long start_us;      // When play_us 0 is (was) due, at the current speed
+    long long window_us;     // Start of the rate window
+    float achieved_hz[OBD_SCHED_MAX_CHANNELS];
+    unsigned long delivered;
+    unsigned long loops;
+    long long max_late_us;   // Worst delivery after the due time
+} Replay;
+
+// Load a recording: a .tlog segment, a directory of segments (every .tlog in
+// it, in name order) or a .dar archive
+bool Replay_Load(Replay* replay, const char* path);
+
+void Replay_Free(Replay* replay);
+
+// Play from the start. speed: 1 = as recorded, N = N times faster, 0 = as
+// fast as possible.
+void Replay_Start(Replay* replay, float speed, bool loop, OBDSampleFn on_sample, void* user);
+
+// Change speed without jumping: the replay carries on from where it is
+void Replay_SetSpeed(Replay* replay, float speed);
+
+// Deliver every sample that is due, then wait up to max_wait_ms for the next.
+// Returns the number delivered, -1 once a replay that doesn't loop is over.
+int Replay_Step(Replay* replay, int max_wait_ms);
+
+// Fraction of the recording played, 0..1 (replay thread)
+float Replay_Position(const Replay* replay);
+
+// Per-PID rates: target_hz is the recorded rate at the current speed
+// (0 at speed 0), achieved_hz what was delivered over the last second
+int Replay_GetStats(const Replay* replay, OBDChannelStats* out, int max_channels);
+
+#endif // REPLAY_H
@@ -1,5 +1,7 @@
 #include "raylib/src/raylib.h"
 #include "raylib/src/raymath.h"
+#include "readout.h"
+#include "gauge_geometry.h"
 #include <stdio.h>
 #include <math.h>
 
@@ -12,95 +14,84 @@
 #define MIN_RPM 0
 #define REDLINE_RPM 7000
 
+#define START_ANGLE 135.0f     // Bottom left
+#define END_ANGLE 405.0f       // Bottom right (full sweep 270 degrees)
+#define NUM_STEPS 9            // Major ticks, labelled 0-8 (x1000 RPM)
+
 typedef struct {
     float currentRPM;
     float targetRPM;
 } Tachometer;
 
-void DrawTachometerGauge(Vector2 center, float radius) {
-    // Draw outer circle
-    DrawCircleV(center, radius + 10, BLACK);
-    DrawCircleV(center, radius + 5, DARKGRAY);
-    DrawCircleV(center, radius, (Color){20, 20, 30, 255});
-
-    // Draw RPM markings and labels
-    float startAngle = 135.0f;  // Bottom left
-    float endAngle = 405.0f;    // Bottom right (full sweep 270 degrees)
-    int rpmSteps[] = {0, 1, 2, 3, 4, 5, 6, 7, 8};
-    int numSteps = 9;
-
-    for (int i = 0; i < numSteps; i++) {
-        float angle = startAngle + (endAngle - startAngle) * i / (numSteps - 1);
-        float angleRad = angle * DEG2RAD;
-
-        // Major tick marks
-        Vector2 outerPoint = {
-            center.x + cosf(angleRad) * (radius - 10),
-            center.y + sinf(angleRad) * (radius - 10)
-        };
-        Vector2 innerPoint = {
-            center.x + cosf(angleRad) * (radius - 30),
-            center.y + sinf(angleRad) * (radius - 30)
-        };
+// Everything on the dial that doesn't move, worked out once at startup
+typedef struct {
+    GeoMesh mesh;                  // Bezel, ticks and colour zones around (0, 0)
+    Vector2 labelPos[NUM_STEPS];   // Top left of each label, from the centre
+    char labels[NUM_STEPS][4];
+    Color labelColors[NUM_STEPS];
+} TachometerFace;
+
+// Needs the window (MeasureText)
+void BuildTachometerFace(TachometerFace* face, float radius) {
+    Vector2 origin = {0, 0};
+    Geo_Init();
+
+    // Outer circles
+    Geo_AddCircle(&face->mesh, origin, radius + 10, BLACK);
+    Geo_AddCircle(&face->mesh, origin, radius + 5, DARKGRAY);
+    Geo_AddCircle(&face->mesh, origin, radius, (Color){20, 20, 30, 255});
+
+    // RPM markings and labels
+    for (int i = 0; i < NUM_STEPS; i++) {
+        float angle = START_ANGLE + (END_ANGLE - START_ANGLE) * i / (NUM_STEPS - 1);
 
         // Color code the tick marks
         Color tickColor = WHITE;
-        if (rpmSteps[i] >= 7) tickColor = RED;
-        else if (rpmSteps[i] >= 6) tickColor = YELLOW;
+        if (i >= 7) tickColor = RED;
+        else if (i >= 6) tickColor = YELLOW;
 
-        DrawLineEx(outerPoint, innerPoint, 3.0f, tickColor);
+        Geo_AddLine(&face->mesh, Geo_OnCircle(origin, angle, radius - 10), Geo_OnCircle(origin, angle, radius - 30),
+                    3.0f, tickColor);
 
-        // Draw RPM labels
-        Vector2 labelPos = {
-            center.x + cosf(angleRad) * (radius - 60),
-            center.y + sinf(angleRad) * (radius - 60)
-        };
-
-        char label[8];
-        sprintf(label, "%d", rpmSteps[i]);
-        int labelWidth = MeasureText(label, 20);
-        DrawText(label, labelPos.x - labelWidth / 2, labelPos.y - 10, 20, tickColor);
+        snprintf(face->labels[i], sizeof(face->labels[i]), "%d", i);
+        Vector2 labelPos = Geo_OnCircle(origin, angle, radius - 60);
+        face->labelPos[i] = (Vector2){ labelPos.x - MeasureText(face->labels[i], 20) / 2, labelPos.y - 10 };
+        face->labelColors[i] = tickColor;
     }
 
-    // Draw minor tick marks (between major marks)
-    for (int i = 0; i < (numSteps - 1) * 5; i++) {
+    // Minor tick marks (between major marks)
+    for (int i = 0; i < (NUM_STEPS - 1) * 5; i++) {
         if (i % 5 == 0) continue;  // Skip major marks
-
-        float angle = startAngle + (endAngle - startAngle) * i / ((numSteps - 1) * 5.0f);
-        float angleRad = angle * DEG2RAD;
-
-        Vector2 outerPoint = {
-            center.x + cosf(angleRad) * (radius - 10),
-            center.y + sinf(angleRad) * (radius - 10)
-        };
-        Vector2 innerPoint = {
-            center.x + cosf(angleRad) * (radius - 20),
-            center.y + sinf(angleRad) * (radius - 20)
-        };
-
-        DrawLineEx(outerPoint, innerPoint, 1.5f, GRAY);
+        float angle = START_ANGLE + (END_ANGLE - START_ANGLE) * i / ((NUM_STEPS - 1) * 5.0f);
+        Geo_AddLine(&face->mesh, Geo_OnCircle(origin, angle, radius - 10), Geo_OnCircle(origin, angle, radius - 20),
+                    1.5f, GRAY);
     }
 
-    // Draw color zones
-    for (int angle = startAngle; angle < endAngle; angle++) {
-        float angleRad = angle * DEG2RAD;
-        float rpm = (angle - startAngle) / (endAngle - startAngle) * MAX_RPM;
+    // Color zones, a line per degree
+    for (int angle = START_ANGLE; angle < END_ANGLE; angle++) {
+        float rpm = (angle - START_ANGLE) / (END_ANGLE - START_ANGLE) * MAX_RPM;
 
         Color zoneColor;
         if (rpm >= REDLINE_RPM) zoneColor = (Color){255, 0, 0, 40};
         else if (rpm >= 6000) zoneColor = (Color){255, 255, 0, 40};
         else zoneColor = (Color){0, 255, 0, 20};
 
-        Vector2 p1 = {
-            center.x + cosf(angleRad) * (radius - 35),
-            center.y + sinf(angleRad) * (radius - 35)
-        };
-        Vector2 p2 = {
-            center.x + cosf(angleRad) * (radius - 5),
-            center.y + sinf(angleRad) * (radius - 5)
-        };
+        Geo_AddLine(&face->mesh, Geo_OnCircle(origin, angle, radius - 35), Geo_OnCircle(origin, angle, radius - 5),
+                    2.0f, zoneColor);
+    }
+}
 
-        DrawLineEx(p1, p2, 2.0f, zoneColor);
+void DrawTachometerGauge(const TachometerFace* face, Vector2 center) {
+    const GeoMesh* mesh = &face->mesh;
+    for (int i = 0; i < mesh->count; i += 3) {
+        const Vector2* v = &mesh->vertices[i];
+        DrawTriangle((Vector2){center.x + v[0].x, center.y + v[0].y}, (Vector2){center.x + v[1].x, center.y + v[1].y},
+                     (Vector2){center.x + v[2].x, center.y + v[2].y}, mesh->colors[i / 3]);
+    }
+
+    for (int i = 0; i < NUM_STEPS; i++) {
+        DrawText(face->labels[i], center.x + face->labelPos[i].x, center.y + face->labelPos[i].y, 20,
+                 face->labelColors[i]);
     }
 
     // Draw center text
@@ -108,30 +99,20 @@ void DrawTachometerGauge(Vector2 center, float radius) {
 }
 
 void DrawNeedle(Vector2 center, float rpm, float maxRPM) {
-    float startAngle = 135.0f;
-    float endAngle = 405.0f;
-    float currentAngle = startAngle + (endAngle - startAngle) * (rpm / maxRPM);
-    float angleRad = currentAngle * DEG2RAD;
+    float currentAngle = START_ANGLE + (END_ANGLE - START_ANGLE) * (rpm / maxRPM);
+    float s, c;
+    Geo_SinCos(currentAngle, &s, &c);
 
     // Needle tip
     Vector2 needleTip = {
-        center.x + cosf(angleRad) * (GAUGE_RADIUS - 40),
-        center.y + sinf(angleRad) * (GAUGE_RADIUS - 40)
+        center.x + c * (GAUGE_RADIUS - 40),
+        center.y + s * (GAUGE_RADIUS - 40)
     };
 
-    // Needle base points (triangular)
-    float baseAngle1 = (currentAngle - 90) * DEG2RAD;
-    float baseAngle2 = (currentAngle + 90) * DEG2RAD;
-
-    Vector2 basePoint1 = {
-        center.x + cosf(baseAngle1) * 8,
-        center.y + sinf(baseAngle1) * 8
-    };
-
-    Vector2 basePoint2 = {
-        center.x + cosf(baseAngle2) * 8,
-        center.y + sinf(baseAngle2) * 8
-    };
+    // Needle base points (triangular), a quarter turn either side:
+    // (cos, sin) of angle -/+ 90 is (s, -c) / (-s, c)
+    Vector2 basePoint1 = { center.x + s * 8, center.y - c * 8 };
+    Vector2 basePoint2 = { center.x - s * 8, center.y + c * 8 };
 
     // Draw needle shadow
     DrawTriangle(
@@ -141,12 +122,12 @@ void DrawNeedle(Vector2 center, float rpm, float maxRPM) {
         (Color){0, 0, 0, 100}
     );
 
-    // Draw needle
+    // Draw needle; tip, base 1, base 2 is counter-clockwise on screen at
+    // every angle, so one triangle shows
     Color needleColor = RED;
     if (rpm < REDLINE_RPM) needleColor = ORANGE;
 
     DrawTriangle(needleTip, basePoint1, basePoint2, needleColor);
-    DrawTriangle(needleTip, basePoint2, basePoint1, needleColor);
 
     // Center cap
     DrawCircleV(center, 12, BLACK);
@@ -154,18 +135,15 @@ void DrawNeedle(Vector2 center, float rpm, float maxRPM) {
     DrawCircleV(center, 6, needleColor);
 }
 
-void DrawDigitalReadout(Vector2 center, float rpm) {
-    char rpmText[16];
-    sprintf(rpmText, "%04d", (int)rpm);
-
+void DrawDigitalReadout(Vector2 center, Readout* readout, float rpm) {
     // Background
     Rectangle box = {center.x - 60, center.y + 20, 120, 50};
     DrawRectangleRounded(box, 0.2f, 8, BLACK);
     DrawRectangleRoundedLines(box, 0.2f, 8, DARKGRAY);
 
     // RPM value
-    int textWidth = MeasureText(rpmText, 35);
-    DrawText(rpmText, center.x - textWidth / 2, center.y + 30, 35, LIME);
+    Readout_Set(readout, (int)rpm);
+    Readout_Draw(readout, (Vector2){center.x, center.y + 30}, LIME);
 }
 
 int main(void) {
@@ -177,6 +155,10 @@ int main(void) {
     tach.targetRPM = 1000.0f;
 
     Vector2 gaugeCenter = {CENTER_X, CENTER_Y};
+    TachometerFace face = {0};
+    BuildTachometerFace(&face, GAUGE_RADIUS);
+    Readout rpmReadout = Readout_Make(35, 4, "");
+    Readout_Prepare(&rpmReadout);
 
     while (!WindowShouldClose()) {
         // Update
@@ -198,9 +180,9 @@ int main(void) {
         ClearBackground((Color){15, 15, 25, 255});
 
         // Draw tachometer
-        DrawTachometerGauge(gaugeCenter, GAUGE_RADIUS);
+        DrawTachometerGauge(&face, gaugeCenter);
         DrawNeedle(gaugeCenter, tach.currentRPM, MAX_RPM);
-        DrawDigitalReadout(gaugeCenter, tach.currentRPM);
+        DrawDigitalReadout(gaugeCenter, &rpmReadout, tach.currentRPM);
 
         // Draw instructions
         DrawText("UP/DOWN ARROWS: Control RPM", 20, 20, 20, WHITE);
@@ -213,6 +195,8 @@ int main(void) {
         EndDrawing();
     }
 
+    Readout_Unload(&rpmReadout);
+    Geo_FreeMesh(&face.mesh);
     CloseWindow();
     return 0;
 }
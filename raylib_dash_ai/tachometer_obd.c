@@ -1,514 +1,651 @@
 #include "raylib/src/raylib.h"
 #include "raylib/src/raymath.h"
 #include "obd_reader.h"
+#include "obd_scheduler.h"
+#include "obd_can.h"
+#include "can_signals.h"
+#include "obd_monitor.h"
+#include "telemetry.h"
+#include "timeseries.h"
+#include "needle_motion.h"
+#include "telemetry_log.h"
+#include "replay.h"
+#include "gauges.h"
+#include "dash_layout.h"
+#include "frame_pacer.h"
+#include "raylib/src/rlgl.h"
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <math.h>
 #include <pthread.h>
 #include <unistd.h>
 
-#define SCREEN_WIDTH 1200
-#define SCREEN_HEIGHT 700
-#define CENTER_X (SCREEN_WIDTH / 2)
-#define CENTER_Y (SCREEN_HEIGHT / 2)
-#define GAUGE_RADIUS 150
-#define MAX_RPM 8000
-#define MIN_RPM 0
-#define REDLINE_RPM 7000
-#define MAX_SPEED 200
-#define MAX_TEMP 120
+// Simulated vehicle; the gauges and their scales come from the layout
+#define SIM_MAX_RPM 8000
+#define SIM_MIN_RPM 0
+#define SIM_MAX_SPEED 200
+#define SIM_IDLE_TEMP 20
+
+// Serial ELM327 adapter, or a SocketCAN interface such as "can0"
+#define OBD_DEVICE "/dev/tty.OBD-II-Port"
+
+// Passive mode: decode the broadcast signals in this file instead of polling,
+// straight from a CAN interface or through the adapter's monitor-all mode
+// (NULL = always poll Mode 01)
+#define CAN_SIGNAL_FILE NULL
+
+// Record every sample to binary log segments in this directory (NULL = don't)
+#define LOG_DIRECTORY NULL
+
+// Replays loop by default; speed comes from the command line and the keys
+#define REPLAY_LOOP true
+#define REPLAY_MAX_SPEED 64.0f
+
+// Draw the gauges with the distance field shader where the GL supports it
+// (G switches at runtime)
+#define GAUGE_SHADER false
+
+#define BACKGROUND_COLOR ((Color){15, 15, 25, 255})
 
 // OBD mode toggle
 typedef enum {
     MODE_SIMULATION,
-    MODE_OBD
+    MODE_OBD,
+    MODE_REPLAY                   // A recording played through the OBD path
 } TachMode;
 
 typedef struct {
-    float currentRPM;
-    float targetRPM;
-    float currentSpeed;
+    float targetRPM;              // Simulated vehicle
     float targetSpeed;
-    float currentTemp;
     float targetTemp;
+    float noTarget;               // Channels the simulation doesn't have
     TachMode mode;
     OBDConnection obd;
     bool obdThreadRunning;
     pthread_t obdThread;
-    pthread_mutex_t dataMutex;
+    Telemetry telemetry;          // Written by the OBD thread, read by the render loop
+    TelemetrySnapshot snapshot;   // Render loop's latest copies
+    TelemetryLink link;
+    TimeSeriesSet history;        // Every sample, appended by the OBD thread
+    TelemetryLog log;             // Drive recording, written by the OBD thread
+    bool logging;
+    bool passive;                 // Listening to broadcasts, not polling
+    CANSignalSet canSignals;
+    CANListener canListener;
+    bool monitoring;              // Passive through an ELM327 (ATMA)
+    OBDMonitor obdMonitor;
+    Replay replay;                // Loaded recording, played by the replay thread
+    bool replayLoaded;
+    bool replaying;               // Samples are replayed: don't record them again
+    float replaySpeed;            // Requested: 1 = as recorded, 0 = as fast as possible
+    Dashboard dash;               // Gauges from the layout, compiled at startup
+    NeedleMotion needles[LAYOUT_MAX_GAUGES];    // By widget, advanced by real frame time
+    const float* simTargets[LAYOUT_MAX_GAUGES]; // Each widget's simulated channel
 } Tachometer;
 
+// Text over the dashboard, rebuilt every tick and compared with what is on
+// screen to find what changed
+#define HUD_MAX_LINES 16
+
+typedef struct {
+    char text[96];
+    int x;
+    int y;
+    int size;
+    Color color;
+} HudLine;
+
+typedef struct {
+    HudLine lines[HUD_MAX_LINES];
+    int count;
+    float scale;                  // The layout's text scale
+} Hud;
+
+// Smallest text size: the default font's own
+#define HUD_MIN_FONT 10
+
+// Margins and offsets, given as at scale 1
+static int HudPx(const Hud* hud, float px) {
+    return (int)roundf(px * hud->scale);
+}
+
+// Text in pixels, as it is
+static void HudPut(Hud* hud, const char* text, int x, int y, int size, Color color) {
+    if (hud->count == HUD_MAX_LINES) return;
+    HudLine* line = &hud->lines[hud->count++];
+    memset(line, 0, sizeof(*line));
+    strncpy(line->text, text, sizeof(line->text) - 1);
+    line->x = x;
+    line->y = y;
+    line->size = size;
+    line->color = color;
+}
+
+// Text of a size given as at scale 1
+static void HudAdd(Hud* hud, const char* text, int x, int y, int size, Color color) {
+    HudPut(hud, text, x, y, (int)fmaxf(HUD_MIN_FONT, roundf(size * hud->scale)), color);
+}
+
+static Rectangle HudBounds(const HudLine* line) {
+    return (Rectangle){ line->x, line->y, MeasureText(line->text, line->size), line->size };
+}
+
+// Damage where a line differs from the one shown: where it was and where it goes
+static void HudDamage(FramePacer* pacer, const Hud* hud, const Hud* shown) {
+    int count = hud->count > shown->count ? hud->count : shown->count;
+    for (int i = 0; i < count; i++) {
+        bool old = i < shown->count, now = i < hud->count;
+        if (old && now && memcmp(&hud->lines[i], &shown->lines[i], sizeof(HudLine)) == 0) continue;
+        if (old) Pacer_Damage(pacer, HudBounds(&shown->lines[i]));
+        if (now) Pacer_Damage(pacer, HudBounds(&hud->lines[i]));
+    }
+}
+
+// Scheduler callback: publish each sample as it arrives
+static void OnOBDSample(void* user, const OBDValue* value, long long timestamp_us) {
+    Tachometer* tach = (Tachometer*)user;
+    Telemetry_Publish(&tach->telemetry, value->pid, value->value, timestamp_us);
+
+    TimeSeries* series = TS_Channel(&tach->history, value->pid);
+    if (series) TS_Append(series, timestamp_us, value->value);
+
+    if (tach->logging && !tach->replaying) {
+        TLog_Write(&tach->log, timestamp_us, value->pid, value->value,
+                   tach->passive ? TLOG_FLAG_BROADCAST : TLOG_FLAG_POLLED);
+    }
+}
+
 // Thread function to read OBD data
 void* OBDReadThread(void* arg) {
     Tachometer* tach = (Tachometer*)arg;
 
-    while (tach->obdThreadRunning) {
-        int rpm = OBD_ReadRPM(&tach->obd);
-        int speed = OBD_ReadSpeed(&tach->obd);
-        int temp = OBD_ReadCoolantTemp(&tach->obd);
+    OBDScheduler sched;
+    OBD_SchedulerInit(&sched, &tach->obd, OnOBDSample, tach);
+    for (int i = 0; i < tach->dash.count; i++) {
+        OBD_SchedulerAddChannel(&sched, tach->dash.pids[i], tach->dash.poll_hz[i]);
+    }
 
-        pthread_mutex_lock(&tach->dataMutex);
-        if (rpm >= 0) tach->targetRPM = (float)rpm;
-        if (speed >= 0) tach->targetSpeed = (float)speed;
-        if (temp >= -40) tach->targetTemp = (float)temp;
-        pthread_mutex_unlock(&tach->dataMutex);
+    TelemetryLink link = {0};
+    while (tach->obdThreadRunning) {
+        // Short max wait so a disconnect request is noticed quickly
+        OBD_SchedulerStep(&sched, 50);
 
-        usleep(100000);  // Read every 100ms
+        link.num_stats = OBD_SchedulerGetStats(&sched, link.stats, OBD_SCHED_MAX_CHANNELS);
+        link.saturated = sched.saturated;
+        Telemetry_PublishLink(&tach->telemetry, &link);
     }
 
     return NULL;
 }
 
-void DrawTachometerGauge(Vector2 center, float radius) {
-    // Draw outer circle
-    DrawCircleV(center, radius + 10, BLACK);
-    DrawCircleV(center, radius + 5, DARKGRAY);
-    DrawCircleV(center, radius, (Color){20, 20, 30, 255});
-
-    // Draw RPM markings and labels
-    float startAngle = 135.0f;
-    float endAngle = 405.0f;
-    int rpmSteps[] = {0, 1, 2, 3, 4, 5, 6, 7, 8};
-    int numSteps = 9;
-
-    for (int i = 0; i < numSteps; i++) {
-        float angle = startAngle + (endAngle - startAngle) * i / (numSteps - 1);
-        float angleRad = angle * DEG2RAD;
-
-        Vector2 outerPoint = {
-            center.x + cosf(angleRad) * (radius - 10),
-            center.y + sinf(angleRad) * (radius - 10)
-        };
-        Vector2 innerPoint = {
-            center.x + cosf(angleRad) * (radius - 30),
-            center.y + sinf(angleRad) * (radius - 30)
-        };
-
-        Color tickColor = WHITE;
-        if (rpmSteps[i] >= 7) tickColor = RED;
-        else if (rpmSteps[i] >= 6) tickColor = YELLOW;
-
-        DrawLineEx(outerPoint, innerPoint, 3.0f, tickColor);
-
-        Vector2 labelPos = {
-            center.x + cosf(angleRad) * (radius - 60),
-            center.y + sinf(angleRad) * (radius - 60)
-        };
-
-        char label[8];
-        sprintf(label, "%d", rpmSteps[i]);
-        int labelWidth = MeasureText(label, 20);
-        DrawText(label, labelPos.x - labelWidth / 2, labelPos.y - 10, 20, tickColor);
-    }
+// Thread function for passive mode: decode broadcast frames as they arrive
+void* CANListenThread(void* arg) {
+    Tachometer* tach = (Tachometer*)arg;
 
-    // Draw minor tick marks
-    for (int i = 0; i < (numSteps - 1) * 5; i++) {
-        if (i % 5 == 0) continue;
+    TelemetryLink link = {0};
+    while (tach->obdThreadRunning) {
+        if (CAN_ListenStep(&tach->canListener, 50) < 0) break;
 
-        float angle = startAngle + (endAngle - startAngle) * i / ((numSteps - 1) * 5.0f);
-        float angleRad = angle * DEG2RAD;
+        link.num_stats = CAN_ListenGetStats(&tach->canListener, link.stats, OBD_SCHED_MAX_CHANNELS);
+        Telemetry_PublishLink(&tach->telemetry, &link);
+    }
 
-        Vector2 outerPoint = {
-            center.x + cosf(angleRad) * (radius - 10),
-            center.y + sinf(angleRad) * (radius - 10)
-        };
-        Vector2 innerPoint = {
-            center.x + cosf(angleRad) * (radius - 20),
-            center.y + sinf(angleRad) * (radius - 20)
-        };
+    return NULL;
+}
 
-        DrawLineEx(outerPoint, innerPoint, 1.5f, GRAY);
-    }
+// Thread function for passive mode on an adapter: decode the monitor stream
+void* OBDMonitorThread(void* arg) {
+    Tachometer* tach = (Tachometer*)arg;
 
-    // Draw color zones
-    for (int angle = startAngle; angle < endAngle; angle++) {
-        float angleRad = angle * DEG2RAD;
-        float rpm = (angle - startAngle) / (endAngle - startAngle) * MAX_RPM;
-
-        Color zoneColor;
-        if (rpm >= REDLINE_RPM) zoneColor = (Color){255, 0, 0, 40};
-        else if (rpm >= 6000) zoneColor = (Color){255, 255, 0, 40};
-        else zoneColor = (Color){0, 255, 0, 20};
-
-        Vector2 p1 = {
-            center.x + cosf(angleRad) * (radius - 35),
-            center.y + sinf(angleRad) * (radius - 35)
-        };
-        Vector2 p2 = {
-            center.x + cosf(angleRad) * (radius - 5),
-            center.y + sinf(angleRad) * (radius - 5)
-        };
-
-        DrawLineEx(p1, p2, 2.0f, zoneColor);
+    TelemetryLink link = {0};
+    while (tach->obdThreadRunning) {
+        if (OBD_MonitorStep(&tach->obdMonitor, 50) < 0) break;
+
+        link.monitor_frames = tach->obdMonitor.frames;
+        link.monitor_overruns = tach->obdMonitor.overruns;
+        Telemetry_PublishLink(&tach->telemetry, &link);
     }
 
-    DrawText("RPM x1000", center.x - 50, center.y - 90, 15, LIGHTGRAY);
+    return NULL;
 }
 
-void DrawNeedle(Vector2 center, float rpm, float maxRPM) {
-    float startAngle = 135.0f;
-    float endAngle = 405.0f;
-    float currentAngle = startAngle + (endAngle - startAngle) * (rpm / maxRPM);
-    float angleRad = currentAngle * DEG2RAD;
-
-    Vector2 needleTip = {
-        center.x + cosf(angleRad) * (GAUGE_RADIUS - 40),
-        center.y + sinf(angleRad) * (GAUGE_RADIUS - 40)
-    };
-
-    float baseAngle1 = (currentAngle - 90) * DEG2RAD;
-    float baseAngle2 = (currentAngle + 90) * DEG2RAD;
-
-    Vector2 basePoint1 = {
-        center.x + cosf(baseAngle1) * 8,
-        center.y + sinf(baseAngle1) * 8
-    };
-
-    Vector2 basePoint2 = {
-        center.x + cosf(baseAngle2) * 8,
-        center.y + sinf(baseAngle2) * 8
-    };
-
-    DrawTriangle(
-        (Vector2){needleTip.x + 2, needleTip.y + 2},
-        (Vector2){basePoint1.x + 2, basePoint1.y + 2},
-        (Vector2){basePoint2.x + 2, basePoint2.y + 2},
-        (Color){0, 0, 0, 100}
-    );
-
-    Color needleColor = RED;
-    if (rpm < REDLINE_RPM) needleColor = ORANGE;
-
-    DrawTriangle(needleTip, basePoint1, basePoint2, needleColor);
-    DrawTriangle(needleTip, basePoint2, basePoint1, needleColor);
-
-    DrawCircleV(center, 12, BLACK);
-    DrawCircleV(center, 10, DARKGRAY);
-    DrawCircleV(center, 6, needleColor);
-}
+// Thread function for replay mode: deliver the recording's samples on time
+void* ReplayThread(void* arg) {
+    Tachometer* tach = (Tachometer*)arg;
 
-void DrawDigitalReadout(Vector2 center, float rpm) {
-    char rpmText[16];
-    sprintf(rpmText, "%04d", (int)rpm);
+    TelemetryLink link = {0};
+    while (tach->obdThreadRunning) {
+        int delivered = Replay_Step(&tach->replay, 50);
+
+        link.num_stats = Replay_GetStats(&tach->replay, link.stats, OBD_SCHED_MAX_CHANNELS);
+        link.replay_position = Replay_Position(&tach->replay);
+        link.replay_speed = tach->replay.speed;
+        link.replay_loops = tach->replay.loops;
+        link.replay_late_us = tach->replay.max_late_us;
+        Telemetry_PublishLink(&tach->telemetry, &link);
+        if (delivered < 0) break;   // Played to the end
+    }
 
-    Rectangle box = {center.x - 60, center.y + 20, 120, 50};
-    DrawRectangleRounded(box, 0.2f, 8, BLACK);
-    DrawRectangleRoundedLines(box, 0.2f, 8, DARKGRAY);
+    return NULL;
+}
 
-    int textWidth = MeasureText(rpmText, 35);
-    DrawText(rpmText, center.x - textWidth / 2, center.y + 30, 35, LIME);
+// Start the needles over from where they are drawn, without samples from a
+// previous source
+static void ResetNeedles(Tachometer* tach) {
+    for (int i = 0; i < tach->dash.count; i++) {
+        NeedleTuning tuning = Needle_DefaultTuning(tach->dash.pids[i]);
+        Needle_Init(&tach->needles[i], &tuning, tach->dash.values[i]);
+    }
 }
 
-void DrawSpeedometer(Vector2 center, float radius, float speed) {
-    // Draw outer circle
-    DrawCircleV(center, radius + 10, BLACK);
-    DrawCircleV(center, radius + 5, DARKGRAY);
-    DrawCircleV(center, radius, (Color){20, 20, 30, 255});
-
-    // Draw speed markings
-    float startAngle = 135.0f;
-    float endAngle = 405.0f;
-    int speedSteps[] = {0, 20, 40, 60, 80, 100, 120, 140, 160, 180, 200};
-    int numSteps = 11;
-
-    for (int i = 0; i < numSteps; i++) {
-        float angle = startAngle + (endAngle - startAngle) * i / (numSteps - 1);
-        float angleRad = angle * DEG2RAD;
-
-        Vector2 outerPoint = {
-            center.x + cosf(angleRad) * (radius - 10),
-            center.y + sinf(angleRad) * (radius - 10)
-        };
-        Vector2 innerPoint = {
-            center.x + cosf(angleRad) * (radius - 25),
-            center.y + sinf(angleRad) * (radius - 25)
-        };
-
-        DrawLineEx(outerPoint, innerPoint, 2.5f, WHITE);
-
-        if (i % 2 == 0) {  // Label every other mark
-            Vector2 labelPos = {
-                center.x + cosf(angleRad) * (radius - 50),
-                center.y + sinf(angleRad) * (radius - 50)
-            };
-
-            char label[8];
-            sprintf(label, "%d", speedSteps[i]);
-            int labelWidth = MeasureText(label, 16);
-            DrawText(label, labelPos.x - labelWidth / 2, labelPos.y - 8, 16, WHITE);
+// Point each widget at the simulated value of its channel
+static void BindSimulation(Tachometer* tach) {
+    for (int i = 0; i < tach->dash.count; i++) {
+        switch (tach->dash.pids[i]) {
+            case 0x0C: tach->simTargets[i] = &tach->targetRPM; break;
+            case 0x0D: tach->simTargets[i] = &tach->targetSpeed; break;
+            case 0x05: tach->simTargets[i] = &tach->targetTemp; break;
+            default: tach->simTargets[i] = &tach->noTarget; break;
         }
+        tach->dash.values[i] = *tach->simTargets[i];
     }
+}
 
-    // Draw minor tick marks
-    for (int i = 0; i < (numSteps - 1) * 2; i++) {
-        if (i % 2 == 0) continue;
-
-        float angle = startAngle + (endAngle - startAngle) * i / ((numSteps - 1) * 2.0f);
-        float angleRad = angle * DEG2RAD;
+// Listen to broadcasts if a signal file is configured: on the CAN interface
+// itself, or through the adapter's monitor mode. Otherwise poll.
+static bool ConnectVehicle(Tachometer* tach) {
+    const char* signalFile = CAN_SIGNAL_FILE;
+    tach->passive = false;
+    tach->monitoring = false;
+    Telemetry_Clear(&tach->telemetry);
+    memset(&tach->snapshot, 0, sizeof(tach->snapshot));
+    memset(&tach->link, 0, sizeof(tach->link));
+
+    if (signalFile && OBD_CANIsInterface(OBD_DEVICE) && CAN_LoadSignals(&tach->canSignals, signalFile) &&
+        CAN_ListenOpen(&tach->canListener, OBD_DEVICE, &tach->canSignals, OnOBDSample, tach)) {
+        tach->passive = true;
+        tach->obdThreadRunning = true;
+        pthread_create(&tach->obdThread, NULL, CANListenThread, tach);
+        return true;
+    }
 
-        Vector2 outerPoint = {
-            center.x + cosf(angleRad) * (radius - 10),
-            center.y + sinf(angleRad) * (radius - 10)
-        };
-        Vector2 innerPoint = {
-            center.x + cosf(angleRad) * (radius - 18),
-            center.y + sinf(angleRad) * (radius - 18)
-        };
+    if (!OBD_Init(&tach->obd, OBD_DEVICE)) return false;
+    tach->obdThreadRunning = true;
 
-        DrawLineEx(outerPoint, innerPoint, 1.2f, GRAY);
+    if (signalFile && tach->obd.transport == OBD_TRANSPORT_ELM327 &&
+        CAN_LoadSignals(&tach->canSignals, signalFile) &&
+        OBD_MonitorStart(&tach->obdMonitor, &tach->obd, &tach->canSignals, true, OnOBDSample, tach)) {
+        tach->passive = true;
+        tach->monitoring = true;
+        pthread_create(&tach->obdThread, NULL, OBDMonitorThread, tach);
+        return true;
     }
 
-    DrawText("km/h", center.x - 22, center.y - 70, 14, LIGHTGRAY);
-
-    // Draw needle for speed
-    float currentAngle = startAngle + (endAngle - startAngle) * (speed / MAX_SPEED);
-    if (speed > MAX_SPEED) currentAngle = startAngle + (endAngle - startAngle);
-    float angleRad = currentAngle * DEG2RAD;
-
-    Vector2 needleTip = {
-        center.x + cosf(angleRad) * (radius - 35),
-        center.y + sinf(angleRad) * (radius - 35)
-    };
-
-    float baseAngle1 = (currentAngle - 90) * DEG2RAD;
-    float baseAngle2 = (currentAngle + 90) * DEG2RAD;
-
-    Vector2 basePoint1 = {
-        center.x + cosf(baseAngle1) * 6,
-        center.y + sinf(baseAngle1) * 6
-    };
-
-    Vector2 basePoint2 = {
-        center.x + cosf(baseAngle2) * 6,
-        center.y + sinf(baseAngle2) * 6
-    };
-
-    DrawTriangle(needleTip, basePoint1, basePoint2, SKYBLUE);
-    DrawTriangle(needleTip, basePoint2, basePoint1, SKYBLUE);
-
-    DrawCircleV(center, 10, BLACK);
-    DrawCircleV(center, 8, DARKGRAY);
-    DrawCircleV(center, 5, SKYBLUE);
-
-    // Digital speed readout
-    char speedText[16];
-    sprintf(speedText, "%03d", (int)speed);
-    Rectangle box = {center.x - 40, center.y + 15, 80, 35};
-    DrawRectangleRounded(box, 0.2f, 8, BLACK);
-    DrawRectangleRoundedLines(box, 0.2f, 8, DARKGRAY);
-    int textWidth = MeasureText(speedText, 25);
-    DrawText(speedText, center.x - textWidth / 2, center.y + 20, 25, SKYBLUE);
+    pthread_create(&tach->obdThread, NULL, OBDReadThread, tach);
+    return true;
 }
 
-void DrawTemperatureGauge(Vector2 center, float radius, float temp) {
-    // Draw outer circle
-    DrawCircleV(center, radius + 10, BLACK);
-    DrawCircleV(center, radius + 5, DARKGRAY);
-    DrawCircleV(center, radius, (Color){20, 20, 30, 255});
-
-    // Draw temperature arc (bottom half + some sides)
-    float startAngle = 135.0f;
-    float endAngle = 405.0f;
-    int tempSteps[] = {0, 20, 40, 60, 80, 100, 120};
-    int numSteps = 7;
-
-    for (int i = 0; i < numSteps; i++) {
-        float angle = startAngle + (endAngle - startAngle) * i / (numSteps - 1);
-        float angleRad = angle * DEG2RAD;
-
-        Vector2 outerPoint = {
-            center.x + cosf(angleRad) * (radius - 10),
-            center.y + sinf(angleRad) * (radius - 10)
-        };
-        Vector2 innerPoint = {
-            center.x + cosf(angleRad) * (radius - 25),
-            center.y + sinf(angleRad) * (radius - 25)
-        };
-
-        Color tickColor = WHITE;
-        if (tempSteps[i] >= 100) tickColor = RED;
-        else if (tempSteps[i] >= 90) tickColor = YELLOW;
-
-        DrawLineEx(outerPoint, innerPoint, 2.5f, tickColor);
-
-        Vector2 labelPos = {
-            center.x + cosf(angleRad) * (radius - 45),
-            center.y + sinf(angleRad) * (radius - 45)
-        };
-
-        char label[8];
-        sprintf(label, "%d", tempSteps[i]);
-        int labelWidth = MeasureText(label, 14);
-        DrawText(label, labelPos.x - labelWidth / 2, labelPos.y - 7, 14, tickColor);
-    }
+static void StartReplay(Tachometer* tach) {
+    Telemetry_Clear(&tach->telemetry);
+    memset(&tach->snapshot, 0, sizeof(tach->snapshot));
+    memset(&tach->link, 0, sizeof(tach->link));
+    tach->passive = false;
+    tach->replaying = true;
+    Replay_Start(&tach->replay, tach->replaySpeed, REPLAY_LOOP, OnOBDSample, tach);
+    tach->obdThreadRunning = true;
+    pthread_create(&tach->obdThread, NULL, ReplayThread, tach);
+}
 
-    DrawText("COOLANT °C", center.x - 45, center.y - 60, 13, LIGHTGRAY);
-
-    // Draw needle for temperature
-    float clampedTemp = temp;
-    if (clampedTemp < 0) clampedTemp = 0;
-    if (clampedTemp > MAX_TEMP) clampedTemp = MAX_TEMP;
-
-    float currentAngle = startAngle + (endAngle - startAngle) * (clampedTemp / MAX_TEMP);
-    float angleRad = currentAngle * DEG2RAD;
-
-    Vector2 needleTip = {
-        center.x + cosf(angleRad) * (radius - 30),
-        center.y + sinf(angleRad) * (radius - 30)
-    };
-
-    float baseAngle1 = (currentAngle - 90) * DEG2RAD;
-    float baseAngle2 = (currentAngle + 90) * DEG2RAD;
-
-    Vector2 basePoint1 = {
-        center.x + cosf(baseAngle1) * 6,
-        center.y + sinf(baseAngle1) * 6
-    };
-
-    Vector2 basePoint2 = {
-        center.x + cosf(baseAngle2) * 6,
-        center.y + sinf(baseAngle2) * 6
-    };
-
-    Color tempNeedleColor = LIME;
-    if (temp >= 100) tempNeedleColor = RED;
-    else if (temp >= 90) tempNeedleColor = YELLOW;
-
-    DrawTriangle(needleTip, basePoint1, basePoint2, tempNeedleColor);
-    DrawTriangle(needleTip, basePoint2, basePoint1, tempNeedleColor);
-
-    DrawCircleV(center, 10, BLACK);
-    DrawCircleV(center, 8, DARKGRAY);
-    DrawCircleV(center, 5, tempNeedleColor);
-
-    // Digital temperature readout
-    char tempText[16];
-    sprintf(tempText, "%d°C", (int)temp);
-    Rectangle box = {center.x - 35, center.y + 15, 70, 35};
-    DrawRectangleRounded(box, 0.2f, 8, BLACK);
-    DrawRectangleRoundedLines(box, 0.2f, 8, DARKGRAY);
-    int textWidth = MeasureText(tempText, 22);
-    DrawText(tempText, center.x - textWidth / 2, center.y + 22, 22, tempNeedleColor);
+static void StopReplay(Tachometer* tach) {
+    tach->obdThreadRunning = false;
+    pthread_join(tach->obdThread, NULL);
+    tach->replaying = false;
 }
 
-int main(void) {
-    InitWindow(SCREEN_WIDTH, SCREEN_HEIGHT, "Car Tachometer - OBD Mode");
-    SetTargetFPS(60);
+static void DisconnectVehicle(Tachometer* tach) {
+    tach->obdThreadRunning = false;
+    pthread_join(tach->obdThread, NULL);
+    if (tach->monitoring) OBD_MonitorStop(&tach->obdMonitor);
+    if (tach->passive && !tach->monitoring) CAN_ListenClose(&tach->canListener);
+    else OBD_Close(&tach->obd);
+}
+
+// Usage: ./tachometer_obd [-l layout] [recording [speed]]
+// layout: a screen profile such as layouts/800x480.layout (default: the
+// built-in desktop layout)
+// recording: a .tlog segment, a directory of them or a .dar archive, played
+// in replay mode from the start; speed 1 = as recorded, 0 = as fast as possible,
+// at most REPLAY_MAX_SPEED
+int main(int argc, char** argv) {
+    DashLayout layout;
+    Layout_Default(&layout);
+    int opt;
+    while ((opt = getopt(argc, argv, "l:")) != -1) {
+        switch (opt) {
+            case 'l':
+                if (!Layout_Load(&layout, optarg)) return 1;
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-l layout] [recording [speed]]\n", argv[0]);
+                return 1;
+        }
+    }
+    const char* recording = optind < argc ? argv[optind] : NULL;
+    float replaySpeed = 1.0f;
+    if (optind + 1 < argc) {
+        // A typo must not turn into 0 (as fast as possible)
+        char* end;
+        replaySpeed = strtof(argv[optind + 1], &end);
+        if (end == argv[optind + 1] || *end != '\0' || !(replaySpeed >= 0.0f)) {
+            fprintf(stderr, "usage: %s [-l layout] [recording [speed]]\n", argv[0]);
+            return 1;
+        }
+        // The range the UP/DOWN keys allow
+        if (replaySpeed > 0.0f) replaySpeed = fminf(fmaxf(replaySpeed, 1.0f / REPLAY_MAX_SPEED), REPLAY_MAX_SPEED);
+    }
+
+    InitWindow(layout.width, layout.height, "Car Tachometer - OBD Mode");
 
     Tachometer tach = {0};
-    tach.currentRPM = 0.0f;
     tach.targetRPM = 0.0f;
-    tach.currentSpeed = 0.0f;
     tach.targetSpeed = 0.0f;
-    tach.currentTemp = 20.0f;
-    tach.targetTemp = 20.0f;
+    tach.targetTemp = SIM_IDLE_TEMP;
     tach.mode = MODE_SIMULATION;
     tach.obdThreadRunning = false;
-    pthread_mutex_init(&tach.dataMutex, NULL);
+    tach.replaySpeed = replaySpeed;
+
+    // The layout's gauges, made once; their faces are rendered before the
+    // first frame. From here on every gauge is handled alike, by index.
+    Layout_Compile(&layout, &tach.dash);
+    Dashboard* dash = &tach.dash;
+    BindSimulation(&tach);
+    if (GAUGE_SHADER) Gauge_UseShader(true);
+
+    Telemetry_Init(&tach.telemetry);
+    TimeSeriesConfig historyChannels[LAYOUT_MAX_GAUGES];
+    for (int i = 0; i < dash->count; i++) {
+        historyChannels[i] = (TimeSeriesConfig){ dash->pids[i], dash->poll_hz[i] };
+    }
+    TS_Init(&tach.history, historyChannels, dash->count, TIMESERIES_DEFAULT_BUDGET);
+    ResetNeedles(&tach);
+    if (LOG_DIRECTORY) {
+        TLogConfig logConfig = TLog_DefaultConfig(LOG_DIRECTORY);
+        tach.logging = TLog_Open(&tach.log, &logConfig);
+    }
+    if (recording && Replay_Load(&tach.replay, recording)) {
+        tach.replayLoaded = true;
+        StartReplay(&tach);
+        tach.mode = MODE_REPLAY;
+    }
 
-    // Gauge positions
-    Vector2 tachCenter = {280, 280};
-    Vector2 speedCenter = {680, 280};
-    Vector2 tempCenter = {1000, 500};
+    // The frame rate follows the needles: the display's refresh while one
+    // moves, idle otherwise. Changed regions are redrawn into the composed
+    // dashboard, and a drawn frame shows it whole, so nothing depends on
+    // what the swap left in the back buffer.
+    FramePacerConfig pacing = Pacer_DefaultConfig();
+    FramePacer pacer;
+    Pacer_Init(&pacer, &pacing);
+    RenderTexture2D dashboard = LoadRenderTexture(layout.width, layout.height);
+    Hud hud = { .scale = layout.text_scale };
+    Hud shownHud = {0};
+    bool showStats = false;
+    long long lastTick = OBD_NowMicros();
 
     while (!WindowShouldClose()) {
         // Handle mode switching
-        if (IsKeyPressed(KEY_O)) {
+        if (IsKeyPressed(KEY_O) && tach.mode != MODE_REPLAY) {
             if (tach.mode == MODE_SIMULATION) {
                 // Try to connect to OBD
-                // Change this path to your actual device
-                if (OBD_Init(&tach.obd, "/dev/tty.OBD-II-Port")) {
+                // Change OBD_DEVICE to your actual device
+                if (ConnectVehicle(&tach)) {
                     tach.mode = MODE_OBD;
-                    tach.obdThreadRunning = true;
-                    pthread_create(&tach.obdThread, NULL, OBDReadThread, &tach);
+                    ResetNeedles(&tach);
                 }
             } else {
                 // Switch back to simulation
-                tach.obdThreadRunning = false;
-                pthread_join(tach.obdThread, NULL);
-                OBD_Close(&tach.obd);
+                DisconnectVehicle(&tach);
                 tach.mode = MODE_SIMULATION;
+                ResetNeedles(&tach);
+            }
+        }
+
+        if (IsKeyPressed(KEY_R) && tach.replayLoaded && tach.mode != MODE_OBD) {
+            if (tach.mode == MODE_SIMULATION) {
+                StartReplay(&tach);
+                tach.mode = MODE_REPLAY;
+            } else {
+                StopReplay(&tach);
+                tach.mode = MODE_SIMULATION;
+            }
+            ResetNeedles(&tach);
+        }
+
+        // Replay speed: halve, double, or as fast as possible (from there,
+        // UP goes back to 1x)
+        if (tach.mode == MODE_REPLAY) {
+            float speed = tach.replaySpeed;
+            if (IsKeyPressed(KEY_UP)) speed = speed > 0.0f ? fminf(speed * 2.0f, REPLAY_MAX_SPEED) : 1.0f;
+            if (IsKeyPressed(KEY_DOWN) && speed > 0.0f) speed = fmaxf(speed / 2.0f, 1.0f / REPLAY_MAX_SPEED);
+            if (IsKeyPressed(KEY_F)) speed = 0.0f;
+            if (speed != tach.replaySpeed) {
+                tach.replaySpeed = speed;
+                Replay_SetSpeed(&tach.replay, speed);
             }
         }
 
         // Update values based on mode
+        long long now = OBD_NowMicros();
+        float dt = (now - lastTick) / 1e6f;
+        lastTick = now;
         if (tach.mode == MODE_SIMULATION) {
-            // RPM controls
+            // RPM controls: rates per second, not per frame
             if (IsKeyDown(KEY_UP)) {
-                tach.targetRPM += 50.0f;
-                if (tach.targetRPM > MAX_RPM) tach.targetRPM = MAX_RPM;
+                tach.targetRPM += 3000.0f * dt;
+                if (tach.targetRPM > SIM_MAX_RPM) tach.targetRPM = SIM_MAX_RPM;
                 // Simulate temp increase with RPM
-                tach.targetTemp = 50.0f + (tach.targetRPM / MAX_RPM) * 50.0f;
+                tach.targetTemp = 50.0f + (tach.targetRPM / SIM_MAX_RPM) * 50.0f;
             }
             if (IsKeyDown(KEY_DOWN)) {
-                tach.targetRPM -= 50.0f;
-                if (tach.targetRPM < MIN_RPM) tach.targetRPM = MIN_RPM;
-                tach.targetTemp = 50.0f + (tach.targetRPM / MAX_RPM) * 50.0f;
+                tach.targetRPM -= 3000.0f * dt;
+                if (tach.targetRPM < SIM_MIN_RPM) tach.targetRPM = SIM_MIN_RPM;
+                tach.targetTemp = 50.0f + (tach.targetRPM / SIM_MAX_RPM) * 50.0f;
             }
             // Speed controls
             if (IsKeyDown(KEY_RIGHT)) {
-                tach.targetSpeed += 2.0f;
-                if (tach.targetSpeed > MAX_SPEED) tach.targetSpeed = MAX_SPEED;
+                tach.targetSpeed += 120.0f * dt;
+                if (tach.targetSpeed > SIM_MAX_SPEED) tach.targetSpeed = SIM_MAX_SPEED;
             }
             if (IsKeyDown(KEY_LEFT)) {
-                tach.targetSpeed -= 2.0f;
+                tach.targetSpeed -= 120.0f * dt;
                 if (tach.targetSpeed < 0) tach.targetSpeed = 0;
             }
         } else {
-            pthread_mutex_lock(&tach.dataMutex);
-            // Values are updated by OBD thread
-            pthread_mutex_unlock(&tach.dataMutex);
+            // Latest values from the OBD thread; if a copy was torn every
+            // time, last frame's values stay
+            Telemetry_Read(&tach.telemetry, &tach.snapshot);
+            Telemetry_ReadLink(&tach.telemetry, &tach.link);
+            // Each sample goes to its needle with the time it arrived; the
+            // same sample seen again on the next frame is ignored
+            for (int i = 0; i < dash->count; i++) {
+                int ch = Telemetry_Channel(&tach.snapshot, dash->pids[i]);
+                if (ch < 0) continue;
+                Needle_AddSample(&tach.needles[i], tach.snapshot.timestamp_us[ch], tach.snapshot.value[ch]);
+            }
         }
 
-        // Smooth transitions
-        float rpmDiff = tach.targetRPM - tach.currentRPM;
-        tach.currentRPM += rpmDiff * 0.1f;
-
-        float speedDiff = tach.targetSpeed - tach.currentSpeed;
-        tach.currentSpeed += speedDiff * 0.1f;
-
-        float tempDiff = tach.targetTemp - tach.currentTemp;
-        tach.currentTemp += tempDiff * 0.05f;
+        // Move the needles by the time since the last frame, so they sweep
+        // the same at any frame rate; in OBD mode they lead the samples by
+        // the acquisition latency
+        if (tach.mode == MODE_SIMULATION) {
+            for (int i = 0; i < dash->count; i++) {
+                dash->values[i] = Needle_UpdateTo(&tach.needles[i], now, *tach.simTargets[i]);
+            }
+        } else {
+            for (int i = 0; i < dash->count; i++) dash->values[i] = Needle_Update(&tach.needles[i], now);
+        }
 
-        // Draw
-        BeginDrawing();
-        ClearBackground((Color){15, 15, 25, 255});
+        // Needles still on their way keep the frame rate up
+        for (int i = 0; i < dash->count; i++) {
+            float tolerance = Gauge_ValueTolerance(&dash->gauges[i]);
+            if (!Needle_Settled(&tach.needles[i], tolerance)) Pacer_Motion(&pacer, now);
+        }
 
-        // Draw all three gauges
-        DrawTachometerGauge(tachCenter, GAUGE_RADIUS);
-        DrawNeedle(tachCenter, tach.currentRPM, MAX_RPM);
-        DrawDigitalReadout(tachCenter, tach.currentRPM);
+        if (IsKeyPressed(KEY_G)) {
+            Gauge_UseShader(!Gauge_ShaderActive());
+            Pacer_DamageAll(&pacer);
+        }
+        if (IsKeyPressed(KEY_S)) showStats = !showStats;
+        if (IsWindowResized()) Pacer_DamageAll(&pacer);
+
+        // Faces go into textures outside the frame (a no-op once they are)
+        for (int i = 0; i < dash->count; i++) Gauge_PrepareFace(&dash->gauges[i]);
+
+        // Text for this tick
+        hud.count = 0;
+        const char* modeText = "SIMULATION";
+        Color modeColor = YELLOW;
+        if (tach.mode == MODE_OBD) {
+            modeText = "OBD MODE";
+            modeColor = GREEN;
+        } else if (tach.mode == MODE_REPLAY) {
+            modeText = "REPLAY";
+            modeColor = SKYBLUE;
+        }
+        int margin = HudPx(&hud, 20);
+        HudAdd(&hud, modeText, margin, margin, 20, modeColor);
+        if (Gauge_ShaderActive()) HudAdd(&hud, "SHADER", layout.width - HudPx(&hud, 90), margin, 16, GRAY);
 
-        DrawSpeedometer(speedCenter, GAUGE_RADIUS, tach.currentSpeed);
+        // Instructions
+        if (tach.mode == MODE_SIMULATION) {
+            HudAdd(&hud, tach.replayLoaded ? "UP/DOWN: RPM | LEFT/RIGHT: Speed | O: Connect OBD | R: Replay"
+                                           : "UP/DOWN: RPM | LEFT/RIGHT: Speed | O: Connect OBD",
+                   margin, HudPx(&hud, 50), 18, WHITE);
+        } else if (tach.mode == MODE_REPLAY) {
+            HudAdd(&hud, "Replaying recording... | UP/DOWN: Speed | F: Fast as possible | R: Stop", margin,
+                   HudPx(&hud, 50), 18, WHITE);
+        } else {
+            HudAdd(&hud, "Reading from vehicle... | O: Disconnect", margin, HudPx(&hud, 50), 18, WHITE);
+        }
 
-        DrawTemperatureGauge(tempCenter, 120, tach.currentTemp);
+        // Achieved vs requested poll rate per channel
+        if (tach.mode != MODE_SIMULATION) {
+            const TelemetryLink* link = &tach.link;
+            for (int i = 0; i < link->num_stats; i++) {
+                const OBDChannelStats* st = &link->stats[i];
+                const char* line = tach.passive
+                    ? TextFormat("PID %02X  %5.1f Hz (broadcast)", st->pid, st->achieved_hz)
+                    : TextFormat("PID %02X  %5.1f / %4.1f Hz", st->pid, st->achieved_hz, st->target_hz);
+                Color color = (st->achieved_hz < st->target_hz * 0.9f) ? ORANGE : GRAY;
+                HudAdd(&hud, line, margin, HudPx(&hud, 80 + i * 18), 16, color);
+            }
+            if (link->saturated) {
+                HudAdd(&hud, "LINK SATURATED", margin, HudPx(&hud, 80 + link->num_stats * 18), 16, RED);
+            }
 
-        // Draw mode indicator
-        const char* modeText = (tach.mode == MODE_OBD) ? "OBD MODE" : "SIMULATION";
-        Color modeColor = (tach.mode == MODE_OBD) ? GREEN : YELLOW;
-        DrawText(modeText, 20, 20, 20, modeColor);
+            // Last 10 seconds of RPM from the history
+            TimeSeries* rpmHistory = TS_Channel(&tach.history, 0x0C);
+            TimeSeriesStats rpmStats;
+            if (rpmHistory && TS_Stats(rpmHistory, OBD_NowMicros() - 10000000LL, &rpmStats)) {
+                HudAdd(&hud, TextFormat("RPM 10 s  min %4.0f  max %4.0f  mean %4.0f", rpmStats.min, rpmStats.max,
+                                        rpmStats.mean),
+                       margin, layout.height - HudPx(&hud, 30), 16, GRAY);
+            }
+            if (tach.monitoring) {
+                HudAdd(&hud, TextFormat("%s  %lu frames  %lu BUFFER FULL", tach.obdMonitor.stn ? "STMA" : "ATMA",
+                                        link->monitor_frames, link->monitor_overruns),
+                       margin, HudPx(&hud, 80), 16, link->monitor_overruns > 0 ? ORANGE : GRAY);
+            }
+            if (tach.mode == MODE_REPLAY) {
+                const char* speed = link->replay_speed > 0.0f ? TextFormat("%gx", link->replay_speed) : "max";
+                HudAdd(&hud, TextFormat("REPLAY  %s  %3.0f%%  loop %lu  late max %.1f ms", speed,
+                                        link->replay_position * 100.0f, link->replay_loops,
+                                        link->replay_late_us / 1000.0f),
+                       margin, layout.height - HudPx(&hud, 50), 16, GRAY);
+            } else if (tach.logging) {
+                unsigned long dropped = atomic_load_explicit(&tach.log.dropped, memory_order_relaxed);
+                HudAdd(&hud, TextFormat("REC  segment %u  %lu records  %lu dropped",
+                                        atomic_load_explicit(&tach.log.segment, memory_order_relaxed),
+                                        atomic_load_explicit(&tach.log.records, memory_order_relaxed), dropped),
+                       margin, layout.height - HudPx(&hud, 50), 16, dropped > 0 ? ORANGE : GRAY);
+            }
+        }
 
-        // Draw instructions
-        if (tach.mode == MODE_SIMULATION) {
-            DrawText("UP/DOWN: RPM | LEFT/RIGHT: Speed | O: Connect OBD", 20, 50, 18, WHITE);
-        } else {
-            DrawText("Reading from vehicle... | O: Disconnect", 20, 50, 18, WHITE);
+        // Frame pacing, over the last second
+        if (showStats) {
+            int x = layout.width - HudPx(&hud, 300);
+            HudAdd(&hud, TextFormat("FRAMES  %3.0f drawn  %3.0f skipped /s", pacer.drawn_per_s, pacer.skipped_per_s),
+                   x, HudPx(&hud, 50), 16, GRAY);
+            HudAdd(&hud, TextFormat("RATE    %3.0f Hz %s", Pacer_Rate(&pacer), pacer.active ? "active" : "idle"),
+                   x, HudPx(&hud, 68), 16, GRAY);
+            HudAdd(&hud, TextFormat("CPU     %5.1f%%  render %5.1f%%", pacer.cpu_percent, pacer.render_cpu_percent),
+                   x, HudPx(&hud, 86), 16, GRAY);
         }
 
-        // Redline warning
-        if (tach.currentRPM >= REDLINE_RPM) {
-            DrawText("REDLINE!", tachCenter.x - 70, tachCenter.y + 100, 30, RED);
+        // Red zone warnings (REDLINE!), sized with their gauges
+        for (int i = 0; i < dash->count; i++) {
+            const DashAlert* alert = &dash->alerts[i];
+            if (dash->values[i] >= alert->threshold) {
+                HudPut(&hud, alert->text, alert->x, alert->y, alert->font_size, RED);
+            }
         }
 
-        EndDrawing();
+        // What changed since it was drawn
+        for (int i = 0; i < dash->count; i++) {
+            if (Gauge_Changed(&dash->gauges[i], dash->values[i])) Pacer_Damage(&pacer, dash->bounds[i]);
+        }
+        HudDamage(&pacer, &hud, &shownHud);
+        Pacer_DamageWhole(&pacer, dash->bounds, dash->count);
+
+        // Draw the damaged regions into the dashboard, each over a cleared
+        // background: gauges (a cached face each, then needle and readout),
+        // then text
+        bool drawn = Pacer_NeedsFrame(&pacer);
+        if (drawn) {
+            BeginTextureMode(dashboard);
+            for (int d = 0; d < pacer.num_damage; d++) {
+                Rectangle area = pacer.damage[d];
+                BeginScissorMode(area.x, area.y, area.width, area.height);
+                ClearBackground(BACKGROUND_COLOR);
+                for (int i = 0; i < dash->count; i++) {
+                    if (Pacer_Damaged(&pacer, dash->bounds[i])) Gauge_Draw(&dash->gauges[i], dash->values[i]);
+                }
+                for (int i = 0; i < hud.count; i++) {
+                    const HudLine* line = &hud.lines[i];
+                    if (CheckCollisionRecs(area, HudBounds(line))) {
+                        DrawText(line->text, line->x, line->y, line->size, line->color);
+                    }
+                }
+                EndScissorMode();
+            }
+            EndTextureMode();
+            shownHud = hud;
+
+            // Copied, not blended: the dashboard's alpha isn't 1 at every
+            // anti-aliased edge. Render textures are stored bottom up.
+            BeginDrawing();
+            rlSetBlendFactors(RL_ONE, RL_ZERO, RL_FUNC_ADD);
+            BeginBlendMode(BLEND_CUSTOM);
+            DrawTextureRec(dashboard.texture, (Rectangle){ 0, 0, layout.width, -layout.height }, (Vector2){ 0, 0 },
+                           WHITE);
+            EndBlendMode();
+            EndDrawing();
+        } else {
+            // EndDrawing would have polled the input
+            PollInputEvents();
+        }
+        Pacer_EndTick(&pacer, drawn);
     }
 
     // Cleanup
-    if (tach.mode == MODE_OBD) {
-        tach.obdThreadRunning = false;
-        pthread_join(tach.obdThread, NULL);
-        OBD_Close(&tach.obd);
-    }
-    pthread_mutex_destroy(&tach.dataMutex);
+    UnloadRenderTexture(dashboard);
+    Layout_Unload(dash);
+    Gauge_UnloadShader();
+    if (tach.mode == MODE_OBD) DisconnectVehicle(&tach);
+    if (tach.mode == MODE_REPLAY) StopReplay(&tach);
+    if (tach.replayLoaded) Replay_Free(&tach.replay);
+    if (tach.logging) TLog_Close(&tach.log);
+    TS_Free(&tach.history);
 
     CloseWindow();
     return 0;
@@ -0,0 +1,107 @@
+#include "telemetry.h"
+#include <string.h>
+
+_Static_assert(sizeof(TelemetrySnapshot) % 4 == 0, "snapshot must be whole words");
+_Static_assert(sizeof(TelemetryLink) % 4 == 0, "link status must be whole words");
+
+// Write side of the seqlock: odd count, payload, even count. The release
+// fence keeps the payload stores after the odd count; the release store keeps
+// them before the even one.
+static void SeqStore(_Atomic unsigned int* seq, _Atomic uint32_t* words, const void* src, size_t num_words) {
+    unsigned int s = atomic_load_explicit(seq, memory_order_relaxed);
+    atomic_store_explicit(seq, s + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    const unsigned char* bytes = (const unsigned char*)src;
+    for (size_t i = 0; i < num_words; i++) {
+        uint32_t word;
+        memcpy(&word, bytes + i * 4, 4);
+        atomic_store_explicit(&words[i], word, memory_order_relaxed);
+    }
+
+    atomic_store_explicit(seq, s + 2, memory_order_release);
+}
+
+// Read side: an even count that is unchanged after the copy means no write
+// overlapped it. The copy goes to a scratch buffer so a failed read leaves
+// the caller's snapshot alone.
+static bool SeqLoad(Telemetry* telemetry, _Atomic unsigned int* seq, _Atomic uint32_t* words,
+                    void* dst, size_t num_words) {
+    uint32_t scratch[TELEMETRY_LINK_WORDS > TELEMETRY_SNAPSHOT_WORDS ? TELEMETRY_LINK_WORDS
+                                                                      : TELEMETRY_SNAPSHOT_WORDS];
+    for (int attempt = 0; attempt < TELEMETRY_READ_ATTEMPTS; attempt++) {
+        unsigned int before = atomic_load_explicit(seq, memory_order_acquire);
+        if (before & 1) {
+            atomic_fetch_add_explicit(&telemetry->read_retries, 1, memory_order_relaxed);
+            continue;
+        }
+        for (size_t i = 0; i < num_words; i++) {
+            scratch[i] = atomic_load_explicit(&words[i], memory_order_relaxed);
+        }
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(seq, memory_order_relaxed) == before) {
+            memcpy(dst, scratch, num_words * 4);
+            return true;
+        }
+        atomic_fetch_add_explicit(&telemetry->read_retries, 1, memory_order_relaxed);
+    }
+    atomic_fetch_add_explicit(&telemetry->read_failures, 1, memory_order_relaxed);
+    return false;
+}
+
+void Telemetry_Init(Telemetry* telemetry) {
+    memset(&telemetry->working, 0, sizeof(telemetry->working));
+    memset(&telemetry->link_working, 0, sizeof(telemetry->link_working));
+    atomic_init(&telemetry->seq, 0);
+    atomic_init(&telemetry->link_seq, 0);
+    for (size_t i = 0; i < TELEMETRY_SNAPSHOT_WORDS; i++) atomic_init(&telemetry->words[i], 0);
+    for (size_t i = 0; i < TELEMETRY_LINK_WORDS; i++) atomic_init(&telemetry->link_words[i], 0);
+    atomic_init(&telemetry->read_retries, 0);
+    atomic_init(&telemetry->read_failures, 0);
+}
+
+void Telemetry_Clear(Telemetry* telemetry) {
+    uint32_t updates = telemetry->working.updates;
+    memset(&telemetry->working, 0, sizeof(telemetry->working));
+    telemetry->working.updates = updates + 1;
+    memset(&telemetry->link_working, 0, sizeof(telemetry->link_working));
+    SeqStore(&telemetry->seq, telemetry->words, &telemetry->working, TELEMETRY_SNAPSHOT_WORDS);
+    SeqStore(&telemetry->link_seq, telemetry->link_words, &telemetry->link_working, TELEMETRY_LINK_WORDS);
+}
+
+void Telemetry_Publish(Telemetry* telemetry, uint8_t pid, float value, long long timestamp_us) {
+    TelemetrySnapshot* snap = &telemetry->working;
+    int channel = 0;
+    while (channel < snap->num_channels && snap->pid[channel] != pid) channel++;
+    if (channel == snap->num_channels) {
+        if (channel == TELEMETRY_MAX_CHANNELS) return;
+        snap->pid[channel] = pid;
+        snap->num_channels++;
+    }
+
+    snap->value[channel] = value;
+    snap->timestamp_us[channel] = timestamp_us;
+    snap->valid |= 1u << channel;
+    snap->updates++;
+    SeqStore(&telemetry->seq, telemetry->words, snap, TELEMETRY_SNAPSHOT_WORDS);
+}
+
+void Telemetry_PublishLink(Telemetry* telemetry, const TelemetryLink* link) {
+    telemetry->link_working = *link;
+    SeqStore(&telemetry->link_seq, telemetry->link_words, &telemetry->link_working, TELEMETRY_LINK_WORDS);
+}
+
+bool Telemetry_Read(Telemetry* telemetry, TelemetrySnapshot* out) {
+    return SeqLoad(telemetry, &telemetry->seq, telemetry->words, out, TELEMETRY_SNAPSHOT_WORDS);
+}
+
+bool Telemetry_ReadLink(Telemetry* telemetry, TelemetryLink* out) {
+    return SeqLoad(telemetry, &telemetry->link_seq, telemetry->link_words, out, TELEMETRY_LINK_WORDS);
+}
+
+int Telemetry_Channel(const TelemetrySnapshot* snapshot, uint8_t pid) {
+    for (int i = 0; i < snapshot->num_channels; i++) {
+        if (snapshot->pid[i] == pid) return (snapshot->valid & (1u << i)) ? i : -1;
+    }
+    return -1;
+}
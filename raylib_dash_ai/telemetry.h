@@ -0,0 +1,94 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include "obd_scheduler.h"
+
+// Latest values from the OBD thread for the render loop, without a lock.
+//
+// One writer (the thread that owns the connection) publishes whole snapshots
+// under a sequence counter (a seqlock): the counter is odd while a snapshot is
+// being written, and a reader that sees it change while copying tries again.
+// The writer never waits for readers. A reader never waits for the writer
+// either: after TELEMETRY_READ_ATTEMPTS torn copies it gives up, leaves its
+// previous snapshot as it was and draws that for one more frame.
+//
+// The payload is stored as relaxed atomic words, so the copies race with
+// nothing as far as the language (and ThreadSanitizer) is concerned.
+//
+// Writer role: whoever starts the I/O thread hands it over with
+// pthread_create and takes it back with pthread_join.
+
+#define TELEMETRY_MAX_CHANNELS 16
+
+// Copy attempts before Telemetry_Read gives up for this frame
+#define TELEMETRY_READ_ATTEMPTS 64
+
+// Channel values, one per PID in the order they were first published
+typedef struct {
+    int num_channels;
+    uint8_t pid[TELEMETRY_MAX_CHANNELS];
+    float value[TELEMETRY_MAX_CHANNELS];
+    long long timestamp_us[TELEMETRY_MAX_CHANNELS];  // OBD_NowMicros clock of the sample
+    uint32_t valid;                                  // Bit per channel: holds a sample
+    uint32_t updates;                                // Snapshots published (wraps)
+} TelemetrySnapshot;
+
+// How the link is doing, for the overlay (published less often than values)
+typedef struct {
+    OBDChannelStats stats[OBD_SCHED_MAX_CHANNELS];
+    int num_stats;
+    bool saturated;                  // Poll scheduler can't keep its rates
+    unsigned long monitor_frames;    // Monitor mode: frames decoded
+    unsigned long monitor_overruns;  // Monitor mode: BUFFER FULL
+    float replay_position;           // Replay mode: fraction played
+    float replay_speed;              // Replay mode: 0 = as fast as possible
+    unsigned long replay_loops;
+    long long replay_late_us;        // Replay mode: worst delivery after due
+} TelemetryLink;
+
+#define TELEMETRY_SNAPSHOT_WORDS ((sizeof(TelemetrySnapshot) + 3) / 4)
+#define TELEMETRY_LINK_WORDS ((sizeof(TelemetryLink) + 3) / 4)
+
+typedef struct {
+    // Writer's own copies, published whole
+    TelemetrySnapshot working;
+    TelemetryLink link_working;
+
+    // Shared, each on its own cache lines
+    _Alignas(64) _Atomic unsigned int seq;
+    _Atomic uint32_t words[TELEMETRY_SNAPSHOT_WORDS];
+    _Alignas(64) _Atomic unsigned int link_seq;
+    _Atomic uint32_t link_words[TELEMETRY_LINK_WORDS];
+
+    // Reader side
+    _Alignas(64) _Atomic unsigned long read_retries;   // Copies torn by a concurrent write
+    _Atomic unsigned long read_failures;               // Reads that kept the previous snapshot
+} Telemetry;
+
+// Empty snapshot and link status (call before any thread uses it)
+void Telemetry_Init(Telemetry* telemetry);
+
+// Writer: drop every value and the link status, e.g. on (dis)connect
+void Telemetry_Clear(Telemetry* telemetry);
+
+// Writer: new sample for a PID. PIDs get a channel on first use; once all
+// TELEMETRY_MAX_CHANNELS are taken, new PIDs are ignored.
+void Telemetry_Publish(Telemetry* telemetry, uint8_t pid, float value, long long timestamp_us);
+
+// Writer: new link status
+void Telemetry_PublishLink(Telemetry* telemetry, const TelemetryLink* link);
+
+// Reader: copy the latest snapshot. Returns false, leaving *out untouched,
+// if every attempt overlapped a write.
+bool Telemetry_Read(Telemetry* telemetry, TelemetrySnapshot* out);
+
+// Reader: copy the latest link status (false: *out untouched, as above)
+bool Telemetry_ReadLink(Telemetry* telemetry, TelemetryLink* out);
+
+// Channel of a PID in a snapshot, -1 if it has none or no sample yet
+int Telemetry_Channel(const TelemetrySnapshot* snapshot, uint8_t pid);
+
+#endif // TELEMETRY_H
@@ -0,0 +1,378 @@
+#include "telemetry_log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// How often the background thread looks for work between syncs
+#define POLL_MS 50
+
+#define RETIRED_MASK (TLOG_RETIRED_SLOTS - 1)
+_Static_assert((TLOG_RETIRED_SLOTS & RETIRED_MASK) == 0, "TLOG_RETIRED_SLOTS must be a power of two");
+
+// Same clock as OBD_NowMicros, without linking the reader
+static long long MonotonicMicros(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+static long long WallMicros(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (long long)ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+// ---- Record check ----
+
+// CRC-16/CCITT-FALSE, a nibble at a time
+static const uint16_t CRC_NIBBLE[16] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+};
+
+uint16_t TLog_RecordCheck(const TLogRecord* record) {
+    const uint8_t* bytes = (const uint8_t*)record;
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < offsetof(TLogRecord, check); i++) {
+        crc = (uint16_t)(crc << 4) ^ CRC_NIBBLE[(crc >> 12) ^ (bytes[i] >> 4)];
+        crc = (uint16_t)(crc << 4) ^ CRC_NIBBLE[(crc >> 12) ^ (bytes[i] & 0x0F)];
+    }
+    return crc;
+}
+
+// ---- Segments (background thread) ----
+
+static void SyncDirectory(const char* directory) {
+    int fd = open(directory, O_RDONLY);
+    if (fd < 0) return;
+    fsync(fd);
+    close(fd);
+}
+
+static bool Preallocate(int fd, size_t bytes) {
+#ifdef __linux__
+    // Real blocks, so writing through the mapping can't hit ENOSPC (SIGBUS)
+    return posix_fallocate(fd, 0, bytes) == 0;
+#else
+    static const char zeros[65536];
+    for (size_t done = 0; done < bytes;) {
+        size_t n = bytes - done < sizeof(zeros) ? bytes - done : sizeof(zeros);
+        ssize_t written = pwrite(fd, zeros, n, done);
+        if (written <= 0) return false;
+        done += written;
+    }
+    return true;
+#endif
+}
+
+// Create, preallocate and map the next segment, header synced before use
+static TLogSegment* CreateSegment(TelemetryLog* log) {
+    TLogSegment* seg = calloc(1, sizeof(TLogSegment));
+    if (!seg) return NULL;
+    seg->index = log->next_index;
+    seg->capacity = (uint32_t)((log->config.segment_bytes - TLOG_HEADER_BYTES) / sizeof(TLogRecord));
+    seg->map_bytes = TLOG_HEADER_BYTES + (size_t)seg->capacity * sizeof(TLogRecord);
+    snprintf(seg->path, sizeof(seg->path), "%s/%s-%s-%04u.tlog", log->directory, log->prefix, log->session,
+             seg->index);
+
+    seg->fd = open(seg->path, O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (seg->fd < 0) {
+        fprintf(stderr, "Cannot create log segment %s: %s\n", seg->path, strerror(errno));
+        free(seg);
+        return NULL;
+    }
+    int flags = MAP_SHARED;
+#ifdef MAP_POPULATE
+    flags |= MAP_POPULATE;   // Fault the pages in now, not on the writer's first touch
+#endif
+    if (!Preallocate(seg->fd, seg->map_bytes) ||
+        (seg->map = mmap(NULL, seg->map_bytes, PROT_READ | PROT_WRITE, flags, seg->fd, 0)) == MAP_FAILED) {
+        fprintf(stderr, "Cannot map log segment %s: %s\n", seg->path, strerror(errno));
+        close(seg->fd);
+        unlink(seg->path);
+        free(seg);
+        return NULL;
+    }
+
+    TLogHeader header = {0};
+    memcpy(header.magic, TLOG_MAGIC, sizeof(TLOG_MAGIC));
+    header.version = TLOG_VERSION;
+    header.record_size = sizeof(TLogRecord);
+    header.segment = seg->index;
+    header.capacity = seg->capacity;
+    header.session_us = log->session_us;
+    header.created_us = WallMicros();
+    header.clock_offset_us = header.created_us - MonotonicMicros();
+    memcpy(seg->map, &header, sizeof(header));
+    msync(seg->map, TLOG_HEADER_BYTES, MS_SYNC);
+    fsync(seg->fd);
+    SyncDirectory(log->directory);
+
+    atomic_init(&seg->count, 0);
+    log->next_index++;
+    return seg;
+}
+
+// Make the records written so far durable. Pages already synced are skipped;
+// the partial page at the end is synced again next time.
+static void SyncSegment(TelemetryLog* log, TLogSegment* seg) {
+    uint32_t count = atomic_load_explicit(&seg->count, memory_order_acquire);
+    if (count == seg->synced) return;
+
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t from = (TLOG_HEADER_BYTES + (size_t)seg->synced * sizeof(TLogRecord)) / page * page;
+    size_t to = TLOG_HEADER_BYTES + (size_t)count * sizeof(TLogRecord);
+
+    long long start = MonotonicMicros();
+    if (msync(seg->map + from, to - from, MS_SYNC) != 0) {
+        atomic_fetch_add_explicit(&log->errors, 1, memory_order_relaxed);
+        return;
+    }
+    long long took = MonotonicMicros() - start;
+    if (took > atomic_load_explicit(&log->max_sync_us, memory_order_relaxed))
+        atomic_store_explicit(&log->max_sync_us, took, memory_order_relaxed);
+    atomic_fetch_add_explicit(&log->syncs, 1, memory_order_relaxed);
+    seg->synced = count;
+}
+
+// Sync, trim to the records written, and release. A segment that received
+// nothing is removed.
+static void FinishSegment(TelemetryLog* log, TLogSegment* seg) {
+    SyncSegment(log, seg);
+    uint32_t count = atomic_load_explicit(&seg->count, memory_order_acquire);
+    munmap(seg->map, seg->map_bytes);
+    if (count == 0) {
+        close(seg->fd);
+        unlink(seg->path);
+    } else {
+        if (ftruncate(seg->fd, TLOG_HEADER_BYTES + (off_t)count * sizeof(TLogRecord)) == 0) fsync(seg->fd);
+        close(seg->fd);
+    }
+    free(seg);
+}
+
+static void* BackgroundThread(void* arg) {
+    TelemetryLog* log = (TelemetryLog*)arg;
+
+    pthread_mutex_lock(&log->lock);
+    while (!log->stopping) {
+        pthread_mutex_unlock(&log->lock);
+
+        // Next segment ready before the writer needs it
+        if (!atomic_load_explicit(&log->spare, memory_order_acquire)) {
+            TLogSegment* seg = CreateSegment(log);
+            if (seg) atomic_store_explicit(&log->spare, seg, memory_order_release);
+            else atomic_fetch_add_explicit(&log->errors, 1, memory_order_relaxed);
+        }
+
+        long long now = MonotonicMicros();
+        if (now - log->last_sync_us >= log->config.sync_interval_ms * 1000LL) {
+            TLogSegment* seg = atomic_load_explicit(&log->current, memory_order_acquire);
+            if (seg) SyncSegment(log, seg);
+            log->last_sync_us = now;
+        }
+
+        // Segments the writer left behind (synced in full here, even if the
+        // writer moved on while the sync above was running)
+        unsigned int tail = atomic_load_explicit(&log->retired_tail, memory_order_relaxed);
+        while (tail != atomic_load_explicit(&log->retired_head, memory_order_acquire)) {
+            FinishSegment(log, log->retired[tail & RETIRED_MASK]);
+            tail++;
+            atomic_store_explicit(&log->retired_tail, tail, memory_order_release);
+        }
+
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_nsec += POLL_MS * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+        pthread_mutex_lock(&log->lock);
+        if (!log->stopping) pthread_cond_timedwait(&log->wake, &log->lock, &deadline);
+    }
+    pthread_mutex_unlock(&log->lock);
+    return NULL;
+}
+
+// ---- Writer ----
+
+TLogConfig TLog_DefaultConfig(const char* directory) {
+    TLogConfig config = {
+        .directory = directory,
+        .prefix = "drive",
+        .segment_bytes = TLOG_DEFAULT_SEGMENT_BYTES,
+        .segment_seconds = TLOG_DEFAULT_SEGMENT_SECONDS,
+        .sync_interval_ms = TLOG_DEFAULT_SYNC_MS,
+    };
+    return config;
+}
+
+bool TLog_Open(TelemetryLog* log, const TLogConfig* config) {
+    memset(log, 0, sizeof(*log));
+    log->config = *config;
+    snprintf(log->directory, sizeof(log->directory), "%s", config->directory ? config->directory : ".");
+    snprintf(log->prefix, sizeof(log->prefix), "%s", config->prefix ? config->prefix : "drive");
+    if (log->config.segment_bytes < TLOG_HEADER_BYTES + 16 * sizeof(TLogRecord))
+        log->config.segment_bytes = TLOG_HEADER_BYTES + 16 * sizeof(TLogRecord);
+    if (log->config.sync_interval_ms <= 0) log->config.sync_interval_ms = TLOG_DEFAULT_SYNC_MS;
+
+    if (mkdir(log->directory, 0755) != 0 && errno != EEXIST) {
+        fprintf(stderr, "Cannot create log directory %s: %s\n", log->directory, strerror(errno));
+        return false;
+    }
+    log->session_us = WallMicros();
+    time_t seconds = (time_t)(log->session_us / 1000000);
+    struct tm local;
+    localtime_r(&seconds, &local);
+    strftime(log->session, sizeof(log->session), "%Y%m%d-%H%M%S", &local);
+
+    // The first segment is made here so a bad directory fails now
+    log->active = CreateSegment(log);
+    if (!log->active) return false;
+    atomic_init(&log->current, log->active);
+    atomic_init(&log->spare, CreateSegment(log));
+    atomic_init(&log->segment, log->active->index);
+    log->last_sync_us = MonotonicMicros();
+
+    pthread_mutex_init(&log->lock, NULL);
+    pthread_cond_init(&log->wake, NULL);
+    if (pthread_create(&log->thread, NULL, BackgroundThread, log) != 0) {
+        FinishSegment(log, log->active);
+        TLogSegment* spare = atomic_load(&log->spare);
+        if (spare) FinishSegment(log, spare);
+        return false;
+    }
+    return true;
+}
+
+// Swap in the prepared segment and queue the old one for the background
+// thread. Fails (and the caller carries on in the old one if it can) when
+// nothing is prepared yet or the queue is full.
+static bool Rotate(TelemetryLog* log) {
+    unsigned int head = atomic_load_explicit(&log->retired_head, memory_order_relaxed);
+    if (head - atomic_load_explicit(&log->retired_tail, memory_order_acquire) >= TLOG_RETIRED_SLOTS) return false;
+    TLogSegment* next = atomic_exchange_explicit(&log->spare, NULL, memory_order_acq_rel);
+    if (!next) return false;
+
+    log->retired[head & RETIRED_MASK] = log->active;
+    atomic_store_explicit(&log->retired_head, head + 1, memory_order_release);
+    log->active = next;
+    atomic_store_explicit(&log->current, next, memory_order_release);
+    atomic_store_explicit(&log->segment, next->index, memory_order_relaxed);
+    atomic_fetch_add_explicit(&log->rotations, 1, memory_order_relaxed);
+    return true;
+}
+
+bool TLog_Write(TelemetryLog* log, long long timestamp_us, uint8_t pid, float value, uint8_t flags) {
+    TLogSegment* seg = log->active;
+    uint32_t count = atomic_load_explicit(&seg->count, memory_order_relaxed);
+
+    bool full = count >= seg->capacity;
+    bool expired = count > 0 && log->config.segment_seconds > 0 &&
+                   timestamp_us - seg->first_us >= log->config.segment_seconds * 1000000LL;
+    if ((full || expired) && Rotate(log)) {
+        seg = log->active;
+        count = 0;
+    } else if (full) {
+        atomic_fetch_add_explicit(&log->dropped, 1, memory_order_relaxed);
+        return false;
+    }
+
+    TLogRecord record = {
+        .timestamp_us = timestamp_us,
+        .value = value,
+        .pid = pid,
+        .flags = flags,
+    };
+    record.check = TLog_RecordCheck(&record);
+    memcpy(seg->map + TLOG_HEADER_BYTES + (size_t)count * sizeof(TLogRecord), &record, sizeof(record));
+    if (count == 0) seg->first_us = timestamp_us;
+
+    atomic_store_explicit(&seg->count, count + 1, memory_order_release);
+    atomic_fetch_add_explicit(&log->records, 1, memory_order_relaxed);
+    return true;
+}
+
+void TLog_Close(TelemetryLog* log) {
+    pthread_mutex_lock(&log->lock);
+    log->stopping = true;
+    pthread_cond_signal(&log->wake);
+    pthread_mutex_unlock(&log->lock);
+    pthread_join(log->thread, NULL);
+
+    unsigned int tail = atomic_load(&log->retired_tail);
+    for (; tail != atomic_load(&log->retired_head); tail++) FinishSegment(log, log->retired[tail & RETIRED_MASK]);
+    FinishSegment(log, log->active);
+    TLogSegment* spare = atomic_exchange(&log->spare, NULL);
+    if (spare) FinishSegment(log, spare);   // Empty: removed
+    SyncDirectory(log->directory);
+
+    pthread_cond_destroy(&log->wake);
+    pthread_mutex_destroy(&log->lock);
+    log->active = NULL;
+    atomic_store(&log->current, NULL);
+}
+
+// ---- Reader ----
+
+bool TLog_ReaderOpen(TLogReader* reader, const char* path) {
+    memset(reader, 0, sizeof(*reader));
+    reader->fd = open(path, O_RDONLY);
+    if (reader->fd < 0) {
+        fprintf(stderr, "Cannot open log segment %s: %s\n", path, strerror(errno));
+        return false;
+    }
+    struct stat st;
+    if (fstat(reader->fd, &st) != 0 || st.st_size < TLOG_HEADER_BYTES) {
+        fprintf(stderr, "%s: not a log segment\n", path);
+        close(reader->fd);
+        return false;
+    }
+    reader->map_bytes = (size_t)st.st_size;
+    reader->map = mmap(NULL, reader->map_bytes, PROT_READ, MAP_SHARED, reader->fd, 0);
+    if (reader->map == MAP_FAILED) {
+        fprintf(stderr, "Cannot map log segment %s: %s\n", path, strerror(errno));
+        close(reader->fd);
+        return false;
+    }
+
+    memcpy(&reader->header, reader->map, sizeof(reader->header));
+    if (memcmp(reader->header.magic, TLOG_MAGIC, sizeof(TLOG_MAGIC)) != 0 ||
+        reader->header.version != TLOG_VERSION || reader->header.record_size != sizeof(TLogRecord)) {
+        fprintf(stderr, "%s: not a version %d log segment\n", path, TLOG_VERSION);
+        TLog_ReaderClose(reader);
+        return false;
+    }
+    reader->capacity = (uint32_t)((reader->map_bytes - TLOG_HEADER_BYTES) / sizeof(TLogRecord));
+    return true;
+}
+
+bool TLog_ReaderNext(TLogReader* reader, TLogRecord* record) {
+    static const TLogRecord empty = {0};
+    while (reader->next < reader->capacity) {
+        memcpy(record, reader->map + TLOG_HEADER_BYTES + (size_t)reader->next * sizeof(TLogRecord),
+               sizeof(*record));
+        reader->next++;
+        if (record->check == TLog_RecordCheck(record)) {
+            reader->records++;
+            return true;
+        }
+        // Zeros are preallocated space never written; anything else is damage
+        if (memcmp(record, &empty, sizeof(empty)) != 0) reader->damaged++;
+    }
+    return false;
+}
+
+void TLog_ReaderClose(TLogReader* reader) {
+    if (reader->map && reader->map != MAP_FAILED) munmap((void*)reader->map, reader->map_bytes);
+    if (reader->fd >= 0) close(reader->fd);
+    reader->map = NULL;
+    reader->fd = -1;
+}
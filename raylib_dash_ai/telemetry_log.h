@@ -0,0 +1,162 @@
+#ifndef TELEMETRY_LOG_H
+#define TELEMETRY_LOG_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+// Drive recorder: every sample as a fixed 16-byte binary record, appended to
+// preallocated segment files that are memory-mapped for writing.
+//
+// The acquisition thread only copies a record into the mapping and bumps a
+// counter: no system calls, no allocation, no locks. A background thread does
+// everything that can block. It creates, preallocates and maps the next segment
+// before it is needed, msyncs what has been written every sync interval, and
+// closes (trims, fsyncs, unmaps) segments the writer has moved on from. The
+// writer rotates to the prepared segment when the current one is full or has
+// been open for segment_seconds.
+//
+// Crash safety: the header is written and synced before a segment is used,
+// records are only ever appended, and each carries a CRC of its contents. A
+// power cut can lose what was written since the last sync, but it cannot
+// damage anything already synced: a torn page only yields records that fail
+// their check, which TLog_ReaderNext skips and counts. A segment that was
+// never closed keeps its preallocated size; the unused tail reads as zeros.
+//
+// Writer role: one thread at a time calls TLog_Write (hand it over with
+// pthread_create/pthread_join, as with Telemetry).
+
+#define TLOG_MAGIC "OBDTLOG"
+#define TLOG_VERSION 1
+#define TLOG_HEADER_BYTES 64
+
+// Defaults: 8 MB (about 500k records) or 10 minutes per segment, synced every second
+#define TLOG_DEFAULT_SEGMENT_BYTES (8u << 20)
+#define TLOG_DEFAULT_SEGMENT_SECONDS 600
+#define TLOG_DEFAULT_SYNC_MS 1000
+
+// Segments the writer can hand back before the background thread closes them
+#define TLOG_RETIRED_SLOTS 8
+
+// Record flags: where the sample came from
+#define TLOG_FLAG_POLLED    0x01   // Mode 01 request
+#define TLOG_FLAG_BROADCAST 0x02   // Decoded from bus traffic (SocketCAN or ATMA)
+
+typedef struct {
+    int64_t timestamp_us;    // OBD_NowMicros clock
+    float value;
+    uint8_t pid;
+    uint8_t flags;
+    uint16_t check;          // CRC-16 of the 14 bytes above
+} TLogRecord;
+
+_Static_assert(sizeof(TLogRecord) == 16, "TLogRecord must be 16 bytes");
+
+// First 64 bytes of every segment file (little-endian, as written)
+typedef struct {
+    char magic[8];           // TLOG_MAGIC
+    uint32_t version;
+    uint32_t record_size;    // sizeof(TLogRecord)
+    uint32_t segment;        // Sequence number within the session, from 0
+    uint32_t capacity;       // Records the preallocated file holds
+    int64_t session_us;      // Wall clock when the session was opened
+    int64_t created_us;      // Wall clock when this segment was created
+    int64_t clock_offset_us; // Wall clock minus OBD_NowMicros: add to timestamps
+    uint8_t reserved[16];
+} TLogHeader;
+
+_Static_assert(sizeof(TLogHeader) == TLOG_HEADER_BYTES, "TLogHeader must be 64 bytes");
+
+typedef struct {
+    const char* directory;
+    const char* prefix;      // File names: <prefix>-YYYYMMDD-HHMMSS-NNNN.tlog
+    size_t segment_bytes;    // Including the header
+    int segment_seconds;     // Rotate after this long (0 = by size only)
+    int sync_interval_ms;
+} TLogConfig;
+
+typedef struct {
+    int fd;
+    uint32_t index;
+    uint8_t* map;
+    size_t map_bytes;
+    uint32_t capacity;
+    _Atomic uint32_t count;  // Records written (the writer stores, release)
+    uint32_t synced;         // Records msync'd (background thread only)
+    long long first_us;      // Timestamp of the first record (writer only)
+    char path[288];
+} TLogSegment;
+
+typedef struct {
+    TLogConfig config;
+    char directory[200];
+    char prefix[32];
+    char session[24];        // YYYYMMDD-HHMMSS
+    int64_t session_us;
+
+    // Writer side
+    TLogSegment* active;
+    _Atomic(TLogSegment*) current;   // active, for the background thread to sync
+    _Atomic(TLogSegment*) spare;     // Prepared by the background thread, taken by the writer
+    TLogSegment* retired[TLOG_RETIRED_SLOTS];
+    _Atomic unsigned int retired_head;   // Pushed by the writer
+    _Atomic unsigned int retired_tail;   // Popped by the background thread
+
+    // Background thread
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    bool stopping;
+    uint32_t next_index;
+    long long last_sync_us;
+
+    // Counters (any thread may read)
+    _Atomic unsigned long records;
+    _Atomic unsigned long dropped;       // No room and no prepared segment
+    _Atomic unsigned long rotations;
+    _Atomic unsigned long syncs;
+    _Atomic unsigned long errors;        // Failed create/map/msync
+    _Atomic long long max_sync_us;       // Longest msync
+    _Atomic unsigned int segment;        // Index of the segment being written
+} TelemetryLog;
+
+// Records a segment file yields, in order
+typedef struct {
+    int fd;
+    const uint8_t* map;
+    size_t map_bytes;
+    TLogHeader header;
+    uint32_t capacity;       // Record slots in the file
+    uint32_t next;
+    unsigned long records;   // Valid records returned so far
+    unsigned long damaged;   // Non-empty slots that failed their check
+} TLogReader;
+
+TLogConfig TLog_DefaultConfig(const char* directory);
+
+// Create the directory if needed, prepare the first segment and start the
+// background thread. Returns false if the first segment can't be created.
+bool TLog_Open(TelemetryLog* log, const TLogConfig* config);
+
+// Writer: append one record. Never blocks or makes a system call. Returns
+// false if the record was dropped (segment full and the next one not ready).
+bool TLog_Write(TelemetryLog* log, long long timestamp_us, uint8_t pid, float value, uint8_t flags);
+
+// Stop the background thread, sync and trim every segment, remove the unused
+// prepared one. Call after the writer has stopped.
+void TLog_Close(TelemetryLog* log);
+
+// Read back a segment, including one that was never closed
+bool TLog_ReaderOpen(TLogReader* reader, const char* path);
+
+// Next valid record; skips empty and damaged slots. Returns false at the end.
+bool TLog_ReaderNext(TLogReader* reader, TLogRecord* record);
+
+void TLog_ReaderClose(TLogReader* reader);
+
+// CRC a record's first 14 bytes, as stored in check
+uint16_t TLog_RecordCheck(const TLogRecord* record);
+
+#endif // TELEMETRY_LOG_H
@@ -0,0 +1,180 @@
+#include "timeseries.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Smallest ring per channel
+#define MIN_CAPACITY 16
+
+// Samples copied per pass of TS_Stats
+#define STATS_CHUNK 256
+
+static unsigned int FloorPowerOfTwo(size_t n) {
+    unsigned int p = 1;
+    while ((size_t)p * 2 <= n && p < (1u << 30)) p *= 2;
+    return p;
+}
+
+bool TS_Init(TimeSeriesSet* set, const TimeSeriesConfig* configs, int num_channels, size_t budget_bytes) {
+    memset(set, 0, sizeof(*set));
+    memset(set->index, -1, sizeof(set->index));
+    if (num_channels < 1 || num_channels > TIMESERIES_MAX_CHANNELS) return false;
+
+    // Same time span for every channel: samples in proportion to the rate
+    double total_hz = 0.0;
+    for (int i = 0; i < num_channels; i++) total_hz += configs[i].hz > 0.0f ? configs[i].hz : 1.0f;
+    size_t budget_samples = budget_bytes / TIMESERIES_SAMPLE_BYTES;
+    size_t total_samples = 0;
+    for (int i = 0; i < num_channels; i++) {
+        float hz = configs[i].hz > 0.0f ? configs[i].hz : 1.0f;
+        unsigned int capacity = FloorPowerOfTwo((size_t)(budget_samples * (hz / total_hz)));
+        if (capacity < MIN_CAPACITY) capacity = MIN_CAPACITY;
+        set->channels[i].pid = configs[i].pid;
+        set->channels[i].capacity = capacity;
+        set->channels[i].mask = capacity - 1;
+        total_samples += capacity;
+    }
+    if (total_samples * TIMESERIES_SAMPLE_BYTES > budget_bytes) return false;
+
+    // One block: every channel's timestamps, then every channel's values
+    set->memory_bytes = total_samples * TIMESERIES_SAMPLE_BYTES;
+    set->memory = calloc(1, set->memory_bytes);
+    if (!set->memory) return false;
+    _Atomic long long* timestamps = (_Atomic long long*)set->memory;
+    _Atomic float* values = (_Atomic float*)(timestamps + total_samples);
+
+    for (int i = 0; i < num_channels; i++) {
+        TimeSeries* series = &set->channels[i];
+        series->timestamp_us = timestamps;
+        series->value = values;
+        timestamps += series->capacity;
+        values += series->capacity;
+        atomic_init(&series->claimed, 0);
+        atomic_init(&series->head, 0);
+        if (set->index[series->pid] < 0) set->index[series->pid] = (int8_t)i;
+    }
+    set->num_channels = num_channels;
+    return true;
+}
+
+void TS_Free(TimeSeriesSet* set) {
+    free(set->memory);
+    memset(set, 0, sizeof(*set));
+    memset(set->index, -1, sizeof(set->index));
+}
+
+TimeSeries* TS_Channel(TimeSeriesSet* set, uint8_t pid) {
+    int i = set->index[pid];
+    return i >= 0 ? &set->channels[i] : NULL;
+}
+
+// Claim the slot before writing it, so a reader that saw any part of the new
+// sample also sees that the old one is gone; publish after.
+void TS_Append(TimeSeries* series, long long timestamp_us, float value) {
+    unsigned long long h = atomic_load_explicit(&series->head, memory_order_relaxed);
+    atomic_store_explicit(&series->claimed, h + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    unsigned int slot = (unsigned int)h & series->mask;
+    atomic_store_explicit(&series->timestamp_us[slot], timestamp_us, memory_order_relaxed);
+    atomic_store_explicit(&series->value[slot], value, memory_order_relaxed);
+
+    atomic_store_explicit(&series->head, h + 1, memory_order_release);
+}
+
+float TS_SpanSeconds(const TimeSeries* series, float hz) {
+    return hz > 0.0f ? series->capacity / hz : 0.0f;
+}
+
+// Copy samples [first, end) and return the first index that was still intact
+// afterwards: a slot is rewritten by the sample capacity indices later.
+static unsigned long long CopySlots(const TimeSeries* series, unsigned long long first, unsigned long long end,
+                                    long long* timestamps_us, float* values) {
+    for (unsigned long long i = first; i < end; i++) {
+        unsigned int slot = (unsigned int)i & series->mask;
+        timestamps_us[i - first] = atomic_load_explicit(&series->timestamp_us[slot], memory_order_relaxed);
+        values[i - first] = atomic_load_explicit(&series->value[slot], memory_order_relaxed);
+    }
+    atomic_thread_fence(memory_order_acquire);
+    unsigned long long claimed = atomic_load_explicit(&series->claimed, memory_order_relaxed);
+    unsigned long long intact = claimed > series->capacity ? claimed - series->capacity : 0;
+    return intact > first ? intact : first;
+}
+
+bool TS_Latest(const TimeSeries* series, long long* timestamp_us, float* value) {
+    long long t;
+    float v;
+    for (;;) {
+        unsigned long long head = atomic_load_explicit(&series->head, memory_order_acquire);
+        if (head == 0) return false;
+        if (CopySlots(series, head - 1, head, &t, &v) == head - 1) break;
+    }
+    *timestamp_us = t;
+    *value = v;
+    return true;
+}
+
+int TS_Read(const TimeSeries* series, long long since_us, long long* timestamps_us, float* values,
+            int max_samples) {
+    if (max_samples <= 0) return 0;
+    unsigned long long head, n, first, intact;
+    for (;;) {
+        head = atomic_load_explicit(&series->head, memory_order_acquire);
+        n = head < series->capacity ? head : series->capacity;
+        if (n > (unsigned long long)max_samples) n = max_samples;
+        first = head - n;
+        intact = CopySlots(series, first, head, timestamps_us, values);
+        // Lapped during the copy: nothing of it is left, so copy again from
+        // the new head
+        if (intact < head || n == 0) break;
+    }
+
+    // Overwritten samples are the oldest ones; drop them, then the ones
+    // older than the window
+    int skip = intact - first < n ? (int)(intact - first) : (int)n;
+    while (skip < (int)n && timestamps_us[skip] < since_us) skip++;
+    int count = (int)n - skip;
+    if (skip > 0 && count > 0) {
+        memmove(timestamps_us, timestamps_us + skip, count * sizeof(long long));
+        memmove(values, values + skip, count * sizeof(float));
+    }
+    return count;
+}
+
+// Walk back from the newest sample a chunk at a time until the window or the
+// intact part of the ring ends
+bool TS_Stats(const TimeSeries* series, long long since_us, TimeSeriesStats* out) {
+    long long t[STATS_CHUNK];
+    float v[STATS_CHUNK];
+    memset(out, 0, sizeof(*out));
+    double sum = 0.0;
+
+    unsigned long long end = atomic_load_explicit(&series->head, memory_order_acquire);
+    unsigned long long oldest = end > series->capacity ? end - series->capacity : 0;
+    while (end > oldest) {
+        unsigned long long first = end - oldest > STATS_CHUNK ? end - STATS_CHUNK : oldest;
+        unsigned long long intact = CopySlots(series, first, end, t, v);
+        bool done = intact > first;
+        for (unsigned long long i = end; i > intact; i--) {
+            int k = (int)(i - 1 - first);
+            if (t[k] < since_us) {
+                done = true;
+                break;
+            }
+            if (out->count == 0) {
+                out->min = out->max = v[k];
+                out->last_us = t[k];
+            }
+            if (v[k] < out->min) out->min = v[k];
+            if (v[k] > out->max) out->max = v[k];
+            out->first_us = t[k];
+            sum += v[k];
+            out->count++;
+        }
+        if (done) break;
+        end = first;
+    }
+
+    if (out->count == 0) return false;
+    out->mean = (float)(sum / out->count);
+    return true;
+}
@@ -0,0 +1,92 @@
+#ifndef TIMESERIES_H
+#define TIMESERIES_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
+
+// History of every telemetry channel: a fixed ring of (timestamp, value) per
+// PID, kept as two parallel arrays so scans over values or times touch only
+// what they need. All rings live in one allocation sized from a memory
+// budget, split so every channel covers about the same span of time.
+//
+// One thread appends (O(1), never allocates, never waits); any number of
+// threads read at the same time without a lock. Appending overwrites the
+// oldest sample, so readers check after copying which samples may have been
+// overwritten meanwhile and drop those: a query returns the newest samples
+// that were intact, never a mix.
+//
+// Timestamps are OBD_NowMicros microseconds and must not go backwards per
+// channel (windowed queries stop at the first sample older than the window).
+
+#define TIMESERIES_MAX_CHANNELS 16
+
+// A few MB: ~95 minutes of the dashboard's 20 + 10 + 0.5 Hz
+#define TIMESERIES_DEFAULT_BUDGET (2u << 20)
+
+// Bytes of ring per sample (timestamp + value)
+#define TIMESERIES_SAMPLE_BYTES (sizeof(long long) + sizeof(float))
+
+typedef struct {
+    uint8_t pid;
+    float hz;                // Expected rate, for sizing (0 = 1 Hz)
+} TimeSeriesConfig;
+
+typedef struct {
+    uint8_t pid;
+    unsigned int capacity;             // Power of two
+    unsigned int mask;
+    _Atomic long long* timestamp_us;   // Structure of arrays, slot = index & mask
+    _Atomic float* value;
+    _Atomic unsigned long long claimed;  // Index the writer is filling + 1
+    _Atomic unsigned long long head;     // Samples appended (all before it complete)
+} TimeSeries;
+
+typedef struct {
+    TimeSeries channels[TIMESERIES_MAX_CHANNELS];
+    int num_channels;
+    int8_t index[256];       // Channel of each PID, -1 if none
+    void* memory;
+    size_t memory_bytes;
+} TimeSeriesSet;
+
+// Windowed statistics
+typedef struct {
+    int count;
+    float min;
+    float max;
+    float mean;
+    long long first_us;      // Oldest sample in the window
+    long long last_us;       // Newest
+} TimeSeriesStats;
+
+// Allocate rings for the channels within budget_bytes. Capacities are powers
+// of two in proportion to each channel's rate (at least 16 samples).
+// Returns false if the budget can't hold 16 samples per channel.
+bool TS_Init(TimeSeriesSet* set, const TimeSeriesConfig* configs, int num_channels, size_t budget_bytes);
+
+void TS_Free(TimeSeriesSet* set);
+
+// Ring of a PID, NULL if it has none
+TimeSeries* TS_Channel(TimeSeriesSet* set, uint8_t pid);
+
+// Writer: append a sample (one appending thread per channel)
+void TS_Append(TimeSeries* series, long long timestamp_us, float value);
+
+// Seconds of history the ring holds at its expected rate
+float TS_SpanSeconds(const TimeSeries* series, float hz);
+
+// Newest sample. Returns false if there is none.
+bool TS_Latest(const TimeSeries* series, long long* timestamp_us, float* value);
+
+// Copy the newest samples no older than since_us, at most max_samples,
+// oldest first. Returns the number copied.
+int TS_Read(const TimeSeries* series, long long since_us, long long* timestamps_us, float* values,
+            int max_samples);
+
+// Count, min, max and mean of the samples no older than since_us. Returns
+// false (count 0) if there are none.
+bool TS_Stats(const TimeSeries* series, long long since_us, TimeSeriesStats* out);
+
+#endif // TIMESERIES_H
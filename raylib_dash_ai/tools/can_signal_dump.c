@@ -0,0 +1,110 @@
+// Decode broadcast signals from a candump log or a live SocketCAN interface
+// and print them as "time_s pid value" lines, the emulator's trace format (so
+// a recorded drive can be fed back through elm327_emu -t). A summary of
+// updates per signal goes to stderr at the end.
+//
+// Build: gcc tools/can_signal_dump.c can_signals.c -o can_signal_dump
+// Usage: ./can_signal_dump -s signals.sig -f candump.log [-q]
+//        ./can_signal_dump -s signals.sig -i vcan0 [-q]      (until Ctrl-C)
+//   -q  summary only
+
+#include "../can_signals.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+
+static volatile sig_atomic_t quit = 0;
+
+static void OnSignal(int sig) {
+    (void)sig;
+    quit = 1;
+}
+
+typedef struct {
+    const CANSignalSet* set;
+    bool quiet;
+    long long first_us;
+    long long last_us;
+    bool started;
+    unsigned long updates[256];   // Per PID
+} Dump;
+
+static void OnValue(void* user, const OBDValue* value, long long timestamp_us) {
+    Dump* dump = (Dump*)user;
+    if (!dump->started) {
+        dump->first_us = timestamp_us;
+        dump->started = true;
+    }
+    dump->last_us = timestamp_us;
+    dump->updates[value->pid]++;
+    if (!dump->quiet) {
+        printf("%.6f %02X %g\n", (timestamp_us - dump->first_us) / 1e6, value->pid, value->value);
+    }
+}
+
+static void PrintSummary(const Dump* dump, long frames) {
+    double seconds = (dump->last_us - dump->first_us) / 1e6;
+    fprintf(stderr, "%ld frames, %.2f s\n", frames, seconds);
+    for (int i = 0; i < dump->set->num_signals; i++) {
+        const CANSignal* signal = &dump->set->signals[i];
+        unsigned long n = dump->updates[signal->pid];
+        fprintf(stderr, "  %-20s PID %02X  %03X  %7lu updates  %7.1f Hz\n", signal->name, signal->pid,
+                signal->can_id, n, seconds > 0 ? n / seconds : 0.0);
+    }
+}
+
+static void Usage(const char* name) {
+    fprintf(stderr, "usage: %s -s signal_file (-f candump_log | -i can_ifname) [-q]\n", name);
+}
+
+int main(int argc, char** argv) {
+    const char* signal_path = NULL;
+    const char* log_path = NULL;
+    const char* ifname = NULL;
+    bool quiet = false;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "s:f:i:q")) != -1) {
+        switch (opt) {
+            case 's': signal_path = optarg; break;
+            case 'f': log_path = optarg; break;
+            case 'i': ifname = optarg; break;
+            case 'q': quiet = true; break;
+            default:
+                Usage(argv[0]);
+                return 1;
+        }
+    }
+    if (!signal_path || (!log_path) == (!ifname)) {
+        Usage(argv[0]);
+        return 1;
+    }
+
+    static CANSignalSet set;
+    if (!CAN_LoadSignals(&set, signal_path)) return 1;
+    Dump dump = { .set = &set, .quiet = quiet };
+
+    if (log_path) {
+        long frames = CAN_DecodeCandump(&set, log_path, OnValue, &dump);
+        if (frames < 0) {
+            perror(log_path);
+            return 1;
+        }
+        PrintSummary(&dump, frames);
+        return 0;
+    }
+
+    CANListener listener;
+    if (!CAN_ListenOpen(&listener, ifname, &set, OnValue, &dump)) return 1;
+    signal(SIGINT, OnSignal);
+    signal(SIGTERM, OnSignal);
+    while (!quit) {
+        if (CAN_ListenStep(&listener, 100) < 0) break;
+        if (!quiet) fflush(stdout);
+    }
+    CAN_ListenClose(&listener);
+    PrintSummary(&dump, (long)listener.frames);
+    return 0;
+}
@@ -0,0 +1,208 @@
+// Pack drive recorder segments into a compressed archive, and get data back
+// out of it as CSV.
+//
+//   pack   archive.dar segment.tlog...  Add segments (in name order) to the
+//                                       archive, creating it if needed
+//   info   archive.dar                  Chunks, samples, span and range per PID
+//   csv    archive.dar                  "time_s,pid,value" lines, time_s in
+//                                       Unix seconds; only the chunks that can
+//                                       match the filters are read
+//
+// Filters for csv:
+//   -p 0C      one PID (hex)
+//   -s 30d     newer than 30 days ago (s, m, h, d)
+//   -u 7d      older than 7 days ago
+//   -g 6000    value at least 6000
+//   -l 100     value at most 100
+//
+// Build: gcc -O2 tools/drive_archive_tool.c drive_archive.c telemetry_log.c obd_pids.c -o drive_archive
+//        -lpthread -lm
+// Usage: ./drive_archive pack drives.dar logs/*.tlog
+//        ./drive_archive csv -p 0C -g 6000 -s 30d drives.dar > fast.csv
+
+#include "../drive_archive.h"
+#include "../telemetry_log.h"
+#include "../obd_pids.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+
+static void Usage(const char* name) {
+    fprintf(stderr,
+            "usage: %s pack archive.dar segment.tlog...\n"
+            "       %s info archive.dar\n"
+            "       %s csv [-p pid] [-s age] [-u age] [-g min] [-l max] archive.dar\n",
+            name, name, name);
+}
+
+static int CompareName(const void* a, const void* b) {
+    return strcmp(*(char* const*)a, *(char* const*)b);
+}
+
+// "30d", "12h", "90m", "45s" (or plain seconds) as microseconds
+static bool ParseAge(const char* text, long long* us) {
+    char* end;
+    double n = strtod(text, &end);
+    if (end == text || n < 0) return false;
+    double unit = 1.0;
+    switch (*end) {
+        case 'd': unit = 86400.0; break;
+        case 'h': unit = 3600.0; break;
+        case 'm': unit = 60.0; break;
+        case 's': case '\0': break;
+        default: return false;
+    }
+    *us = (long long)(n * unit * 1e6);
+    return true;
+}
+
+static long long WallMicros(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (long long)ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+// ---- pack ----
+
+static int Pack(const char* archive_path, char** segments, int num_segments) {
+    qsort(segments, num_segments, sizeof(char*), CompareName);
+
+    ArchiveWriter writer;
+    if (!Archive_Append(&writer, archive_path)) return 1;
+    unsigned long damaged = 0;
+    for (int i = 0; i < num_segments; i++) {
+        TLogReader reader;
+        if (!TLog_ReaderOpen(&reader, segments[i])) continue;
+        TLogRecord record;
+        while (TLog_ReaderNext(&reader, &record)) {
+            Archive_Add(&writer, record.pid, record.timestamp_us + reader.header.clock_offset_us, record.value);
+        }
+        damaged += reader.damaged;
+        TLog_ReaderClose(&reader);
+    }
+    unsigned long samples = writer.samples;
+    if (!Archive_Finish(&writer)) {
+        fprintf(stderr, "%s: write failed\n", archive_path);
+        return 1;
+    }
+    fprintf(stderr, "%lu samples from %d segments into %s (%lu damaged records skipped)\n", samples, num_segments,
+            archive_path, damaged);
+    return 0;
+}
+
+// ---- info ----
+
+// One PID across its chunks, from the index alone
+typedef struct {
+    int chunks;
+    int raw_chunks;
+    unsigned long samples;
+    unsigned long bytes;
+    long long first_us;
+    long long last_us;
+    float min;
+    float max;
+} PIDSummary;
+
+static int Info(const char* archive_path) {
+    ArchiveReader reader;
+    if (!Archive_Open(&reader, archive_path)) return 1;
+
+    static PIDSummary per[256];
+    unsigned long samples = 0;
+    for (int c = 0; c < reader.num_chunks; c++) {
+        const ArchiveChunk* chunk = &reader.index[c];
+        PIDSummary* p = &per[chunk->pid];
+        if (p->chunks == 0 || chunk->start_us < p->first_us) p->first_us = chunk->start_us;
+        if (p->chunks == 0 || chunk->end_us > p->last_us) p->last_us = chunk->end_us;
+        if (p->chunks == 0 || chunk->min < p->min) p->min = chunk->min;
+        if (p->chunks == 0 || chunk->max > p->max) p->max = chunk->max;
+        p->chunks++;
+        p->samples += chunk->count;
+        p->bytes += chunk->bytes;
+        if (chunk->encoding == ARCHIVE_VALUES_RAW) p->raw_chunks++;
+        samples += chunk->count;
+    }
+
+    fseeko(reader.file, 0, SEEK_END);
+    long long file_bytes = ftello(reader.file);
+    printf("%s: %d chunks, %lu samples, %lld bytes (%.1fx smaller than log records), %u us resolution%s\n",
+           archive_path, reader.num_chunks, samples, file_bytes,
+           file_bytes > 0 ? (double)samples * sizeof(TLogRecord) / file_bytes : 0.0, reader.header.time_unit_us,
+           reader.recovered ? ", index rebuilt" : "");
+    for (int pid = 0; pid < 256; pid++) {
+        if (per[pid].chunks == 0) continue;
+        const OBDPIDInfo* info = OBD_GetPIDInfo((uint8_t)pid);
+        time_t first = (time_t)(per[pid].first_us / 1000000), last = (time_t)(per[pid].last_us / 1000000);
+        char from[32], to[32];
+        strftime(from, sizeof(from), "%Y-%m-%d %H:%M", localtime(&first));
+        strftime(to, sizeof(to), "%Y-%m-%d %H:%M", localtime(&last));
+        printf("  %02X %-28s %5d chunks (%d raw) %9lu samples %5.2f bits each  %s .. %s  %g .. %g %s\n", pid,
+               info ? info->name : "?", per[pid].chunks, per[pid].raw_chunks, per[pid].samples,
+               per[pid].bytes * 8.0 / per[pid].samples, from, to, per[pid].min, per[pid].max,
+               info ? info->unit : "");
+    }
+    Archive_Close(&reader);
+    return 0;
+}
+
+// ---- csv ----
+
+static bool PrintSample(void* user, uint8_t pid, long long timestamp_us, float value) {
+    const char* format = (const char*)user;
+    printf(format, timestamp_us / 1e6, pid, value);
+    return true;
+}
+
+static int Csv(int argc, char** argv) {
+    ArchiveQuery query = Archive_QueryAll();
+    long long now = WallMicros(), age;
+    int opt;
+    while ((opt = getopt(argc, argv, "p:s:u:g:l:")) != -1) {
+        switch (opt) {
+            case 'p': query.pid = (int)strtol(optarg, NULL, 16); break;
+            case 's':
+                if (!ParseAge(optarg, &age)) return 1;
+                query.from_us = now - age;
+                break;
+            case 'u':
+                if (!ParseAge(optarg, &age)) return 1;
+                query.to_us = now - age;
+                break;
+            case 'g': query.min_value = strtof(optarg, NULL); break;
+            case 'l': query.max_value = strtof(optarg, NULL); break;
+            default:
+                Usage(argv[0]);
+                return 1;
+        }
+    }
+    if (optind != argc - 1) {
+        Usage(argv[0]);
+        return 1;
+    }
+
+    ArchiveReader reader;
+    if (!Archive_Open(&reader, argv[optind])) return 1;
+    const char* format = reader.header.time_unit_us >= 1000 ? "%.3f,%02X,%g\n" : "%.6f,%02X,%g\n";
+    printf("time_s,pid,value\n");
+    long matches = Archive_Query(&reader, &query, PrintSample, (void*)format);
+    fprintf(stderr, "%ld samples; read %lu of %d chunks (%lu bytes)\n", matches, reader.chunks_read,
+            reader.num_chunks, reader.bytes_read);
+    Archive_Close(&reader);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        Usage(argv[0]);
+        return 1;
+    }
+    if (strcmp(argv[1], "pack") == 0 && argc >= 4) return Pack(argv[2], argv + 3, argc - 3);
+    if (strcmp(argv[1], "info") == 0 && argc == 3) return Info(argv[2]);
+    if (strcmp(argv[1], "csv") == 0) return Csv(argc - 1, argv + 1);
+    Usage(argv[0]);
+    return 1;
+}
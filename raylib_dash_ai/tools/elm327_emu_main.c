@@ -0,0 +1,133 @@
+// Standalone ELM327 emulator. Prints the pty path to point OBD_Init (or the
+// dashboard, or a terminal program) at, and answers until Ctrl-C. With -c the
+// same ECUs answer raw ISO 15765-4 frames on a SocketCAN interface instead.
+//
+// Build: gcc tools/elm327_emu_main.c elm327_emu.c obd_pids.c can_signals.c -o elm327_emu -lpthread -lm
+// Usage: ./elm327_emu [options]
+//   -p protocol     ATDPN protocol number (default 6, CAN 11-bit 500k)
+//   -l ms           ECU latency (default 10)
+//   -j ms           random extra latency, 0..ms
+//   -b baud         serial rate replies are paced to (default 38400, 0 = no pacing)
+//   -e count        number of ECUs answering Mode 01 (default 1, at most 4)
+//   -d rate         fraction of requests dropped without a reply
+//   -n rate         fraction of requests answered "NO DATA"
+//   -g rate         fraction of replies with corrupted characters
+//   -o period:ms    link outage of ms every period ms
+//   -t file         value trace ("time_s pid value" per line, see elm327_emu.h)
+//   -s seed         random seed for faults and jitter
+//   -L path         also create a symlink to the pty at path
+//   -c ifname       answer on a SocketCAN interface (e.g. vcan0) instead of a pty
+//   -m file         candump log replayed as bus traffic for ATMA/STMA
+//   -M bytes        monitor output buffer (default 512; BUFFER FULL beyond it)
+//   -S              identify as an STN11xx (STI, STMA)
+
+#include "../elm327_emu.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+
+static volatile sig_atomic_t quit = 0;
+
+static void OnSignal(int sig) {
+    (void)sig;
+    quit = 1;
+}
+
+static void Usage(const char* name) {
+    fprintf(stderr, "usage: %s [-p protocol] [-l latency_ms] [-j jitter_ms] [-b baud] [-e ecus]\n"
+                    "       [-d drop_rate] [-n no_data_rate] [-g garbage_rate] [-o period_ms:outage_ms]\n"
+                    "       [-t trace_file] [-s seed] [-L link_path] [-c can_ifname]\n"
+                    "       [-m candump_log] [-M monitor_buffer] [-S]\n", name);
+}
+
+int main(int argc, char** argv) {
+    ELMConfig config = ELM_DefaultConfig();
+    const char* link_path = NULL;
+    const char* can_ifname = NULL;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "p:l:j:b:e:d:n:g:o:t:s:L:c:m:M:S")) != -1) {
+        switch (opt) {
+            case 'p': config.protocol = (int)strtol(optarg, NULL, 16); break;
+            case 'l': config.ecu_latency_us = atoi(optarg) * 1000; break;
+            case 'j': config.latency_jitter_us = atoi(optarg) * 1000; break;
+            case 'b': config.baud = atoi(optarg); break;
+            case 'e': config.num_ecus = atoi(optarg); break;
+            case 'd': config.drop_rate = (float)atof(optarg); break;
+            case 'n': config.no_data_rate = (float)atof(optarg); break;
+            case 'g': config.garbage_rate = (float)atof(optarg); break;
+            case 'o':
+                if (sscanf(optarg, "%d:%d", &config.outage_period_ms, &config.outage_ms) != 2) {
+                    Usage(argv[0]);
+                    return 1;
+                }
+                break;
+            case 't': config.trace_path = optarg; break;
+            case 's': config.seed = (unsigned int)strtoul(optarg, NULL, 10); break;
+            case 'L': link_path = optarg; break;
+            case 'c': can_ifname = optarg; break;
+            case 'm': config.candump_path = optarg; break;
+            case 'M': config.monitor_buffer = atoi(optarg); break;
+            case 'S': config.stn = true; break;
+            default:
+                Usage(argv[0]);
+                return 1;
+        }
+    }
+    if (config.protocol < 1 || config.protocol > 9) {
+        fprintf(stderr, "protocol must be 1-9\n");
+        return 1;
+    }
+
+    // Extra ECUs answer the same PIDs a little later (transmission, ABS, ...)
+    if (config.num_ecus > ELM_MAX_ECUS) config.num_ecus = ELM_MAX_ECUS;
+    bool can = config.protocol >= 6;
+    bool long_header = config.protocol == 7 || config.protocol == 9;
+    for (int i = 0; i < config.num_ecus; i++) {
+        config.ecus[i] = config.ecus[0];
+        config.ecus[i].header = can ? (long_header ? 0x18DAF110 + i : 0x7E8 + i) : 0x10 + i * 8;
+        config.ecus[i].delay_us = i * 2000;
+    }
+
+    ELMEmulator emu;
+    if (can_ifname) {
+        if (!ELM_StartCAN(&emu, &config, can_ifname)) return 1;
+        link_path = NULL;
+    } else if (!ELM_Start(&emu, &config)) {
+        return 1;
+    }
+
+    if (link_path) {
+        unlink(link_path);
+        if (symlink(emu.slave_path, link_path) != 0) perror(link_path);
+    }
+
+    signal(SIGINT, OnSignal);
+    signal(SIGTERM, OnSignal);
+    if (can_ifname) {
+        printf("ECU emulator on %s (7DF/7E0 requests, %d ECU%s from 7E8, %d ms latency)\n",
+               emu.slave_path, emu.config.num_ecus, emu.config.num_ecus == 1 ? "" : "s",
+               config.ecu_latency_us / 1000);
+    } else {
+        printf("ELM327 emulator on %s%s%s (protocol %X, %d ECU%s, %d ms latency, %d baud)\n",
+               emu.slave_path, link_path ? " -> " : "", link_path ? link_path : "",
+               config.protocol, config.num_ecus, config.num_ecus == 1 ? "" : "s",
+               config.ecu_latency_us / 1000, config.baud);
+    }
+    fflush(stdout);
+
+    while (!quit) pause();
+
+    ELMStats stats = emu.stats;
+    ELM_Stop(&emu);
+    if (link_path) unlink(link_path);
+    printf("\n%ld commands, %ld OBD requests (%ld dropped, %ld NO DATA, %ld garbled), %ld bytes sent\n",
+           stats.commands, stats.obd_requests, stats.dropped, stats.no_data, stats.garbage,
+           stats.bytes_sent);
+    if (config.candump_path) {
+        printf("%ld frames monitored, %ld BUFFER FULL\n", stats.monitor_frames, stats.buffer_full);
+    }
+    return 0;
+}
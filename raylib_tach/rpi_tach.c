@@ -1,9 +1,32 @@
 #include "raylib/src/raylib.h"
-#include <stdio.h>
+#include "../raylib_dash_ai/readout.h"
 #include <stdlib.h>
+#include <time.h>
+
+#define RPM_FONT_SIZE 300
+
+// Keys are read this often; a frame is drawn only when the RPM changes
+#define TICK_HZ 20
+
+// Sleep to the next tick, a whole period after the last one (no busy wait)
+static void WaitTick(struct timespec* tick) {
+    tick->tv_nsec += 1000000000L / TICK_HZ;
+    if (tick->tv_nsec >= 1000000000L) {
+        tick->tv_sec++;
+        tick->tv_nsec -= 1000000000L;
+    }
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    long long ns = (tick->tv_sec - now.tv_sec) * 1000000000LL + (tick->tv_nsec - now.tv_nsec);
+    if (ns <= 0) {
+        *tick = now;    // Late: start again from now rather than catch up
+        return;
+    }
+    struct timespec wait = { .tv_sec = ns / 1000000000LL, .tv_nsec = ns % 1000000000LL };
+    nanosleep(&wait, NULL);
+}
 
 int main(void) {
-    SetTargetFPS(20);
     InitWindow(800, 480, "Tachometer");
 
     const int rev_limit = 7200;
@@ -11,9 +34,17 @@ int main(void) {
     const int green_cutoff = 17;
     const int yellow_cutoff = 23;
     const float rev_step = rev_limit / num_bars;
-    char rpm[5];
     unsigned int raw_rpm = 0;
 
+    // The RPM digits at their 300 px size, rasterised once: drawing the
+    // number is then a textured quad per digit instead of text layout
+    Readout rpm = Readout_Make(RPM_FONT_SIZE, 1, "");
+    Readout_Prepare(&rpm);
+    Readout_Set(&rpm, raw_rpm);
+    bool dirty = true;
+    struct timespec tick;
+    clock_gettime(CLOCK_MONOTONIC, &tick);
+
     while (!WindowShouldClose()) {
         if (IsKeyPressed(KEY_LEFT)) {
             if (raw_rpm >= 100) {
@@ -26,27 +57,37 @@ int main(void) {
             }
         }
 
-        sprintf(rpm, "%u", raw_rpm);
-        BeginDrawing();
-            ClearBackground(RAYWHITE);
-            DrawText(rpm, 20, 220, 300, DARKGRAY);
-            DrawText("R\nP\nM", 730, 244, 75, DARKGRAY);
-            int bar_x_val = 15;
-            for (float i = rev_step; i <= raw_rpm; i += rev_step) {
-                if (i < (rev_step * green_cutoff)) {
-                    DrawRectangle(bar_x_val, 20, 20, 210, GREEN);
-                } else if (i >= (rev_step * green_cutoff) && i < (rev_step * yellow_cutoff)) {
-                    DrawRectangle(bar_x_val, 20, 20, 210, YELLOW);
-                } else if (i >= (rev_step * yellow_cutoff)) {
-                    DrawRectangle(bar_x_val, 20, 20, 210, RED);
-                } else {
-                    DrawRectangle(bar_x_val, 20, 20, 210, BLUE);
+        if (Readout_Set(&rpm, raw_rpm)) dirty = true;
+
+        // Nothing changed: leave the last frame on screen
+        if (dirty) {
+            BeginDrawing();
+                ClearBackground(RAYWHITE);
+                // Left aligned at x = 20
+                Readout_Draw(&rpm, (Vector2){ 20 + Readout_Width(&rpm) / 2, 220 }, DARKGRAY);
+                DrawText("R\nP\nM", 730, 244, 75, DARKGRAY);
+                int bar_x_val = 15;
+                for (float i = rev_step; i <= raw_rpm; i += rev_step) {
+                    if (i < (rev_step * green_cutoff)) {
+                        DrawRectangle(bar_x_val, 20, 20, 210, GREEN);
+                    } else if (i >= (rev_step * green_cutoff) && i < (rev_step * yellow_cutoff)) {
+                        DrawRectangle(bar_x_val, 20, 20, 210, YELLOW);
+                    } else if (i >= (rev_step * yellow_cutoff)) {
+                        DrawRectangle(bar_x_val, 20, 20, 210, RED);
+                    } else {
+                        DrawRectangle(bar_x_val, 20, 20, 210, BLUE);
+                    }
+                    bar_x_val += 30;
                 }
-                bar_x_val += 30;
-            }
-        EndDrawing();
+            EndDrawing();
+            dirty = false;
+        } else {
+            PollInputEvents();
+        }
+        WaitTick(&tick);
     }
 
+    Readout_Unload(&rpm);
     CloseWindow();
 
     return 0;